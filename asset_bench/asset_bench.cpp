@@ -0,0 +1,331 @@
+#include "asset_bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "result_table.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+    volatile uint64_t g_sink = 0;
+
+    timing_stats compute_stats( std::vector< double > samples_ms )
+    {
+        std::sort( samples_ms.begin(), samples_ms.end() );
+
+        timing_stats ret{};
+        ret.repetitions = static_cast< uint32_t >( samples_ms.size() );
+        ret.min_ms      = samples_ms.front();
+        ret.max_ms      = samples_ms.back();
+
+        const size_t mid = samples_ms.size() / 2;
+        ret.median_ms    = samples_ms.size() % 2 == 1
+                            ? samples_ms[mid]
+                            : 0.5 * ( samples_ms[mid - 1] + samples_ms[mid] );
+
+        double sum = 0.0;
+        for ( const double ms : samples_ms )
+        {
+            sum += ms;
+        }
+        ret.mean_ms = sum / samples_ms.size();
+
+        double square_sum = 0.0;
+        for ( const double ms : samples_ms )
+        {
+            square_sum += ( ms - ret.mean_ms ) * ( ms - ret.mean_ms );
+        }
+        ret.stddev_ms = std::sqrt( square_sum / samples_ms.size() );
+
+        return ret;
+    }
+
+    // the grid closest to triangle_count triangles, two per quad
+    uint32_t grid_side( uint64_t triangle_count )
+    {
+        return std::max( 1u, static_cast< uint32_t >(
+                                 std::sqrt( static_cast< double >( triangle_count ) / 2 )
+                                 + 0.5 ) );
+    }
+
+    float grid_height( uint32_t x, uint32_t y )
+    {
+        return 0.5f * std::sin( x * 0.37f ) * std::cos( y * 0.23f );
+    }
+
+    // PNG chunks are checksummed with the CRC-32 of zlib
+    uint32_t crc32( const uint8_t* data, size_t size, uint32_t crc = 0 )
+    {
+        static const auto table = [] {
+            std::array< uint32_t, 256 > ret{};
+            for ( uint32_t n = 0; n < 256; ++n )
+            {
+                uint32_t c = n;
+                for ( int k = 0; k < 8; ++k )
+                {
+                    c = ( c & 1 ) != 0 ? 0xedb88320u ^ ( c >> 1 ) : c >> 1;
+                }
+                ret[n] = c;
+            }
+            return ret;
+        }();
+
+        crc = ~crc;
+        for ( size_t i = 0; i < size; ++i )
+        {
+            crc = table[( crc ^ data[i] ) & 0xff] ^ ( crc >> 8 );
+        }
+        return ~crc;
+    }
+
+    void put_u32_be( std::vector< uint8_t >& out, uint32_t v )
+    {
+        out.insert( out.end(), {static_cast< uint8_t >( v >> 24 ),
+                                static_cast< uint8_t >( v >> 16 ),
+                                static_cast< uint8_t >( v >> 8 ),
+                                static_cast< uint8_t >( v )} );
+    }
+
+    void write_png_chunk( std::ofstream& os, const char* type,
+                          const std::vector< uint8_t >& data )
+    {
+        std::vector< uint8_t > chunk;
+        put_u32_be( chunk, static_cast< uint32_t >( data.size() ) );
+        chunk.insert( chunk.end(), type, type + 4 );
+        chunk.insert( chunk.end(), data.begin(), data.end() );
+        put_u32_be( chunk, crc32( chunk.data() + 4, chunk.size() - 4 ) );
+
+        os.write( reinterpret_cast< const char* >( chunk.data() ), chunk.size() );
+    }
+
+    result_table make_result_table( const asset_bench_context& ctx )
+    {
+        result_table ret;
+        ret.metadata = {{"warmup", ctx.options.warmup},
+                        {"repetitions", ctx.options.repetitions}};
+        ret.columns  = {"suite",   "name",    "items",     "unit",   "repetitions",
+                       "min_ms",  "median_ms", "mean_ms", "stddev_ms", "max_ms",
+                       "throughput"};
+
+        for ( const auto& r : ctx.results )
+        {
+            ret.add_row( {r.suite, r.name, r.items, r.unit, r.stats.repetitions,
+                          r.stats.min_ms, r.stats.median_ms, r.stats.mean_ms,
+                          r.stats.stddev_ms, r.stats.max_ms, r.throughput} );
+        }
+
+        return ret;
+    }
+} // namespace
+
+void measure( asset_bench_context& ctx, const char* suite, const std::string& name,
+              uint64_t items, const char* unit, const std::function< void() >& run,
+              const std::function< void() >& setup )
+{
+    using clock_h = std::chrono::high_resolution_clock;
+
+    for ( uint32_t i = 0; i < ctx.options.warmup; ++i )
+    {
+        if ( setup )
+        {
+            setup();
+        }
+        run();
+    }
+
+    std::vector< double > samples_ms;
+    samples_ms.reserve( ctx.options.repetitions );
+
+    for ( uint32_t i = 0; i < ctx.options.repetitions; ++i )
+    {
+        if ( setup )
+        {
+            setup();
+        }
+
+        const auto begin = clock_h::now();
+        run();
+        samples_ms.push_back(
+            std::chrono::duration< double, std::milli >( clock_h::now() - begin )
+                .count() );
+    }
+
+    asset_bench_result result{suite, name, items, unit, compute_stats( samples_ms ), 0.0};
+    result.throughput = items / ( std::max( result.stats.median_ms, 1.0e-6 ) * 0.001 );
+
+    log_result( "\t", name, " ", items, ": median ", result.stats.median_ms, " ms, min ",
+                result.stats.min_ms, ", stddev ", result.stats.stddev_ms, ", ",
+                result.throughput, " ", unit, "/s" );
+
+    ctx.results.push_back( std::move( result ) );
+}
+
+void consume( uint64_t value )
+{
+    g_sink = g_sink + value;
+}
+
+model_data make_grid_model( uint64_t triangle_count )
+{
+    const uint32_t side = grid_side( triangle_count );
+
+    model_data ret;
+    ret.vertex_data.reserve( size_t{side + 1} * ( side + 1 ) );
+    ret.index_data.reserve( size_t{side} * side * 6 );
+
+    for ( uint32_t y = 0; y <= side; ++y )
+    {
+        for ( uint32_t x = 0; x <= side; ++x )
+        {
+            vtx_t::vertex v;
+            v.position = glm::vec3( x, grid_height( x, y ), y );
+            v.texcoord = glm::vec2( float( x ) / side, float( y ) / side );
+
+            ret.vertex_data.push_back( v );
+        }
+    }
+
+    for ( uint32_t y = 0; y < side; ++y )
+    {
+        for ( uint32_t x = 0; x < side; ++x )
+        {
+            const vtx_t::index a = y * ( side + 1 ) + x;
+            const vtx_t::index b = a + 1;
+            const vtx_t::index c = a + side + 1;
+            const vtx_t::index d = c + 1;
+
+            ret.index_data.insert( ret.index_data.end(), {a, c, b, b, c, d} );
+        }
+    }
+
+    return ret;
+}
+
+void write_grid_obj( const std::string& path, uint64_t triangle_count )
+{
+    const uint32_t side = grid_side( triangle_count );
+
+    std::ofstream os( path );
+    NEO_ASSERT_ALWAYS( os.is_open(), "Couldn't open ", path, " for writing!" );
+
+    for ( uint32_t y = 0; y <= side; ++y )
+    {
+        for ( uint32_t x = 0; x <= side; ++x )
+        {
+            os << "v " << x << ' ' << grid_height( x, y ) << ' ' << y << '\n';
+        }
+    }
+
+    for ( uint32_t y = 0; y <= side; ++y )
+    {
+        for ( uint32_t x = 0; x <= side; ++x )
+        {
+            os << "vt " << float( x ) / side << ' ' << float( y ) / side << '\n';
+        }
+    }
+
+    // OBJ indices start at 1, positions and texture coordinates share them
+    for ( uint32_t y = 0; y < side; ++y )
+    {
+        for ( uint32_t x = 0; x < side; ++x )
+        {
+            const uint64_t a = uint64_t{y} * ( side + 1 ) + x + 1;
+            const uint64_t b = a + 1;
+            const uint64_t c = a + side + 1;
+            const uint64_t d = c + 1;
+
+            os << "f " << a << '/' << a << ' ' << c << '/' << c << ' ' << b << '/' << b
+               << '\n';
+            os << "f " << b << '/' << b << ' ' << c << '/' << c << ' ' << d << '/' << d
+               << '\n';
+        }
+    }
+}
+
+void write_noise_png( const std::string& path, uint32_t width, uint32_t height )
+{
+    std::ofstream os( path, std::ios::binary );
+    NEO_ASSERT_ALWAYS( os.is_open(), "Couldn't open ", path, " for writing!" );
+
+    const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    os.write( reinterpret_cast< const char* >( signature ), sizeof( signature ) );
+
+    // 8 bits per channel, RGBA, deflate, adaptive filtering, no interlace
+    std::vector< uint8_t > header;
+    put_u32_be( header, width );
+    put_u32_be( header, height );
+    header.insert( header.end(), {8, 6, 0, 0, 0} );
+    write_png_chunk( os, "IHDR", header );
+
+    // every row starts with its filter type, Sub stores the difference to the pixel on
+    // the left
+    const size_t row_size = size_t{width} * 4 + 1;
+    std::vector< uint8_t > filtered( row_size * height );
+
+    uint32_t noise = 0x12345678u;
+    std::vector< uint8_t > row( size_t{width} * 4 );
+
+    for ( uint32_t y = 0; y < height; ++y )
+    {
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            noise = noise * 1664525u + 1013904223u;
+
+            row[x * 4 + 0] = static_cast< uint8_t >( x * 255 / width + ( noise >> 28 ) );
+            row[x * 4 + 1] = static_cast< uint8_t >( y * 255 / height + ( noise >> 24 ) );
+            row[x * 4 + 2] = static_cast< uint8_t >( noise >> 16 );
+            row[x * 4 + 3] = 255;
+        }
+
+        uint8_t* out = &filtered[y * row_size];
+        out[0]       = 1;
+        for ( size_t i = 0; i < row.size(); ++i )
+        {
+            out[i + 1] = static_cast< uint8_t >( row[i] - ( i >= 4 ? row[i - 4] : 0 ) );
+        }
+    }
+
+    // a zlib stream of stored deflate blocks, at most 65535 bytes each
+    std::vector< uint8_t > idat = {0x78, 0x01};
+
+    for ( size_t offset = 0; offset < filtered.size(); offset += 65535 )
+    {
+        const auto size = static_cast< uint16_t >(
+            std::min< size_t >( 65535, filtered.size() - offset ) );
+        const bool last = offset + size == filtered.size();
+
+        idat.insert( idat.end(),
+                     {static_cast< uint8_t >( last ? 1 : 0 ),
+                      static_cast< uint8_t >( size ), static_cast< uint8_t >( size >> 8 ),
+                      static_cast< uint8_t >( ~size ),
+                      static_cast< uint8_t >( ~size >> 8 )} );
+        idat.insert( idat.end(), filtered.begin() + offset,
+                     filtered.begin() + offset + size );
+    }
+
+    uint32_t s1 = 1, s2 = 0;
+    for ( const uint8_t b : filtered )
+    {
+        s1 = ( s1 + b ) % 65521;
+        s2 = ( s2 + s1 ) % 65521;
+    }
+    put_u32_be( idat, ( s2 << 16 ) | s1 );
+
+    write_png_chunk( os, "IDAT", idat );
+    write_png_chunk( os, "IEND", {} );
+}
+
+void write_results_csv( const asset_bench_context& ctx, const std::string& path )
+{
+    make_result_table( ctx ).write_csv( path );
+}
+
+void write_results_json( const asset_bench_context& ctx, const std::string& path )
+{
+    make_result_table( ctx ).write_json( path );
+}
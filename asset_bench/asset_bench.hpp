@@ -0,0 +1,79 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include "model.hpp"
+
+struct asset_bench_options
+{
+    std::string suite      = "all";
+    uint32_t warmup        = 2;
+    uint32_t repetitions   = 10;
+    uint64_t max_triangles = 10000000; //!< the model suite goes up to here
+    bool validate          = false;    //!< soft_raster writes its last frames as .pfm
+    std::string csv_path;              //!< empty disables the csv output
+    std::string json_path;             //!< empty disables the json output
+};
+
+// Wall clock time of the repetitions of one benchmark
+struct timing_stats
+{
+    uint32_t repetitions;
+    double min_ms;
+    double median_ms;
+    double mean_ms;
+    double stddev_ms;
+    double max_ms;
+};
+
+// items is the work done by one repetition in the unit of the benchmark (triangles,
+// pixels, calls), the throughput is items per second of the median.
+struct asset_bench_result
+{
+    std::string suite;
+    std::string name;
+    uint64_t items;
+    std::string unit;
+    timing_stats stats;
+    double throughput;
+};
+
+struct asset_bench_context
+{
+    asset_bench_options options;
+    std::vector< asset_bench_result > results;
+};
+
+// Calls run options.warmup times unmeasured and then options.repetitions times
+// measured, setup runs untimed before each of them. Logs and keeps the result.
+void measure( asset_bench_context& ctx, const char* suite, const std::string& name,
+              uint64_t items, const char* unit, const std::function< void() >& run,
+              const std::function< void() >& setup = {} );
+
+// Keeps the compiler from dropping work whose result is unused.
+void consume( uint64_t value );
+
+// A height field of about triangle_count triangles on a square grid, every vertex is
+// shared by up to six triangles like in a scanned or sculpted mesh. Normals are zero.
+model_data make_grid_model( uint64_t triangle_count );
+
+// The same grid as OBJ text with positions, texture coordinates and v/vt faces.
+void write_grid_obj( const std::string& path, uint64_t triangle_count );
+
+// An RGBA8 PNG of width x height noisy gradient pixels, stored without compression and
+// with the Sub filter on every row.
+void write_noise_png( const std::string& path, uint32_t width, uint32_t height );
+
+void write_results_csv( const asset_bench_context& ctx, const std::string& path );
+void write_results_json( const asset_bench_context& ctx, const std::string& path );
+
+void run_model_suite( asset_bench_context& ctx );
+void run_image_suite( asset_bench_context& ctx );
+void run_containers_suite( asset_bench_context& ctx );
+void run_logger_suite( asset_bench_context& ctx );
+void run_transforms_suite( asset_bench_context& ctx );
+void run_soft_raster_suite( asset_bench_context& ctx );
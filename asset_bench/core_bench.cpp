@@ -0,0 +1,197 @@
+#include "asset_bench.hpp"
+
+#include "frame_arena.hpp"
+#include "logger.hpp"
+#include "static_array.hpp"
+#include "examples/example4_transforms.hpp"
+
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+namespace
+{
+    constexpr int64_t ARENA_SIZE = 64 * 1024 * 1024;
+    using arena_t                = stack_allocator< ARENA_SIZE >;
+
+    constexpr int64_t MAX_ELEMENTS = 1 << 22;
+
+    // the temporaries of a frame, a sort key and a visibility entry per draw
+    constexpr uint32_t FRAMES           = 64;
+    constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+    using frame_arena_t                 = frame_arena< 32 * 1024 * 1024 >;
+
+    // swallows the log output, so only the formatting is measured
+    class null_buffer final : public std::streambuf
+    {
+      protected:
+        int_type overflow( int_type c ) override { return traits_type::not_eof( c ); }
+        std::streamsize xsputn( const char*, std::streamsize n ) override { return n; }
+    };
+} // namespace
+
+void run_containers_suite( asset_bench_context& ctx )
+{
+    log_result( "containers suite:" );
+
+    // every repetition starts from an empty allocator
+    const auto arena     = std::make_unique< arena_t >();
+    const auto new_arena = [&arena] { arena->reset(); };
+
+    for ( const uint32_t count : {1024u, 65536u, 262144u} )
+    {
+        // the mix of sizes and alignments the vulkan_data arrays ask for
+        measure(
+            ctx, "containers", "stack_allocator::allocate", count, "allocations",
+            [&arena, count] {
+                uint64_t sum = 0;
+                for ( uint32_t i = 0; i < count; ++i )
+                {
+                    const int64_t size      = 16 + ( i * 40 ) % 112;
+                    const int64_t alignment = int64_t{8} << ( i % 3 );
+                    sum += reinterpret_cast< uintptr_t >(
+                        arena->allocate( size, alignment ) );
+                }
+                consume( sum );
+            },
+            new_arena );
+    }
+
+    for ( const uint32_t count : {1024u, 65536u, 1048576u} )
+    {
+        measure(
+            ctx, "containers", "static_array::push_back", count, "elements",
+            [&arena, count] {
+                static_array< uint64_t, MAX_ELEMENTS, arena_t > array{arena.get()};
+                for ( uint32_t i = 0; i < count; ++i )
+                {
+                    array.push_back( uint64_t{i} );
+                }
+                consume( array[count - 1] );
+            },
+            new_arena );
+    }
+
+    const auto frame_arena = std::make_unique< frame_arena_t >();
+    frame_arena->initialize( FRAMES_IN_FLIGHT );
+
+    for ( const uint32_t draws : {256u, 4096u, 65536u} )
+    {
+        measure( ctx, "containers", "frame_arena", draws * FRAMES, "draws",
+                 [&frame_arena, draws] {
+                     uint64_t sum = 0;
+                     for ( uint32_t f = 0; f < FRAMES; ++f )
+                     {
+                         frame_arena->begin_frame( f % FRAMES_IN_FLIGHT );
+                         auto* keys    = frame_arena->allocate_array< uint64_t >( draws );
+                         auto* visible = frame_arena->allocate_array< uint32_t >( draws );
+                         keys[draws - 1]    = f;
+                         visible[draws - 1] = f;
+                         sum += keys[draws - 1] + visible[draws - 1];
+                     }
+                     consume( sum );
+                 } );
+
+        // what the same frames cost with fresh vectors
+        measure( ctx, "containers", "std::vector", draws * FRAMES, "draws", [draws] {
+            uint64_t sum = 0;
+            for ( uint32_t f = 0; f < FRAMES; ++f )
+            {
+                std::vector< uint64_t > keys( draws );
+                std::vector< uint32_t > visible( draws );
+                keys[draws - 1]    = f;
+                visible[draws - 1] = f;
+                sum += keys[draws - 1] + visible[draws - 1];
+            }
+            consume( sum );
+        } );
+    }
+
+    const frame_arena_stats stats = frame_arena->stats();
+    log_result( "\tframe arena: ", stats.high_water_mark, " of ", stats.capacity,
+                " bytes at most, ", stats.overflows, " overflows" );
+}
+
+void run_logger_suite( asset_bench_context& ctx )
+{
+    log_result( "logger suite:" );
+
+    null_buffer sink;
+
+    const auto log_frames = []( uint32_t count ) {
+        for ( uint32_t i = 0; i < count; ++i )
+        {
+            log( "frame ", i, ": ", 16.6f, " ms, ", 1024u, " draws" );
+        }
+    };
+
+    // Both fit into the ring of the logger, which starts empty. log is what the calling
+    // thread pays, log_flush adds the formatting on the background thread.
+    for ( const uint32_t count : {1000u, 4000u} )
+    {
+        log_flush();
+        auto* const stdout_buffer = std::cout.rdbuf( &sink );
+
+        measure(
+            ctx, "logger", "log", count, "calls",
+            [&log_frames, count] { log_frames( count ); }, log_flush );
+
+        measure(
+            ctx, "logger", "log_flush", count, "calls",
+            [&log_frames, count] {
+                log_frames( count );
+                log_flush();
+            },
+            log_flush );
+
+        log_flush();
+        std::cout.rdbuf( stdout_buffer );
+
+        // log_result() of the results went to the sink as well
+        for ( auto r = ctx.results.end() - 2; r != ctx.results.end(); ++r )
+        {
+            log_result( "\t", r->name, " ", count, ": median ", r->stats.median_ms,
+                        " ms, ", r->throughput, " calls/s" );
+        }
+    }
+
+    // what an enabled site costs while its category is filtered out at runtime
+    log_set_level( log_category::frame, log_level::error );
+
+    for ( const uint32_t count : {1000u, 1000000u} )
+    {
+        measure( ctx, "logger", "filtered", count, "calls", [count] {
+            for ( uint32_t i = 0; i < count; ++i )
+            {
+                NEO_LOG_INFO( frame, "frame ", i, ": ", 16.6f, " ms, ", 1024u, " draws" );
+            }
+        } );
+    }
+
+    log_set_level( log_category::frame, log_level::debug );
+
+    log_result( "\t", log_dropped_records(), " records dropped, ",
+                log_truncated_records(), " truncated" );
+}
+
+void run_transforms_suite( asset_bench_context& ctx )
+{
+    log_result( "transforms suite:" );
+
+    for ( const uint32_t count : {1000u, 100000u, 1000000u} )
+    {
+        // the matrices example4 builds every frame, one set per instance
+        measure( ctx, "transforms", "model_view_proj", count, "instances", [count] {
+            float sum = 0.0f;
+            for ( uint32_t i = 0; i < count; ++i )
+            {
+                const auto t = make_example4_transforms( i * 0.01f, i * 0.02f, i * 0.03f,
+                                                         16.0f / 9.0f );
+                const glm::mat4 mvp = t.proj * t.view * t.model;
+                sum += mvp[3][2];
+            }
+            consume( static_cast< uint64_t >( sum ) );
+        } );
+    }
+}
@@ -0,0 +1,24 @@
+#include "asset_bench.hpp"
+
+#include "image.hpp"
+#include "logger.hpp"
+
+#include <cstdio>
+
+void run_image_suite( asset_bench_context& ctx )
+{
+    log_result( "image suite:" );
+
+    for ( const uint32_t side : {256u, 1024u, 4096u} )
+    {
+        const std::string path = "asset_bench_" + std::to_string( side ) + ".png";
+        write_noise_png( path, side, side );
+
+        measure( ctx, "image", "load_image", uint64_t{side} * side, "pixels", [&path] {
+            const image img = load_image( path.c_str() );
+            consume( img.data.size() );
+        } );
+
+        std::remove( path.c_str() );
+    }
+}
@@ -0,0 +1,117 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "debug.hpp"
+#include "logger.hpp"
+
+#include "asset_bench.hpp"
+
+namespace
+{
+    asset_bench_options parse_options( int argc, char** argv )
+    {
+        asset_bench_options ret{};
+
+        for ( int i = 1; i < argc; ++i )
+        {
+            const bool has_value = i + 1 < argc;
+
+            if ( std::strcmp( argv[i], "--suite" ) == 0 && has_value )
+            {
+                ret.suite = argv[++i];
+            }
+            else if ( std::strcmp( argv[i], "--warmup" ) == 0 && has_value )
+            {
+                ret.warmup = static_cast< uint32_t >( std::atoi( argv[++i] ) );
+            }
+            else if ( std::strcmp( argv[i], "--repetitions" ) == 0 && has_value )
+            {
+                ret.repetitions = static_cast< uint32_t >( std::atoi( argv[++i] ) );
+            }
+            else if ( std::strcmp( argv[i], "--max-triangles" ) == 0 && has_value )
+            {
+                ret.max_triangles = std::strtoull( argv[++i], nullptr, 10 );
+            }
+            else if ( std::strcmp( argv[i], "--validate" ) == 0 )
+            {
+                ret.validate = true;
+            }
+            else if ( std::strcmp( argv[i], "--csv" ) == 0 && has_value )
+            {
+                ret.csv_path = argv[++i];
+            }
+            else if ( std::strcmp( argv[i], "--json" ) == 0 && has_value )
+            {
+                ret.json_path = argv[++i];
+            }
+            else
+            {
+                log( "usage: ", argv[0],
+                     " [--suite NAME] [--warmup N] [--repetitions N] [--max-triangles N]"
+                     " [--validate] [--csv file] [--json file]" );
+                log( "suites: all, model, image, containers, logger, transforms,"
+                     " soft_raster" );
+                exit( -1 );
+            }
+        }
+
+        NEO_ASSERT_ALWAYS( ret.repetitions > 0, "Need at least one repetition!" );
+
+        return ret;
+    }
+} // namespace
+
+// CPU side of the asset pipeline on synthetic inputs, runs without a GPU
+int main( int argc, char** argv )
+{
+    asset_bench_context ctx;
+    ctx.options = parse_options( argc, argv );
+
+    const auto run_suite = [&ctx]( const char* name ) {
+        return ctx.options.suite == "all" || ctx.options.suite == name;
+    };
+
+    if ( run_suite( "model" ) )
+    {
+        run_model_suite( ctx );
+    }
+
+    if ( run_suite( "image" ) )
+    {
+        run_image_suite( ctx );
+    }
+
+    if ( run_suite( "containers" ) )
+    {
+        run_containers_suite( ctx );
+    }
+
+    if ( run_suite( "logger" ) )
+    {
+        run_logger_suite( ctx );
+    }
+
+    if ( run_suite( "transforms" ) )
+    {
+        run_transforms_suite( ctx );
+    }
+
+    if ( run_suite( "soft_raster" ) )
+    {
+        run_soft_raster_suite( ctx );
+    }
+
+    if ( !ctx.options.csv_path.empty() )
+    {
+        write_results_csv( ctx, ctx.options.csv_path );
+    }
+
+    if ( !ctx.options.json_path.empty() )
+    {
+        write_results_json( ctx, ctx.options.json_path );
+    }
+
+    log( "End" );
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "asset_bench.hpp"
+
+#include "logger.hpp"
+
+#include "tiny_obj_loader.h"
+
+#include <cstdio>
+
+void run_model_suite( asset_bench_context& ctx )
+{
+    log_result( "model suite:" );
+
+    for ( uint64_t triangles = 1000; triangles <= ctx.options.max_triangles;
+          triangles *= 10 )
+    {
+        const std::string path = "asset_bench_" + std::to_string( triangles ) + ".obj";
+        write_grid_obj( path, triangles );
+
+        // tinyobjloader alone, load_model() minus both of them is the vertex dedup
+        measure( ctx, "model", "parse", triangles, "triangles", [&path] {
+            tinyobj::attrib_t attrib;
+            std::vector< tinyobj::shape_t > shapes;
+            std::vector< tinyobj::material_t > materials;
+            std::string warn, err;
+
+            tinyobj::LoadObj( &attrib, &shapes, &materials, &warn, &err, path.c_str() );
+            consume( attrib.vertices.size() );
+        } );
+
+        measure( ctx, "model", "load_model", triangles, "triangles", [&path] {
+            const model_data m = load_model( path.c_str() );
+            consume( m.vertex_data.size() );
+        } );
+
+        std::remove( path.c_str() );
+
+        const model_data grid = make_grid_model( triangles );
+        model_data input;
+
+        measure(
+            ctx, "model", "calculate_normals", triangles, "triangles",
+            [&input] {
+                input = calculate_normals( std::move( input ) );
+                consume( static_cast< uint64_t >( input.vertex_data[0].normal.y * 100 ) );
+            },
+            [&input, &grid] { input = grid; } );
+    }
+}
@@ -0,0 +1,89 @@
+#include "asset_bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "soft_rasterizer.hpp"
+
+#include <array>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    // Portable float map, bottom row first. Meant for diffing against a capture of
+    // example4's HDR target.
+    void write_pfm( const soft_rasterizer& r, const std::string& path )
+    {
+        FILE* f = fopen( path.c_str(), "wb" );
+        NEO_ASSERT_ALWAYS( f != nullptr, "Couldn't open ", path, " for writing!" );
+
+        fprintf( f, "PF\n%d %d\n-1.0\n", r.width(), r.height() );
+
+        for ( int32_t y = r.height() - 1; y >= 0; --y )
+        {
+            for ( int32_t x = 0; x < r.width(); ++x )
+            {
+                const glm::vec4& c = r.color()[size_t( y ) * r.width() + x];
+                fwrite( &c, sizeof( float ), 3, f );
+            }
+        }
+
+        fclose( f );
+    }
+} // namespace
+
+void run_soft_raster_suite( asset_bench_context& ctx )
+{
+    const std::array< std::pair< int32_t, int32_t >, 3 > resolutions = {
+        std::pair{1280, 720}, std::pair{1920, 1080}, std::pair{3840, 2160}};
+
+    const auto model   = load_model( "media/cat.obj" );
+    const auto texture = load_image( "media/cat.png" );
+
+    thread_pool pool;
+
+#ifdef __AVX2__
+    const char* path = "avx2";
+#else
+    const char* path = "scalar";
+#endif
+
+    log_result( "soft_raster suite: ", path, " on ", pool.thread_count() + 1,
+                " threads" );
+
+    for ( const auto& [width, height] : resolutions )
+    {
+        const float aspect = width / static_cast< float >( height );
+
+        soft_rasterizer rasterizer{pool, width, height};
+        soft_raster_stats totals{};
+        uint32_t frame = 0;
+
+        // same clear color as example4, the cat turns a bit every frame
+        measure( ctx, "soft_raster", "frame", uint64_t( width ) * height, "pixels", [&] {
+            const auto transforms =
+                make_example4_transforms( 0.0f, frame * 0.05f, 0.0f, aspect );
+
+            rasterizer.clear( glm::vec4( 0.0f, 0.1f, 0.0f, 1.0f ) );
+            const auto stats = rasterizer.draw( model, texture, transforms );
+
+            totals.triangles_rasterized += stats.triangles_rasterized;
+            totals.pixels_shaded += stats.pixels_shaded;
+            frame += 1;
+        } );
+
+        NEO_ASSERT_ALWAYS( totals.pixels_shaded > 0,
+                           "Software rasterizer drew nothing!" );
+
+        log_result( "\t", totals.triangles_rasterized / frame, " triangles rasterized, ",
+                    totals.pixels_shaded / frame, " pixels shaded per frame" );
+
+        if ( ctx.options.validate )
+        {
+            const std::string file = "soft_raster_" + std::to_string( width ) + "x"
+                                     + std::to_string( height ) + ".pfm";
+            write_pfm( rasterizer, file );
+            log_result( "\twrote last frame to ", file );
+        }
+    }
+}
@@ -0,0 +1,136 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "auto_exposure.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+
+namespace
+{
+    // Grey values spread over the luminance range of the histogram and a few black
+    // pixels for bin 0, so every part of both passes has something to do.
+    std::vector< float > make_hdr_stops( VkExtent2D extent )
+    {
+        std::mt19937 gen{4321};
+        std::uniform_real_distribution< float > stops( -12.0f, 4.0f );
+        std::uniform_real_distribution< float > tint( 0.5f, 1.5f );
+        std::uniform_real_distribution< float > black( 0.0f, 1.0f );
+
+        std::vector< float > ret( size_t{extent.width} * extent.height * 4 );
+
+        for ( size_t i = 0; i < ret.size(); i += 4 )
+        {
+            const float v = black( gen ) < 0.05f ? 0.0f : std::exp2( stops( gen ) );
+            ret[i + 0]    = v * tint( gen );
+            ret[i + 1]    = v;
+            ret[i + 2]    = v * tint( gen );
+            ret[i + 3]    = 1.0f;
+        }
+
+        return ret;
+    }
+
+    float relative_error( float a, float b )
+    {
+        return std::abs( a - b ) / std::max( std::abs( b ), 1.0f );
+    }
+
+    // Two frames, the second adapts from what the first left in the exposure buffer.
+    void validate( bench_context& ctx, auto_exposure& exposure, VkExtent2D extent,
+                   const std::vector< float >& pixels, const auto_exposure::settings& s )
+    {
+        constexpr float DT_S = 1.0f / 60.0f;
+
+        const auto w = static_cast< int32_t >( extent.width );
+        const auto h = static_cast< int32_t >( extent.height );
+
+        // the state initialize() starts from
+        float previous = 1.0f;
+
+        for ( uint32_t frame = 0; frame < 2; ++frame )
+        {
+            exposure.update( DT_S, 0 );
+
+            VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+            exposure.record( cmd, 0 );
+            ctx.vulkan.submit_one_time_commands( cmd );
+
+            const auto state = exposure.read_exposure_state();
+            const auto expected =
+                compute_auto_exposure_reference( pixels.data(), w, h, s, previous, DT_S );
+
+            const float err =
+                std::max( relative_error( state.average_luminance,
+                                          expected.average_luminance ),
+                          relative_error( state.exposure, expected.exposure ) );
+            log_result( "\tframe ", frame, " exposure ", state.exposure, ", expected ",
+                        expected.exposure, ", max relative error: ", err,
+                        err < 0.01f ? " ok" : " FAILED" );
+
+            previous = expected.average_luminance;
+        }
+    }
+} // namespace
+
+void run_auto_exposure_suite( bench_context& ctx, const bench_options& options )
+{
+    const std::array< VkExtent2D, 3 > resolutions = {
+        VkExtent2D{640, 360}, VkExtent2D{1920, 1080}, VkExtent2D{3840, 2160}};
+
+    log_result( "auto_exposure: ms for the histogram and the average pass, average of ",
+                options.iterations, " iterations" );
+
+    for ( const auto extent : resolutions )
+    {
+        const auto pixels = make_hdr_stops( extent );
+        image_data input =
+            create_rgba32f_image( ctx, extent, pixels, VK_IMAGE_USAGE_SAMPLED_BIT );
+
+        const auto_exposure::settings s{};
+
+        auto_exposure exposure{ctx.vulkan};
+        gpu_timer timer{ctx.vulkan};
+
+        exposure.initialize( input.image_view, VK_IMAGE_LAYOUT_GENERAL, extent, 1, s );
+        timer.initialize( options.iterations * 2 );
+
+        if ( options.validate )
+        {
+            validate( ctx, exposure, extent, pixels, s );
+        }
+
+        exposure.update( 1.0f / 60.0f, 0 );
+
+        VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+        timer.reset( cmd );
+
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            timer.write( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT );
+            exposure.record( cmd, 0 );
+            timer.write( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+        }
+
+        ctx.vulkan.submit_one_time_commands( cmd );
+
+        const auto ticks = timer.read();
+
+        double total_ms = 0.0;
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            total_ms += timer.ticks_to_ms( ticks[i * 2 + 1] - ticks[i * 2] );
+        }
+
+        const uint64_t size = uint64_t{extent.width} * extent.height;
+        report( ctx, {"auto_exposure", "histogram_average", size,
+                      total_ms / options.iterations, "ms"} );
+
+        timer.deinitialize();
+        exposure.deinitialize();
+        ctx.vulkan.destroy_image( input );
+    }
+}
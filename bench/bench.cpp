@@ -0,0 +1,385 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "result_table.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#include "glm/gtc/packing.hpp"
+
+namespace
+{
+    std::string version_string( uint32_t version )
+    {
+        return std::to_string( VK_VERSION_MAJOR( version ) ) + "."
+               + std::to_string( VK_VERSION_MINOR( version ) ) + "."
+               + std::to_string( VK_VERSION_PATCH( version ) );
+    }
+
+    // the ids are easier to look up in hex, as in the csv comments
+    std::string hex_string( uint32_t v )
+    {
+        std::ostringstream os;
+        os << "0x" << std::hex << v;
+        return os.str();
+    }
+
+    result_table make_result_table( const bench_context& ctx, bool hex_ids )
+    {
+        result_table ret;
+        ret.metadata_name = "device";
+        ret.columns       = {"suite", "name", "size", "value", "unit"};
+
+        for ( const auto& r : ctx.results )
+        {
+            ret.add_row( {r.suite, r.name, r.size, r.value, r.unit} );
+        }
+
+        // only the CPU suites ran
+        if ( !ctx.vulkan_initialized )
+        {
+            return ret;
+        }
+
+        const auto& p = ctx.vulkan.device_properties[ctx.vulkan.selected_device_idx];
+        ret.metadata  = {
+            {"name", p.deviceName},
+            {"vendor_id", hex_ids ? result_cell( hex_string( p.vendorID ) ) : p.vendorID},
+            {"device_id", hex_ids ? result_cell( hex_string( p.deviceID ) ) : p.deviceID},
+            {"driver_version", p.driverVersion},
+            {"api_version", version_string( p.apiVersion )},
+            {"timestamp_period", p.limits.timestampPeriod}};
+
+        return ret;
+    }
+} // namespace
+
+void gpu_timer::initialize( uint32_t max_queries )
+{
+    const auto& props =
+        m_vulkan_data.queue_family_properties[m_vulkan_data.selected_gfx_queue_idx];
+    NEO_ASSERT_ALWAYS( props.timestampValidBits > 0,
+                       "Timestamps are not supported on the selected queue!" );
+
+    m_max_queries  = max_queries;
+    m_used_queries = 0;
+    m_timestamp_period =
+        m_vulkan_data.device_properties[m_vulkan_data.selected_device_idx]
+            .limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo create_info = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                         nullptr,
+                                         0,
+                                         VK_QUERY_TYPE_TIMESTAMP,
+                                         max_queries,
+                                         0};
+
+    const auto res = vkCreateQueryPool( m_vulkan_data.logical_device, &create_info,
+                                        nullptr, &m_query_pool );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create query pool!" );
+}
+
+void gpu_timer::deinitialize()
+{
+    vkDestroyQueryPool( m_vulkan_data.logical_device, m_query_pool, nullptr );
+}
+
+void gpu_timer::reset( VkCommandBuffer cmd )
+{
+    vkCmdResetQueryPool( cmd, m_query_pool, 0, m_max_queries );
+    m_used_queries = 0;
+}
+
+uint32_t gpu_timer::write( VkCommandBuffer cmd, VkPipelineStageFlagBits stage )
+{
+    NEO_ASSERT_ALWAYS( m_used_queries < m_max_queries, "Out of timestamp queries!" );
+    vkCmdWriteTimestamp( cmd, stage, m_query_pool, m_used_queries );
+    return m_used_queries++;
+}
+
+std::vector< uint64_t > gpu_timer::read()
+{
+    std::vector< uint64_t > ret( m_used_queries );
+
+    if ( m_used_queries == 0 )
+    {
+        return ret;
+    }
+
+    const auto res = vkGetQueryPoolResults(
+        m_vulkan_data.logical_device, m_query_pool, 0, m_used_queries,
+        ret.size() * sizeof( uint64_t ), ret.data(), sizeof( uint64_t ),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't read timestamp queries!" );
+
+    return ret;
+}
+
+double gpu_timer::ticks_to_ms( uint64_t ticks ) const
+{
+    return static_cast< double >( ticks ) * m_timestamp_period * 1.0e-6;
+}
+
+buffer_data create_buffer_with_data( bench_context& ctx, const void* data,
+                                     VkDeviceSize size, VkBufferUsageFlags usage )
+{
+    auto& vd = ctx.vulkan;
+
+    buffer_data ret = vd.create_buffer( size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    buffer_data staging = vd.create_buffer(
+        size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+    void* mapped   = nullptr;
+    const auto res =
+        vkMapMemory( vd.logical_device, staging.memory, 0, size, 0, &mapped );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map staging memory!" );
+    std::memcpy( mapped, data, size );
+    vkUnmapMemory( vd.logical_device, staging.memory );
+
+    VkCommandBuffer cmd = vd.begin_one_time_commands();
+    const VkBufferCopy region{0, 0, size};
+    vkCmdCopyBuffer( cmd, staging.buffer, ret.buffer, 1, &region );
+    vd.submit_one_time_commands( cmd );
+
+    vd.destroy_buffer( staging );
+
+    return ret;
+}
+
+void read_buffer( bench_context& ctx, VkBuffer buffer, VkDeviceSize size, void* out )
+{
+    auto& vd = ctx.vulkan;
+
+    buffer_data staging = vd.create_buffer(
+        size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+    VkCommandBuffer cmd = vd.begin_one_time_commands();
+
+    const VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+                                  VK_ACCESS_SHADER_WRITE_BIT,
+                                  VK_ACCESS_TRANSFER_READ_BIT};
+    vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+                          nullptr );
+
+    const VkBufferCopy region{0, 0, size};
+    vkCmdCopyBuffer( cmd, buffer, staging.buffer, 1, &region );
+    vd.submit_one_time_commands( cmd );
+
+    void* mapped   = nullptr;
+    const auto res =
+        vkMapMemory( vd.logical_device, staging.memory, 0, size, 0, &mapped );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map staging memory!" );
+    std::memcpy( out, mapped, size );
+    vkUnmapMemory( vd.logical_device, staging.memory );
+
+    vd.destroy_buffer( staging );
+}
+
+image_data create_rgba32f_image( bench_context& ctx, VkExtent2D extent,
+                                 const std::vector< float >& pixels,
+                                 VkImageUsageFlags usage )
+{
+    auto& vd = ctx.vulkan;
+
+    const VkDeviceSize size = pixels.size() * sizeof( float );
+    NEO_ASSERT_ALWAYS( size == VkDeviceSize{extent.width} * extent.height * 16,
+                       "Pixel count doesn't match the image extent!" );
+
+    image_data ret = vd.create_image_2d( extent, VK_FORMAT_R32G32B32A32_SFLOAT,
+                                         usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT );
+
+    buffer_data staging = vd.create_buffer(
+        size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+    void* data     = nullptr;
+    const auto res = vkMapMemory( vd.logical_device, staging.memory, 0, size, 0, &data );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map staging memory!" );
+    std::memcpy( data, pixels.data(), size );
+    vkUnmapMemory( vd.logical_device, staging.memory );
+
+    VkCommandBuffer cmd = vd.begin_one_time_commands();
+
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                                    nullptr,
+                                    0,
+                                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                                    VK_IMAGE_LAYOUT_UNDEFINED,
+                                    VK_IMAGE_LAYOUT_GENERAL,
+                                    VK_QUEUE_FAMILY_IGNORED,
+                                    VK_QUEUE_FAMILY_IGNORED,
+                                    ret.image,
+                                    {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+
+    vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                          &barrier );
+
+    const VkBufferImageCopy region = {0,
+                                      0,
+                                      0,
+                                      {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+                                      {0, 0, 0},
+                                      {extent.width, extent.height, 1}};
+    vkCmdCopyBufferToImage( cmd, staging.buffer, ret.image, VK_IMAGE_LAYOUT_GENERAL, 1,
+                            &region );
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout     = VK_IMAGE_LAYOUT_GENERAL;
+
+    vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                          1, &barrier );
+
+    vd.submit_one_time_commands( cmd );
+    vd.destroy_buffer( staging );
+
+    return ret;
+}
+
+std::vector< float > read_rgba16f_image( bench_context& ctx, const image_data& image )
+{
+    auto& vd = ctx.vulkan;
+
+    const size_t pixel_count = size_t{image.extent.width} * image.extent.height;
+    const VkDeviceSize size  = pixel_count * sizeof( uint64_t );
+
+    buffer_data staging = vd.create_buffer(
+        size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+    VkCommandBuffer cmd = vd.begin_one_time_commands();
+
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                                    nullptr,
+                                    VK_ACCESS_SHADER_WRITE_BIT,
+                                    VK_ACCESS_TRANSFER_READ_BIT,
+                                    VK_IMAGE_LAYOUT_GENERAL,
+                                    VK_IMAGE_LAYOUT_GENERAL,
+                                    VK_QUEUE_FAMILY_IGNORED,
+                                    VK_QUEUE_FAMILY_IGNORED,
+                                    image.image,
+                                    {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+
+    vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                          &barrier );
+
+    const VkBufferImageCopy region = {0,
+                                      0,
+                                      0,
+                                      {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+                                      {0, 0, 0},
+                                      {image.extent.width, image.extent.height, 1}};
+    vkCmdCopyImageToBuffer( cmd, image.image, VK_IMAGE_LAYOUT_GENERAL, staging.buffer, 1,
+                            &region );
+
+    vd.submit_one_time_commands( cmd );
+
+    std::vector< uint64_t > packed( pixel_count );
+
+    void* data     = nullptr;
+    const auto res = vkMapMemory( vd.logical_device, staging.memory, 0, size, 0, &data );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map staging memory!" );
+    std::memcpy( packed.data(), data, size );
+    vkUnmapMemory( vd.logical_device, staging.memory );
+
+    vd.destroy_buffer( staging );
+
+    std::vector< float > ret( pixel_count * 4 );
+
+    for ( size_t i = 0; i < pixel_count; ++i )
+    {
+        const glm::vec4 c = glm::unpackHalf4x16( packed[i] );
+        std::memcpy( &ret[i * 4], &c, sizeof( float ) * 4 );
+    }
+
+    return ret;
+}
+
+float max_relative_error( const std::vector< float >& a, const std::vector< float >& b )
+{
+    NEO_ASSERT_ALWAYS( a.size() == b.size(), "Comparing results of different size!" );
+
+    float ret = 0.0f;
+
+    for ( size_t i = 0; i < a.size(); ++i )
+    {
+        const float denominator = std::max( std::abs( b[i] ), 1.0f );
+        ret                     = std::max( ret, std::abs( a[i] - b[i] ) / denominator );
+    }
+
+    return ret;
+}
+
+model_data make_scan_mesh( uint32_t rows, uint32_t cols )
+{
+    const float pi = 3.14159265358979f;
+
+    model_data ret;
+    ret.vertex_data.reserve( size_t{rows + 1} * ( cols + 1 ) );
+    ret.index_data.reserve( size_t{rows} * cols * 6 );
+
+    for ( uint32_t r = 0; r <= rows; ++r )
+    {
+        for ( uint32_t c = 0; c <= cols; ++c )
+        {
+            const float theta  = pi * r / rows;
+            const float phi    = 2.0f * pi * c / cols;
+            const float radius = 10.0f * ( 1.0f + 0.05f * std::sin( 8.0f * theta )
+                                                      * std::sin( 8.0f * phi ) );
+
+            vtx_t::vertex v;
+            v.position = radius * glm::vec3( std::sin( theta ) * std::cos( phi ),
+                                             std::cos( theta ),
+                                             std::sin( theta ) * std::sin( phi ) );
+            v.normal   = glm::normalize( v.position );
+            v.texcoord = glm::vec2( float( c ) / cols, float( r ) / rows );
+
+            ret.vertex_data.push_back( v );
+        }
+    }
+
+    for ( uint32_t r = 0; r < rows; ++r )
+    {
+        for ( uint32_t c = 0; c < cols; ++c )
+        {
+            const vtx_t::index a = r * ( cols + 1 ) + c;
+            const vtx_t::index b = a + 1;
+            const vtx_t::index d = a + cols + 1;
+            const vtx_t::index e = d + 1;
+
+            ret.index_data.insert( ret.index_data.end(), {a, b, d, b, e, d} );
+        }
+    }
+
+    return ret;
+}
+
+void report( bench_context& ctx, bench_result result )
+{
+    log_result( "\t", result.name, " ", result.size, ": ", result.value, " ",
+                result.unit );
+    ctx.results.push_back( std::move( result ) );
+}
+
+
+void write_results_csv( const bench_context& ctx, const std::string& path )
+{
+    make_result_table( ctx, true ).write_csv( path );
+}
+
+void write_results_json( const bench_context& ctx, const std::string& path )
+{
+    make_result_table( ctx, false ).write_json( path );
+}
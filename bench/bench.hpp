@@ -0,0 +1,117 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+#include "model.hpp"
+
+struct bench_options
+{
+    std::string suite   = "all";
+    uint32_t iterations = 20;
+    bool validate       = false;
+    std::string csv_path;  //!< empty disables the csv output
+    std::string json_path; //!< empty disables the json output
+};
+
+// One measured value, size is the problem size in the unit of the suite (elements,
+// pixels, bytes) and 0 where it doesn't apply.
+struct bench_result
+{
+    std::string suite;
+    std::string name;
+    uint64_t size;
+    double value;
+    std::string unit;
+};
+
+// Headless vulkan instance shared by the suites, created by the first one that needs the
+// GPU. The CPU only suites run on machines without any Vulkan device.
+struct bench_context
+{
+    bench_context()
+        : vulkan{&data.stack_alloc}
+    {
+    }
+
+    bench_context( const bench_context& ) = delete;
+    bench_context& operator=( const bench_context& ) = delete;
+
+    application_data data;
+    vulkan_data< application_data::stack_alloc_t > vulkan;
+    bool vulkan_initialized = false;
+
+    std::vector< bench_result > results;
+};
+
+// Timestamp queries on the graphics queue, results are read back blocking.
+class gpu_timer final
+{
+  public:
+    gpu_timer( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    void initialize( uint32_t max_queries );
+    void deinitialize();
+
+    void reset( VkCommandBuffer cmd );
+    uint32_t write( VkCommandBuffer cmd, VkPipelineStageFlagBits stage );
+
+    std::vector< uint64_t > read();
+
+    double ticks_to_ms( uint64_t ticks ) const;
+
+  private:
+    VkQueryPool m_query_pool;
+    uint32_t m_max_queries;
+    uint32_t m_used_queries;
+    float m_timestamp_period;
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
+
+// Device local buffer filled through a staging buffer, usage gets TRANSFER_DST added.
+buffer_data create_buffer_with_data( bench_context& ctx, const void* data,
+                                     VkDeviceSize size, VkBufferUsageFlags usage );
+
+// Blocking readback of size bytes, the buffer needs TRANSFER_SRC usage.
+void read_buffer( bench_context& ctx, VkBuffer buffer, VkDeviceSize size, void* out );
+
+// Device local RGBA32F image in GENERAL layout, filled with pixels.
+image_data create_rgba32f_image( bench_context& ctx, VkExtent2D extent,
+                                 const std::vector< float >& pixels,
+                                 VkImageUsageFlags usage );
+
+// Blocking readback of an RGBA16F image in GENERAL layout, converted to floats.
+std::vector< float > read_rgba16f_image( bench_context& ctx, const image_data& image );
+
+// Largest relative difference, denominators are clamped to 1.
+float max_relative_error( const std::vector< float >& a, const std::vector< float >& b );
+
+// A bumpy sphere of radius 10 around the origin with rows x cols quads, the kind of
+// dense and regular mesh a scan produces. Triangles wind so their normal points outwards.
+model_data make_scan_mesh( uint32_t rows, uint32_t cols );
+
+// Logs the result and keeps it for the csv / json output.
+void report( bench_context& ctx, bench_result result );
+
+// Results of all suites, prefixed with the properties of the selected device.
+void write_results_csv( const bench_context& ctx, const std::string& path );
+void write_results_json( const bench_context& ctx, const std::string& path );
+
+void run_image_filter_suite( bench_context& ctx, const bench_options& options );
+void run_auto_exposure_suite( bench_context& ctx, const bench_options& options );
+void run_primitives_suite( bench_context& ctx, const bench_options& options );
+void run_micro_suite( bench_context& ctx, const bench_options& options );
+void run_cpu_compute_suite( bench_context& ctx, const bench_options& options );
+void run_culling_suite( bench_context& ctx, const bench_options& options );
+void run_meshlet_suite( bench_context& ctx, const bench_options& options );
+void run_lod_suite( bench_context& ctx, const bench_options& options );
+void run_geometry_pool_suite( bench_context& ctx, const bench_options& options );
+void run_render_queue_suite( bench_context& ctx, const bench_options& options );
+void run_recording_suite( bench_context& ctx, const bench_options& options );
+void run_render_graph_suite( bench_context& ctx, const bench_options& options );
@@ -0,0 +1,183 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "cpu_kernels.hpp"
+#include "gpu_primitives.hpp"
+
+#include <array>
+#include <chrono>
+#include <random>
+
+namespace
+{
+    constexpr std::array< gpu_primitives::reduce_op, 3 > REDUCE_OPS = {
+        gpu_primitives::reduce_op::sum, gpu_primitives::reduce_op::min,
+        gpu_primitives::reduce_op::max};
+
+    // Average ms of options.iterations calls of f.
+    template < typename F > double time_ms( const bench_options& options, F&& f )
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            f();
+        }
+
+        const std::chrono::duration< double, std::milli > elapsed =
+            std::chrono::high_resolution_clock::now() - begin;
+
+        return elapsed.count() / options.iterations;
+    }
+
+    double melements_per_s( uint32_t count, double ms )
+    {
+        return ms > 0.0 ? count / ( ms * 1000.0 ) : 0.0;
+    }
+
+    // the reduction against the GPU, once a GPU suite created the device
+    bool validate_gpu_reduce( bench_context& ctx, cpu_compute& compute,
+                              const std::vector< uint32_t >& keys )
+    {
+        const auto count = static_cast< uint32_t >( keys.size() );
+
+        buffer_data input = create_buffer_with_data(
+            ctx, keys.data(), VkDeviceSize{count} * sizeof( uint32_t ),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT );
+        buffer_data output = ctx.vulkan.create_buffer(
+            sizeof( uint32_t ),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+        gpu_primitives primitives{ctx.vulkan};
+        primitives.initialize( count );
+
+        bool ok = true;
+
+        for ( const auto op : REDUCE_OPS )
+        {
+            primitives.reset();
+            VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+            primitives.record_reduce( cmd, op, input.buffer, output.buffer, count );
+            ctx.vulkan.submit_one_time_commands( cmd );
+
+            uint32_t gpu = 0;
+            read_buffer( ctx, output.buffer, sizeof( uint32_t ), &gpu );
+
+            const bool op_ok = cpu_reduce( compute, op, keys.data(), count ) == gpu;
+            ok &= op_ok;
+            log_result( "\tgpu reduce ", static_cast< uint32_t >( op ), ": ",
+                        op_ok ? "ok" : "FAILED" );
+        }
+
+        primitives.deinitialize();
+        ctx.vulkan.destroy_buffer( output );
+        ctx.vulkan.destroy_buffer( input );
+
+        return ok;
+    }
+
+    // CPU kernels against the plain references
+    void validate( bench_context& ctx, cpu_compute& compute,
+                   const std::vector< uint32_t >& keys )
+    {
+        const auto count = static_cast< uint32_t >( keys.size() );
+
+        bool ok = true;
+
+        for ( const auto op : REDUCE_OPS )
+        {
+            const uint32_t cpu       = cpu_reduce( compute, op, keys.data(), count );
+            const uint32_t reference = reduce_reference( op, keys.data(), count );
+
+            ok &= cpu == reference;
+            log_result( "\treduce ", static_cast< uint32_t >( op ), ": ",
+                        cpu == reference ? "ok" : "FAILED" );
+        }
+
+        if ( ctx.vulkan_initialized )
+        {
+            ok &= validate_gpu_reduce( ctx, compute, keys );
+        }
+
+        const size_t table_size = size_t{gpu_primitives::RADIX_DIGITS}
+                                  * gpu_primitives::sort_partitions( count );
+
+        for ( uint32_t shift = 0; shift < 32; shift += 8 )
+        {
+            std::vector< uint32_t > table( table_size );
+            std::vector< uint32_t > expected( table_size );
+
+            cpu_radix_histogram( compute, keys.data(), count, shift, table.data() );
+            radix_histogram_reference( keys.data(), count, shift, expected.data() );
+
+            ok &= ( table == expected );
+            log_result( "\tradix histogram shift ", shift, ": ",
+                        table == expected ? "ok" : "FAILED" );
+        }
+
+        NEO_ASSERT_ALWAYS( ok, "Validation of cpu kernels failed for ", count,
+                           " elements" );
+    }
+} // namespace
+
+void run_cpu_compute_suite( bench_context& ctx, const bench_options& options )
+{
+    const std::array< uint32_t, 4 > sizes = {1u << 16, 1u << 20, 1u << 22, 1u << 24};
+
+    thread_pool pool;
+    cpu_compute compute{pool};
+
+    log_result( "cpu_compute: million elements per second on ", pool.thread_count() + 1,
+                " threads, average of ", options.iterations, " iterations" );
+
+    std::mt19937 gen{1234};
+    std::uniform_int_distribution< uint32_t > dis;
+
+    for ( const uint32_t count : sizes )
+    {
+        std::vector< uint32_t > keys( count );
+        for ( auto& k : keys )
+        {
+            k = dis( gen );
+        }
+
+        if ( options.validate )
+        {
+            validate( ctx, compute, keys );
+        }
+
+        std::vector< uint32_t > table( size_t{gpu_primitives::RADIX_DIGITS}
+                                       * gpu_primitives::sort_partitions( count ) );
+
+        // keeps the reductions from being optimized away
+        volatile uint32_t sink = 0;
+
+        const double reduce_ms = time_ms( options, [&]() {
+            sink =
+                cpu_reduce( compute, gpu_primitives::reduce_op::sum, keys.data(), count );
+        } );
+
+        const double reduce_reference_ms = time_ms( options, [&]() {
+            sink = reduce_reference( gpu_primitives::reduce_op::sum, keys.data(), count );
+        } );
+
+        const double histogram_ms = time_ms( options, [&]() {
+            cpu_radix_histogram( compute, keys.data(), count, 0, table.data() );
+        } );
+
+        const double histogram_reference_ms = time_ms( options, [&]() {
+            radix_histogram_reference( keys.data(), count, 0, table.data() );
+        } );
+
+        report( ctx, {"cpu_compute", "reduce_sum", count,
+                      melements_per_s( count, reduce_ms ), "Melem/s"} );
+        report( ctx, {"cpu_compute", "reduce_sum_reference", count,
+                      melements_per_s( count, reduce_reference_ms ), "Melem/s"} );
+        report( ctx, {"cpu_compute", "radix_histogram", count,
+                      melements_per_s( count, histogram_ms ), "Melem/s"} );
+        report( ctx, {"cpu_compute", "radix_histogram_reference", count,
+                      melements_per_s( count, histogram_reference_ms ), "Melem/s"} );
+    }
+}
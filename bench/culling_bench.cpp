@@ -0,0 +1,294 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "instance_culling.hpp"
+#include "hiz_pyramid.hpp"
+#include "examples/example4_transforms.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+
+namespace
+{
+    bool translation_less( const glm::vec3& a, const glm::vec3& b )
+    {
+        return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+    }
+
+    // instance translations in a fixed order, to compare sets of visible transforms
+    std::vector< glm::vec3 > sorted_translations( const std::vector< glm::mat4 >& m )
+    {
+        std::vector< glm::vec3 > ret( m.size() );
+        std::transform( m.begin(), m.end(), ret.begin(),
+                        []( const glm::mat4& t ) { return glm::vec3( t[3] ); } );
+        std::sort( ret.begin(), ret.end(), translation_less );
+
+        return ret;
+    }
+
+    constexpr VkExtent2D DEPTH_EXTENT = {1280, 720};
+    constexpr float WALL_DISTANCE     = 40.0f;
+
+    // Depth buffer with an occluder covering the left half of the screen at
+    // WALL_DISTANCE in front of the camera, the right half is empty.
+    image_data create_wall_depth( bench_context& ctx, const glm::mat4& proj )
+    {
+        auto& vd = ctx.vulkan;
+
+        const float wall_depth = proj[2][2] + proj[3][2] / WALL_DISTANCE;
+
+        std::vector< float > pixels( size_t{DEPTH_EXTENT.width} * DEPTH_EXTENT.height );
+        for ( size_t i = 0; i < pixels.size(); ++i )
+        {
+            const bool is_left = i % DEPTH_EXTENT.width < DEPTH_EXTENT.width / 2;
+            pixels[i]          = is_left ? wall_depth : 1.0f;
+        }
+
+        image_data ret = vd.create_image_2d(
+            DEPTH_EXTENT, VK_FORMAT_D32_SFLOAT,
+            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VK_IMAGE_ASPECT_DEPTH_BIT );
+
+        const VkDeviceSize size = pixels.size() * sizeof( float );
+        buffer_data staging     = vd.create_buffer(
+            size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+        void* data     = nullptr;
+        const auto res =
+            vkMapMemory( vd.logical_device, staging.memory, 0, size, 0, &data );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map staging memory!" );
+        std::memcpy( data, pixels.data(), size );
+        vkUnmapMemory( vd.logical_device, staging.memory );
+
+        VkCommandBuffer cmd = vd.begin_one_time_commands();
+
+        VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                                        nullptr,
+                                        0,
+                                        VK_ACCESS_TRANSFER_WRITE_BIT,
+                                        VK_IMAGE_LAYOUT_UNDEFINED,
+                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                        VK_QUEUE_FAMILY_IGNORED,
+                                        VK_QUEUE_FAMILY_IGNORED,
+                                        ret.image,
+                                        {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1}};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                              1, &barrier );
+
+        const VkBufferImageCopy region = {0,
+                                          0,
+                                          0,
+                                          {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1},
+                                          {0, 0, 0},
+                                          {DEPTH_EXTENT.width, DEPTH_EXTENT.height, 1}};
+        vkCmdCopyBufferToImage( cmd, staging.buffer, ret.image,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region );
+
+        // the layout a scene pass leaves it in for the pyramid
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                              nullptr, 1, &barrier );
+
+        vd.submit_one_time_commands( cmd );
+        vd.destroy_buffer( staging );
+
+        return ret;
+    }
+
+    void record_culling( VkCommandBuffer cmd, instance_culling& culling,
+                         hiz_pyramid& pyramid )
+    {
+        culling.record_early( cmd, 0 );
+        pyramid.record( cmd );
+        culling.record_late( cmd, 0 );
+    }
+
+    void validate( bench_context& ctx, instance_culling& culling, hiz_pyramid& pyramid,
+                   const instance_scene& scene, const example4_transforms& transforms )
+    {
+        VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+        record_culling( cmd, culling, pyramid );
+        ctx.vulkan.submit_one_time_commands( cmd );
+
+        const instance_cull_stats stats = culling.read_stats( 0 );
+        const auto planes = extract_frustum_planes( transforms.proj * transforms.view );
+
+        // Spheres touching a plane may go either way with a different rounding. The
+        // result has to lie within a slightly grown frustum, and contain everything in a
+        // slightly shrunk one that can't be entirely behind the wall.
+        const auto reference = [&]( float margin, bool skip_hidden ) {
+            std::vector< glm::vec4 > bounds = scene.bounds();
+            for ( auto& b : bounds )
+            {
+                b.w += margin;
+            }
+
+            std::vector< glm::mat4 > ret;
+            for ( const auto i : cull_instances_reference( planes, bounds ) )
+            {
+                const glm::vec4 b = scene.bounds()[i];
+                const glm::vec3 c = transforms.view * glm::vec4( glm::vec3( b ), 1.0f );
+
+                const bool maybe_hidden =
+                    c.x + b.w < 0.01f && c.z - b.w > WALL_DISTANCE - 0.01f;
+
+                if ( !skip_hidden || !maybe_hidden )
+                {
+                    ret.push_back( scene.transforms()[i] );
+                }
+            }
+
+            return sorted_translations( ret );
+        };
+
+        std::vector< glm::mat4 > visible( stats.visible_early + stats.visible_late );
+        if ( stats.visible_early > 0 )
+        {
+            read_buffer( ctx, culling.early_transforms(),
+                         stats.visible_early * sizeof( glm::mat4 ), visible.data() );
+        }
+
+        if ( stats.visible_late > 0 )
+        {
+            read_buffer( ctx, culling.late_transforms(),
+                         stats.visible_late * sizeof( glm::mat4 ),
+                         visible.data() + stats.visible_early );
+        }
+
+        const auto result = sorted_translations( visible );
+        const auto inner  = reference( -1e-3f, true );
+        const auto outer  = reference( 1e-3f, false );
+
+        const bool ok = std::includes( result.begin(), result.end(), inner.begin(),
+                                       inner.end(), translation_less )
+                        && std::includes( outer.begin(), outer.end(), result.begin(),
+                                          result.end(), translation_less )
+                        && stats.instances == scene.count();
+
+        log_result( "\tcull: ", stats.frustum_culled, " outside, ", stats.occluded,
+                    " occluded, ", stats.visible_early, " + ", stats.visible_late,
+                    " visible of ", scene.count(), ", ", ok ? "ok" : "FAILED" );
+
+        NEO_ASSERT_ALWAYS( ok, "Validation of the instance culling failed for ",
+                           scene.count(), " instances" );
+    }
+} // namespace
+
+void run_culling_suite( bench_context& ctx, const bench_options& options )
+{
+    const std::array< uint32_t, 4 > sizes = {1u << 10, 1u << 14, 1u << 17, 1u << 20};
+
+    log_result( "culling: million instances per second and ms, average of ",
+                options.iterations, " iterations" );
+
+    // the cat example's camera, instances are scattered around its frustum and half of
+    // the screen is covered by a wall
+    const auto transforms =
+        make_example4_transforms( 0.0f, 0.0f, 0.0f, 1280.0f / 720.0f );
+
+    image_data depth = create_wall_depth( ctx, transforms.proj );
+
+    std::mt19937 gen{1234};
+    std::uniform_real_distribution< float > position_dis( -100.0f, 100.0f );
+    std::uniform_real_distribution< float > scale_dis( 0.05f, 0.2f );
+
+    for ( const uint32_t count : sizes )
+    {
+        instance_scene scene{ctx.vulkan};
+        hiz_pyramid pyramid{ctx.vulkan};
+        instance_culling culling{ctx.vulkan};
+        gpu_timer timer{ctx.vulkan};
+
+        // bounding radius of the cat
+        scene.initialize( count, 1, 30.0f );
+
+        for ( uint32_t i = 0; i < count; ++i )
+        {
+            const glm::vec3 position( position_dis( gen ), position_dis( gen ),
+                                      position_dis( gen ) );
+            scene.add( glm::translate( glm::mat4( 1.0f ), position )
+                       * glm::scale( glm::mat4( 1.0f ), glm::vec3( scale_dis( gen ) ) ) );
+        }
+
+        scene.upload( 0 );
+
+        pyramid.initialize( depth.image, VK_FORMAT_D32_SFLOAT,
+                            VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                            DEPTH_EXTENT );
+
+        // only the culling passes run, nothing is drawn, the wall is there from the start
+        culling.initialize( scene, pyramid, {lod_level{0, 0, 0.0f}}, 0, 1 );
+        culling.update( 0, transforms.view, transforms.proj, count );
+
+        {
+            VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+            pyramid.record( cmd );
+            ctx.vulkan.submit_one_time_commands( cmd );
+        }
+
+        timer.initialize( options.iterations * 4 );
+
+        if ( options.validate )
+        {
+            validate( ctx, culling, pyramid, scene, transforms );
+        }
+
+        {
+            VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+            timer.reset( cmd );
+
+            for ( uint32_t i = 0; i < options.iterations; ++i )
+            {
+                timer.write( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT );
+                culling.record_early( cmd, 0 );
+                timer.write( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+                pyramid.record( cmd );
+                timer.write( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+                culling.record_late( cmd, 0 );
+                timer.write( cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT );
+            }
+
+            ctx.vulkan.submit_one_time_commands( cmd );
+        }
+
+        const auto ticks = timer.read();
+
+        std::array< double, 3 > total_ms = {};
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            for ( uint32_t pass = 0; pass < total_ms.size(); ++pass )
+            {
+                total_ms[pass] +=
+                    timer.ticks_to_ms( ticks[i * 4 + pass + 1] - ticks[i * 4 + pass] );
+            }
+        }
+
+        const auto rate = [count, &options]( double ms ) {
+            const double avg_ms = ms / options.iterations;
+            return avg_ms > 0.0 ? count / ( avg_ms * 1000.0 ) : 0.0;
+        };
+
+        report( ctx, {"culling", "early_cull", count, rate( total_ms[0] ), "Minst/s"} );
+        report( ctx, {"culling", "hiz_build", count, total_ms[1] / options.iterations,
+                      "ms"} );
+        report( ctx, {"culling", "late_cull", count, rate( total_ms[2] ), "Minst/s"} );
+
+        timer.deinitialize();
+        culling.deinitialize();
+        pyramid.deinitialize();
+        scene.deinitialize();
+    }
+
+    ctx.vulkan.destroy_image( depth );
+}
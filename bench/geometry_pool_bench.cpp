@@ -0,0 +1,144 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "geometry_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t MESHES = 64;
+
+    // every pooled mesh holds what was added, at the place its range says
+    void validate( bench_context& ctx, const geometry_pool& pool, const model_data& mesh,
+                   const std::vector< geometry_pool::handle >& handles,
+                   uint32_t max_vertices, uint32_t max_indices )
+    {
+        std::vector< vtx_t::vertex > vertices( max_vertices );
+        std::vector< vtx_t::index > indices( max_indices );
+
+        read_buffer( ctx, pool.vertex_buffer(), vertices.size() * sizeof( vtx_t::vertex ),
+                     vertices.data() );
+        read_buffer( ctx, pool.index_buffer(), indices.size() * sizeof( vtx_t::index ),
+                     indices.data() );
+
+        bool ok = pool.mesh_count() == handles.size();
+
+        for ( size_t i = 0; ok && i < handles.size(); ++i )
+        {
+            const auto& range = pool.range( handles[i] );
+
+            ok = range.vertex_count == mesh.vertex_data.size()
+                 && range.index_count == mesh.index_data.size() && range.lods.size() == 1
+                 && range.lods[0].first_index == range.first_index
+                 && memcmp( vertices.data() + range.vertex_offset,
+                            mesh.vertex_data.data(),
+                            mesh.vertex_data.size() * sizeof( vtx_t::vertex ) )
+                        == 0
+                 && std::equal( mesh.index_data.begin(), mesh.index_data.end(),
+                                indices.begin() + range.first_index );
+        }
+
+        log_result( "\tpool: ", pool.mesh_count(), " meshes in ", pool.fragments(),
+                    " fragments, ", ok ? "ok" : "FAILED" );
+
+        NEO_ASSERT_ALWAYS( ok, "Validation of the geometry pool failed for ",
+                           mesh.index_data.size() / 3, " triangles per mesh" );
+    }
+} // namespace
+
+void run_geometry_pool_suite( bench_context& ctx, const bench_options& options )
+{
+    // rows x cols quads of each of the streamed meshes
+    const std::array< std::array< uint32_t, 2 >, 3 > sizes = {
+        {{8, 16}, {32, 64}, {128, 256}}};
+
+    // every submit waits for the queue, a few rounds are enough
+    const uint32_t iterations = std::min( options.iterations, 5u );
+
+    log_result( "geometry_pool: MB/s streaming ", MESHES, " meshes in, ms to compact "
+                "after removing every other one, average of ",
+                iterations, " iterations" );
+
+    for ( const auto& size : sizes )
+    {
+        const model_data mesh = make_scan_mesh( size[0], size[1] );
+
+        const auto vertex_count = static_cast< uint32_t >( mesh.vertex_data.size() );
+        const auto index_count  = static_cast< uint32_t >( mesh.index_data.size() );
+        const uint32_t max_vertices = vertex_count * MESHES;
+        const uint32_t max_indices  = index_count * MESHES;
+
+        const uint64_t bytes = uint64_t{MESHES}
+                               * ( mesh.vertex_data.size() * sizeof( vtx_t::vertex )
+                                   + mesh.index_data.size() * sizeof( vtx_t::index ) );
+
+        geometry_pool pool{ctx.vulkan};
+        pool.initialize( max_vertices, max_indices );
+
+        double add_ms     = 0.0;
+        double compact_ms = 0.0;
+
+        for ( uint32_t i = 0; i < iterations; ++i )
+        {
+            std::vector< geometry_pool::handle > handles;
+
+            const auto begin = std::chrono::high_resolution_clock::now();
+            for ( uint32_t m = 0; m < MESHES; ++m )
+            {
+                handles.push_back( pool.add( mesh ) );
+                NEO_ASSERT_ALWAYS( handles.back() != geometry_pool::INVALID_HANDLE,
+                                   "The geometry pool ran out of space" );
+            }
+            const auto added = std::chrono::high_resolution_clock::now();
+
+            std::vector< geometry_pool::handle > kept;
+            for ( uint32_t m = 0; m < MESHES; ++m )
+            {
+                if ( m % 2 == 0 )
+                {
+                    pool.remove( handles[m] );
+                }
+                else
+                {
+                    kept.push_back( handles[m] );
+                }
+            }
+
+            const auto compact_begin = std::chrono::high_resolution_clock::now();
+            pool.compact();
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            const std::chrono::duration< double, std::milli > add_elapsed = added - begin;
+            const std::chrono::duration< double, std::milli > compact_elapsed =
+                end - compact_begin;
+
+            add_ms += add_elapsed.count();
+            compact_ms += compact_elapsed.count();
+
+            if ( options.validate && i == 0 )
+            {
+                validate( ctx, pool, mesh, kept, max_vertices, max_indices );
+            }
+
+            for ( const auto h : kept )
+            {
+                pool.remove( h );
+            }
+        }
+
+        const uint64_t triangles = mesh.index_data.size() / 3;
+        const double avg_add_ms  = add_ms / iterations;
+
+        report( ctx, {"geometry_pool", "add", triangles,
+                      avg_add_ms > 0.0 ? bytes / ( avg_add_ms * 1000.0 ) : 0.0, "MB/s"} );
+        report( ctx,
+                {"geometry_pool", "compact", triangles, compact_ms / iterations, "ms"} );
+
+        pool.deinitialize();
+    }
+}
@@ -0,0 +1,144 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "image_filter.hpp"
+
+#include <array>
+#include <random>
+#include <string>
+
+namespace
+{
+    std::vector< float > make_hdr_noise( VkExtent2D extent )
+    {
+        std::mt19937 gen{1234};
+        std::uniform_real_distribution< float > dis( 0.0f, 4.0f );
+
+        std::vector< float > ret( size_t{extent.width} * extent.height * 4 );
+
+        for ( auto& v : ret )
+        {
+            v = dis( gen );
+        }
+
+        return ret;
+    }
+
+    void validate( bench_context& ctx, image_filter& filter, const image_data& input,
+                   const std::vector< float >& pixels )
+    {
+        const auto& s = filter.get_settings();
+        const auto w  = static_cast< int32_t >( input.extent.width );
+        const auto h  = static_cast< int32_t >( input.extent.height );
+
+        VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+        filter.record_blur( cmd );
+        filter.record_bloom( cmd );
+        ctx.vulkan.submit_one_time_commands( cmd );
+
+        {
+            std::vector< float > expected( pixels.size() );
+            blur_reference( pixels.data(), w, h, s.blur_radius, s.blur_sigma,
+                            expected.data() );
+
+            const float err =
+                max_relative_error( read_rgba16f_image( ctx, filter.blur_output() ),
+                                    expected );
+            log_result( "\tblur max relative error: ", err,
+                        err < 0.01f ? " ok" : " FAILED" );
+        }
+
+        // with a single level bloom_output is the thresholded downsample of the input
+        if ( s.bloom_levels == 1 )
+        {
+            std::vector< float > expected( size_t( ( w + 1 ) / 2 ) * ( ( h + 1 ) / 2 )
+                                           * 4 );
+            bloom_downsample_reference( pixels.data(), w, h, s.bloom_threshold,
+                                        expected.data() );
+
+            const float err =
+                max_relative_error( read_rgba16f_image( ctx, filter.bloom_output() ),
+                                    expected );
+            log_result( "\tdownsample max relative error: ", err,
+                        err < 0.01f ? " ok" : " FAILED" );
+        }
+    }
+} // namespace
+
+void run_image_filter_suite( bench_context& ctx, const bench_options& options )
+{
+    const std::array< VkExtent2D, 4 > resolutions = {
+        VkExtent2D{640, 360}, VkExtent2D{1280, 720}, VkExtent2D{1920, 1080},
+        VkExtent2D{3840, 2160}};
+
+    log_result( "image_filter: ms per pass, average of ", options.iterations,
+                " iterations" );
+
+    for ( const auto extent : resolutions )
+    {
+        const auto pixels = make_hdr_noise( extent );
+        image_data input  = create_rgba32f_image( ctx, extent, pixels,
+                                                 VK_IMAGE_USAGE_SAMPLED_BIT
+                                                     | VK_IMAGE_USAGE_STORAGE_BIT );
+
+        image_filter filter{ctx.vulkan};
+        gpu_timer timer{ctx.vulkan};
+
+        image_filter::settings s{};
+        if ( options.validate )
+        {
+            // a single level keeps the downsample output comparable to the reference
+            s.bloom_levels = 1;
+        }
+
+        filter.initialize( input.image_view, VK_IMAGE_LAYOUT_GENERAL, extent, s );
+        timer.initialize( options.iterations * 4 );
+
+        if ( options.validate )
+        {
+            validate( ctx, filter, input, pixels );
+        }
+
+        VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+        timer.reset( cmd );
+
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            timer.write( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT );
+            filter.record_blur_horizontal( cmd );
+            timer.write( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+            filter.record_blur_vertical( cmd );
+            timer.write( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+            filter.record_bloom( cmd );
+            timer.write( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+        }
+
+        ctx.vulkan.submit_one_time_commands( cmd );
+
+        const auto ticks = timer.read();
+
+        std::array< double, 3 > total_ms = {};
+
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            for ( uint32_t p = 0; p < total_ms.size(); ++p )
+            {
+                total_ms[p] +=
+                    timer.ticks_to_ms( ticks[i * 4 + p + 1] - ticks[i * 4 + p] );
+            }
+        }
+
+        const double n          = options.iterations;
+        const uint64_t size     = uint64_t{extent.width} * extent.height;
+        const std::string bloom = "bloom_" + std::to_string( s.bloom_levels ) + "_levels";
+
+        report( ctx, {"image_filter", "blur_h", size, total_ms[0] / n, "ms"} );
+        report( ctx, {"image_filter", "blur_v", size, total_ms[1] / n, "ms"} );
+        report( ctx, {"image_filter", bloom, size, total_ms[2] / n, "ms"} );
+
+        timer.deinitialize();
+        filter.deinitialize();
+        ctx.vulkan.destroy_image( input );
+    }
+}
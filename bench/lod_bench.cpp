@@ -0,0 +1,107 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "mesh_lod.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+namespace
+{
+    // Every level draws existing vertices with proper triangles, gets smaller and
+    // doesn't claim to be more accurate than the one before.
+    void validate( const model_data& model )
+    {
+        bool ok = !model.lods.empty() && model.lods[0].first_index == 0
+                  && model.lods[0].error == 0.0f;
+
+        for ( size_t l = 0; ok && l < model.lods.size(); ++l )
+        {
+            const lod_level& lod = model.lods[l];
+
+            ok = lod.index_count % 3 == 0
+                 && lod.first_index + lod.index_count <= model.index_data.size();
+
+            if ( ok && l > 0 )
+            {
+                ok = lod.index_count < model.lods[l - 1].index_count
+                     && lod.error >= model.lods[l - 1].error;
+            }
+
+            const uint32_t end = lod.first_index + lod.index_count;
+            for ( uint32_t i = lod.first_index; ok && i < end; i += 3 )
+            {
+                const auto a = model.index_data[i];
+                const auto b = model.index_data[i + 1];
+                const auto c = model.index_data[i + 2];
+
+                ok = a != b && b != c && a != c
+                     && std::max( std::max( a, b ), c ) < model.vertex_data.size();
+            }
+        }
+
+        log_result( "\tchain: ", model.lods.size(), " levels, ", ok ? "ok" : "FAILED" );
+
+        NEO_ASSERT_ALWAYS( ok, "Validation of the LOD chain failed for ",
+                           model.lods.empty() ? 0 : model.lods[0].index_count / 3,
+                           " triangles" );
+    }
+} // namespace
+
+void run_lod_suite( bench_context& ctx, const bench_options& options )
+{
+    std::vector< model_data > meshes;
+    meshes.push_back( load_model( "media/cat.obj" ) );
+    meshes.push_back( make_scan_mesh( 128, 256 ) );
+    meshes.push_back( make_scan_mesh( 256, 512 ) );
+
+    thread_pool pool;
+
+    // cooking takes a while, a few runs are enough
+    const uint32_t iterations = std::min( options.iterations, 3u );
+
+    log_result( "lod: ms to build a chain, % of the triangles and error in model "
+                "units per level, average of ",
+                iterations, " iterations" );
+
+    for ( const auto& mesh : meshes )
+    {
+        const uint64_t triangles = mesh.index_data.size() / 3;
+
+        model_data chain;
+        double build_ms = 0.0;
+
+        for ( uint32_t i = 0; i < iterations; ++i )
+        {
+            chain = mesh;
+
+            const auto begin = std::chrono::high_resolution_clock::now();
+            build_lod_chain( chain, pool );
+            const std::chrono::duration< double, std::milli > elapsed =
+                std::chrono::high_resolution_clock::now() - begin;
+
+            build_ms += elapsed.count();
+        }
+
+        report( ctx, {"lod", "build", triangles, build_ms / iterations, "ms"} );
+
+        for ( size_t l = 1; l < chain.lods.size(); ++l )
+        {
+            const std::string level = "level" + std::to_string( l );
+
+            report( ctx, {"lod", level + "_triangles", triangles,
+                          100.0 * chain.lods[l].index_count / mesh.index_data.size(),
+                          "%"} );
+            report( ctx, {"lod", level + "_error", triangles, chain.lods[l].error,
+                          "units"} );
+        }
+
+        if ( options.validate )
+        {
+            validate( chain );
+        }
+    }
+}
@@ -0,0 +1,160 @@
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "vulkan.hpp"
+
+#include "bench.hpp"
+
+namespace
+{
+    bench_options parse_options( int argc, char** argv )
+    {
+        bench_options ret{};
+
+        for ( int i = 1; i < argc; ++i )
+        {
+            const bool has_value = i + 1 < argc;
+
+            if ( std::strcmp( argv[i], "--suite" ) == 0 && has_value )
+            {
+                ret.suite = argv[++i];
+            }
+            else if ( std::strcmp( argv[i], "--iterations" ) == 0 && has_value )
+            {
+                ret.iterations = static_cast< uint32_t >( std::atoi( argv[++i] ) );
+            }
+            else if ( std::strcmp( argv[i], "--csv" ) == 0 && has_value )
+            {
+                ret.csv_path = argv[++i];
+            }
+            else if ( std::strcmp( argv[i], "--json" ) == 0 && has_value )
+            {
+                ret.json_path = argv[++i];
+            }
+            else if ( std::strcmp( argv[i], "--validate" ) == 0 )
+            {
+                ret.validate = true;
+            }
+            else
+            {
+                log( "usage: ", argv[0],
+                     " [--suite NAME] [--iterations N] [--validate] [--csv file]"
+                     " [--json file]" );
+                log( "suites: all, image_filter, auto_exposure, primitives, micro,"
+                     " cpu_compute, culling, meshlets, lod, geometry_pool,"
+                     " render_queue, recording, render_graph" );
+                exit( -1 );
+            }
+        }
+
+        NEO_ASSERT_ALWAYS( ret.iterations > 0, "Need at least one iteration!" );
+
+        return ret;
+    }
+} // namespace
+
+int main( int argc, char** argv )
+{
+    const bench_options options = parse_options( argc, argv );
+
+    // a few MB of stack allocator, keep it off the stack
+    auto ctx = std::make_unique< bench_context >();
+
+    const auto run_suite = [&options]( const char* name ) {
+        return options.suite == "all" || options.suite == name;
+    };
+
+    // only once a GPU suite runs, cpu_compute, lod and render_queue run on machines
+    // without a Vulkan device
+    const auto run_gpu_suite = [&ctx, &run_suite]( const char* name ) {
+        if ( run_suite( name ) && !ctx->vulkan_initialized )
+        {
+            initialize_vulkan_headless( ctx->vulkan );
+            ctx->vulkan_initialized = true;
+        }
+
+        return run_suite( name );
+    };
+
+    if ( run_gpu_suite( "image_filter" ) )
+    {
+        run_image_filter_suite( *ctx, options );
+    }
+
+    if ( run_gpu_suite( "auto_exposure" ) )
+    {
+        run_auto_exposure_suite( *ctx, options );
+    }
+
+    if ( run_gpu_suite( "primitives" ) )
+    {
+        run_primitives_suite( *ctx, options );
+    }
+
+    if ( run_gpu_suite( "micro" ) )
+    {
+        run_micro_suite( *ctx, options );
+    }
+
+    if ( run_suite( "cpu_compute" ) )
+    {
+        run_cpu_compute_suite( *ctx, options );
+    }
+
+    if ( run_gpu_suite( "culling" ) )
+    {
+        run_culling_suite( *ctx, options );
+    }
+
+    if ( run_gpu_suite( "meshlets" ) )
+    {
+        run_meshlet_suite( *ctx, options );
+    }
+
+    if ( run_suite( "lod" ) )
+    {
+        run_lod_suite( *ctx, options );
+    }
+
+    if ( run_gpu_suite( "geometry_pool" ) )
+    {
+        run_geometry_pool_suite( *ctx, options );
+    }
+
+    if ( run_suite( "render_queue" ) )
+    {
+        run_render_queue_suite( *ctx, options );
+    }
+
+    if ( run_gpu_suite( "recording" ) )
+    {
+        run_recording_suite( *ctx, options );
+    }
+
+    if ( run_gpu_suite( "render_graph" ) )
+    {
+        run_render_graph_suite( *ctx, options );
+    }
+
+    if ( !options.csv_path.empty() )
+    {
+        write_results_csv( *ctx, options.csv_path );
+    }
+
+    if ( !options.json_path.empty() )
+    {
+        write_results_json( *ctx, options.json_path );
+    }
+
+    if ( ctx->vulkan_initialized )
+    {
+        destroy_vulkan_headless( ctx->vulkan );
+    }
+
+    log( "End" );
+
+    return 0;
+}
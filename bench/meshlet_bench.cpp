@@ -0,0 +1,183 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "meshlet_culling.hpp"
+#include "thread_pool.hpp"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+namespace
+{
+    using triangle = std::array< vtx_t::index, 3 >;
+
+    // the triangles of an index list, in a fixed order
+    std::vector< triangle > sorted_triangles( const vtx_t::index* indices, size_t count )
+    {
+        std::vector< triangle > ret( count / 3 );
+        for ( size_t i = 0; i < ret.size(); ++i )
+        {
+            ret[i] = {indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2]};
+        }
+        std::sort( ret.begin(), ret.end() );
+
+        return ret;
+    }
+
+    void validate( bench_context& ctx, meshlet_culling& culling, const model_data& mesh,
+                   const glm::mat4& model, const glm::mat4& view, const glm::mat4& proj )
+    {
+        VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+        culling.record( cmd, 0 );
+        ctx.vulkan.submit_one_time_commands( cmd );
+
+        meshlet_culling::cull_state state;
+        read_buffer( ctx, culling.state(), sizeof( state ), &state );
+
+        std::vector< vtx_t::index > indices( state.draw.indexCount );
+        if ( !indices.empty() )
+        {
+            read_buffer( ctx, culling.indices(), indices.size() * sizeof( vtx_t::index ),
+                         indices.data() );
+        }
+
+        const auto planes = extract_frustum_planes( proj * view * model );
+        const glm::vec3 camera =
+            glm::inverse( view * model ) * glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f );
+
+        // Meshlets touching a plane or on the edge of their cone may go either way with a
+        // different rounding. The result has to contain everything kept with slightly
+        // smaller bounds, and lie within what is kept with slightly bigger ones.
+        const auto reference = [&]( float margin ) {
+            std::vector< vtx_t::index > ret;
+            for ( const auto i :
+                  cull_meshlets_reference( mesh.meshlets, planes, camera, margin ) )
+            {
+                const meshlet& m = mesh.meshlets[i];
+                const auto first = mesh.index_data.begin() + m.first_index;
+                ret.insert( ret.end(), first, first + m.triangle_count * 3 );
+            }
+
+            return sorted_triangles( ret.data(), ret.size() );
+        };
+
+        const auto result = sorted_triangles( indices.data(), indices.size() );
+        const auto inner  = reference( -1e-3f );
+        const auto outer  = reference( 1e-3f );
+
+        const bool ok =
+            std::includes( result.begin(), result.end(), inner.begin(), inner.end() )
+            && std::includes( outer.begin(), outer.end(), result.begin(), result.end() )
+            && std::adjacent_find( result.begin(), result.end() ) == result.end()
+            && state.draw.instanceCount == 1;
+
+        log_result( "\tcull: ", state.visible_meshlets, " of ", culling.meshlet_count(),
+                    " meshlets, ", result.size(), " of ", mesh.index_data.size() / 3,
+                    " triangles, ", ok ? "ok" : "FAILED" );
+
+        NEO_ASSERT_ALWAYS( ok, "Validation of the meshlet culling failed for ",
+                           mesh.index_data.size() / 3, " triangles" );
+    }
+} // namespace
+
+void run_meshlet_suite( bench_context& ctx, const bench_options& options )
+{
+    // rows x cols quads, two triangles each
+    const std::array< std::array< uint32_t, 2 >, 3 > sizes = {
+        {{128, 256}, {256, 512}, {512, 1024}}};
+
+    log_result( "meshlets: ms to build, million triangles per second and % of triangles "
+                "kept, average of ",
+                options.iterations, " iterations" );
+
+    // close enough that part of the sphere is outside of the frustum, about half of the
+    // rest faces away
+    const glm::mat4 view = glm::lookAtLH( glm::vec3( 0.0f, 0.0f, -15.0f ),
+                                          glm::vec3( 0.0f ),
+                                          glm::vec3( 0.0f, 1.0f, 0.0f ) );
+    const glm::mat4 proj =
+        glm::perspectiveLH_ZO( glm::radians( 60.0f ), 1280.0f / 720.0f, 0.1f, 100.0f );
+    const glm::mat4 model =
+        glm::rotate( glm::mat4( 1.0f ), glm::radians( 30.0f ),
+                     glm::normalize( glm::vec3( 1.0f, 1.0f, 0.0f ) ) );
+
+    thread_pool pool;
+
+    for ( const auto& size : sizes )
+    {
+        model_data mesh          = make_scan_mesh( size[0], size[1] );
+        const uint64_t triangles = mesh.index_data.size() / 3;
+
+        // the build reorders the index data, it starts over from the same mesh each time
+        const std::vector< vtx_t::index > original = mesh.index_data;
+
+        double build_ms = 0.0;
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            mesh.index_data = original;
+            mesh.meshlets.clear();
+
+            const auto begin = std::chrono::high_resolution_clock::now();
+            build_meshlets( mesh, pool );
+            const std::chrono::duration< double, std::milli > elapsed =
+                std::chrono::high_resolution_clock::now() - begin;
+
+            build_ms += elapsed.count();
+        }
+
+        report( ctx,
+                {"meshlets", "build", triangles, build_ms / options.iterations, "ms"} );
+
+        meshlet_culling culling{ctx.vulkan};
+        gpu_timer timer{ctx.vulkan};
+
+        culling.initialize( mesh, 1 );
+        culling.update( 0, model, view, proj );
+
+        timer.initialize( options.iterations * 2 );
+
+        if ( options.validate )
+        {
+            validate( ctx, culling, mesh, model, view, proj );
+        }
+
+        {
+            VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+            timer.reset( cmd );
+
+            for ( uint32_t i = 0; i < options.iterations; ++i )
+            {
+                timer.write( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT );
+                culling.record( cmd, 0 );
+                timer.write( cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT );
+            }
+
+            ctx.vulkan.submit_one_time_commands( cmd );
+        }
+
+        const auto ticks = timer.read();
+
+        double cull_ms = 0.0;
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            cull_ms += timer.ticks_to_ms( ticks[i * 2 + 1] - ticks[i * 2] );
+        }
+
+        const double avg_ms = cull_ms / options.iterations;
+        report( ctx, {"meshlets", "cull", triangles,
+                      avg_ms > 0.0 ? triangles / ( avg_ms * 1000.0 ) : 0.0, "Mtri/s"} );
+
+        meshlet_culling::cull_state state;
+        read_buffer( ctx, culling.state(), sizeof( state ), &state );
+
+        report( ctx, {"meshlets", "kept_triangles", triangles,
+                      100.0 * state.draw.indexCount / mesh.index_data.size(), "%"} );
+
+        timer.deinitialize();
+        culling.deinitialize();
+    }
+}
@@ -0,0 +1,403 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <string>
+
+namespace
+{
+    constexpr uint32_t GROUP_SIZE       = 256;
+    constexpr uint32_t ITEMS_PER_THREAD = 16;
+    constexpr uint32_t MAX_GROUPS       = 65535;
+    constexpr VkDeviceSize BUFFER_SIZE  = 64 * 1024 * 1024;
+
+    struct push_constants
+    {
+        uint32_t count;
+        uint32_t param;
+        uint32_t iterations;
+    };
+
+    // Every kernel reads binding 0 and writes binding 1, so one set serves them all.
+    struct micro_data
+    {
+        buffer_data src;
+        buffer_data dst;
+        VkDeviceSize size;
+
+        VkDescriptorSetLayout set_layout;
+        VkDescriptorPool descriptor_pool;
+        VkDescriptorSet set;
+        VkPipelineLayout pipeline_layout;
+    };
+
+    micro_data create_micro_data( bench_context& ctx )
+    {
+        auto& vd = ctx.vulkan;
+
+        const auto& limits = vd.device_properties[vd.selected_device_idx].limits;
+
+        micro_data ret{};
+
+        // power of two sizes keep the strided and random index math simple
+        ret.size = BUFFER_SIZE;
+        while ( ret.size > limits.maxStorageBufferRange )
+        {
+            ret.size /= 2;
+        }
+
+        // the first two vec4 are the multiplier and addend of the fma kernel
+        std::vector< uint32_t > init( ret.size / sizeof( uint32_t ), 0 );
+        const std::array< float, 8 > fma_constants = {0.999f, 0.999f, 0.999f, 0.999f,
+                                                      0.001f, 0.001f, 0.001f, 0.001f};
+        std::memcpy( init.data(), fma_constants.data(), sizeof( fma_constants ) );
+
+        ret.src = create_buffer_with_data( ctx, init.data(), ret.size,
+                                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT );
+        ret.dst = vd.create_buffer( ret.size,
+                                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                                        | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+        const std::array< VkDescriptorSetLayoutBinding, 2 > bindings = {
+            VkDescriptorSetLayoutBinding{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                         VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+            VkDescriptorSetLayoutBinding{1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                         VK_SHADER_STAGE_COMPUTE_BIT, nullptr}};
+
+        VkDescriptorSetLayoutCreateInfo layout_info{
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+            static_cast< uint32_t >( bindings.size() ), bindings.data()};
+
+        auto res = vkCreateDescriptorSetLayout( vd.logical_device, &layout_info, nullptr,
+                                                &ret.set_layout );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor set layout" );
+
+        const VkDescriptorPoolSize pool_size{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2};
+        VkDescriptorPoolCreateInfo pool_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, nullptr, 0, 1, 1, &pool_size};
+
+        res = vkCreateDescriptorPool( vd.logical_device, &pool_info, nullptr,
+                                      &ret.descriptor_pool );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor pool!" );
+
+        VkDescriptorSetAllocateInfo allocate_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, ret.descriptor_pool,
+            1, &ret.set_layout};
+
+        res = vkAllocateDescriptorSets( vd.logical_device, &allocate_info, &ret.set );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't allocate descriptor set!" );
+
+        const std::array< VkDescriptorBufferInfo, 2 > buffer_infos = {
+            VkDescriptorBufferInfo{ret.src.buffer, 0, VK_WHOLE_SIZE},
+            VkDescriptorBufferInfo{ret.dst.buffer, 0, VK_WHOLE_SIZE}};
+
+        std::array< VkWriteDescriptorSet, 2 > writes{};
+        for ( uint32_t i = 0; i < writes.size(); ++i )
+        {
+            writes[i] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                         nullptr,
+                         ret.set,
+                         i,
+                         0,
+                         1,
+                         VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                         nullptr,
+                         &buffer_infos[i],
+                         nullptr};
+        }
+
+        vkUpdateDescriptorSets( vd.logical_device,
+                                static_cast< uint32_t >( writes.size() ), writes.data(),
+                                0, nullptr );
+
+        const VkPushConstantRange push_range{VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                             sizeof( push_constants )};
+
+        VkPipelineLayoutCreateInfo pipeline_layout_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &ret.set_layout,
+            1,
+            &push_range};
+
+        res = vkCreatePipelineLayout( vd.logical_device, &pipeline_layout_info, nullptr,
+                                      &ret.pipeline_layout );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline layout failed" );
+
+        return ret;
+    }
+
+    void destroy_micro_data( bench_context& ctx, micro_data& md )
+    {
+        auto& vd = ctx.vulkan;
+
+        vkDestroyPipelineLayout( vd.logical_device, md.pipeline_layout, nullptr );
+        vkDestroyDescriptorPool( vd.logical_device, md.descriptor_pool, nullptr );
+        vkDestroyDescriptorSetLayout( vd.logical_device, md.set_layout, nullptr );
+        vd.destroy_buffer( md.dst );
+        vd.destroy_buffer( md.src );
+    }
+
+    void compute_barrier( VkCommandBuffer cmd )
+    {
+        const VkMemoryBarrier barrier{
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                              nullptr, 0, nullptr );
+    }
+
+    uint32_t grid_groups( uint32_t count )
+    {
+        return std::clamp( count / ( GROUP_SIZE * ITEMS_PER_THREAD ), 1u, MAX_GROUPS );
+    }
+
+    // Average ms of options.iterations timed runs of record, after one warm up run.
+    double measure( bench_context& ctx, const micro_data& md, VkPipeline pipeline,
+                    const bench_options& options,
+                    const std::function< void( VkCommandBuffer ) >& record )
+    {
+        auto& vd = ctx.vulkan;
+
+        gpu_timer timer{vd};
+        timer.initialize( options.iterations * 2 );
+
+        VkCommandBuffer cmd = vd.begin_one_time_commands();
+        timer.reset( cmd );
+
+        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+        vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, md.pipeline_layout,
+                                 0, 1, &md.set, 0, nullptr );
+
+        vkCmdFillBuffer( cmd, md.dst.buffer, 0, VK_WHOLE_SIZE, 0 );
+
+        const VkMemoryBarrier fill_barrier{
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fill_barrier,
+                              0, nullptr, 0, nullptr );
+
+        record( cmd );
+        compute_barrier( cmd );
+
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            timer.write( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT );
+            record( cmd );
+            timer.write( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+            compute_barrier( cmd );
+        }
+
+        vd.submit_one_time_commands( cmd );
+
+        const auto ticks = timer.read();
+        timer.deinitialize();
+
+        double total_ms = 0.0;
+
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            total_ms += timer.ticks_to_ms( ticks[i * 2 + 1] - ticks[i * 2] );
+        }
+
+        return total_ms / options.iterations;
+    }
+
+    // Runs one dispatch of the given kernel per timed iteration.
+    double measure_kernel( bench_context& ctx, const micro_data& md, const char* filename,
+                           uint32_t mode, uint32_t groups, const push_constants& pc,
+                           const bench_options& options )
+    {
+        const VkSpecializationMapEntry entry{0, 0, sizeof( uint32_t )};
+        const VkSpecializationInfo specialization{1, &entry, sizeof( uint32_t ), &mode};
+
+        VkPipeline pipeline = ctx.vulkan.create_compute_pipeline(
+            filename, md.pipeline_layout, &specialization );
+
+        const auto record = [&md, &pc, groups]( VkCommandBuffer cmd ) {
+            vkCmdPushConstants( cmd, md.pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                sizeof( push_constants ), &pc );
+            vkCmdDispatch( cmd, groups, 1, 1 );
+        };
+
+        const double ms = measure( ctx, md, pipeline, options, record );
+
+        vkDestroyPipeline( ctx.vulkan.logical_device, pipeline, nullptr );
+
+        return ms;
+    }
+
+    // bytes per ms to GB/s, also used for flops and ops
+    double giga_per_s( double amount, double ms )
+    {
+        return ms > 0.0 ? amount / ( ms * 1.0e6 ) : 0.0;
+    }
+
+    void run_bandwidth( bench_context& ctx, const micro_data& md,
+                        const bench_options& options )
+    {
+        const uint32_t vec4_count = static_cast< uint32_t >( md.size / 16 );
+        const push_constants copy_pc{vec4_count, 0, 0};
+
+        const double ms = measure_kernel( ctx, md, "generated/bench_copy.comp.spirv", 0,
+                                          grid_groups( vec4_count ), copy_pc, options );
+
+        // every byte is read once and written once
+        report( ctx,
+                {"micro", "copy", md.size, giga_per_s( 2.0 * md.size, ms ), "GB/s"} );
+
+        const uint32_t count = static_cast< uint32_t >( md.size / sizeof( uint32_t ) );
+        const std::array< uint32_t, 5 > strides = {1, 2, 16, 64, 1024};
+
+        for ( const uint32_t stride : strides )
+        {
+            const push_constants pc{count, stride, 0};
+            const double strided_ms = measure_kernel(
+                ctx, md, "generated/bench_read.comp.spirv", 0, grid_groups( count ), pc,
+                options );
+
+            report( ctx, {"micro", "read_stride_" + std::to_string( stride ), md.size,
+                          giga_per_s( static_cast< double >( md.size ), strided_ms ),
+                          "GB/s"} );
+        }
+
+        const push_constants random_pc{count, 1, 0};
+        const double random_ms =
+            measure_kernel( ctx, md, "generated/bench_read.comp.spirv", 1,
+                            grid_groups( count ), random_pc, options );
+
+        report( ctx, {"micro", "read_random", md.size,
+                      giga_per_s( static_cast< double >( md.size ), random_ms ),
+                      "GB/s"} );
+    }
+
+    void run_alu( bench_context& ctx, const micro_data& md, const bench_options& options )
+    {
+        const uint32_t groups     = 1024;
+        const uint32_t iterations = 1024;
+        const push_constants pc{0, 0, iterations};
+
+        const double ms = measure_kernel( ctx, md, "generated/bench_alu.comp.spirv", 0,
+                                          groups, pc, options );
+
+        // 8 chains of vec4 fma, 2 flops each
+        const double flops = double{groups} * GROUP_SIZE * iterations * 8 * 4 * 2;
+
+        report( ctx, {"micro", "fma", uint64_t{groups} * GROUP_SIZE,
+                      giga_per_s( flops, ms ), "GFLOP/s"} );
+    }
+
+    void run_atomics( bench_context& ctx, const micro_data& md,
+                      const bench_options& options )
+    {
+        const uint32_t groups     = 256;
+        const uint32_t iterations = 64;
+        const double ops          = double{groups} * GROUP_SIZE * iterations;
+
+        const std::array< const char*, 2 > modes = {"atomic_global_", "atomic_shared_"};
+        const std::array< uint32_t, 3 > counters = {1, 32, 256};
+
+        for ( uint32_t mode = 0; mode < modes.size(); ++mode )
+        {
+            for ( const uint32_t counter_count : counters )
+            {
+                const push_constants pc{0, counter_count, iterations};
+
+                const double ms =
+                    measure_kernel( ctx, md, "generated/bench_atomics.comp.spirv", mode,
+                                    groups, pc, options );
+
+                report( ctx, {"micro", modes[mode] + std::to_string( counter_count ),
+                              uint64_t{groups} * GROUP_SIZE,
+                              giga_per_s( ops, ms ), "Gop/s"} );
+            }
+        }
+    }
+
+    void run_shared_memory( bench_context& ctx, const micro_data& md,
+                            const bench_options& options )
+    {
+        const uint32_t groups     = 1024;
+        const uint32_t iterations = 1024;
+        const double bytes =
+            double{groups} * GROUP_SIZE * iterations * sizeof( uint32_t );
+
+        // 32 banks of 4 bytes on most hardware, odd strides are conflict free
+        const std::array< uint32_t, 7 > strides = {1, 2, 4, 8, 16, 32, 33};
+
+        for ( const uint32_t stride : strides )
+        {
+            const push_constants pc{0, stride, iterations};
+
+            const double ms = measure_kernel( ctx, md,
+                                              "generated/bench_shared_memory.comp.spirv",
+                                              0, groups, pc, options );
+
+            report( ctx, {"micro", "shared_stride_" + std::to_string( stride ),
+                          uint64_t{groups} * GROUP_SIZE, giga_per_s( bytes, ms ),
+                          "GB/s"} );
+        }
+    }
+
+    void run_dispatch( bench_context& ctx, const micro_data& md,
+                       const bench_options& options )
+    {
+        const uint32_t dispatches = 1000;
+        const push_constants pc{0, 0, 0};
+
+        VkPipeline pipeline = ctx.vulkan.create_compute_pipeline(
+            "generated/bench_dispatch.comp.spirv", md.pipeline_layout );
+
+        for ( const bool barriers : {false, true} )
+        {
+            const auto record = [&md, &pc, barriers]( VkCommandBuffer cmd ) {
+                vkCmdPushConstants( cmd, md.pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT,
+                                    0, sizeof( push_constants ), &pc );
+
+                for ( uint32_t i = 0; i < dispatches; ++i )
+                {
+                    vkCmdDispatch( cmd, 1, 1, 1 );
+
+                    if ( barriers )
+                    {
+                        compute_barrier( cmd );
+                    }
+                }
+            };
+
+            const double ms = measure( ctx, md, pipeline, options, record );
+
+            report( ctx, {"micro", barriers ? "dispatch_with_barrier" : "dispatch",
+                          dispatches, ms * 1000.0 / dispatches, "us"} );
+        }
+
+        vkDestroyPipeline( ctx.vulkan.logical_device, pipeline, nullptr );
+    }
+} // namespace
+
+void run_micro_suite( bench_context& ctx, const bench_options& options )
+{
+    micro_data md = create_micro_data( ctx );
+
+    log_result( "micro: average of ", options.iterations, " iterations on ",
+                md.size / 1024 / 1024, " MB buffers" );
+
+    run_bandwidth( ctx, md, options );
+    run_alu( ctx, md, options );
+    run_atomics( ctx, md, options );
+    run_shared_memory( ctx, md, options );
+    run_dispatch( ctx, md, options );
+
+    destroy_micro_data( ctx, md );
+}
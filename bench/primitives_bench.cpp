@@ -0,0 +1,290 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "gpu_primitives.hpp"
+
+#include <array>
+#include <random>
+
+namespace
+{
+    void transfer_to_compute_barrier( VkCommandBuffer cmd )
+    {
+        const VkMemoryBarrier barrier{
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                              nullptr, 0, nullptr );
+    }
+
+    void compute_barrier( VkCommandBuffer cmd )
+    {
+        const VkMemoryBarrier barrier{
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                              nullptr, 0, nullptr );
+    }
+
+    bool fits( bench_context& ctx, uint32_t count )
+    {
+        const auto& limits =
+            ctx.vulkan.device_properties[ctx.vulkan.selected_device_idx].limits;
+
+        const uint64_t table_size = uint64_t{gpu_primitives::RADIX_DIGITS}
+                                    * gpu_primitives::sort_partitions( count );
+
+        return uint64_t{count} * sizeof( uint32_t ) <= limits.maxStorageBufferRange
+               && table_size * sizeof( uint32_t ) <= limits.maxStorageBufferRange;
+    }
+
+    struct buffers
+    {
+        buffer_data input;
+        buffer_data output;
+        buffer_data keys;
+        buffer_data values;
+        buffer_data sort_keys;
+        buffer_data sort_values;
+    };
+
+    void validate( bench_context& ctx, gpu_primitives& primitives, const buffers& b,
+                   const std::vector< uint32_t >& input,
+                   const std::vector< uint32_t >& keys,
+                   const std::vector< uint32_t >& values )
+    {
+        const auto count        = static_cast< uint32_t >( input.size() );
+        const VkDeviceSize size = VkDeviceSize{count} * sizeof( uint32_t );
+
+        bool ok = true;
+
+        {
+            primitives.reset();
+            VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+            primitives.record_scan( cmd, b.input.buffer, b.output.buffer, count );
+            ctx.vulkan.submit_one_time_commands( cmd );
+
+            std::vector< uint32_t > expected( count );
+            std::vector< uint32_t > result( count );
+            scan_reference( input.data(), count, expected.data() );
+            read_buffer( ctx, b.output.buffer, size, result.data() );
+
+            ok &= ( expected == result );
+            log_result( "\tscan: ", expected == result ? "ok" : "FAILED" );
+        }
+
+        {
+            primitives.reset();
+            VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+            primitives.record_workgroup_scan( cmd, b.input.buffer, b.output.buffer,
+                                              count );
+            ctx.vulkan.submit_one_time_commands( cmd );
+
+            std::vector< uint32_t > expected( count );
+            std::vector< uint32_t > result( count );
+
+            for ( uint32_t i = 0; i < count; i += gpu_primitives::SCAN_PARTITION_SIZE )
+            {
+                const uint32_t n =
+                    std::min( count - i, gpu_primitives::SCAN_PARTITION_SIZE );
+                scan_reference( input.data() + i, n, expected.data() + i );
+            }
+
+            read_buffer( ctx, b.output.buffer, size, result.data() );
+
+            ok &= ( expected == result );
+            log_result( "\tworkgroup scan: ", expected == result ? "ok" : "FAILED" );
+        }
+
+        const std::array< gpu_primitives::reduce_op, 3 > ops = {
+            gpu_primitives::reduce_op::sum, gpu_primitives::reduce_op::min,
+            gpu_primitives::reduce_op::max};
+
+        for ( const auto op : ops )
+        {
+            primitives.reset();
+            VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+            primitives.record_reduce( cmd, op, b.input.buffer, b.output.buffer, count );
+            ctx.vulkan.submit_one_time_commands( cmd );
+
+            uint32_t result = 0;
+            read_buffer( ctx, b.output.buffer, sizeof( uint32_t ), &result );
+
+            const uint32_t expected = reduce_reference( op, input.data(), count );
+
+            ok &= ( expected == result );
+            log_result( "\treduce ", static_cast< uint32_t >( op ), ": ",
+                        expected == result ? "ok" : "FAILED" );
+        }
+
+        {
+            primitives.reset();
+            VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+            const VkBufferCopy region{0, 0, size};
+            vkCmdCopyBuffer( cmd, b.keys.buffer, b.sort_keys.buffer, 1, &region );
+            vkCmdCopyBuffer( cmd, b.values.buffer, b.sort_values.buffer, 1, &region );
+            transfer_to_compute_barrier( cmd );
+            primitives.record_radix_sort( cmd, b.sort_keys.buffer, b.sort_values.buffer,
+                                          count );
+            ctx.vulkan.submit_one_time_commands( cmd );
+
+            std::vector< uint32_t > expected_keys   = keys;
+            std::vector< uint32_t > expected_values = values;
+            radix_sort_reference( expected_keys.data(), expected_values.data(), count );
+
+            std::vector< uint32_t > result_keys( count );
+            std::vector< uint32_t > result_values( count );
+            read_buffer( ctx, b.sort_keys.buffer, size, result_keys.data() );
+            read_buffer( ctx, b.sort_values.buffer, size, result_values.data() );
+
+            const bool sort_ok =
+                ( expected_keys == result_keys ) && ( expected_values == result_values );
+            ok &= sort_ok;
+            log_result( "\tradix sort: ", sort_ok ? "ok" : "FAILED" );
+        }
+
+        NEO_ASSERT_ALWAYS( ok, "Validation of gpu primitives failed for ", count,
+                           " elements" );
+    }
+} // namespace
+
+void run_primitives_suite( bench_context& ctx, const bench_options& options )
+{
+    const std::array< uint32_t, 8 > sizes = {1u << 10,  1u << 14,  1u << 17, 1u << 20,
+                                             1u << 22,  1u << 24,  1u << 26,
+                                             100000000u};
+
+    log_result( "primitives: million elements per second, average of ",
+                options.iterations, " iterations" );
+
+    std::mt19937 gen{1234};
+
+    for ( const uint32_t count : sizes )
+    {
+        if ( !fits( ctx, count ) )
+        {
+            log_result( "\t", count, " skipped, exceeds maxStorageBufferRange" );
+            continue;
+        }
+
+        // small scan inputs keep the sums meaningful, keys use all 32 bits
+        std::uniform_int_distribution< uint32_t > small_dis( 0, 255 );
+        std::uniform_int_distribution< uint32_t > key_dis;
+
+        std::vector< uint32_t > input( count );
+        std::vector< uint32_t > keys( count );
+        std::vector< uint32_t > values( count );
+
+        for ( uint32_t i = 0; i < count; ++i )
+        {
+            input[i]  = small_dis( gen );
+            keys[i]   = key_dis( gen );
+            values[i] = i;
+        }
+
+        const VkDeviceSize size        = VkDeviceSize{count} * sizeof( uint32_t );
+        const VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                                         | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                                         | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+        buffers b{};
+        b.input  = create_buffer_with_data( ctx, input.data(), size, usage );
+        b.keys   = create_buffer_with_data( ctx, keys.data(), size, usage );
+        b.values = create_buffer_with_data( ctx, values.data(), size, usage );
+        b.output =
+            ctx.vulkan.create_buffer( size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+        b.sort_keys =
+            ctx.vulkan.create_buffer( size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+        b.sort_values =
+            ctx.vulkan.create_buffer( size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+        gpu_primitives primitives{ctx.vulkan};
+        gpu_timer timer{ctx.vulkan};
+
+        primitives.initialize( count );
+        timer.initialize( options.iterations * 6 );
+
+        if ( options.validate )
+        {
+            validate( ctx, primitives, b, input, keys, values );
+        }
+
+        {
+            VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+            timer.reset( cmd );
+            ctx.vulkan.submit_one_time_commands( cmd );
+        }
+
+        // one submit per iteration so the descriptor pool can be recycled in between
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            primitives.reset();
+
+            VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+
+            // sorting in place, start every iteration from the unsorted keys
+            const VkBufferCopy region{0, 0, size};
+            vkCmdCopyBuffer( cmd, b.keys.buffer, b.sort_keys.buffer, 1, &region );
+            vkCmdCopyBuffer( cmd, b.values.buffer, b.sort_values.buffer, 1, &region );
+            transfer_to_compute_barrier( cmd );
+
+            timer.write( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT );
+            primitives.record_scan( cmd, b.input.buffer, b.output.buffer, count );
+            timer.write( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+
+            compute_barrier( cmd );
+
+            timer.write( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT );
+            primitives.record_reduce( cmd, gpu_primitives::reduce_op::sum, b.input.buffer,
+                                      b.output.buffer, count );
+            timer.write( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+
+            timer.write( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT );
+            primitives.record_radix_sort( cmd, b.sort_keys.buffer, b.sort_values.buffer,
+                                          count );
+            timer.write( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+
+            ctx.vulkan.submit_one_time_commands( cmd );
+        }
+
+        const auto ticks = timer.read();
+
+        std::array< double, 3 > total_ms = {};
+
+        for ( uint32_t i = 0; i < options.iterations; ++i )
+        {
+            for ( uint32_t p = 0; p < total_ms.size(); ++p )
+            {
+                total_ms[p] +=
+                    timer.ticks_to_ms( ticks[i * 6 + p * 2 + 1] - ticks[i * 6 + p * 2] );
+            }
+        }
+
+        auto melements_per_s = [&options, count]( double ms ) {
+            const double avg_ms = ms / options.iterations;
+            return avg_ms > 0.0 ? count / ( avg_ms * 1000.0 ) : 0.0;
+        };
+
+        report( ctx, {"primitives", "scan", count, melements_per_s( total_ms[0] ),
+                      "Melem/s"} );
+        report( ctx, {"primitives", "reduce_sum", count, melements_per_s( total_ms[1] ),
+                      "Melem/s"} );
+        report( ctx, {"primitives", "radix_sort", count, melements_per_s( total_ms[2] ),
+                      "Melem/s"} );
+
+        timer.deinitialize();
+        primitives.deinitialize();
+
+        ctx.vulkan.destroy_buffer( b.sort_values );
+        ctx.vulkan.destroy_buffer( b.sort_keys );
+        ctx.vulkan.destroy_buffer( b.output );
+        ctx.vulkan.destroy_buffer( b.values );
+        ctx.vulkan.destroy_buffer( b.keys );
+        ctx.vulkan.destroy_buffer( b.input );
+    }
+}
@@ -0,0 +1,380 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "parallel_recorder.hpp"
+#include "render_queue.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace
+{
+    constexpr uint32_t DRAWS     = 50000;
+    constexpr uint32_t PIPELINES = 4;
+    constexpr uint32_t MESHES    = 16;
+
+    constexpr VkExtent2D EXTENT     = {64, 64};
+    constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+    // A render pass with one color attachment and pipelines drawing simple.vert, just
+    // enough for the recorded draws to be valid.
+    struct draw_target
+    {
+        image_data color;
+        VkRenderPass render_pass;
+        VkFramebuffer framebuffer;
+        VkPipelineLayout layout;
+        std::array< VkPipeline, PIPELINES > pipelines;
+
+        // a triangle per mesh, position and color
+        std::array< buffer_data, MESHES > vertices;
+        buffer_data indices;
+    };
+
+    void create_render_pass( bench_context& ctx, draw_target& target )
+    {
+        const VkAttachmentDescription attachment = {0,
+                                                    COLOR_FORMAT,
+                                                    VK_SAMPLE_COUNT_1_BIT,
+                                                    VK_ATTACHMENT_LOAD_OP_CLEAR,
+                                                    VK_ATTACHMENT_STORE_OP_STORE,
+                                                    VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+                                                    VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                                                    VK_IMAGE_LAYOUT_UNDEFINED,
+                                                    VK_IMAGE_LAYOUT_GENERAL};
+
+        const VkAttachmentReference color_reference = {
+            0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+        const VkSubpassDescription subpass = {0,       VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                              0,       nullptr,
+                                              1,       &color_reference,
+                                              nullptr, nullptr,
+                                              0,       nullptr};
+
+        const VkRenderPassCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &attachment,
+            1,
+            &subpass,
+            0,
+            nullptr};
+
+        auto res = vkCreateRenderPass( ctx.vulkan.logical_device, &create_info, nullptr,
+                                       &target.render_pass );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of render pass failed" );
+
+        target.color = ctx.vulkan.create_image_2d( EXTENT, COLOR_FORMAT,
+                                                   VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT );
+
+        const VkFramebufferCreateInfo framebuffer_info = {
+            VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+            nullptr,
+            0,
+            target.render_pass,
+            1,
+            &target.color.image_view,
+            EXTENT.width,
+            EXTENT.height,
+            1};
+
+        res = vkCreateFramebuffer( ctx.vulkan.logical_device, &framebuffer_info, nullptr,
+                                   &target.framebuffer );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of framebuffer failed" );
+    }
+
+    void create_pipelines( bench_context& ctx, draw_target& target )
+    {
+        const VkPipelineLayoutCreateInfo layout_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, nullptr, 0, 0, nullptr, 0,
+            nullptr};
+
+        auto res = vkCreatePipelineLayout( ctx.vulkan.logical_device, &layout_info,
+                                           nullptr, &target.layout );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline layout failed" );
+
+        const std::array< VkPipelineShaderStageCreateInfo, 2 > stages = {
+            VkPipelineShaderStageCreateInfo{
+                VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0,
+                VK_SHADER_STAGE_VERTEX_BIT,
+                ctx.vulkan.load_shader( "generated/simple.vert.spirv" ), "main", nullptr},
+            VkPipelineShaderStageCreateInfo{
+                VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0,
+                VK_SHADER_STAGE_FRAGMENT_BIT,
+                ctx.vulkan.load_shader( "generated/simple.frag.spirv" ), "main",
+                nullptr}};
+
+        const VkVertexInputBindingDescription binding = {0, 6 * sizeof( float ),
+                                                         VK_VERTEX_INPUT_RATE_VERTEX};
+
+        const std::array< VkVertexInputAttributeDescription, 2 > attributes = {
+            VkVertexInputAttributeDescription{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
+            VkVertexInputAttributeDescription{1, 0, VK_FORMAT_R32G32B32_SFLOAT,
+                                              3 * sizeof( float )}};
+
+        const VkPipelineVertexInputStateCreateInfo vertex_input_state = {
+            VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &binding,
+            static_cast< uint32_t >( attributes.size() ),
+            attributes.data()};
+
+        const VkPipelineInputAssemblyStateCreateInfo input_assembly_state = {
+            VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO, nullptr, 0,
+            VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_FALSE};
+
+        const VkViewport viewport = {0.0f, 0.0f, 1.0f * EXTENT.width,
+                                     1.0f * EXTENT.height, 0.0f, 1.0f};
+        const VkRect2D scissor    = {{0, 0}, EXTENT};
+
+        const VkPipelineViewportStateCreateInfo viewport_state = {
+            VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &viewport,
+            1,
+            &scissor};
+
+        const VkPipelineRasterizationStateCreateInfo rasterization_state = {
+            VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+            nullptr,
+            0,
+            VK_FALSE,
+            VK_FALSE,
+            VK_POLYGON_MODE_FILL,
+            VK_CULL_MODE_NONE,
+            VK_FRONT_FACE_COUNTER_CLOCKWISE,
+            VK_FALSE,
+            0.0f,
+            0.0f,
+            0.0f,
+            1.0f};
+
+        const VkPipelineMultisampleStateCreateInfo multisample_state = {
+            VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+            nullptr,
+            0,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_FALSE,
+            0.0f,
+            nullptr,
+            VK_FALSE,
+            VK_FALSE};
+
+        const VkPipelineColorBlendAttachmentState blend_attachment_state = {
+            VK_FALSE,
+            VK_BLEND_FACTOR_ZERO,
+            VK_BLEND_FACTOR_ZERO,
+            VK_BLEND_OP_ADD,
+            VK_BLEND_FACTOR_ZERO,
+            VK_BLEND_FACTOR_ZERO,
+            VK_BLEND_OP_ADD,
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT
+                | VK_COLOR_COMPONENT_A_BIT};
+
+        const VkPipelineColorBlendStateCreateInfo color_blend_state = {
+            VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            nullptr,
+            0,
+            VK_FALSE,
+            VK_LOGIC_OP_CLEAR,
+            1,
+            &blend_attachment_state,
+            {0.0f, 0.0f, 0.0f, 0.0f}};
+
+        const VkGraphicsPipelineCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            nullptr,
+            0,
+            static_cast< uint32_t >( stages.size() ),
+            stages.data(),
+            &vertex_input_state,
+            &input_assembly_state,
+            nullptr,
+            &viewport_state,
+            &rasterization_state,
+            &multisample_state,
+            nullptr,
+            &color_blend_state,
+            nullptr,
+            target.layout,
+            target.render_pass,
+            0,
+            nullptr,
+            -1};
+
+        // identical state, separate objects, so the queue has pipeline changes to sort
+        for ( auto& pipeline : target.pipelines )
+        {
+            res = vkCreateGraphicsPipelines( ctx.vulkan.logical_device, nullptr, 1,
+                                             &create_info, nullptr, &pipeline );
+            NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline failed" );
+        }
+
+        for ( const auto& stage : stages )
+        {
+            vkDestroyShaderModule( ctx.vulkan.logical_device, stage.module, nullptr );
+        }
+    }
+
+    draw_target create_draw_target( bench_context& ctx )
+    {
+        draw_target target{};
+
+        create_render_pass( ctx, target );
+        create_pipelines( ctx, target );
+
+        for ( uint32_t m = 0; m < MESHES; ++m )
+        {
+            const float x = -1.0f + 2.0f * m / MESHES;
+
+            const std::array< float, 18 > vertices = {
+                x,        -1.0f, 0.5f, 1.0f, 0.0f, 0.0f, // position, color
+                x,        1.0f,  0.5f, 0.0f, 1.0f, 0.0f, //
+                x + 0.1f, 1.0f,  0.5f, 0.0f, 0.0f, 1.0f};
+
+            target.vertices[m] =
+                create_buffer_with_data( ctx, vertices.data(), sizeof( vertices ),
+                                         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT );
+        }
+
+        const std::array< uint32_t, 3 > indices = {0, 1, 2};
+        target.indices = create_buffer_with_data( ctx, indices.data(), sizeof( indices ),
+                                                  VK_BUFFER_USAGE_INDEX_BUFFER_BIT );
+
+        return target;
+    }
+
+    void destroy_draw_target( bench_context& ctx, draw_target& target )
+    {
+        ctx.vulkan.destroy_buffer( target.indices );
+        for ( auto& v : target.vertices )
+        {
+            ctx.vulkan.destroy_buffer( v );
+        }
+
+        for ( auto pipeline : target.pipelines )
+        {
+            vkDestroyPipeline( ctx.vulkan.logical_device, pipeline, nullptr );
+        }
+
+        vkDestroyPipelineLayout( ctx.vulkan.logical_device, target.layout, nullptr );
+        vkDestroyFramebuffer( ctx.vulkan.logical_device, target.framebuffer, nullptr );
+        vkDestroyRenderPass( ctx.vulkan.logical_device, target.render_pass, nullptr );
+        ctx.vulkan.destroy_image( target.color );
+    }
+
+    // the secondary buffers execute inside the render pass without errors
+    void validate( bench_context& ctx, const draw_target& target,
+                   const parallel_recorder& recorder )
+    {
+        const VkClearValue clear_value = {};
+
+        const VkRenderPassBeginInfo begin_info = {
+            VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            nullptr,
+            target.render_pass,
+            target.framebuffer,
+            {{0, 0}, EXTENT},
+            1,
+            &clear_value};
+
+        VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+        vkCmdBeginRenderPass( cmd, &begin_info,
+                              VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+        recorder.execute( cmd, 0 );
+        vkCmdEndRenderPass( cmd );
+        ctx.vulkan.submit_one_time_commands( cmd );
+
+        log_result( "\tsecondary buffers: ", recorder.partitions(), " executed, ok" );
+    }
+} // namespace
+
+void run_recording_suite( bench_context& ctx, const bench_options& options )
+{
+    draw_target target = create_draw_target( ctx );
+
+    std::mt19937 rng( 11 );
+    std::uniform_int_distribution< uint32_t > pipeline_dist( 0, PIPELINES - 1 );
+    std::uniform_int_distribution< uint32_t > mesh_dist( 0, MESHES - 1 );
+
+    render_queue queue;
+
+    for ( uint32_t i = 0; i < DRAWS; ++i )
+    {
+        const uint32_t pipeline = pipeline_dist( rng );
+        const uint32_t mesh     = mesh_dist( rng );
+
+        draw_item item{};
+        item.pipeline       = target.pipelines[pipeline];
+        item.layout         = target.layout;
+        item.vertices       = target.vertices[mesh].buffer;
+        item.indices        = target.indices.buffer;
+        item.index_count    = 3;
+        item.instance_count = 1;
+
+        queue.push( make_sort_key( pipeline, 0, mesh, 0.0f ), item );
+    }
+
+    queue.sort();
+
+    const uint32_t max_threads = std::max( std::thread::hardware_concurrency(), 1u );
+
+    log_result( "recording: ms to record ", DRAWS, " sorted draws into secondary command "
+                "buffers, average of ",
+                options.iterations, " iterations" );
+
+    for ( uint32_t threads = 1; threads <= max_threads; threads *= 2 )
+    {
+        // the caller takes part in parallel_for, so threads - 1 workers are enough
+        thread_pool workers( std::max( threads - 1, 1u ) );
+
+        parallel_recorder recorder{ctx.vulkan, workers};
+        recorder.initialize( threads, 1 );
+
+        double record_ms = 0.0;
+        render_queue_stats stats{};
+        application_data::frame_arena_t arena;
+        arena.initialize( 1 );
+
+        for ( uint32_t it = 0; it < options.iterations; ++it )
+        {
+            arena.begin_frame( 0 );
+
+            const auto begin = std::chrono::high_resolution_clock::now();
+            stats = recorder.record( queue, 0, target.render_pass, 0, target.framebuffer,
+                                     VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, arena );
+            const std::chrono::duration< double, std::milli > elapsed =
+                std::chrono::high_resolution_clock::now() - begin;
+
+            record_ms += elapsed.count();
+        }
+
+        const std::string name = "record_" + std::to_string( threads ) + "_threads";
+        report( ctx, {"recording", name, DRAWS, record_ms / options.iterations, "ms"} );
+
+        NEO_ASSERT_ALWAYS( stats.draws == DRAWS, "Recorded ", stats.draws, " of ", DRAWS,
+                           " draws" );
+
+        if ( options.validate )
+        {
+            validate( ctx, target, recorder );
+        }
+
+        recorder.deinitialize();
+    }
+
+    destroy_draw_target( ctx, target );
+}
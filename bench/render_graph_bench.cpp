@@ -0,0 +1,189 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "render_graph.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    constexpr VkExtent2D EXTENT     = {1280, 720};
+    constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+    constexpr VkFormat DEPTH_FORMAT = VK_FORMAT_D32_SFLOAT;
+
+    // the albedo clear color in COLOR_FORMAT, what the readback has to contain
+    constexpr float ALBEDO[4]           = {0.25f, 0.5f, 0.75f, 1.0f};
+    constexpr uint8_t ALBEDO_BYTES[4]   = {64, 128, 191, 255};
+    constexpr VkDeviceSize OUTPUT_BYTES = 4ull * EXTENT.width * EXTENT.height;
+
+    // A deferred frame reduced to clears and copies, so it runs without pipelines:
+    //
+    //   gbuffer  (graphics) clears albedo, normal and depth
+    //   lighting (transfer) albedo -> lit
+    //   debug    (graphics) draws normals into an image nobody reads, culled
+    //   bloom    (transfer) lit -> bloom
+    //   readback (transfer) bloom -> output buffer
+    //
+    // normal and depth never leave the gbuffer pass and are lazy candidates, bloom
+    // can take the memory of albedo.
+    void build_frame( render_graph& graph, VkBuffer output )
+    {
+        const auto albedo = graph.create_image( "albedo", EXTENT, COLOR_FORMAT );
+        const auto normal = graph.create_image( "normal", EXTENT, COLOR_FORMAT );
+        const auto depth  = graph.create_image( "depth", EXTENT, DEPTH_FORMAT,
+                                                VK_IMAGE_ASPECT_DEPTH_BIT );
+        const auto lit    = graph.create_image( "lit", EXTENT, COLOR_FORMAT );
+        const auto debug  = graph.create_image( "debug", EXTENT, COLOR_FORMAT );
+        const auto bloom  = graph.create_image( "bloom", EXTENT, COLOR_FORMAT );
+        const auto out    = graph.import_buffer( "output", output, OUTPUT_BYTES );
+
+        VkClearValue albedo_clear{};
+        for ( uint32_t c = 0; c < 4; ++c )
+        {
+            albedo_clear.color.float32[c] = ALBEDO[c];
+        }
+
+        VkClearValue depth_clear{};
+        depth_clear.depthStencil = {1.0f, 0};
+
+        const auto gbuffer = graph.add_pass( "gbuffer", render_graph::pass_type::graphics,
+                                             []( VkCommandBuffer ) {} );
+        graph.write( gbuffer, albedo, graph_access::color_attachment );
+        graph.write( gbuffer, normal, graph_access::color_attachment );
+        graph.write( gbuffer, depth, graph_access::depth_attachment );
+        graph.clear( gbuffer, albedo, albedo_clear );
+        graph.clear( gbuffer, normal, VkClearValue{} );
+        graph.clear( gbuffer, depth, depth_clear );
+
+        const VkImageCopy copy = {{VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+                                  {0, 0, 0},
+                                  {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+                                  {0, 0, 0},
+                                  {EXTENT.width, EXTENT.height, 1}};
+
+        const auto lighting = graph.add_pass(
+            "lighting", render_graph::pass_type::transfer,
+            [&graph, albedo, lit, copy]( VkCommandBuffer cmd ) {
+                vkCmdCopyImage( cmd, graph.image( albedo ),
+                                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, graph.image( lit ),
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy );
+            } );
+        graph.read( lighting, albedo, graph_access::transfer_src );
+        graph.write( lighting, lit, graph_access::transfer_dst );
+
+        const auto debug_pass = graph.add_pass(
+            "debug", render_graph::pass_type::graphics, []( VkCommandBuffer ) {} );
+        graph.read( debug_pass, normal, graph_access::sampled );
+        graph.write( debug_pass, debug, graph_access::color_attachment );
+        graph.clear( debug_pass, debug, VkClearValue{} );
+
+        const auto bloom_pass = graph.add_pass(
+            "bloom", render_graph::pass_type::transfer,
+            [&graph, lit, bloom, copy]( VkCommandBuffer cmd ) {
+                vkCmdCopyImage( cmd, graph.image( lit ),
+                                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                graph.image( bloom ),
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy );
+            } );
+        graph.read( bloom_pass, lit, graph_access::transfer_src );
+        graph.write( bloom_pass, bloom, graph_access::transfer_dst );
+
+        const auto readback = graph.add_pass(
+            "readback", render_graph::pass_type::transfer,
+            [&graph, bloom, out]( VkCommandBuffer cmd ) {
+                const VkBufferImageCopy region = {0,
+                                                  0,
+                                                  0,
+                                                  {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+                                                  {0, 0, 0},
+                                                  {EXTENT.width, EXTENT.height, 1}};
+
+                vkCmdCopyImageToBuffer( cmd, graph.image( bloom ),
+                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                        graph.buffer( out ), 1, &region );
+            } );
+        graph.read( readback, bloom, graph_access::transfer_src );
+        graph.write( readback, out, graph_access::transfer_dst );
+    }
+
+    // the albedo clear made it through both copies into the output buffer
+    void validate( bench_context& ctx, const render_graph& graph, VkBuffer output )
+    {
+        VkCommandBuffer cmd = ctx.vulkan.begin_one_time_commands();
+        graph.execute( cmd );
+        ctx.vulkan.submit_one_time_commands( cmd );
+
+        std::vector< uint8_t > pixels( OUTPUT_BYTES );
+        read_buffer( ctx, output, OUTPUT_BYTES, pixels.data() );
+
+        for ( size_t i = 0; i < pixels.size(); ++i )
+        {
+            NEO_ASSERT_ALWAYS( std::abs( pixels[i] - ALBEDO_BYTES[i % 4] ) <= 1,
+                               "Output byte ", i, " is ", uint32_t{pixels[i]},
+                               " instead of ", uint32_t{ALBEDO_BYTES[i % 4]} );
+        }
+
+        log_result( "\tall ", EXTENT.width * EXTENT.height, " pixels ok" );
+    }
+} // namespace
+
+void run_render_graph_suite( bench_context& ctx, const bench_options& options )
+{
+    buffer_data output = ctx.vulkan.create_buffer(
+        OUTPUT_BYTES, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    log_result( "render_graph: ms to build and compile a ", EXTENT.width, "x",
+                EXTENT.height, " deferred frame, average of ", options.iterations,
+                " iterations" );
+
+    render_graph graph{ctx.vulkan};
+    double compile_ms = 0.0;
+
+    for ( uint32_t it = 0; it < options.iterations; ++it )
+    {
+        if ( it > 0 )
+        {
+            graph.deinitialize();
+        }
+
+        const auto begin = std::chrono::high_resolution_clock::now();
+        build_frame( graph, output.buffer );
+        graph.compile();
+        const std::chrono::duration< double, std::milli > elapsed =
+            std::chrono::high_resolution_clock::now() - begin;
+
+        compile_ms += elapsed.count();
+    }
+
+    const render_graph_stats& stats = graph.stats();
+
+    report( ctx, {"render_graph", "compile", 0, compile_ms / options.iterations, "ms"} );
+    report( ctx, {"render_graph", "passes", 0, 1.0 * stats.passes, "passes"} );
+    report( ctx, {"render_graph", "culled_passes", 0, 1.0 * stats.culled_passes,
+                  "passes"} );
+    report( ctx, {"render_graph", "barriers", 0, 1.0 * stats.barriers, "calls"} );
+    report( ctx, {"render_graph", "image_barriers", 0, 1.0 * stats.image_barriers,
+                  "barriers"} );
+    report( ctx, {"render_graph", "buffer_barriers", 0, 1.0 * stats.buffer_barriers,
+                  "barriers"} );
+    report( ctx, {"render_graph", "lazy_images", 0, 1.0 * stats.lazy_images, "images"} );
+    report( ctx, {"render_graph", "transient_memory", 0,
+                  stats.transient_bytes / ( 1024.0 * 1024.0 ), "MiB"} );
+    report( ctx, {"render_graph", "allocated_memory", 0,
+                  stats.allocated_bytes / ( 1024.0 * 1024.0 ), "MiB"} );
+
+    NEO_ASSERT_ALWAYS( stats.culled_passes == 1, "The debug pass should be culled, ",
+                       stats.culled_passes, " passes were" );
+
+    if ( options.validate )
+    {
+        validate( ctx, graph, output.buffer );
+    }
+
+    graph.deinitialize();
+    ctx.vulkan.destroy_buffer( output );
+}
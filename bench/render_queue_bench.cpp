@@ -0,0 +1,146 @@
+#include "bench.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+namespace
+{
+    constexpr uint32_t PIPELINES = 8;
+    constexpr uint32_t SETS      = 64;
+    constexpr uint32_t MESHES    = 256;
+
+    // the queue only compares handles, made up ones are fine as long as nothing records
+    template < typename T > T fake_handle( uint32_t id )
+    {
+        return reinterpret_cast< T >( static_cast< uintptr_t >( id ) + 1 );
+    }
+
+    uint32_t total_binds( const render_queue_stats& stats )
+    {
+        return stats.pipeline_binds + stats.set_binds + stats.vertex_binds
+               + stats.index_binds;
+    }
+
+    // the radix sort orders like a stable comparison sort
+    void validate( const std::vector< sort_entry >& entries )
+    {
+        std::vector< sort_entry > sorted = entries;
+        std::vector< sort_entry > scratch;
+        radix_sort( sorted, scratch );
+
+        std::vector< sort_entry > expected = entries;
+        std::stable_sort(
+            expected.begin(), expected.end(),
+            []( const sort_entry& a, const sort_entry& b ) { return a.key < b.key; } );
+
+        const bool ok = std::equal(
+            sorted.begin(), sorted.end(), expected.begin(),
+            []( const sort_entry& a, const sort_entry& b ) {
+                return a.key == b.key && a.index == b.index;
+            } );
+
+        log_result( "\tradix sort: ", ok ? "ok" : "FAILED" );
+
+        NEO_ASSERT_ALWAYS( ok, "Validation of the radix sort failed for ", entries.size(),
+                           " keys" );
+    }
+} // namespace
+
+void run_render_queue_suite( bench_context& ctx, const bench_options& options )
+{
+    log_result( "render_queue: ms to sort a frame of draws, binds recorded with and "
+                "without sorting, average of ",
+                options.iterations, " iterations" );
+
+    std::mt19937 rng( 7 );
+
+    for ( const uint32_t draws : {1000u, 10000u, 100000u} )
+    {
+        std::uniform_int_distribution< uint32_t > pipeline_dist( 0, PIPELINES - 1 );
+        std::uniform_int_distribution< uint32_t > set_dist( 0, SETS - 1 );
+        std::uniform_int_distribution< uint32_t > mesh_dist( 0, MESHES - 1 );
+        std::uniform_real_distribution< float > depth_dist( 0.0f, 1.0f );
+
+        // draws in submission order, every mesh has its own vertices and indices
+        std::vector< sort_entry > entries( draws );
+        std::vector< draw_item > items( draws );
+
+        for ( uint32_t i = 0; i < draws; ++i )
+        {
+            const uint32_t pipeline = pipeline_dist( rng );
+            const uint32_t set      = set_dist( rng );
+            const uint32_t mesh     = mesh_dist( rng );
+
+            draw_item& item     = items[i];
+            item.pipeline       = fake_handle< VkPipeline >( pipeline );
+            item.layout         = fake_handle< VkPipelineLayout >( 0 );
+            item.set            = fake_handle< VkDescriptorSet >( set );
+            item.vertices       = fake_handle< VkBuffer >( 2 * mesh );
+            item.indices        = fake_handle< VkBuffer >( 2 * mesh + 1 );
+            item.index_count    = 3;
+            item.instance_count = 1;
+
+            entries[i] = {make_sort_key( pipeline, set, mesh, depth_dist( rng ) ), i};
+        }
+
+        render_queue queue;
+        double radix_ms = 0.0;
+        double std_ms   = 0.0;
+
+        std::vector< sort_entry > scratch;
+
+        for ( uint32_t it = 0; it < options.iterations; ++it )
+        {
+            std::vector< sort_entry > keys = entries;
+
+            auto begin = std::chrono::high_resolution_clock::now();
+            radix_sort( keys, scratch );
+            const std::chrono::duration< double, std::milli > radix_elapsed =
+                std::chrono::high_resolution_clock::now() - begin;
+
+            keys = entries;
+
+            begin = std::chrono::high_resolution_clock::now();
+            std::sort( keys.begin(), keys.end(),
+                       []( const sort_entry& a, const sort_entry& b ) {
+                           return a.key < b.key;
+                       } );
+            const std::chrono::duration< double, std::milli > std_elapsed =
+                std::chrono::high_resolution_clock::now() - begin;
+
+            radix_ms += radix_elapsed.count();
+            std_ms += std_elapsed.count();
+        }
+
+        for ( uint32_t i = 0; i < draws; ++i )
+        {
+            queue.push( entries[i].key, items[i] );
+        }
+
+        const auto unsorted = queue.record( nullptr );
+        queue.sort();
+        const auto sorted = queue.record( nullptr );
+
+        report( ctx, {"render_queue", "radix_sort", draws, radix_ms / options.iterations,
+                      "ms"} );
+        report( ctx,
+                {"render_queue", "std_sort", draws, std_ms / options.iterations, "ms"} );
+        report( ctx, {"render_queue", "binds_unsorted", draws,
+                      static_cast< double >( total_binds( unsorted ) ), "binds"} );
+        report( ctx, {"render_queue", "binds_sorted", draws,
+                      static_cast< double >( total_binds( sorted ) ), "binds"} );
+        report( ctx, {"render_queue", "pipeline_binds_sorted", draws,
+                      static_cast< double >( sorted.pipeline_binds ), "binds"} );
+
+        if ( options.validate )
+        {
+            validate( entries );
+        }
+    }
+}
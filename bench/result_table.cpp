@@ -0,0 +1,137 @@
+#include "result_table.hpp"
+
+#include "debug.hpp"
+#include "json.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+    // quoted when it would split the row, quotes inside are doubled
+    void write_csv_cell( std::ofstream& os, const result_cell& cell )
+    {
+        if ( cell.text.find_first_of( ",\"\r\n" ) == std::string::npos )
+        {
+            os << cell.text;
+            return;
+        }
+
+        os << '"';
+        for ( const char c : cell.text )
+        {
+            os << ( c == '"' ? "\"\"" : std::string( 1, c ) );
+        }
+        os << '"';
+    }
+
+    void write_json_cell( std::ofstream& os, const result_cell& cell )
+    {
+        if ( cell.is_string )
+        {
+            write_json_string( os, cell.text );
+        }
+        else if ( cell.text.find_first_of( "ni" ) != std::string::npos )
+        {
+            // nan or inf, JSON has no numbers for them
+            os << "null";
+        }
+        else
+        {
+            os << cell.text;
+        }
+    }
+} // namespace
+
+void result_table::add_row( std::vector< result_cell > row )
+{
+    NEO_ASSERT_ALWAYS( row.size() == columns.size(), "A row of ", row.size(),
+                       " cells for ", columns.size(), " columns" );
+
+    rows.push_back( std::move( row ) );
+}
+
+void result_table::write_csv( const std::string& path ) const
+{
+    std::ofstream os( path );
+    NEO_ASSERT_ALWAYS( os.is_open(), "Couldn't open ", path, " for writing!" );
+
+    for ( const auto& m : metadata )
+    {
+        // a line break would end the comment
+        std::string text = m.second.text;
+        std::replace_if(
+            text.begin(), text.end(), []( char c ) { return c == '\r' || c == '\n'; },
+            ' ' );
+
+        os << "# " << m.first << ": " << text << "\n";
+    }
+
+    for ( size_t c = 0; c < columns.size(); ++c )
+    {
+        os << ( c == 0 ? "" : "," ) << columns[c];
+    }
+    os << "\n";
+
+    for ( const auto& row : rows )
+    {
+        for ( size_t c = 0; c < row.size(); ++c )
+        {
+            os << ( c == 0 ? "" : "," );
+            write_csv_cell( os, row[c] );
+        }
+        os << "\n";
+    }
+
+    log_result( "Wrote ", rows.size(), " results to ", path );
+}
+
+void result_table::write_json( const std::string& path ) const
+{
+    std::ofstream os( path );
+    NEO_ASSERT_ALWAYS( os.is_open(), "Couldn't open ", path, " for writing!" );
+
+    const bool nested       = !metadata_name.empty();
+    const char* indentation = nested ? "    " : "  ";
+
+    os << "{";
+    if ( nested )
+    {
+        os << "\n  ";
+        write_json_string( os, metadata_name );
+        os << ": {";
+    }
+
+    for ( size_t i = 0; i < metadata.size(); ++i )
+    {
+        os << ( i == 0 ? "\n" : ",\n" ) << indentation;
+        write_json_string( os, metadata[i].first );
+        os << ": ";
+        write_json_cell( os, metadata[i].second );
+    }
+
+    if ( nested )
+    {
+        os << "\n  }";
+    }
+
+    os << ( nested || !metadata.empty() ? ",\n" : "\n" ) << "  \"results\": [";
+
+    for ( size_t r = 0; r < rows.size(); ++r )
+    {
+        os << ( r == 0 ? "\n    {" : ",\n    {" );
+        for ( size_t c = 0; c < columns.size(); ++c )
+        {
+            os << ( c == 0 ? "" : ", " );
+            write_json_string( os, columns[c] );
+            os << ": ";
+            write_json_cell( os, rows[r][c] );
+        }
+        os << "}";
+    }
+
+    os << "\n  ]\n}\n";
+
+    log_result( "Wrote ", rows.size(), " results to ", path );
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A number or a string of a result_table, numbers are formatted when they're added.
+struct result_cell
+{
+    result_cell( std::string s )
+        : text{std::move( s )}
+        , is_string{true}
+    {
+    }
+
+    result_cell( const char* s )
+        : result_cell( std::string( s ) )
+    {
+    }
+
+    template < typename T, std::enable_if_t< std::is_arithmetic_v< T >, int > = 0 >
+    result_cell( T value )
+    {
+        std::ostringstream os;
+        os << value;
+        text = os.str();
+    }
+
+    std::string text;
+    bool is_string = false;
+};
+
+// Results of a benchmark run as rows of named columns, shared by ComputeBench and
+// AssetBench and free of Vulkan. The metadata, the device or the settings of the run,
+// goes in front as "# name: value" comment lines of the csv, most readers skip them.
+// In JSON it is an object named metadata_name, or the top level fields with no name,
+// followed by the rows as an array of objects named "results".
+struct result_table
+{
+    std::string metadata_name;
+    std::vector< std::pair< std::string, result_cell > > metadata;
+
+    std::vector< std::string > columns;
+    std::vector< std::vector< result_cell > > rows;
+
+    // with a cell for every column
+    void add_row( std::vector< result_cell > row );
+
+    void write_csv( const std::string& path ) const;
+    void write_json( const std::string& path ) const;
+};
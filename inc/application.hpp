@@ -1,9 +1,12 @@
 #pragma once
 
 #include <charconv>
+#include <chrono>
 #include <array>
 
 #include "application_data.hpp"
+#include "cpu_profiler.hpp"
+#include "frame_stats.hpp"
 #include "vulkan_data.hpp"
 #include "vulkan.hpp"
 #include "sdl.hpp"
@@ -32,6 +35,14 @@ namespace detail
     }
 } // namespace detail
 
+// how long the phases of application::initialize() took
+struct startup_timings
+{
+    double window_ms;
+    double vulkan_ms;
+    double renderer_ms;
+};
+
 template < class TRenderer > struct application final
 {
   public:
@@ -53,9 +64,23 @@ template < class TRenderer > struct application final
 
   public:
     application_data& get_data() { return m_data; }
+    TRenderer& get_renderer() { return m_renderer; }
+    vulkan_data< application_data::stack_alloc_t >& get_vulkan_data()
+    {
+        return m_vulkan_data;
+    }
+    const startup_timings& get_startup_timings() const { return m_startup; }
 
     void initialize()
     {
+        using clock_h = std::chrono::high_resolution_clock;
+
+        const auto to_ms = []( clock_h::time_point from, clock_h::time_point to ) {
+            return std::chrono::duration< double, std::milli >( to - from ).count();
+        };
+
+        const auto t0 = clock_h::now();
+
         m_sdl_context = sdl_context::make();
         m_sdl_window  = sdl_window::make( TRenderer::NAME, 0, 0, TRenderer::WIDTH,
                                          TRenderer::HEIGHT );
@@ -71,10 +96,17 @@ template < class TRenderer > struct application final
             return result == SDL_TRUE;
         };
 
+        const auto t1 = clock_h::now();
+
         initialize_vulkan( m_vulkan_data, extensions, create_vulkan_surface,
                            {TRenderer::WIDTH, TRenderer::HEIGHT} );
 
+        const auto t2 = clock_h::now();
+
         m_renderer.initialize();
+        vkDeviceWaitIdle( m_vulkan_data.logical_device );
+
+        m_startup = {to_ms( t0, t1 ), to_ms( t1, t2 ), to_ms( t2, clock_h::now() )};
     }
 
     void run()
@@ -89,6 +121,8 @@ template < class TRenderer > struct application final
 
         while ( !quit )
         {
+            PROFILE_SCOPE( "frame" );
+
             while ( SDL_PollEvent( &e ) != 0 )
             {
                 if ( e.type == SDL_QUIT )
@@ -112,6 +146,8 @@ template < class TRenderer > struct application final
 
             if ( m_time >= 0.5f )
             {
+                // keeps the profiler rings from filling up
+                profiler_collect();
                 update_window_name();
                 m_time        = 0.0f;
                 m_fps_counter = 0;
@@ -121,6 +157,52 @@ template < class TRenderer > struct application final
         }
     }
 
+    // Renders frame_count frames as fast as possible, returns the average frame time in
+    // milliseconds including the wait for the last frame to finish. With a fixed_dt_s
+    // every step advances the animation by it instead of the elapsed time, so runs are
+    // repeatable. frame_times gets the wall clock time of every frame in microseconds.
+    double run_frames( uint32_t frame_count, float fixed_dt_s = 0.0f,
+                       hdr_histogram* frame_times = nullptr )
+    {
+        using clock_h = std::chrono::high_resolution_clock;
+
+        SDL_Event e{};
+        const auto start = clock_h::now();
+        auto t1          = start;
+
+        for ( uint32_t i = 0; i < frame_count; ++i )
+        {
+            PROFILE_SCOPE( "frame" );
+
+            while ( SDL_PollEvent( &e ) != 0 )
+            {
+            }
+
+            const auto t2 = clock_h::now();
+            const auto t_us =
+                std::chrono::duration_cast< std::chrono::microseconds >( t2 - t1 )
+                    .count();
+
+            // the first step has nothing before it to measure
+            if ( frame_times != nullptr && i > 0 )
+            {
+                frame_times->record( t_us );
+            }
+
+            m_renderer.step( fixed_dt_s > 0.0f ? fixed_dt_s : t_us * 0.000001f );
+
+            t1 = t2;
+        }
+
+        vkDeviceWaitIdle( m_vulkan_data.logical_device );
+        profiler_collect();
+
+        const double total_ms =
+            std::chrono::duration< double, std::milli >( clock_h::now() - start ).count();
+
+        return total_ms / frame_count;
+    }
+
     void update_window_name()
     {
         std::array< char, 512 > buffer;
@@ -155,4 +237,6 @@ template < class TRenderer > struct application final
 
     uint64_t m_fps_counter;
     float m_time;
+
+    startup_timings m_startup{};
 };
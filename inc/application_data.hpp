@@ -1,5 +1,6 @@
 #pragma once
 
+#include "frame_arena.hpp"
 #include "static_array.hpp"
 
 struct application_data
@@ -7,5 +8,9 @@ struct application_data
     static constexpr int64_t stack_size = 1024 * 1024 * 2;
     using stack_alloc_t                 = stack_allocator< stack_size >;
 
+    // per frame, initialize() with the frames in flight
+    static constexpr int64_t frame_arena_size = 1024 * 256;
+    using frame_arena_t                       = frame_arena< frame_arena_size >;
+
     stack_alloc_t stack_alloc{};
 };
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+
+struct auto_exposure_settings
+{
+    float min_log_luminance   = -10.0f;
+    float log_luminance_range = 12.0f;
+    float adaptation_rate     = 1.5f; //!< how fast we converge, 1/s
+    float key_value           = 0.18f;
+};
+
+// Luminance histogram based auto exposure. Everything stays on the GPU: one dispatch
+// builds a log2 luminance histogram of the HDR frame, a second single workgroup
+// dispatch reduces it into an adapted exposure which the tone mapping pass reads
+// straight from exposure_buffer().
+class auto_exposure final
+{
+  public:
+    static constexpr uint32_t HISTOGRAM_BINS = 256;
+
+    using settings = auto_exposure_settings;
+
+    // layout of the exposure buffer as seen by the shaders
+    struct exposure_state
+    {
+        float exposure;
+        float average_luminance;
+    };
+
+    auto_exposure( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    // hdr_layout is the layout hdr_image_view is in when record() executes, GENERAL or
+    // SHADER_READ_ONLY_OPTIMAL
+    void initialize( VkImageView hdr_image_view, VkImageLayout hdr_layout,
+                     VkExtent2D extent, uint32_t frame_count,
+                     const settings& s = settings{} );
+    void deinitialize();
+
+    void update( float dt_s, uint32_t frame_idx );
+    void record( VkCommandBuffer cmd, uint32_t frame_idx );
+
+    VkBuffer exposure_buffer() const { return m_exposure.buffer; }
+
+    // Blocking readback, for validation against the cpu reference only.
+    exposure_state read_exposure_state();
+
+  private:
+    void create_buffers( uint32_t frame_count );
+    void destroy_buffers();
+
+    void init_descriptor_set_layouts();
+    void destroy_descriptor_set_layouts();
+
+    void create_descriptor_sets( VkImageView hdr_image_view, VkImageLayout hdr_layout,
+                                 uint32_t frame_count );
+    void destroy_descriptor_sets();
+
+    void init_pipelines();
+    void destroy_pipelines();
+
+    struct push_constants
+    {
+        float min_log_luminance;
+        float log_luminance_range;
+        float adaptation_rate;
+        float key_value;
+        uint32_t pixel_count;
+    };
+
+    struct frame_params
+    {
+        float dt_s;
+    };
+
+    settings m_settings;
+    VkExtent2D m_extent;
+
+    buffer_data m_histogram;
+    buffer_data m_exposure;
+    std::vector< buffer_data > m_frame_params;
+
+    VkSampler m_sampler;
+
+    VkDescriptorSetLayout m_histogram_set_layout;
+    VkDescriptorSetLayout m_average_set_layout;
+    VkDescriptorPool m_descriptor_pool;
+    VkDescriptorSet m_histogram_set;
+    std::vector< VkDescriptorSet > m_average_sets;
+
+    VkPipelineLayout m_histogram_pipeline_layout;
+    VkPipelineLayout m_average_pipeline_layout;
+    VkPipeline m_histogram_pipeline;
+    VkPipeline m_average_pipeline;
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
+
+struct auto_exposure_reference_result
+{
+    std::array< uint32_t, auto_exposure::HISTOGRAM_BINS > histogram;
+    float average_luminance;
+    float exposure;
+};
+
+// CPU mirror of luminance_histogram.comp and luminance_average.comp, rgba holds
+// width * height linear HDR pixels.
+auto_exposure_reference_result
+compute_auto_exposure_reference( const float* rgba, int32_t width, int32_t height,
+                                 const auto_exposure::settings& s,
+                                 float previous_average_luminance, float dt_s );
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+
+#include "glm/glm.hpp"
+
+#include "thread_pool.hpp"
+
+// One workgroup of an emulated compute dispatch. Invocations run in lockstep: every
+// invocations() call executes its body for all of them before returning, so
+// consecutive calls are separated by an implicit barrier(). Values an invocation keeps
+// across a barrier live in per invocation arrays, indexed by local_index.
+class workgroup final
+{
+  public:
+    workgroup( glm::uvec3 id, glm::uvec3 count, glm::uvec3 size )
+        : m_id{id}
+        , m_count{count}
+        , m_size{size}
+        , m_invocation_count{size.x * size.y * size.z}
+    {
+    }
+
+    // f( local_index ) for gl_LocalInvocationIndex 0 .. invocation_count() - 1, the loop
+    // is kept simple enough for the compiler to vectorize across invocations
+    template < typename F > void invocations( F&& f ) const
+    {
+        for ( uint32_t i = 0; i < m_invocation_count; ++i )
+        {
+            f( i );
+        }
+    }
+
+    glm::uvec3 local_id( uint32_t local_index ) const
+    {
+        return {local_index % m_size.x, ( local_index / m_size.x ) % m_size.y,
+                local_index / ( m_size.x * m_size.y )};
+    }
+
+    glm::uvec3 global_id( uint32_t local_index ) const
+    {
+        return m_id * m_size + local_id( local_index );
+    }
+
+    // same linearisation the shaders use for 2D dispatches
+    uint32_t linear_id() const
+    {
+        return ( m_id.z * m_count.y + m_id.y ) * m_count.x + m_id.x;
+    }
+
+    glm::uvec3 id() const { return m_id; }
+    glm::uvec3 count() const { return m_count; }
+    glm::uvec3 size() const { return m_size; }
+    uint32_t invocation_count() const { return m_invocation_count; }
+
+  private:
+    glm::uvec3 m_id;
+    glm::uvec3 m_count;
+    glm::uvec3 m_size;
+    uint32_t m_invocation_count;
+};
+
+// Executes kernels written against workgroup with Vulkan dispatch semantics on a
+// thread pool. Workgroups run concurrently and in no particular order, kernels may only
+// communicate between workgroups through disjoint writes, like shaders without atomics.
+class cpu_compute final
+{
+  public:
+    explicit cpu_compute( thread_pool& pool )
+        : m_pool{pool}
+    {
+    }
+
+    // kernel( workgroup&, TShared& ) once per workgroup, TShared plays the role of the
+    // shared variables and starts out value initialized
+    template < typename TShared, typename F >
+    void dispatch( glm::uvec3 group_count, glm::uvec3 local_size, F&& kernel )
+    {
+        const uint32_t total = group_count.x * group_count.y * group_count.z;
+
+        // a few chunks per thread leave the stealing something to balance
+        const uint32_t grain =
+            std::max( total / ( ( m_pool.thread_count() + 1 ) * 8 ), 1u );
+
+        m_pool.parallel_for( total, grain, [&]( uint32_t begin, uint32_t end ) {
+            for ( uint32_t i = begin; i < end; ++i )
+            {
+                const glm::uvec3 id{i % group_count.x,
+                                    ( i / group_count.x ) % group_count.y,
+                                    i / ( group_count.x * group_count.y )};
+
+                workgroup wg{id, group_count, local_size};
+                TShared shared{};
+                kernel( wg, shared );
+            }
+        } );
+    }
+
+    thread_pool& pool() { return m_pool; }
+
+  private:
+    thread_pool& m_pool;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include "cpu_compute.hpp"
+#include "primitives_common.hpp"
+
+// Ports of reduce.comp and radix_histogram.comp to cpu_compute. They keep the
+// workgroup structure of the shaders, so results and partial outputs line up with the
+// SPIR-V versions and can be compared one to one.
+
+// Same two passes as gpu_primitives::record_reduce.
+uint32_t cpu_reduce( cpu_compute& compute, primitives::reduce_op op,
+                     const uint32_t* in, uint32_t count );
+
+// One radix_histogram.comp dispatch, table holds RADIX_DIGITS * sort_partitions( count )
+// digit major counts.
+void cpu_radix_histogram( cpu_compute& compute, const uint32_t* keys, uint32_t count,
+                          uint32_t shift, uint32_t* table );
+
+// Plain loop version of cpu_radix_histogram.
+void radix_histogram_reference( const uint32_t* keys, uint32_t count, uint32_t shift,
+                                uint32_t* table );
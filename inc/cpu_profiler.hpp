@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Scoped CPU zones, PROFILE_SCOPE( "name" ) measures the rest of the enclosing block.
+// The name has to outlive the profiler, string literals do.
+//
+// Every thread writes its zones into a ring buffer of its own with no locks on the way,
+// profiler_collect() drains the rings of all threads. Zones don't fit into a full ring
+// are dropped and counted, so collect often enough. profiler_write_chrome_trace() writes
+// what was collected as Chrome trace JSON, which chrome://tracing and Perfetto open. A
+// thread keeps its latest 256k zones, older ones are discarded.
+//
+// Builds without NEO_PROFILER_ENABLED (premake --profiler) compile all of it to nothing.
+#ifndef NEO_PROFILER_ENABLED
+#define NEO_PROFILER_ENABLED 0
+#endif
+
+#if NEO_PROFILER_ENABLED
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#elif defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// TSC ticks where there is one, converted to time when the trace is written
+inline uint64_t profiler_timestamp()
+{
+#if defined( _MSC_VER ) || defined( __x86_64__ ) || defined( __i386__ )
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+               std::chrono::steady_clock::now().time_since_epoch() )
+        .count();
+#endif
+}
+
+void profiler_record( const char* name, uint64_t begin, uint64_t end );
+
+void profiler_collect();
+bool profiler_write_chrome_trace( const std::string& path );
+uint64_t profiler_dropped_zones();
+
+class profile_zone final
+{
+  public:
+    explicit profile_zone( const char* name )
+        : m_name{name}
+        , m_begin{profiler_timestamp()}
+    {
+    }
+
+    ~profile_zone() { profiler_record( m_name, m_begin, profiler_timestamp() ); }
+
+    profile_zone( const profile_zone& ) = delete;
+    profile_zone& operator=( const profile_zone& ) = delete;
+
+  private:
+    const char* m_name;
+    uint64_t m_begin;
+};
+
+#define NEO_PROFILE_CONCAT_IMPL( a, b ) a##b
+#define NEO_PROFILE_CONCAT( a, b ) NEO_PROFILE_CONCAT_IMPL( a, b )
+#define PROFILE_SCOPE( name )                                                            \
+    const profile_zone NEO_PROFILE_CONCAT( profile_zone_, __LINE__ ) { name }
+
+#else
+
+inline void profiler_collect() {}
+inline bool profiler_write_chrome_trace( const std::string& ) { return false; }
+inline uint64_t profiler_dropped_zones() { return 0; }
+
+#define PROFILE_SCOPE( name )
+
+#endif
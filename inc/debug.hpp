@@ -1,11 +1,15 @@
 #pragma once
 
+#include <cstdlib>
+
 #include "logger.hpp"
 
 #define NEO_ASSERT_ALWAYS_IMPL( cnd, line, file_name, ... )                              \
     if ( !( cnd ) )                                                                      \
     {                                                                                    \
-        log( "ASSERT: [", file_name, ":", line, "] ", __VA_ARGS__ );                      \
+        log_at( log_level::error, log_category::general, "ASSERT: [", file_name, ":",    \
+                line, "] ", __VA_ARGS__ );                                               \
+        log_flush();                                                                     \
         exit( -1 );                                                                      \
     }
 #define NEO_ASSERT_ALWAYS( cnd, ... )                                                    \
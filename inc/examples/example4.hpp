@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <vector>
 
 #define GLM_FORCE_RADIANS
@@ -12,12 +13,35 @@
 #include "application_data.hpp"
 #include "model.hpp"
 #include "image.hpp"
+#include "auto_exposure.hpp"
+#include "geometry_pool.hpp"
+#include "instance_scene.hpp"
+#include "hiz_pyramid.hpp"
+#include "instance_culling.hpp"
+#include "render_queue.hpp"
+#include "parallel_recorder.hpp"
+#include "thread_pool.hpp"
+#include "gpu_profiler.hpp"
+#include "render_diagnostics.hpp"
+#include "frame_stats.hpp"
+#include "render_graph.hpp"
+#include "examples/example4_transforms.hpp"
 
 class example4 final
 {
   public:
     example4( vulkan_data< application_data::stack_alloc_t >& vk_data )
-        : m_vulkan_data{vk_data}
+        : m_graph{vk_data}
+        , m_auto_exposure{vk_data}
+        , m_geometry{vk_data}
+        , m_instances{vk_data}
+        , m_hiz{vk_data}
+        , m_culling{vk_data}
+        , m_early_recorder{vk_data, m_workers}
+        , m_late_recorder{vk_data, m_workers}
+        , m_profiler{vk_data}
+        , m_diagnostics{vk_data}
+        , m_vulkan_data{vk_data}
     {
     }
 
@@ -25,10 +49,54 @@ class example4 final
     static constexpr auto WIDTH  = 1280;
     static constexpr auto HEIGHT = 720;
 
+    static constexpr uint32_t MAX_INSTANCES = 1u << 17;
+
+    // room for meshes streamed in next to the cat
+    static constexpr uint32_t MAX_POOL_VERTICES = 1u << 18;
+    static constexpr uint32_t MAX_POOL_INDICES  = 1u << 20;
+
+    static constexpr uint32_t MAX_PROFILED_SCOPES = 16;
+
     void initialize();
     void step( float delta_time_ms );
     void deinitialize();
 
+    // Every instance is drawn with the model matrix of the uniform buffer applied
+    // first, so all the cats keep spinning around their own origin. Instances outside
+    // of the view frustum or hidden behind other cats are culled on the GPU, distant
+    // ones are drawn with a simplified cat.
+    instance_scene& instances() { return m_instances; }
+
+    // culling outcome of the most recent frame that finished on the GPU
+    const instance_cull_stats& last_cull_stats() const { return m_cull_stats; }
+
+    // binds and draws of the most recent recording of the scene passes
+    const render_queue_stats& last_render_stats() const { return m_render_stats; }
+
+    // times the scene passes were recorded, the other frames reuse them
+    uint32_t scene_recordings() const { return m_scene_recordings; }
+
+    // GPU time of the whole frame and of each pass
+    const gpu_profiler& profiler() const { return m_profiler; }
+
+    // Before initialize(), measures pipeline statistics of the scene passes and renders
+    // the visible instances into an overdraw heatmap every frame.
+    void enable_diagnostics() { m_diagnostics_enabled = true; }
+    bool diagnostics_enabled() const { return m_diagnostics_enabled; }
+    const frame_diagnostics& last_diagnostics() const
+    {
+        return m_diagnostics.last_frame();
+    }
+
+    // CPU side durations of every frame, where the time of step() goes
+    frame_stats& frame_statistics() { return m_frame_stats; }
+
+    // how much of the per frame arena the frames needed
+    frame_arena_stats frame_arena_statistics() const { return m_frame_arena.stats(); }
+
+    // replaces the scene with count cats laid out on a square grid filling the view
+    void set_instance_grid( uint32_t count );
+
   private:
     void init_command_buffer();
     void destroy_command_buffer();
@@ -36,6 +104,11 @@ class example4 final
     void init_pipeline();
     void destroy_pipeline();
 
+    void init_tone_map_pipeline();
+    void destroy_tone_map_pipeline();
+
+    void record_overdraw( uint32_t idx );
+
     void create_uniform_buffers();
     void destroy_uniform_buffers();
 
@@ -48,19 +121,18 @@ class example4 final
     void create_descriptor_sets();
     void destroy_descriptor_sets();
 
-    void init_framebuffers_and_images();
-    void destroy_framebuffers_and_images();
+    void create_tone_map_descriptor_set();
 
-    void init_render_pass();
-    void destroy_render_pass();
+    void init_render_graph();
+    void destroy_render_graph();
 
-    void record_command_buffers();
+    void create_fences();
+    void destroy_fences();
 
-    void create_vertex_buffer( const std::vector< vtx_t::vertex >& vertices );
-    void destroy_vertex_buffer();
+    void record_command_buffer( uint32_t idx );
 
-    void create_index_buffer( const std::vector< vtx_t::index >& indices );
-    void destroy_index_buffer();
+    // compacts a fragmented pool and hands the culling the ranges of the current version
+    void sync_geometry();
 
     void create_texture( const image& img );
     void copy_texture_data( const image& img );
@@ -68,15 +140,27 @@ class example4 final
 
     void update_unform_buffer( float dt_s, uint32_t current_image );
 
-    // one per swapchain image
-    std::vector< VkCommandBuffer > m_cmd_draw;
-    std::vector< VkFramebuffer > m_framebuffers;
+    static constexpr VkFormat HDR_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
 
-    VkImage m_depth_stencil_image;
-    VkImageView m_depth_stencil_image_view;
-    VkDeviceMemory m_depth_stencil_memory;
-
-    VkRenderPass m_render_pass;
+    // one per swapchain image, recorded again every frame
+    std::vector< VkCommandPool > m_cmd_pools;
+    std::vector< VkCommandBuffer > m_cmd_draw;
+    std::vector< VkFence > m_fences;
+
+    // The scene is rendered into a linear HDR target, tone mapped into the swapchain.
+    // The late instances are drawn on top of the early ones by a second scene pass, the
+    // depth buffer lives from the first scene pass to the second. The graph owns both
+    // images, the culling, Hi-Z and exposure passes synchronize their own buffers.
+    render_graph m_graph;
+    render_graph::resource m_hdr_color;
+    render_graph::resource m_depth;
+    uint32_t m_early_scene_pass;
+    uint32_t m_late_scene_pass;
+    uint32_t m_tone_map_pass;
+    VkSampler m_hdr_sampler;
+
+    // image the graph is executed for, what its passes record for
+    uint32_t m_frame_idx = 0;
 
     VkDescriptorSetLayout m_descriptor_set_layout;
     VkDescriptorPool m_descriptor_pool;
@@ -85,23 +169,54 @@ class example4 final
     VkPipelineLayout m_pipeline_layout;
     VkPipeline m_pipeline;
 
-    float m_rotation_y = 0.0f;
-    float m_rotation_x = 0.0f;
-    float m_rotation_z = 0.0f;
+    // the scene pipeline writing 1 into the overdraw heatmap, diagnostics only
+    VkPipeline m_overdraw_pipeline = nullptr;
 
-    uint32_t m_indices_to_draw = 0;
+    VkDescriptorSetLayout m_tone_map_set_layout;
+    VkDescriptorSet m_tone_map_set;
+    VkPipelineLayout m_tone_map_pipeline_layout;
+    VkPipeline m_tone_map_pipeline;
 
-    struct
-    {
-        VkDeviceMemory memory;
-        VkBuffer buffer;
-    } m_vertices;
+    auto_exposure m_auto_exposure;
 
-    struct
-    {
-        VkDeviceMemory memory;
-        VkBuffer buffer;
-    } m_indices;
+    // the scene passes draw whatever the culling passes find visible, so they are only
+    // recorded again when the geometry changes
+    geometry_pool m_geometry;
+    geometry_pool::handle m_cat = geometry_pool::INVALID_HANDLE;
+
+    instance_scene m_instances;
+    hiz_pyramid m_hiz;
+    instance_culling m_culling;
+    instance_cull_stats m_cull_stats{};
+
+    // cooks the LOD chains and records the scene passes
+    thread_pool m_workers;
+
+    render_queue m_scene_queue;
+    parallel_recorder m_early_recorder;
+    parallel_recorder m_late_recorder;
+    render_queue_stats m_render_stats{};
+
+    // geometry version the scene passes of each image were recorded at, and the one
+    // the culling draws
+    std::vector< uint32_t > m_scene_versions;
+    uint32_t m_culling_version = 0;
+    uint32_t m_scene_recordings = 0;
+
+    gpu_profiler m_profiler;
+
+    bool m_diagnostics_enabled = false;
+    render_diagnostics m_diagnostics;
+
+    // temporaries of the CPU side of a frame, one allocator per fence
+    application_data::frame_arena_t m_frame_arena;
+
+    frame_stats m_frame_stats;
+    std::chrono::steady_clock::time_point m_last_step;
+
+    float m_rotation_y = 0.0f;
+    float m_rotation_x = 0.0f;
+    float m_rotation_z = 0.0f;
 
     struct
     {
@@ -117,12 +232,7 @@ class example4 final
         VkBuffer buffer;
     };
 
-    struct uniform_buffer
-    {
-        glm::mat4 model;
-        glm::mat4 view;
-        glm::mat4 proj;
-    };
+    using uniform_buffer = example4_transforms;
 
     std::vector< memory_buffer > m_uniform_buffers;
 
@@ -0,0 +1,40 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_LEFT_HANDED
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+// Uniform buffer contents of the cat example. Kept apart from example4 so the software
+// rasterizer renders with exactly the same matrices.
+struct example4_transforms
+{
+    glm::mat4 model;
+    glm::mat4 view;
+    glm::mat4 proj;
+};
+
+// Rotations are in quarter turns.
+inline example4_transforms make_example4_transforms( float rotation_x, float rotation_y,
+                                                     float rotation_z, float aspect )
+{
+    example4_transforms ret{};
+
+    ret.model = glm::rotate( glm::mat4( 1.0f ), rotation_x * glm::radians( 90.0f ),
+                             glm::vec3( 1.0f, 0.0f, 0.0f ) );
+
+    ret.model *= glm::rotate( glm::mat4( 1.0f ), rotation_y * glm::radians( 90.0f ),
+                              glm::vec3( 0.0f, 1.0f, 0.0f ) );
+
+    ret.model *= glm::rotate( glm::mat4( 1.0f ), rotation_z * glm::radians( 90.0f ),
+                              glm::vec3( 0.0f, 0.0f, 1.0f ) );
+
+    ret.view = glm::lookAt( glm::vec3( 0.0f, 0.0f, 50.0f ), glm::vec3( 0.0f, 0.0f, 0.0f ),
+                            glm::vec3( 0.0f, 1.0f, 0.0f ) );
+
+    ret.proj = glm::perspective( glm::radians( 80.0f ), aspect, 0.1f, 100.0f );
+
+    return ret;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "stack_allocator.hpp"
+
+struct frame_arena_stats
+{
+    int64_t capacity;        //!< bytes of a frame
+    int64_t used;            //!< by the current frame so far
+    int64_t high_water_mark; //!< the most a frame used, overflows not included
+    uint64_t overflows;      //!< allocations that didn't fit and went to the heap
+    int64_t overflow_bytes;
+};
+
+// Linear memory for the temporaries of a frame, sort keys, culling lists, descriptor
+// writes and the like. Every frame in flight bumps through a stack_allocator of its own,
+// initialize() makes one per fence the frames are waited for with. begin_frame() rewinds
+// the allocator of the fence that just signaled, so nothing is freed one by one and the
+// heap isn't touched.
+//
+// What doesn't fit is still handed out, from the heap, and counted. Those allocations
+// live until the frame begins again as well, the statistics say how large N has to be.
+// Not thread safe, allocate on the thread running the frame and hand the memory out.
+template < int64_t N > class frame_arena
+{
+  public:
+    using marker = typename stack_allocator< N >::marker;
+
+    frame_arena() = default;
+    ~frame_arena() { release_all(); }
+
+    frame_arena( const frame_arena& ) = delete;
+    frame_arena& operator=( const frame_arena& ) = delete;
+
+  public:
+    // as many frames as there are fences, the swapchain images when a fence is waited
+    // for per image
+    void initialize( uint32_t frames )
+    {
+        assert( frames > 0 );
+
+        release_all();
+        m_frames.reset( new stack_allocator< N >[frames] );
+        m_overflows.assign( frames, {} );
+        m_frame_count = frames;
+        m_current     = 0;
+    }
+
+    // frame is the index of the fence just waited for
+    void begin_frame( uint32_t frame )
+    {
+        assert( frame < m_frame_count );
+
+        m_current = frame;
+        release_overflows( m_current );
+        m_frames[m_current].reset();
+    }
+
+    void* allocate( int64_t size, int64_t alignment = alignof( void* ) )
+    {
+        void* ret = m_frames[m_current].try_allocate( size, alignment );
+
+        if ( ret == nullptr )
+        {
+            ret = ::operator new( size, std::align_val_t( alignment ) );
+            m_overflows[m_current].emplace_back( ret, alignment );
+            m_overflow_bytes += size;
+        }
+
+        return ret;
+    }
+
+    // value initialized, nothing is ever destroyed
+    template < typename T > T* allocate_array( int64_t count )
+    {
+        static_assert( std::is_trivially_destructible_v< T >,
+                       "Frame memory is reused without running destructors" );
+
+        T* ret = static_cast< T* >( allocate( count * sizeof( T ), alignof( T ) ) );
+        for ( int64_t i = 0; i < count; ++i )
+        {
+            new ( &ret[i] ) T{};
+        }
+
+        return ret;
+    }
+
+    // for static_array, the memory only comes back with the frame
+    void free( void* /*ptr*/ ) {}
+
+    // markers of the current frame, heap allocations aren't rewound
+    marker save() const { return m_frames[m_current].save(); }
+    void rewind( marker m ) { m_frames[m_current].rewind( m ); }
+
+    frame_arena_stats stats() const
+    {
+        const int64_t used = m_frame_count > 0 ? m_frames[m_current].size() : 0;
+        frame_arena_stats ret{N, used, 0, 0, m_overflow_bytes};
+
+        for ( uint32_t f = 0; f < m_frame_count; ++f )
+        {
+            ret.high_water_mark = std::max( ret.high_water_mark,
+                                            m_frames[f].high_water_mark() );
+            ret.overflows += m_frames[f].overflows();
+        }
+
+        return ret;
+    }
+
+  private:
+    void release_overflows( uint32_t frame )
+    {
+        for ( const auto& o : m_overflows[frame] )
+        {
+            ::operator delete( o.first, std::align_val_t( o.second ) );
+        }
+
+        m_overflows[frame].clear();
+    }
+
+    void release_all()
+    {
+        for ( uint32_t f = 0; f < m_frame_count; ++f )
+        {
+            release_overflows( f );
+        }
+    }
+
+    std::unique_ptr< stack_allocator< N >[] > m_frames;
+    uint32_t m_frame_count = 0;
+    uint32_t m_current     = 0;
+
+    // pointer and alignment of what a frame got from the heap
+    std::vector< std::vector< std::pair< void*, int64_t > > > m_overflows;
+    int64_t m_overflow_bytes = 0;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+// Log-linear histogram of integer values. Values below 2 * SUB_BUCKETS are counted
+// exactly, above every power of two is split into SUB_BUCKETS buckets, so any value is
+// off by less than 1 / SUB_BUCKETS. Values past MAX_VALUE count as MAX_VALUE.
+class hdr_histogram final
+{
+  public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 7;
+    static constexpr uint32_t SUB_BUCKETS     = 1u << SUB_BUCKET_BITS;
+    static constexpr uint32_t MAGNITUDES      = 30;
+    static constexpr uint64_t MAX_VALUE = ( uint64_t{2} * SUB_BUCKETS << MAGNITUDES ) - 1;
+
+    hdr_histogram();
+
+    void record( uint64_t value );
+    void reset();
+
+    uint64_t count() const { return m_count; }
+    uint64_t max() const { return m_max; }
+
+    // the largest value of the bucket the percentile p in [0, 1] falls into
+    uint64_t value_at_percentile( double p ) const;
+
+  private:
+    static uint32_t bucket_index( uint64_t value );
+    static uint64_t bucket_highest_value( uint32_t idx );
+
+    std::vector< uint64_t > m_buckets;
+    uint64_t m_count = 0;
+    uint64_t m_max   = 0;
+};
+
+// Where the time of one frame went, in milliseconds
+struct frame_timing
+{
+    double frame_ms;   //!< from the start of the previous frame to the start of this one
+    double acquire_ms; //!< acquiring the image and waiting for its fence
+    double cpu_ms;     //!< updates and recording, between the acquire and the submit
+    double submit_ms;
+    double present_ms;
+};
+
+// Tail latencies of one of the frame_timing durations
+struct frame_time_summary
+{
+    const char* name;
+    uint64_t frames;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double p999_ms;
+    double max_ms;
+};
+
+// Frame times of the whole run in histograms with microsecond resolution, so averages
+// can't hide stutter, and the last HISTORY frames one by one for CSV export.
+//
+// dump_on_signal() makes SIGUSR1 write the CSV from the next record(), where the
+// platform has SIGUSR1.
+class frame_stats final
+{
+  public:
+    static constexpr uint32_t HISTORY = 1u << 16;
+
+    frame_stats();
+
+    void record( const frame_timing& timing );
+    void reset();
+
+    // frame, acquire, cpu, submit and present, in this order
+    std::vector< frame_time_summary > summary() const;
+
+    // frame number and the durations of every frame in the history, oldest first
+    bool write_csv( const std::string& path ) const;
+
+    void dump_on_signal( const std::string& path );
+
+  private:
+    static constexpr uint32_t METRICS = 5;
+
+    std::array< hdr_histogram, METRICS > m_histograms;
+
+    std::vector< frame_timing > m_history; //!< ring buffer
+    uint64_t m_frames = 0;
+
+    std::string m_signal_path;
+};
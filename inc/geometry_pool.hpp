@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+#include "model.hpp"
+
+// Many meshes packed into one device local vertex buffer and one index buffer, so all of
+// them draw with a single binding. Each mesh keeps its own indices, a draw adds the
+// vertex offset of its range, which is what VkDrawIndexedIndirectCommand needs to draw
+// any mix of pooled meshes from one buffer of commands.
+//
+// Space is handed out first fit from free lists of vertices and indices, remove() gives
+// it back and merges it with its free neighbours. compact() closes the holes left
+// behind. Handles stay valid until their mesh is removed.
+class geometry_pool final
+{
+  public:
+    using handle = uint32_t;
+
+    static constexpr handle INVALID_HANDLE = ~0u;
+
+    // where a mesh lives in the pool, its LOD chain with pool wide first indices
+    struct mesh_range
+    {
+        int32_t vertex_offset;
+        uint32_t vertex_count;
+        uint32_t first_index;
+        uint32_t index_count;
+        std::vector< lod_level > lods;
+    };
+
+    geometry_pool( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    void initialize( uint32_t max_vertices, uint32_t max_indices );
+    void deinitialize();
+
+    // Copies the mesh in through a staging buffer and blocks until it's there. A mesh
+    // without LODs gets one covering all of its indices. INVALID_HANDLE when no free
+    // range is large enough, compact() might help.
+    handle add( const model_data& model );
+
+    // the GPU must be done with the mesh
+    void remove( handle h );
+
+    // Moves every mesh to the front of freshly allocated buffers and frees the old ones,
+    // the GPU must be done with the pool. Ranges and buffers change, commands using them
+    // have to be recorded again.
+    void compact();
+
+    const mesh_range& range( handle h ) const { return m_meshes[h]; }
+
+    // vertex binding 0 and the uint32 index buffer
+    void bind( VkCommandBuffer cmd ) const;
+
+    VkBuffer vertex_buffer() const { return m_vertices.buffer; }
+    VkBuffer index_buffer() const { return m_indices.buffer; }
+
+    // changes whenever a mesh is added, removed or moved, commands recorded at another
+    // version may draw what isn't there anymore
+    uint32_t version() const { return m_version; }
+
+    uint32_t mesh_count() const { return m_mesh_count; }
+    uint32_t used_vertices() const { return m_used_vertices; }
+    uint32_t used_indices() const { return m_used_indices; }
+
+    // number of free ranges, 1 when nothing is fragmented
+    uint32_t fragments() const
+    {
+        return static_cast< uint32_t >(
+            std::max( m_free_vertices.ranges.size(), m_free_indices.ranges.size() ) );
+    }
+
+  private:
+    // Sorted, non adjacent free ranges of one buffer. Offsets are in elements.
+    struct free_list
+    {
+        struct range
+        {
+            uint32_t offset;
+            uint32_t count;
+        };
+
+        std::vector< range > ranges;
+
+        void reset( uint32_t capacity );
+        bool allocate( uint32_t count, uint32_t& offset );
+        void release( uint32_t offset, uint32_t count );
+    };
+
+    void create_buffers( buffer_data& vertices, buffer_data& indices ) const;
+
+    uint32_t m_max_vertices;
+    uint32_t m_max_indices;
+    uint32_t m_mesh_count    = 0;
+    uint32_t m_used_vertices = 0;
+    uint32_t m_used_indices  = 0;
+    uint32_t m_version       = 0;
+
+    buffer_data m_vertices;
+    buffer_data m_indices;
+
+    free_list m_free_vertices;
+    free_list m_free_indices;
+
+    // indexed by handle, index_count 0 marks a free slot
+    std::vector< mesh_range > m_meshes;
+    std::vector< handle > m_free_handles;
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <initializer_list>
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+#include "primitives_common.hpp"
+
+// Building blocks over uint32 storage buffers: exclusive prefix sum (per workgroup or
+// device wide with decoupled look-back), sum/min/max reduction and an LSD radix
+// sort of 32 bit key/value pairs. The record_* calls only record compute work, the
+// caller makes the inputs visible to compute shaders beforehand and waits on
+// VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT before consuming the outputs.
+//
+// Descriptor sets are allocated from an internal pool on every record_* call,
+// reset() recycles them once the recorded command buffers have finished executing.
+class gpu_primitives final
+{
+  public:
+    static constexpr uint32_t SCAN_PARTITION_SIZE = primitives::SCAN_PARTITION_SIZE;
+    static constexpr uint32_t SORT_PARTITION_SIZE = primitives::SORT_PARTITION_SIZE;
+    static constexpr uint32_t REDUCE_MAX_GROUPS   = primitives::REDUCE_MAX_GROUPS;
+    static constexpr uint32_t RADIX_DIGITS        = primitives::RADIX_DIGITS;
+    static constexpr uint32_t MAX_SETS            = 256;
+
+    using reduce_op = primitives::reduce_op;
+
+    gpu_primitives( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    // max_elements bounds the count of every following record_* call
+    void initialize( uint32_t max_elements );
+    void deinitialize();
+
+    void reset();
+
+    // out[i] = in[0] + ... + in[i - 1], in and out may be the same buffer, count is at
+    // most max_elements
+    void record_scan( VkCommandBuffer cmd, VkBuffer in, VkBuffer out, uint32_t count );
+
+    // same as record_scan but restarts at every SCAN_PARTITION_SIZE block, with the same
+    // limit on count
+    void record_workgroup_scan( VkCommandBuffer cmd, VkBuffer in, VkBuffer out,
+                                uint32_t count );
+
+    // out[0] = op( in[0], ..., in[count - 1] )
+    void record_reduce( VkCommandBuffer cmd, reduce_op op, VkBuffer in, VkBuffer out,
+                        uint32_t count );
+
+    // stable, in place, sorts values along with keys
+    void record_radix_sort( VkCommandBuffer cmd, VkBuffer keys, VkBuffer values,
+                            uint32_t count );
+
+    uint32_t max_elements() const { return m_max_elements; }
+
+    static uint32_t sort_partitions( uint32_t count )
+    {
+        return primitives::sort_partitions( count );
+    }
+
+  private:
+    void create_buffers();
+    void destroy_buffers();
+
+    void init_descriptor_set_layouts();
+    void destroy_descriptor_set_layouts();
+
+    void create_descriptor_pool();
+    void destroy_descriptor_pool();
+
+    void init_pipelines();
+    void destroy_pipelines();
+
+    VkDescriptorSet allocate_set( VkDescriptorSetLayout layout,
+                                  std::initializer_list< VkBuffer > buffers );
+
+    void record_scan_impl( VkCommandBuffer cmd, VkPipeline pipeline, VkBuffer in,
+                           VkBuffer out, uint32_t count );
+
+    void dispatch( VkCommandBuffer cmd, VkPipelineLayout layout, uint32_t groups,
+                   uint32_t count, uint32_t shift );
+
+    void compute_barrier( VkCommandBuffer cmd );
+
+    struct push_constants
+    {
+        uint32_t count;
+        uint32_t partitions;
+        uint32_t shift;
+    };
+
+    uint32_t m_max_elements;
+
+    buffer_data m_scan_status;
+    buffer_data m_reduce_partials;
+    buffer_data m_sort_keys;
+    buffer_data m_sort_values;
+    buffer_data m_sort_table;
+
+    // one layout per binding count, all bindings are storage buffers
+    VkDescriptorSetLayout m_set_layout_2;
+    VkDescriptorSetLayout m_set_layout_3;
+    VkDescriptorSetLayout m_set_layout_5;
+    VkDescriptorPool m_descriptor_pool;
+
+    VkPipelineLayout m_pipeline_layout_2;
+    VkPipelineLayout m_pipeline_layout_3;
+    VkPipelineLayout m_pipeline_layout_5;
+
+    VkPipeline m_scan_pipeline;
+    VkPipeline m_workgroup_scan_pipeline;
+    std::array< VkPipeline, 3 > m_reduce_pipelines;
+    VkPipeline m_radix_histogram_pipeline;
+    VkPipeline m_radix_scatter_pipeline;
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
+
+// CPU references, same semantics as the GPU versions.
+void scan_reference( const uint32_t* in, uint32_t count, uint32_t* out );
+uint32_t reduce_reference( gpu_primitives::reduce_op op, const uint32_t* in,
+                           uint32_t count );
+void radix_sort_reference( uint32_t* keys, uint32_t* values, uint32_t count );
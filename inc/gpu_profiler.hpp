@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+
+// Rolling statistics of one profiled scope over its last gpu_profiler::HISTORY frames
+struct gpu_scope_timing
+{
+    std::string name;
+    uint32_t samples;
+    double average_ms;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+};
+
+// Timestamp queries around the passes of a frame. Every frame in flight has its own
+// range of queries, the results of a frame are read when it is recorded again. By then
+// the fence of the frame has signalled, so reading never waits for the GPU. Queries the
+// GPU hasn't written yet are skipped instead.
+//
+// Scopes are identified by name, the same name in later frames adds to the same
+// statistics. Scopes may nest. On queues without timestamp support nothing is recorded.
+class gpu_profiler final
+{
+  public:
+    static constexpr uint32_t HISTORY = 128;
+
+    gpu_profiler( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    // begins and ends, the RAII way
+    class scope final
+    {
+      public:
+        scope( gpu_profiler& profiler, VkCommandBuffer cmd, const char* name )
+            : m_profiler{profiler}
+            , m_cmd{cmd}
+            , m_slot{profiler.begin( cmd, name )}
+        {
+        }
+
+        ~scope() { m_profiler.end( m_cmd, m_slot ); }
+
+        scope( const scope& ) = delete;
+        scope& operator=( const scope& ) = delete;
+
+      private:
+        gpu_profiler& m_profiler;
+        VkCommandBuffer m_cmd;
+        uint32_t m_slot;
+    };
+
+    void initialize( uint32_t frame_count, uint32_t max_scopes );
+    void deinitialize();
+
+    // Collects the results of the previous recording of frame_idx and resets its
+    // queries, outside of a render pass before any begin() of the frame.
+    void begin_frame( VkCommandBuffer cmd, uint32_t frame_idx );
+
+    // TOP_OF_PIPE to BOTTOM_OF_PIPE, begin() returns the slot end() takes
+    uint32_t begin( VkCommandBuffer cmd, const char* name );
+    void end( VkCommandBuffer cmd, uint32_t slot );
+
+    // in the order the scopes were first seen
+    std::vector< gpu_scope_timing > timings() const;
+
+    bool enabled() const { return m_query_pool != nullptr; }
+
+  private:
+    struct scope_data
+    {
+        std::string name;
+        std::vector< float > history_ms; //!< ring buffer
+        uint32_t next;
+        uint32_t samples;
+    };
+
+    void resolve( uint32_t frame_idx );
+    uint32_t find_scope( const char* name );
+
+    VkQueryPool m_query_pool = nullptr;
+    uint32_t m_max_scopes    = 0;
+    uint64_t m_valid_mask    = 0;
+    double m_ms_per_tick     = 0.0;
+
+    // the frame begin_frame() was called for last
+    uint32_t m_frame_idx = 0;
+
+    // scope of every slot, per frame
+    std::vector< std::vector< uint32_t > > m_frame_slots;
+
+    std::vector< scope_data > m_scopes;
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+
+// Hierarchical depth buffer for occlusion culling. Level 0 holds the farthest depth of
+// every 2x2 pixel block of the depth buffer, every following level the farthest of 2x2
+// texels of the level below, down to 1x1. Level sizes are rounded up, so pixel p of the
+// depth buffer always lies in texel p >> ( level + 1 ).
+//
+// The pyramid is a single R32F image with a full mip chain in VK_IMAGE_LAYOUT_GENERAL,
+// it starts out cleared to the far plane so nothing is occluded before the first
+// record().
+class hiz_pyramid final
+{
+  public:
+    static constexpr VkFormat FORMAT     = VK_FORMAT_R32_SFLOAT;
+    static constexpr uint32_t GROUP_SIZE = 8;
+
+    hiz_pyramid( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    // the depth image needs SAMPLED usage, record() finds it in depth_layout
+    void initialize( VkImage depth_image, VkFormat depth_format,
+                     VkImageLayout depth_layout, VkExtent2D depth_extent );
+    void deinitialize();
+
+    // The depth image is in the layout given to initialize() with its writes made
+    // visible to compute shaders. Afterwards the pyramid can be read by compute shaders.
+    void record( VkCommandBuffer cmd );
+
+    // all levels, read with texelFetch
+    VkImageView image_view() const { return m_image_view; }
+    VkSampler sampler() const { return m_sampler; }
+
+    uint32_t levels() const { return m_levels; }
+    VkExtent2D depth_extent() const { return m_depth_extent; }
+    VkExtent2D level_extent( uint32_t level ) const;
+
+  private:
+    void create_image();
+    void destroy_image();
+
+    void init_descriptor_set_layout();
+    void destroy_descriptor_set_layout();
+
+    void create_descriptor_sets( VkImage depth_image, VkFormat depth_format,
+                                 VkImageLayout depth_layout );
+    void destroy_descriptor_sets();
+
+    void init_pipeline();
+    void destroy_pipeline();
+
+    struct push_constants
+    {
+        int32_t dst_size[2];
+    };
+
+    VkExtent2D m_depth_extent;
+    uint32_t m_levels;
+
+    VkImage m_image;
+    VkDeviceMemory m_memory;
+    VkImageView m_image_view;
+    std::vector< VkImageView > m_level_views;
+    VkImageView m_depth_view;
+    VkSampler m_sampler;
+
+    VkDescriptorSetLayout m_set_layout;
+    VkDescriptorPool m_descriptor_pool;
+    std::vector< VkDescriptorSet > m_sets; //!< one per level
+
+    VkPipelineLayout m_pipeline_layout;
+    VkPipeline m_pipeline;
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
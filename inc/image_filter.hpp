@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+
+struct image_filter_settings
+{
+    uint32_t blur_radius  = 8; //!< baked into the blur pipeline as a spec constant
+    float blur_sigma      = 4.0f;
+    uint32_t bloom_levels = 5; //!< first level is half of the input resolution
+    float bloom_threshold = 1.0f;
+};
+
+// Compute based image filters working on RGBA16F images: separable gaussian blur and
+// a downsample / upsample bloom chain. Blur loads a line of texels plus apron into
+// shared memory once per workgroup, the bloom downsample does the same with a 2D tile.
+// All intermediate images are kept in VK_IMAGE_LAYOUT_GENERAL.
+class image_filter final
+{
+  public:
+    using settings = image_filter_settings;
+
+    static constexpr VkFormat FORMAT           = VK_FORMAT_R16G16B16A16_SFLOAT;
+    static constexpr uint32_t BLUR_TILE_SIZE   = 256;
+    static constexpr uint32_t BLOOM_GROUP_SIZE = 8;
+    static constexpr uint32_t MAX_BLUR_RADIUS  = 32;
+    static constexpr uint32_t MAX_BLOOM_LEVELS = 8;
+
+    image_filter( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    // input_layout is the layout input_view is in when the record_* calls execute,
+    // GENERAL or SHADER_READ_ONLY_OPTIMAL
+    void initialize( VkImageView input_view, VkImageLayout input_layout,
+                     VkExtent2D extent, const settings& s = settings{} );
+    void deinitialize();
+
+    // input -> blur_output(), two dispatches
+    void record_blur( VkCommandBuffer cmd );
+    void record_blur_horizontal( VkCommandBuffer cmd );
+    void record_blur_vertical( VkCommandBuffer cmd );
+
+    // input -> bloom_output(), 2 * bloom_levels - 1 dispatches
+    void record_bloom( VkCommandBuffer cmd );
+
+    const image_data& blur_output() const { return m_blur_output; }
+    const image_data& bloom_output() const { return m_bloom_levels[0]; }
+
+    const settings& get_settings() const { return m_settings; }
+
+  private:
+    void create_images();
+    void destroy_images();
+
+    void init_descriptor_set_layout();
+    void destroy_descriptor_set_layout();
+
+    void create_descriptor_sets( VkImageView input_view, VkImageLayout input_layout );
+    void destroy_descriptor_sets();
+
+    void init_pipelines();
+    void destroy_pipelines();
+
+    void general_image_barrier( VkCommandBuffer cmd, VkImage image );
+
+    struct blur_push_constants
+    {
+        int32_t direction[2];
+        int32_t size[2];
+        float sigma;
+    };
+
+    struct bloom_push_constants
+    {
+        int32_t dst_size[2];
+        float threshold; //!< negative disables thresholding
+    };
+
+    settings m_settings;
+    VkExtent2D m_extent;
+
+    image_data m_blur_temp;
+    image_data m_blur_output;
+    std::vector< image_data > m_bloom_levels;
+
+    VkSampler m_point_sampler;
+    VkSampler m_linear_sampler;
+
+    VkDescriptorSetLayout m_set_layout;
+    VkDescriptorPool m_descriptor_pool;
+    VkDescriptorSet m_blur_h_set;
+    VkDescriptorSet m_blur_v_set;
+    std::vector< VkDescriptorSet > m_downsample_sets;
+    std::vector< VkDescriptorSet > m_upsample_sets;
+
+    VkPipelineLayout m_blur_pipeline_layout;
+    VkPipelineLayout m_bloom_pipeline_layout;
+    VkPipeline m_blur_pipeline;
+    VkPipeline m_downsample_pipeline;
+    VkPipeline m_upsample_pipeline;
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
+
+// Normalized one sided kernel, weights[0] is the center tap.
+std::vector< float > gaussian_weights( uint32_t radius, float sigma );
+
+// CPU references for validation, rgba holds width * height float4 pixels. The inner
+// loops work on a whole pixel at a time with SSE when available.
+void blur_reference( const float* rgba, int32_t width, int32_t height, uint32_t radius,
+                     float sigma, float* out );
+
+// One bloom_downsample.comp step, out is ( width + 1 ) / 2 x ( height + 1 ) / 2.
+void bloom_downsample_reference( const float* rgba, int32_t width, int32_t height,
+                                 float threshold, float* out );
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+#include "instance_scene.hpp"
+#include "hiz_pyramid.hpp"
+#include "model.hpp"
+#include "render_queue.hpp"
+
+using frustum_planes = std::array< glm::vec4, 6 >;
+
+// Per frame outcome of the culling passes, every instance ends up in exactly one of
+// frustum_culled, occluded, visible_early or visible_late.
+struct instance_cull_stats
+{
+    uint32_t instances;
+    uint32_t frustum_culled;
+    uint32_t occluded;      //!< hidden by the depth of this frame
+    uint32_t visible_early; //!< visible in the pyramid of the previous frame
+    uint32_t visible_late;  //!< disoccluded this frame
+    uint64_t triangles;     //!< drawn by both phases over all LODs
+};
+
+// Frustum and occlusion culling of an instance_scene on the GPU, in two phases around
+// a hiz_pyramid.
+//
+// The early phase tests the bounding sphere of every instance against the view frustum
+// and the pyramid of the previous frame, as seen by the previous view. The visible ones
+// are drawn, that depth rebuilds the pyramid, and the late phase re-tests whatever was
+// occluded against it with the current view. The late draw adds the newly disoccluded
+// instances, so nothing pops in when the camera or the scene moves.
+//
+// Each phase appends the transforms of its visible instances to a compacted buffer and
+// writes the instance count of a VkDrawIndexedIndirectCommand. The draws consume both
+// without the CPU ever knowing what is visible, so pre-recorded command buffers stay
+// valid while the scene changes: only update() runs per frame. The order of the
+// visible instances is not stable between frames.
+//
+// Every visible instance is drawn with the coarsest level of the mesh's LOD chain whose
+// error, projected at the nearest depth of its bounds, stays under a threshold in pixels.
+// Each LOD has its own draw and its own region of the compacted transforms.
+class instance_culling final
+{
+  public:
+    static constexpr uint32_t WORKGROUP_SIZE = 256;
+    static constexpr uint32_t MAX_LODS       = 8;
+
+    instance_culling( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    // the scene and the pyramid have to be initialized, their buffers and images are
+    // bound once here. lods holds at least the full resolution mesh, vertex_offset is
+    // added to its indices.
+    void initialize( const instance_scene& scene, const hiz_pyramid& pyramid,
+                     const std::vector< lod_level >& lods, int32_t vertex_offset,
+                     uint32_t frame_count );
+    void deinitialize();
+
+    // The same LOD chain after the mesh moved, when its geometry_pool compacted or
+    // added it again. Takes effect with the next record_early(), frames recorded before
+    // keep drawing from where the mesh was.
+    void set_mesh( const std::vector< lod_level >& lods, int32_t vertex_offset );
+
+    // proj has to be a left handed, zero to one depth perspective projection, the view
+    // of the previous call is used to read the previous pyramid
+    void update( uint32_t frame_idx, const glm::mat4& view, const glm::mat4& proj,
+                 uint32_t instance_count );
+
+    // outside of a render pass, before the early draw
+    void record_early( VkCommandBuffer cmd, uint32_t frame_idx );
+
+    // outside of a render pass after the pyramid was built, before the late draw
+    void record_late( VkCommandBuffer cmd, uint32_t frame_idx );
+
+    // The indirect draw of one LOD of a phase with its transforms as vertex binding 1,
+    // for a render_queue. Pipeline, set, mesh vertices and indices are up to the caller.
+    draw_item early_draw( uint32_t lod ) const;
+    draw_item late_draw( uint32_t lod ) const;
+
+    uint32_t lod_count() const { return static_cast< uint32_t >( m_lods.size() ); }
+
+    // the transforms of LOD l start at l times the capacity of the scene
+    VkBuffer early_transforms() const { return m_early_transforms.buffer; }
+    VkBuffer late_transforms() const { return m_late_transforms.buffer; }
+
+    // projected error in pixels a coarser LOD may add, 1 by default, takes effect with
+    // the next update()
+    void set_lod_threshold( float pixels ) { m_lod_threshold = pixels; }
+
+    // only valid once the commands recorded for frame_idx have finished executing
+    instance_cull_stats read_stats( uint32_t frame_idx ) const;
+
+  private:
+    void create_buffers( uint32_t frame_count );
+    void destroy_buffers();
+
+    void init_descriptor_set_layout();
+    void destroy_descriptor_set_layout();
+
+    void create_descriptor_sets( const instance_scene& scene, const hiz_pyramid& pyramid,
+                                 uint32_t frame_count );
+    void destroy_descriptor_sets();
+
+    void init_pipelines();
+    void destroy_pipelines();
+
+    void dispatch( VkCommandBuffer cmd, uint32_t frame_idx, uint32_t phase );
+    draw_item draw( VkBuffer transforms, uint32_t phase, uint32_t lod ) const;
+
+    // layout of the per frame uniform buffer as seen by instance_cull.comp
+    struct frame_params
+    {
+        frustum_planes planes;
+        glm::mat4 view;
+        glm::mat4 previous_view;
+        glm::vec4 projection; //!< P00, P11, P22, P32
+        glm::vec2 depth_size;
+        float znear;
+        uint32_t instance_count;
+        uint32_t pyramid_levels;
+        uint32_t lod_count;
+        float lod_error_scale;
+        uint32_t lod_stride; //!< instances between the transforms of two LODs
+        std::array< float, MAX_LODS > lod_errors;
+    };
+
+    // the draw commands of every LOD of both phases followed by the number of
+    // occlusion candidates
+    struct cull_state
+    {
+        std::array< VkDrawIndexedIndirectCommand, 2 * MAX_LODS > draws;
+        uint32_t occlusion_candidates;
+    };
+
+    uint32_t m_max_instances;
+    std::vector< lod_level > m_lods;
+    int32_t m_vertex_offset;
+    float m_lod_threshold = 1.0f;
+
+    VkExtent2D m_depth_extent;
+    uint32_t m_pyramid_levels;
+
+    glm::mat4 m_previous_view;
+    bool m_has_previous_view = false;
+
+    buffer_data m_early_transforms;
+    buffer_data m_late_transforms;
+    buffer_data m_candidates;
+    buffer_data m_state;
+    std::vector< buffer_data > m_frame_params;
+
+    // copies of the state for the stats, with the instance count of their frame
+    std::vector< buffer_data > m_readback;
+    std::vector< uint32_t > m_frame_instances;
+
+    VkDescriptorSetLayout m_set_layout;
+    VkDescriptorPool m_descriptor_pool;
+    std::vector< VkDescriptorSet > m_sets;
+
+    VkPipelineLayout m_pipeline_layout;
+    std::array< VkPipeline, 2 > m_pipelines; //!< early and late phase
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
+
+// Normalized planes of the clip volume of view_proj ( depth zero to one ), xyz points
+// inside.
+frustum_planes extract_frustum_planes( const glm::mat4& view_proj );
+
+// CPU mirror of the frustum test of instance_cull.comp, indices of the visible spheres
+// in scene order.
+std::vector< uint32_t >
+cull_instances_reference( const frustum_planes& planes,
+                          const std::vector< glm::vec4 >& bounds );
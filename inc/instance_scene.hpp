@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_LEFT_HANDED
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include "glm/glm.hpp"
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+
+// Transforms of every instance of one mesh, streamed to the GPU as a per instance
+// vertex buffer so the whole set is drawn with a single instanced draw call. Next to
+// every transform we keep a world space bounding sphere ( xyz center, w radius ) for
+// culling on the GPU.
+//
+// Transforms are kept densely packed, removal moves the last instance into the hole.
+// Handles stay valid until their instance is removed. There are buffers per frame in
+// flight, upload() only copies when the scene changed since that frame's last upload.
+class instance_scene final
+{
+  public:
+    using handle = uint32_t;
+
+    static constexpr handle INVALID_HANDLE = ~0u;
+
+    instance_scene( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    // bounding_radius is the radius of a sphere around the mesh origin containing the
+    // whole mesh, so the bounds don't change when the mesh spins around its origin
+    void initialize( uint32_t max_instances, uint32_t frame_count,
+                     float bounding_radius );
+    void deinitialize();
+
+    handle add( const glm::mat4& transform );
+    void remove( handle h );
+    void set_transform( handle h, const glm::mat4& transform );
+    void clear();
+
+    uint32_t count() const { return static_cast< uint32_t >( m_transforms.size() ); }
+    uint32_t capacity() const { return m_capacity; }
+
+    void upload( uint32_t frame_idx );
+
+    const std::vector< glm::mat4 >& transforms() const { return m_transforms; }
+    const std::vector< glm::vec4 >& bounds() const { return m_bounds; }
+
+    // one mat4 per instance, usable as vertex and storage buffer
+    VkBuffer transform_buffer( uint32_t frame_idx ) const
+    {
+        return m_transform_buffers[frame_idx].buffer;
+    }
+
+    // one vec4 per instance, storage buffer
+    VkBuffer bounds_buffer( uint32_t frame_idx ) const
+    {
+        return m_bounds_buffers[frame_idx].buffer;
+    }
+
+  private:
+    glm::vec4 world_bounds( const glm::mat4& transform ) const;
+
+    uint32_t m_capacity     = 0;
+    uint64_t m_version      = 0;
+    float m_bounding_radius = 0.0f;
+
+    std::vector< glm::mat4 > m_transforms;
+    std::vector< glm::vec4 > m_bounds;
+    std::vector< handle > m_owners;  //!< handle of every packed transform
+    std::vector< uint32_t > m_slots; //!< packed index of every handle
+    std::vector< handle > m_free;
+
+    std::vector< buffer_data > m_transform_buffers;
+    std::vector< buffer_data > m_bounds_buffers;
+    std::vector< uint64_t > m_uploaded_versions;
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
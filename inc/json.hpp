@@ -0,0 +1,8 @@
+#pragma once
+
+#include <ostream>
+#include <string_view>
+
+// s as a quoted JSON string. Quotes, backslashes and control characters are escaped,
+// everything else, UTF-8 included, is written as it is.
+void write_json_string( std::ostream& os, std::string_view s );
@@ -1,18 +1,314 @@
 #pragma once
 
-#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <iomanip>
-#include <chrono>
+#include <new>
 
-static const auto start = std::chrono::high_resolution_clock::now();
+// log( args... ) writes the arguments like std::cout << args would, prefixed by the
+// seconds since the start, but without waiting for the output.
+//
+// The calling thread packs the arguments into a fixed size record of a lock-free ring,
+// many threads may log at once. A background thread formats the records and writes them
+// to std::cout, flushing whenever the ring runs empty. Numbers and strings are copied as
+// they are and formatted later, other types go through operator<< right away. Strings
+// that don't fit into the rest of the record are copied to the heap, the background
+// thread frees them once written. Only arguments past a record filled up with others
+// are cut, which is counted. When the ring is full the record is dropped and counted,
+// logging never blocks.
+//
+// log_flush() waits until everything logged before is written, NEO_ASSERT_ALWAYS calls
+// it before exiting.
+//
+// NEO_LOG_DEBUG( vulkan, args... ) and its siblings log with a severity and a category.
+// Sites below NEO_LOG_MIN_LEVEL compile to nothing, their arguments aren't even
+// evaluated, so verbose output can stay in release builds. The sites compiled in are
+// filtered at runtime per category by log_set_level(). log() is info and general,
+// log_result() as well but never left out, for the numbers a benchmark prints.
+
+// 0 debug, 1 info, 2 warning, 3 error
+#ifndef NEO_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define NEO_LOG_MIN_LEVEL 1
+#else
+#define NEO_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+enum class log_level : uint8_t
+{
+    debug,
+    info,
+    warning,
+    error
+};
+
+enum class log_category : uint8_t
+{
+    general,
+    vulkan,
+    assets,
+    frame,
+    count
+};
+
+constexpr log_level LOG_MIN_LEVEL = static_cast< log_level >( NEO_LOG_MIN_LEVEL );
+
+constexpr bool log_compiled( log_level level ) { return level >= LOG_MIN_LEVEL; }
+
+namespace detail
+{
+    enum class log_arg : uint8_t
+    {
+        int64,
+        uint64,
+        float64,
+        character,
+        string,
+        heap_string //!< pointer and length, owned by the record
+    };
+
+    struct log_record
+    {
+        static constexpr uint32_t SIZE         = 512;
+        static constexpr uint32_t PAYLOAD_SIZE = SIZE - 16;
+
+        uint64_t timestamp_us;
+        uint16_t size; //!< of the payload
+        log_level level;
+        log_category category;
+        uint8_t truncated;
+        uint8_t padding[3];
+        unsigned char payload[PAYLOAD_SIZE];
+    };
+
+    // packs the arguments in order, tag by tag
+    class log_packer final
+    {
+      public:
+        explicit log_packer( log_record& record )
+            : m_record{record}
+        {
+        }
+
+        template < typename T > void add( const T& v )
+        {
+            using type = std::decay_t< T >;
+
+            if constexpr ( std::is_same_v< type, char >
+                           || std::is_same_v< type, signed char >
+                           || std::is_same_v< type, unsigned char > )
+            {
+                put( log_arg::character, &v, 1 );
+            }
+            else if constexpr ( std::is_integral_v< type > && std::is_signed_v< type > )
+            {
+                const int64_t i = v;
+                put( log_arg::int64, &i, sizeof( i ) );
+            }
+            else if constexpr ( std::is_integral_v< type > )
+            {
+                const uint64_t u = v;
+                put( log_arg::uint64, &u, sizeof( u ) );
+            }
+            else if constexpr ( std::is_enum_v< type > )
+            {
+                add( static_cast< std::underlying_type_t< type > >( v ) );
+            }
+            else if constexpr ( std::is_floating_point_v< type > )
+            {
+                const double d = v;
+                put( log_arg::float64, &d, sizeof( d ) );
+            }
+            else if constexpr ( std::is_same_v< T, const char* >
+                                || std::is_same_v< T, char* > )
+            {
+                // string literals are arrays and take the string_view branch below
+                add_string( v != nullptr ? std::string_view{v} : std::string_view{} );
+            }
+            else if constexpr ( std::is_convertible_v< const T&, std::string_view > )
+            {
+                add_string( std::string_view{v} );
+            }
+            else
+            {
+                // formatted now the same way the background thread would
+                std::ostringstream os;
+                os << std::setfill( '0' ) << std::fixed << std::setprecision( 4 ) << v;
+                add_string( os.str() );
+            }
+        }
+
+      private:
+        // the tags with the length, and the pointer of a heap copy
+        static constexpr size_t INLINE_STRING_SIZE = 1 + sizeof( uint16_t );
+        static constexpr size_t HEAP_STRING_SIZE =
+            1 + sizeof( char* ) + sizeof( size_t );
+
+        void put( log_arg tag, const void* data, size_t size )
+        {
+            if ( m_record.size + 1 + size > log_record::PAYLOAD_SIZE )
+            {
+                m_record.truncated = 1;
+                return;
+            }
+
+            m_record.payload[m_record.size] = static_cast< unsigned char >( tag );
+            std::memcpy( &m_record.payload[m_record.size + 1], data, size );
+            m_record.size += static_cast< uint16_t >( 1 + size );
+        }
+
+        // inline while a copy on the heap would still fit after it, on the heap when not
+        void add_string( std::string_view s )
+        {
+            const size_t left = log_record::PAYLOAD_SIZE - m_record.size;
+
+            if ( INLINE_STRING_SIZE + s.size() + HEAP_STRING_SIZE <= left )
+            {
+                add_inline_string( s );
+                return;
+            }
+
+            char* copy = nullptr;
+            if ( HEAP_STRING_SIZE <= left )
+            {
+                copy = new ( std::nothrow ) char[s.size()];
+            }
+
+            if ( copy == nullptr )
+            {
+                // the last resort, as much as fits
+                if ( INLINE_STRING_SIZE < left )
+                {
+                    add_inline_string( s.substr( 0, left - INLINE_STRING_SIZE ) );
+                }
+
+                m_record.truncated = 1;
+                return;
+            }
+
+            std::memcpy( copy, s.data(), s.size() );
+
+            const size_t length = s.size();
+            unsigned char* out  = &m_record.payload[m_record.size];
+
+            out[0] = static_cast< unsigned char >( log_arg::heap_string );
+            std::memcpy( out + 1, &copy, sizeof( copy ) );
+            std::memcpy( out + 1 + sizeof( copy ), &length, sizeof( length ) );
+            m_record.size += static_cast< uint16_t >( HEAP_STRING_SIZE );
+        }
+
+        void add_inline_string( std::string_view s )
+        {
+            const auto length  = static_cast< uint16_t >( s.size() );
+            unsigned char* out = &m_record.payload[m_record.size];
+
+            out[0] = static_cast< unsigned char >( log_arg::string );
+            std::memcpy( out + 1, &length, sizeof( length ) );
+            std::memcpy( out + INLINE_STRING_SIZE, s.data(), s.size() );
+            m_record.size += static_cast< uint16_t >( INLINE_STRING_SIZE + s.size() );
+        }
+
+        log_record& m_record;
+    };
+
+    // lowest level logged per category, everything compiled in by default
+    inline std::atomic< log_level >
+        log_thresholds[static_cast< size_t >( log_category::count )];
+
+    // a free record of the ring, nullptr when it is full
+    log_record* log_begin( log_level level, log_category category );
+    // hands the record to the background thread
+    void log_commit( log_record* record );
+} // namespace detail
+
+inline bool log_enabled( log_level level, log_category category )
+{
+    return level >= detail::log_thresholds[static_cast< size_t >( category )].load(
+                        std::memory_order_relaxed );
+}
+
+// the lowest level logged for the category, or for all of them
+inline void log_set_level( log_category category, log_level level )
+{
+    detail::log_thresholds[static_cast< size_t >( category )].store(
+        level, std::memory_order_relaxed );
+}
+
+inline void log_set_level( log_level level )
+{
+    for ( auto& threshold : detail::log_thresholds )
+    {
+        threshold.store( level, std::memory_order_relaxed );
+    }
+}
+
+// unfiltered, the NEO_LOG macros check first
+template < typename... Args >
+void log_at( log_level level, log_category category, Args&&... args )
+{
+    detail::log_record* record = detail::log_begin( level, category );
+    if ( record == nullptr )
+    {
+        return;
+    }
+
+    detail::log_packer packer{*record};
+    ( ..., packer.add( args ) );
+
+    detail::log_commit( record );
+}
 
 template < typename... Args > void log( Args&&... args )
 {
-    const uint64_t us = std::chrono::duration_cast< std::chrono::microseconds >(
-                            std::chrono::high_resolution_clock::now() - start )
-                            .count();
-    std::cout << "[" << std::setfill( '0' ) << std::setw( 9 ) << std::fixed
-              << std::setprecision( 4 ) << us / 1000000.0f << "]:\t";
-    ( ..., ( std::cout << args ) );
-    std::cout << std::endl;
+    if constexpr ( log_compiled( log_level::info ) )
+    {
+        if ( log_enabled( log_level::info, log_category::general ) )
+        {
+            log_at( log_level::info, log_category::general,
+                    std::forward< Args >( args )... );
+        }
+    }
 }
+
+// What a run is made for, benchmark results and statistics. Always compiled in and never
+// filtered, written as info and general.
+template < typename... Args > void log_result( Args&&... args )
+{
+    log_at( log_level::info, log_category::general, std::forward< Args >( args )... );
+}
+
+// if constexpr keeps the arguments of disabled sites from being evaluated
+#define NEO_LOG( level, category, ... )                                                  \
+    do                                                                                   \
+    {                                                                                    \
+        if constexpr ( log_compiled( level ) )                                           \
+        {                                                                                \
+            if ( log_enabled( level, category ) )                                        \
+            {                                                                            \
+                log_at( level, category, __VA_ARGS__ );                                  \
+            }                                                                            \
+        }                                                                                \
+    } while ( false )
+
+#define NEO_LOG_DEBUG( category, ... )                                                   \
+    NEO_LOG( log_level::debug, log_category::category, __VA_ARGS__ )
+#define NEO_LOG_INFO( category, ... )                                                    \
+    NEO_LOG( log_level::info, log_category::category, __VA_ARGS__ )
+#define NEO_LOG_WARNING( category, ... )                                                 \
+    NEO_LOG( log_level::warning, log_category::category, __VA_ARGS__ )
+#define NEO_LOG_ERROR( category, ... )                                                   \
+    NEO_LOG( log_level::error, log_category::category, __VA_ARGS__ )
+
+void log_flush();
+
+// records lost to a full ring since the start
+uint64_t log_dropped_records();
+
+// records with arguments cut off since the start
+uint64_t log_truncated_records();
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "model.hpp"
+
+class thread_pool;
+
+// Reduces indices, triangles drawing vertices, to at most target_index_count indices by
+// collapsing edges onto their cheapest end ( Garland and Heckbert, "Simplifying Surfaces
+// with Color and Texture using Quadric Error Metrics" 1998 ). The quadrics cover the
+// position, normal and texcoord of the vertices, so collapses across creases and texture
+// discontinuities cost more. Vertices on an open border or a texture seam never move,
+// which keeps the silhouette and seams closed. No vertex is created, the result indexes
+// the same vertices.
+//
+// error receives how far in model units the result may be from the input surface. Less
+// than the target is left when everything else is locked.
+std::vector< vtx_t::index > simplify_mesh( const std::vector< vtx_t::vertex >& vertices,
+                                           const std::vector< vtx_t::index >& indices,
+                                           size_t target_index_count, float& error );
+
+// Appends up to max_levels - 1 simplified versions of the model to its index data, each
+// with about ratio times the triangles of the previous one, and fills model.lods with
+// the full resolution first. The levels are simplified in parallel, all from the full
+// resolution. A level which doesn't get meaningfully smaller ends the chain.
+void build_lod_chain( model_data& model, thread_pool& pool, uint32_t max_levels = 4,
+                      float ratio = 0.5f );
+
+// Pixels a model space error of 1 covers at view depth 1, for a perspective projection
+// rendering viewport_height pixels and divided by the pixels of error which are
+// acceptable.
+float lod_error_scale( const glm::mat4& proj, float viewport_height,
+                       float threshold_pixels );
+
+// The coarsest level whose error stays under the threshold, scale is the uniform scale
+// of the instance and depth its nearest view depth. Mirrors the selection in
+// instance_cull.comp.
+uint32_t select_lod( const std::vector< lod_level >& lods, float error_scale, float scale,
+                     float depth );
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+#include "model.hpp"
+#include "instance_culling.hpp"
+
+// Cluster culling of a single large mesh on the GPU, without mesh shaders. A compute pass
+// tests every meshlet of the model against the view frustum and its normal cone against
+// the camera, and copies the triangles of the visible ones into a compacted index
+// buffer. One VkDrawIndexedIndirectCommand draws them with the vertex buffer of the
+// model, so the vertex stage never sees a culled cluster. The order of the visible
+// meshlets is not stable between frames.
+//
+// Cone culling only holds for a model matrix without mirroring or non uniform scale.
+class meshlet_culling final
+{
+  public:
+    static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+    // what the pass writes, the draw comes first so it can be consumed in place
+    struct cull_state
+    {
+        VkDrawIndexedIndirectCommand draw;
+        uint32_t visible_meshlets;
+    };
+
+    meshlet_culling( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    // build_meshlets() has to have run on the model, its meshlets and index data are
+    // uploaded once here
+    void initialize( const model_data& model, uint32_t frame_count );
+    void deinitialize();
+
+    void update( uint32_t frame_idx, const glm::mat4& model, const glm::mat4& view,
+                 const glm::mat4& proj );
+
+    // outside of a render pass, before the draw
+    void record( VkCommandBuffer cmd, uint32_t frame_idx );
+
+    // inside the render pass, indices() is bound as a uint32 index buffer
+    void record_draw( VkCommandBuffer cmd );
+
+    VkBuffer indices() const { return m_indices.buffer; }
+
+    // cull_state, readable with a transfer
+    VkBuffer state() const { return m_state.buffer; }
+
+    uint32_t meshlet_count() const { return m_meshlet_count; }
+
+  private:
+    void create_buffers( const model_data& model, uint32_t frame_count );
+    void destroy_buffers();
+
+    void init_descriptor_set_layout();
+    void destroy_descriptor_set_layout();
+
+    void create_descriptor_sets( uint32_t frame_count );
+    void destroy_descriptor_sets();
+
+    void init_pipeline();
+    void destroy_pipeline();
+
+    // layout of the per frame uniform buffer as seen by meshlet_cull.comp, model space
+    struct cull_params
+    {
+        frustum_planes planes;
+        glm::vec4 camera;
+        uint32_t meshlet_count;
+    };
+
+    uint32_t m_meshlet_count;
+
+    buffer_data m_meshlets;
+    buffer_data m_source_indices;
+    buffer_data m_indices;
+    buffer_data m_state;
+    std::vector< buffer_data > m_cull_params;
+
+    VkDescriptorSetLayout m_set_layout;
+    VkDescriptorPool m_descriptor_pool;
+    std::vector< VkDescriptorSet > m_sets;
+
+    VkPipelineLayout m_pipeline_layout;
+    VkPipeline m_pipeline;
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
+
+// CPU mirror of meshlet_cull.comp with model space planes and camera, indices of the
+// visible meshlets in model order. margin is added to every bounding radius.
+std::vector< uint32_t > cull_meshlets_reference( const std::vector< meshlet >& meshlets,
+                                                 const frustum_planes& planes,
+                                                 const glm::vec3& camera,
+                                                 float margin = 0.0f );
@@ -39,10 +39,53 @@ namespace std
     };
 } // namespace std
 
+class thread_pool;
+
+// A cluster of neighbouring triangles, which can be culled as a whole. The triangles are
+// a contiguous range of the index data, the bounds are in model space. The normal cone
+// holds cross( v1 - v0, v2 - v0 ) of every triangle, which has to point out of a closed
+// mesh. All triangles face away from a camera at p when
+//     dot( center - p, axis ) >= cutoff * length( center - p ) + radius
+// and a cutoff of 1 disables the test.
+struct meshlet
+{
+    static constexpr uint32_t MAX_VERTICES  = 64;
+    static constexpr uint32_t MAX_TRIANGLES = 124;
+
+    glm::vec4 sphere; //!< center, radius
+    glm::vec4 cone;   //!< axis, cutoff
+    uint32_t first_index;
+    uint32_t triangle_count;
+    uint32_t vertex_count;
+    uint32_t padding;
+};
+
+// A range of the index data drawing the whole model with less detail, all levels share
+// the vertex data. error is how far in model units the surface may be from the full
+// resolution one.
+struct lod_level
+{
+    uint32_t first_index;
+    uint32_t index_count;
+    float error;
+};
+
 struct model_data
 {
     std::vector< vtx_t::vertex > vertex_data;
     std::vector< vtx_t::index > index_data;
+    std::vector< meshlet > meshlets; //!< empty until build_meshlets()
+    std::vector< lod_level > lods;   //!< empty until build_lod_chain()
 };
 
-model_data load_model( const char* file_name );
\ No newline at end of file
+model_data load_model( const char* file_name );
+
+// Adds the unit face normal of every triangle to its vertices and normalizes the sums,
+// load_model() does this for the normals it starts at zero.
+model_data calculate_normals( model_data&& m );
+
+// Splits the triangles into meshlets, reordering them in index_data so every meshlet is
+// a contiguous range. Triangles are grouped greedily by shared vertices within chunks of
+// the index data, which are processed in parallel. Has to run before build_lod_chain(),
+// meshlets only cover the full resolution.
+void build_meshlets( model_data& model, thread_pool& pool );
\ No newline at end of file
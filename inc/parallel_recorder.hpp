@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+#include "render_queue.hpp"
+#include "thread_pool.hpp"
+
+// Records a sorted render_queue into secondary command buffers on the workers of a
+// thread_pool. The queue is split into equal ranges of draws, one secondary buffer each,
+// and the primary buffer executes them in order, so the draw order of the queue is kept.
+//
+// A command pool must not be used by two threads at once. Every partition of every frame
+// has a pool of its own and is recorded by a single task, so recording needs no locks.
+// The pools of a frame are reset as a whole before it is recorded again.
+class parallel_recorder final
+{
+  public:
+    parallel_recorder( vulkan_data< application_data::stack_alloc_t >& vk_data,
+                       thread_pool& workers )
+        : m_workers{workers}
+        , m_vulkan_data{vk_data}
+    {
+    }
+
+    // a partition per thread of the pool, more balance uneven draws better
+    void initialize( uint32_t partitions, uint32_t frame_count );
+    void deinitialize();
+
+    // Blocks until every partition of the frame is recorded, the GPU must be done with
+    // the previous recording of the frame. Each partition starts with nothing bound, so
+    // the binds add up over all of them. usage gets RENDER_PASS_CONTINUE added. The
+    // per partition results are kept in the arena of the frame.
+    render_queue_stats record( const render_queue& queue, uint32_t frame_idx,
+                               VkRenderPass render_pass, uint32_t subpass,
+                               VkFramebuffer framebuffer, VkCommandBufferUsageFlags usage,
+                               application_data::frame_arena_t& arena );
+
+    // inside a subpass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+    void execute( VkCommandBuffer primary, uint32_t frame_idx ) const;
+
+    uint32_t partitions() const { return m_partitions; }
+
+  private:
+    uint32_t m_partitions;
+
+    // frame major, partitions of a frame next to each other
+    std::vector< VkCommandPool > m_pools;
+    std::vector< VkCommandBuffer > m_buffers;
+
+    thread_pool& m_workers;
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
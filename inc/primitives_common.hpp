@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+// Sizes and operations shared by gpu_primitives and its CPU ports in cpu_kernels. Free of
+// Vulkan, so code written against cpu_compute builds without the SDK.
+namespace primitives
+{
+    constexpr uint32_t SCAN_PARTITION_SIZE = 1024;
+    constexpr uint32_t SORT_PARTITION_SIZE = 512;
+    constexpr uint32_t REDUCE_MAX_GROUPS   = 1024;
+    constexpr uint32_t RADIX_DIGITS        = 256;
+
+    enum class reduce_op : uint32_t
+    {
+        sum = 0,
+        min = 1,
+        max = 2
+    };
+
+    inline uint32_t sort_partitions( uint32_t count )
+    {
+        return ( count + SORT_PARTITION_SIZE - 1 ) / SORT_PARTITION_SIZE;
+    }
+} // namespace primitives
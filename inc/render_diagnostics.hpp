@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+
+// What the diagnostics measured in one frame. Counters the device can't measure stay 0.
+struct frame_diagnostics
+{
+    // pipeline statistics of the passes between begin_statistics() and end_statistics()
+    uint64_t input_vertices;       //!< indices fetched by the input assembly
+    uint64_t input_primitives;
+    uint64_t vertex_invocations;
+    uint64_t clipping_invocations; //!< primitives reaching the clipper
+    uint64_t clipping_primitives;  //!< primitives leaving it
+    uint64_t fragment_invocations;
+
+    // Vertex shader invocations per triangle, the average cache miss ratio. 3 means no
+    // reuse at all, a regular grid gets close to 0.5 with a perfect cache.
+    double vertices_per_triangle;
+    // vertex shader invocations per fetched index
+    double vertex_cache_miss_rate;
+    // fragment shader invocations per pixel of the frame
+    double shaded_per_pixel;
+
+    // of the overdraw heatmap, every fragment rasterized counts, depth test or not
+    uint64_t covered_pixels;
+    uint64_t rasterized_fragments;
+    uint32_t max_overdraw;
+    double overdraw; //!< rasterized fragments per covered pixel
+};
+
+// Diagnostic mode for measuring mesh and culling optimizations. Pipeline statistics
+// queries count vertex and fragment shader invocations and the primitives around the
+// clipper. An overdraw heatmap counts the fragments of every pixel by additive blending
+// into an R32 float image, which is copied into a host visible buffer.
+//
+// Every frame in flight has its own query and readback buffer. The results of a frame
+// are read when it is recorded again, after its fence signalled, so reading never waits
+// for the GPU.
+class render_diagnostics final
+{
+  public:
+    static constexpr VkFormat OVERDRAW_FORMAT = VK_FORMAT_R32_SFLOAT;
+
+    render_diagnostics( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    void initialize( VkExtent2D extent, uint32_t frame_count );
+    void deinitialize();
+
+    // Collects the results of the previous recording of frame_idx and resets its query,
+    // outside of a render pass before anything else of the frame.
+    void begin_frame( VkCommandBuffer cmd, uint32_t frame_idx );
+
+    // around the measured passes, outside of render passes
+    void begin_statistics( VkCommandBuffer cmd );
+    void end_statistics( VkCommandBuffer cmd );
+
+    // Draws in between go into the heatmap, with a pipeline created for
+    // overdraw_render_pass() that blends with overdraw_blend_attachment() and writes 1.
+    void begin_overdraw( VkCommandBuffer cmd );
+    void end_overdraw( VkCommandBuffer cmd );
+
+    VkRenderPass overdraw_render_pass() const { return m_overdraw_render_pass; }
+    static VkPipelineColorBlendAttachmentState overdraw_blend_attachment();
+
+    // pipelineStatisticsQuery is enabled
+    bool statistics_supported() const { return m_query_pool != nullptr; }
+    // the device blends OVERDRAW_FORMAT
+    bool overdraw_supported() const { return m_overdraw_render_pass != nullptr; }
+
+    // the most recent frame that finished on the GPU
+    const frame_diagnostics& last_frame() const { return m_last_frame; }
+
+  private:
+    void create_overdraw_target( uint32_t frame_count );
+    void destroy_overdraw_target();
+
+    void resolve( uint32_t frame_idx );
+
+    VkExtent2D m_extent;
+
+    VkQueryPool m_query_pool = nullptr;
+
+    image_data m_overdraw;
+    VkRenderPass m_overdraw_render_pass = nullptr;
+    VkFramebuffer m_overdraw_framebuffer;
+    std::vector< buffer_data > m_readback;
+
+    // the frame begin_frame() was called for last
+    uint32_t m_frame_idx = 0;
+
+    // what the previous recording of each frame measured
+    std::vector< bool > m_has_statistics;
+    std::vector< bool > m_has_overdraw;
+
+    frame_diagnostics m_last_frame{};
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "vulkan_data.hpp"
+#include "application_data.hpp"
+
+class gpu_profiler;
+
+// How a pass uses an image or a buffer. Each one implies the pipeline stage, the access
+// mask, the image layout and the usage flags the resource needs.
+enum class graph_access
+{
+    color_attachment,  //!< written by a graphics pass
+    depth_attachment,  //!< read and written by a graphics pass
+    sampled,           //!< read in fragment or compute shaders
+    storage_read,      //!< compute shaders
+    storage_write,     //!< compute shaders, read and write
+    transfer_src,
+    transfer_dst,
+    indirect,          //!< buffers with indirect draw or dispatch arguments
+    vertex             //!< vertex and index buffers
+};
+
+// Totals of the last compile()
+struct render_graph_stats
+{
+    uint32_t passes;
+    uint32_t culled_passes;
+    uint32_t barriers;            //!< vkCmdPipelineBarrier calls per execute()
+    uint32_t image_barriers;
+    uint32_t buffer_barriers;
+    uint32_t lazy_images;         //!< attachments living in lazily allocated memory
+    VkDeviceSize transient_bytes; //!< sum of the transient resources
+    VkDeviceSize allocated_bytes; //!< memory they got, after aliasing
+};
+
+// A frame described as passes reading and writing images and buffers, compiled into
+// what the hand written examples spell out themselves: render passes, framebuffers,
+// pipeline barriers and layout transitions.
+//
+// Passes execute in the order they were added. compile() culls the passes none of the
+// outputs depend on, gives every pass the barriers its accesses need since the previous
+// ones and places the transient resources. Transient resources used by passes that never
+// run at the same time share memory. An attachment that is only touched inside one
+// graphics pass and neither loaded nor stored becomes a transient attachment in lazily
+// allocated memory where the device has some.
+//
+// Attachments of a graphics pass are loaded when an earlier pass wrote them, cleared
+// when the pass asks for it and DONT_CARE otherwise. They are stored only when a later
+// pass or the outside world reads them. Imported resources count as outputs, they are
+// left in their final layout.
+//
+// The first access of every resource in execute() waits for all commands before it, so
+// the command buffers of two frames in flight can share the transient resources.
+class render_graph final
+{
+  public:
+    using resource = uint32_t;
+
+    enum class pass_type
+    {
+        graphics, //!< inside a render pass of its attachments
+        compute,
+        transfer
+    };
+
+    render_graph( vulkan_data< application_data::stack_alloc_t >& vk_data )
+        : m_vulkan_data{vk_data}
+    {
+    }
+
+    // transient resources, created by compile()
+    resource create_image( const std::string& name, VkExtent2D extent, VkFormat format,
+                           VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT );
+    resource create_buffer( const std::string& name, VkDeviceSize size );
+
+    // Resources owned elsewhere, every execute() starts from layout and leaves the image
+    // in final_layout.
+    resource import_image( const std::string& name, const image_data& image,
+                           VkImageLayout layout, VkImageLayout final_layout,
+                           VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT );
+    resource import_buffer( const std::string& name, VkBuffer buffer, VkDeviceSize size );
+
+    // One of several images of the same extent and format, like the swapchain images.
+    // execute() is told which one this time, its image index picks the barriers and the
+    // framebuffers made for it.
+    resource import_images( const std::string& name,
+                            const std::vector< image_data >& images, VkImageLayout layout,
+                            VkImageLayout final_layout,
+                            VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT );
+
+    // keeps the passes writing the resource, a transient one is stored at the end
+    void mark_output( resource r );
+
+    uint32_t add_pass( const std::string& name, pass_type type,
+                       std::function< void( VkCommandBuffer ) > execute );
+
+    void read( uint32_t pass, resource r, graph_access access );
+    void write( uint32_t pass, resource r, graph_access access );
+
+    // a graphics pass clears the attachment instead of loading it
+    void clear( uint32_t pass, resource r, VkClearValue value );
+
+    // a pass with side effects outside of the graph is never culled
+    void set_side_effects( uint32_t pass );
+
+    // the render pass of a graphics pass is begun for secondary command buffers, recorded
+    // against render_pass() and framebuffer()
+    void set_secondary_buffers( uint32_t pass );
+
+    // Creates everything, nothing can be added afterwards. The passes' pipelines need
+    // render_pass() so they are created after this.
+    void compile();
+    void deinitialize();
+
+    // Records every pass that wasn't culled, for image_idx of the import_images()
+    // resources. With a profiler each pass is a scope of its name.
+    void execute( VkCommandBuffer cmd, uint32_t image_idx = 0,
+                  gpu_profiler* profiler = nullptr ) const;
+
+    VkImage image( resource r ) const;
+    VkImageView image_view( resource r ) const;
+    VkBuffer buffer( resource r ) const;
+
+    // of a graphics pass, nullptr when it was culled
+    VkRenderPass render_pass( uint32_t pass ) const { return m_passes[pass].render_pass; }
+    bool culled( uint32_t pass ) const { return !m_passes[pass].live; }
+    VkFramebuffer framebuffer( uint32_t pass, uint32_t image_idx = 0 ) const;
+
+    const render_graph_stats& stats() const { return m_stats; }
+
+  private:
+    struct resource_data
+    {
+        std::string name;
+        bool is_image;
+        bool imported;
+        bool output;
+
+        VkExtent2D extent;
+        VkFormat format;
+        VkImageAspectFlags aspect;
+        VkDeviceSize size;
+
+        VkImageLayout initial_layout;
+        VkImageLayout final_layout;
+
+        // filled in by compile()
+        VkImageUsageFlags image_usage;
+        VkBufferUsageFlags buffer_usage;
+        uint32_t first_pass;
+        uint32_t last_pass;
+        bool lazy;
+
+        VkImage image;
+        VkImageView image_view;
+        VkBuffer buffer;
+        VkDeviceMemory own_memory; //!< lazily allocated ones only
+
+        // of import_images(), image and image_view are the first one's
+        std::vector< image_data > images;
+    };
+
+    struct pass_access
+    {
+        resource r;
+        graph_access access;
+        bool writes;
+    };
+
+    struct pass_data
+    {
+        std::string name;
+        pass_type type;
+        std::function< void( VkCommandBuffer ) > execute;
+        std::vector< pass_access > accesses;
+        std::vector< std::pair< resource, VkClearValue > > clears;
+        bool side_effects;
+        bool secondary_buffers;
+
+        // filled in by compile()
+        bool live;
+        VkRenderPass render_pass;
+        std::vector< VkFramebuffer > framebuffers; //!< one, or one per image index
+        VkExtent2D extent;
+        std::vector< VkClearValue > clear_values;
+
+        // the barriers of every image index one after the other
+        VkPipelineStageFlags src_stages;
+        VkPipelineStageFlags dst_stages;
+        std::vector< VkImageMemoryBarrier > image_barriers;
+        std::vector< VkBufferMemoryBarrier > buffer_barriers;
+    };
+
+    void cull_passes();
+    void find_lifetimes();
+    void create_resources();
+    void alias_memory();
+    void create_render_passes();
+    void build_barriers();
+    void expand_image_barriers( std::vector< VkImageMemoryBarrier >& barriers ) const;
+
+    resource add_resource( resource_data data );
+
+    std::vector< resource_data > m_resources;
+    std::vector< pass_data > m_passes;
+    std::vector< VkDeviceMemory > m_heaps; //!< shared by the aliased resources
+
+    // images of every import_images() resource, 1 without any
+    uint32_t m_image_count = 1;
+
+    // transitions of the imported images to their final layouts after the last pass, per
+    // image index as well
+    VkPipelineStageFlags m_final_src_stages = 0;
+    std::vector< VkImageMemoryBarrier > m_final_barriers;
+
+    bool m_compiled = false;
+    render_graph_stats m_stats{};
+
+    vulkan_data< application_data::stack_alloc_t >& m_vulkan_data;
+};
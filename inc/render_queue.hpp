@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Everything one draw needs bound, items only refer to objects owned elsewhere.
+struct draw_item
+{
+    VkPipeline pipeline;
+    VkPipelineLayout layout;
+    VkDescriptorSet set;          //!< set 0, nullptr binds nothing
+    VkBuffer vertices;            //!< binding 0
+    VkBuffer instances;           //!< binding 1, nullptr when not instanced
+    VkDeviceSize instance_offset;
+    VkBuffer indices;             //!< uint32 indices
+    VkBuffer indirect;            //!< nullptr draws the direct arguments below
+    VkDeviceSize indirect_offset; //!< of a VkDrawIndexedIndirectCommand
+    uint32_t index_count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+};
+
+// Bind calls a recorded queue issued, every vkCmdBindVertexBuffers counts once no matter
+// how many bindings it sets.
+struct render_queue_stats
+{
+    uint32_t draws;
+    uint32_t pipeline_binds;
+    uint32_t set_binds;
+    uint32_t vertex_binds;
+    uint32_t index_binds;
+};
+
+inline render_queue_stats& operator+=( render_queue_stats& lhs,
+                                       const render_queue_stats& rhs )
+{
+    lhs.draws += rhs.draws;
+    lhs.pipeline_binds += rhs.pipeline_binds;
+    lhs.set_binds += rhs.set_binds;
+    lhs.vertex_binds += rhs.vertex_binds;
+    lhs.index_binds += rhs.index_binds;
+    return lhs;
+}
+
+// Sort key of a draw, from the most to the least significant bits:
+//
+//   63 .. 52   pipeline id, 12 bits
+//   51 .. 36   descriptor set id, 16 bits
+//   35 .. 20   material id, 16 bits
+//   19 .. 0    depth, quantized to 20 bits
+//
+// So draws group by pipeline first, the most expensive state to change, and go front to
+// back within a material. The ids are whatever small numbers the caller hands out, depth
+// is clamped to [0, 1]. Translucent draws want back to front, they pass 1 - depth.
+uint64_t make_sort_key( uint32_t pipeline, uint32_t set, uint32_t material, float depth );
+
+struct sort_entry
+{
+    uint64_t key;
+    uint32_t index;
+};
+
+// Stable LSD radix sort by key, 8 bits per pass. Passes over bytes all keys share are
+// skipped, so the usual handful of pipelines and sets costs a few passes, not eight.
+// scratch is resized as needed and can be reused between calls.
+void radix_sort( std::vector< sort_entry >& entries, std::vector< sort_entry >& scratch );
+
+// Draws collected over a frame, sorted by key and recorded without the binds that would
+// set what is already bound. Meant to be cleared and filled again every frame, the
+// storage is kept.
+class render_queue final
+{
+  public:
+    void clear();
+    void push( uint64_t key, const draw_item& item );
+
+    void sort();
+
+    // In queue order, inside a render pass. A null command buffer records nothing and
+    // only counts what would be bound.
+    render_queue_stats record( VkCommandBuffer cmd ) const;
+
+    // draws [begin, end) of the queue order, starting with nothing bound
+    render_queue_stats record( VkCommandBuffer cmd, uint32_t begin, uint32_t end ) const;
+
+    uint32_t size() const { return static_cast< uint32_t >( m_items.size() ); }
+
+  private:
+    std::vector< draw_item > m_items;
+    std::vector< sort_entry > m_order;
+    std::vector< sort_entry > m_scratch;
+};
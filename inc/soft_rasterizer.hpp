@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "model.hpp"
+#include "image.hpp"
+#include "thread_pool.hpp"
+#include "examples/example4_transforms.hpp"
+
+struct soft_raster_stats
+{
+    uint64_t triangles;            //!< submitted
+    uint64_t triangles_rasterized; //!< after near plane clipping and degenerate removal
+    uint64_t pixels_shaded;
+};
+
+// CPU fallback for example4 on machines without a GPU. Runs the math of example4.vert
+// and example4.frag and writes the same linear HDR color the Vulkan scene pass does,
+// so the two outputs can be compared before tone mapping.
+//
+// Triangles are set up and binned into TILE_SIZE screen tiles in parallel, then every
+// tile is rasterized by one task. Coverage and depth are evaluated for 4x2 pixel spans,
+// 8 wide with AVX2 when available. Every BLOCK_SIZE square keeps its farthest depth,
+// triangles entirely behind it skip the block.
+class soft_rasterizer final
+{
+  public:
+    static constexpr int32_t TILE_SIZE  = 64;
+    static constexpr int32_t BLOCK_SIZE = 8;
+
+    soft_rasterizer( thread_pool& pool, int32_t width, int32_t height );
+
+    void clear( const glm::vec4& color, float depth = 1.0f );
+
+    // depth test is LESS_OR_EQUAL and nothing is culled, like example4's pipeline
+    soft_raster_stats draw( const model_data& model, const image& texture,
+                            const example4_transforms& transforms );
+
+    int32_t width() const { return m_width; }
+    int32_t height() const { return m_height; }
+
+    // width * height pixels, row major
+    const std::vector< glm::vec4 >& color() const { return m_color; }
+
+  private:
+    struct clip_vertex
+    {
+        glm::vec4 position;
+        glm::vec3 normal; //!< view space, not normalized like in the shader
+        glm::vec2 texcoord;
+    };
+
+    // Screen space setup, the edge functions are scaled to barycentric coordinates:
+    // bary[i] = edge_a[i] * x + edge_b[i] * y + edge_c[i].
+    struct triangle
+    {
+        float edge_a[3];
+        float edge_b[3];
+        float edge_c[3];
+        bool top_left[3]; //!< pixels exactly on the edge belong to this triangle
+
+        float z[3];
+        float inv_w[3];
+        glm::vec3 normal[3];
+        glm::vec2 texcoord[3];
+
+        float min_z;
+        int32_t min_x;
+        int32_t min_y;
+        int32_t max_x;
+        int32_t max_y;
+    };
+
+    void setup_triangle( const clip_vertex& v0, const clip_vertex& v1,
+                         const clip_vertex& v2, std::vector< triangle >& out ) const;
+
+    void bin_triangles( const model_data& model, uint32_t chunk, uint32_t begin,
+                        uint32_t end );
+
+    uint64_t rasterize_tile( int32_t tile, const image& texture );
+
+    uint64_t rasterize_block( const triangle& t, int32_t block_x, int32_t block_y,
+                              const image& texture );
+
+    glm::vec4 shade( const triangle& t, const float bary[3], const image& texture ) const;
+
+    thread_pool& m_pool;
+
+    int32_t m_width;
+    int32_t m_height;
+    int32_t m_tiles_x;
+    int32_t m_tiles_y;
+    int32_t m_blocks_x;
+
+    std::vector< glm::vec4 > m_color;
+    std::vector< float > m_depth;
+    std::vector< float > m_block_max_depth;
+
+    std::vector< clip_vertex > m_vertices;
+
+    // triangles and per tile bins of every binning chunk, tiles walk the chunks in
+    // order so triangles are drawn in submission order
+    uint32_t m_chunk_count;
+    std::vector< std::vector< triangle > > m_chunk_triangles;
+    std::vector< std::vector< uint32_t > > m_bins; //!< [chunk * tile_count + tile]
+};
@@ -8,11 +8,19 @@ constexpr int64_t aligned_size( int64_t size, int64_t alignment )
     return ( size + alignment - 1 ) & ~( alignment - 1 );
 }
 
+// Bump allocator over N bytes of its own. free() does nothing, memory comes back by
+// rewinding to a marker saved earlier, which drops everything allocated after it at
+// once, or by reset(). The high-water mark and the failed allocations are kept over
+// rewinds, they tell how large N has to be.
 template < int64_t N > class stack_allocator
 {
   public:
+    using marker = int64_t;
+
     constexpr stack_allocator()
         : m_current_size{0}
+        , m_high_water_mark{0}
+        , m_overflows{0}
     {
     }
     constexpr stack_allocator( const stack_allocator& ) = delete;
@@ -22,20 +30,76 @@ template < int64_t N > class stack_allocator
 
   public:
     constexpr void* allocate( int64_t size, int64_t alignment = alignof( void* ) )
+    {
+        void* ret = try_allocate( size, alignment );
+        assert( ret != nullptr );
+        return ret;
+    }
+
+    // nullptr when the rest doesn't fit, counted as an overflow
+    constexpr void* try_allocate( int64_t size, int64_t alignment = alignof( void* ) )
     {
         const int64_t current_address =
             reinterpret_cast< int64_t >( &m_ptr[m_current_size] );
         const int64_t aligned_address = aligned_size( current_address, alignment );
         const int64_t new_size =
             m_current_size + ( aligned_address - current_address ) + size;
-        assert( new_size < N );
-        m_current_size = new_size;
+
+        if ( new_size > N )
+        {
+            m_overflows += 1;
+            return nullptr;
+        }
+
+        m_current_size    = new_size;
+        m_high_water_mark = new_size > m_high_water_mark ? new_size : m_high_water_mark;
         return reinterpret_cast< void* >( aligned_address );
     }
 
     constexpr void free( void* /*ptr*/ ) {}
 
+    constexpr marker save() const { return m_current_size; }
+
+    // everything allocated since the marker was saved is gone
+    constexpr void rewind( marker m )
+    {
+        assert( m >= 0 && m <= m_current_size );
+        m_current_size = m;
+    }
+
+    constexpr void reset() { m_current_size = 0; }
+
+  public:
+    constexpr int64_t size() const { return m_current_size; }
+    constexpr int64_t capacity() const { return N; }
+    constexpr int64_t high_water_mark() const { return m_high_water_mark; }
+    constexpr uint64_t overflows() const { return m_overflows; }
+
   private:
     char m_ptr[N];
     int64_t m_current_size;
+    int64_t m_high_water_mark;
+    uint64_t m_overflows;
+};
+
+// Rewinds the allocator to where it was when the scope began, for temporaries that
+// don't outlive a block.
+template < typename TAllocator > class stack_scope
+{
+  public:
+    explicit stack_scope( TAllocator& a )
+        : m_marker{a.save()}
+        , m_allocator{a}
+    {
+    }
+
+    ~stack_scope() { m_allocator.rewind( m_marker ); }
+
+    stack_scope( const stack_scope& ) = delete;
+    stack_scope& operator=( const stack_scope& ) = delete;
+
+  private:
+    typename TAllocator::marker m_marker;
+
+    TAllocator& m_allocator;
 };
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work stealing pool, every worker owns a queue and takes its newest task first, idle
+// workers steal the oldest task of another queue. Threads blocking in parallel_for
+// keep executing tasks, so nested parallel_for calls from inside a task are fine.
+class thread_pool final
+{
+  public:
+    // 0 uses one worker per hardware thread, the calling thread participates as well
+    explicit thread_pool( uint32_t thread_count = 0 );
+    ~thread_pool();
+
+    thread_pool( const thread_pool& ) = delete;
+    thread_pool& operator=( const thread_pool& ) = delete;
+
+    uint32_t thread_count() const { return m_thread_count; }
+
+    // f( begin, end ) over [0, count) in chunks of at most grain, blocks until done
+    template < typename F > void parallel_for( uint32_t count, uint32_t grain, F&& f )
+    {
+        if ( count == 0 )
+        {
+            return;
+        }
+
+        grain = std::max( grain, 1u );
+
+        const uint32_t chunks = ( count + grain - 1 ) / grain;
+        std::atomic< uint32_t > remaining{chunks};
+
+        for ( uint32_t c = 0; c < chunks; ++c )
+        {
+            const uint32_t begin = c * grain;
+            const uint32_t end   = std::min( begin + grain, count );
+
+            push( [&f, &remaining, begin, end]() {
+                f( begin, end );
+                remaining.fetch_sub( 1, std::memory_order_release );
+            } );
+        }
+
+        while ( remaining.load( std::memory_order_acquire ) > 0 )
+        {
+            if ( !run_one() )
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+  private:
+    using task = std::function< void() >;
+
+    struct worker_queue
+    {
+        std::mutex mutex;
+        std::deque< task > tasks;
+    };
+
+    void push( task t );
+    bool pop( uint32_t queue_idx, task& out );
+    bool steal( uint32_t thief_idx, task& out );
+    bool run_one();
+
+    void worker_main( uint32_t idx );
+
+    // one queue per worker plus a shared one for threads outside the pool
+    std::vector< std::unique_ptr< worker_queue > > m_queues;
+    std::vector< std::thread > m_threads;
+    uint32_t m_thread_count; //!< fixed before the workers start, they read it unlocked
+
+    std::atomic< uint32_t > m_queued;
+    std::atomic< uint32_t > m_next_queue;
+
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wake;
+    bool m_stop;
+};
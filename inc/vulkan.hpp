@@ -1,10 +1,14 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
+#include <array>
 #include <vector>
 #include <algorithm>
 #include <cstring>
+#include <tuple>
+#include <limits>
 
+#include "cpu_profiler.hpp"
 #include "debug.hpp"
 #include "static_array.hpp"
 #include "vulkan_data.hpp"
@@ -34,7 +38,7 @@ namespace detail
 
             if ( res != VK_SUCCESS )
             {
-                log( "Enumerate problem!!!" );
+                NEO_LOG_ERROR( vulkan, "Enumerate problem!!!" );
             }
 
             a.resize( count );
@@ -58,7 +62,7 @@ namespace detail
 
             if ( res != VK_SUCCESS )
             {
-                log( "Enumerate problem!!!" );
+                NEO_LOG_ERROR( vulkan, "Enumerate problem!!!" );
             }
 
             a.resize( count );
@@ -110,11 +114,11 @@ namespace detail
         detail::enumerate( vkEnumerateInstanceExtensionProperties, nullptr,
                            vd.instance_extension_properties );
 
-        log( "Instance extensions: " );
+        NEO_LOG_DEBUG( vulkan, "Instance extensions: " );
 
         for ( VkExtensionProperties& e : vd.instance_extension_properties )
         {
-            log( e.extensionName );
+            NEO_LOG_DEBUG( vulkan, e.extensionName );
         }
     }
 
@@ -124,6 +128,8 @@ template < typename TAlloc, typename TCreateSurfaceF >
 void initialize_vulkan( vulkan_data< TAlloc >& vd, names_cnt& required_extensions,
                         TCreateSurfaceF&& cvs, VkExtent2D expected_resolution )
 {
+    PROFILE_SCOPE( "initialize_vulkan" );
+
     names_cnt layer_names{};
 
 #ifdef DEBUG
@@ -137,12 +143,12 @@ void initialize_vulkan( vulkan_data< TAlloc >& vd, names_cnt& required_extension
 
     for ( const auto& ln : layer_names )
     {
-        log( "enabled layer: ", ln );
+        NEO_LOG_INFO( vulkan, "enabled layer: ", ln );
     }
 
     for ( const auto& re : required_extensions )
     {
-        log( "required extension: ", re );
+        NEO_LOG_DEBUG( vulkan, "required extension: ", re );
     }
 
     // initialize it
@@ -181,6 +187,46 @@ template < typename TAlloc > void destroy_vulkan( vulkan_data< TAlloc >& vd )
     destroy_vk_instance( vd );
 }
 
+// No surface and no swap chain, enough for compute only tools. Works with software
+// ICDs as it does not require any device extension.
+template < typename TAlloc > void initialize_vulkan_headless( vulkan_data< TAlloc >& vd )
+{
+    names_cnt layer_names{};
+    names_cnt required_extensions{};
+
+#ifdef DEBUG
+    detail::add_debug_layer_names( layer_names );
+    detail::add_debug_extensions( required_extensions );
+#endif
+
+    detail::enumerate_instance_extensions( vd );
+
+    detail::add_required_instance_extensions( required_extensions );
+
+    create_vk_instance( vd, required_extensions, layer_names );
+
+#ifdef DEBUG
+    create_debug_utils_messanger( vd );
+#endif
+    enumerate_vk_devices( vd );
+    choose_physical_device( vd );
+    enumerate_vk_device_extensions( vd );
+    enumerate_vk_queue_families( vd );
+    create_vk_logical_device( vd, array_ref< const char* >{nullptr, 0} );
+    create_vk_queues( vd );
+    create_vk_command_buffer_pool( vd );
+}
+
+template < typename TAlloc > void destroy_vulkan_headless( vulkan_data< TAlloc >& vd )
+{
+    destroy_vk_command_buffer_pool( vd );
+    destroy_vk_logical_device( vd );
+#ifdef DEBUG
+    destroy_debug_utils_messanger( vd );
+#endif
+    destroy_vk_instance( vd );
+}
+
 #ifdef DEBUG
 template < typename TAlloc >
 void create_debug_utils_messanger( vulkan_data< TAlloc >& vd )
@@ -201,14 +247,14 @@ void create_debug_utils_messanger( vulkan_data< TAlloc >& vd )
 
     if ( func == nullptr )
     {
-        log( "vkCreateDebugUtilsMessengerEXT does not exit!" );
+        NEO_LOG_ERROR( vulkan, "vkCreateDebugUtilsMessengerEXT does not exit!" );
         exit( -1 );
     }
 
     const auto res = func( vd.instance, &create_info, nullptr, &vd.debug_messanger );
     if ( res != VK_SUCCESS )
     {
-        log( "vkCreateDebugUtilsMessengerEXT returned: ", res );
+        NEO_LOG_ERROR( vulkan, "vkCreateDebugUtilsMessengerEXT returned: ", res );
         exit( -1 );
     }
 }
@@ -221,7 +267,7 @@ void destroy_debug_utils_messanger( vulkan_data< TAlloc >& vd )
 
     if ( func == nullptr )
     {
-        log( "vkDestroyDebugUtilsMessengerEXT does not exit!" );
+        NEO_LOG_ERROR( vulkan, "vkDestroyDebugUtilsMessengerEXT does not exit!" );
         exit( -1 );
     }
 
@@ -260,18 +306,18 @@ void create_vk_instance( vulkan_data< TAlloc >& vd, const names_cnt& required_ex
 
     if ( vkCreateInstance( &instance_create_info, nullptr, &vd.instance ) != VK_SUCCESS )
     {
-        log( "Could not create Vulkan instance!" );
+        NEO_LOG_ERROR( vulkan, "Could not create Vulkan instance!" );
         exit( -1 );
     }
 
-    log( "Vulkan instance created" );
+    NEO_LOG_INFO( vulkan, "Vulkan instance created" );
 }
 
 template < typename TAlloc > void destroy_vk_instance( vulkan_data< TAlloc >& vd )
 {
     vkDestroyInstance( vd.instance, nullptr );
     vd.instance = nullptr;
-    log( "Vulkan instance destroyed" );
+    NEO_LOG_INFO( vulkan, "Vulkan instance destroyed" );
 }
 
 template < typename TAlloc, typename TCreateSurfaceF >
@@ -295,7 +341,7 @@ template < typename TAlloc > void enumerate_vk_devices( vulkan_data< TAlloc >& v
     detail::enumerate( vkEnumeratePhysicalDevices, vd.instance, vd.physical_devices );
     const auto count = vd.physical_devices.size();
 
-    log( "Found: ", count, " physical device(s)" );
+    NEO_LOG_INFO( vulkan, "Found: ", count, " physical device(s)" );
 
     vd.device_properties.resize( count );
     vd.device_features.resize( count );
@@ -309,8 +355,10 @@ template < typename TAlloc > void enumerate_vk_devices( vulkan_data< TAlloc >& v
         vkGetPhysicalDeviceProperties( d, &p );
         vkGetPhysicalDeviceFeatures( d, &f );
 
-        log( p.deviceName, " api version: ", VK_VERSION_MAJOR( p.apiVersion ), ".",
-             VK_VERSION_MINOR( p.apiVersion ), ".", VK_VERSION_PATCH( p.apiVersion ) );
+        NEO_LOG_INFO( vulkan, p.deviceName, " api version: ",
+                      VK_VERSION_MAJOR( p.apiVersion ), ".",
+                      VK_VERSION_MINOR( p.apiVersion ), ".",
+                      VK_VERSION_PATCH( p.apiVersion ) );
     }
 }
 
@@ -320,11 +368,11 @@ void enumerate_vk_extensions( vulkan_data< TAlloc >& vd, F&& fnc )
     vd.extension_names = detail::enumerate< vd.extension_names.capacity() >(
         std::move< F >( fnc ), vd.window, vd.al );
 
-    log( "Instance extensions: " );
+    NEO_LOG_DEBUG( vulkan, "Instance extensions: " );
 
     for ( const char* e : vd.extension_names )
     {
-        log( e );
+        NEO_LOG_DEBUG( vulkan, e );
     }
 }
 
@@ -334,11 +382,11 @@ void enumerate_vk_device_extensions( vulkan_data< TAlloc >& vd )
     detail::enumerate( vkEnumerateDeviceExtensionProperties, vd.selected_device, nullptr,
                        vd.device_extension_properties );
 
-    log( "Device extensions: " );
+    NEO_LOG_DEBUG( vulkan, "Device extensions: " );
 
     for ( VkExtensionProperties& e : vd.device_extension_properties )
     {
-        log( e.extensionName );
+        NEO_LOG_DEBUG( vulkan, e.extensionName );
     }
 }
 
@@ -371,16 +419,23 @@ template < typename TAlloc > void enumerate_vk_queue_families( vulkan_data< TAll
     {
         VkQueueFamilyProperties& fp             = vd.queue_family_properties[i];
         VkBool32 surface_presentation_supported = false;
-        const VkResult res                      = vkGetPhysicalDeviceSurfaceSupportKHR(
-            vd.selected_device, i, vd.surface, &surface_presentation_supported );
-        NEO_ASSERT_ALWAYS( res == VK_SUCCESS,
-                           "vkGetPhysicalDeviceSurfaceSupportKHR failed!" );
+
+        // headless, nothing to present to
+        const bool has_surface = vd.surface != nullptr;
+
+        if ( has_surface )
+        {
+            const VkResult res = vkGetPhysicalDeviceSurfaceSupportKHR(
+                vd.selected_device, i, vd.surface, &surface_presentation_supported );
+            NEO_ASSERT_ALWAYS( res == VK_SUCCESS,
+                               "vkGetPhysicalDeviceSurfaceSupportKHR failed!" );
+        }
 
         if ( vd.selected_gfx_queue_idx == -1 )
         {
             const bool has_graphics_bit = fp.queueFlags & VK_QUEUE_GRAPHICS_BIT;
 
-            if ( has_graphics_bit && surface_presentation_supported )
+            if ( has_graphics_bit && ( surface_presentation_supported || !has_surface ) )
                 vd.selected_gfx_queue_idx = i;
         }
 
@@ -390,10 +445,11 @@ template < typename TAlloc > void enumerate_vk_queue_families( vulkan_data< TAll
             vd.selected_compute_queue_ids = i;
         }
 
-        log( "q: ", i, ( ( fp.queueFlags & VK_QUEUE_GRAPHICS_BIT ) ? " [graphics]" : "" ),
-             ( ( fp.queueFlags & VK_QUEUE_TRANSFER_BIT ) ? " [transfer]" : "" ),
-             ( ( fp.queueFlags & VK_QUEUE_COMPUTE_BIT ) ? " [compute]" : "" ),
-             ( ( surface_presentation_supported ) ? " [presentation]" : "" ) );
+        NEO_LOG_DEBUG( vulkan, "q: ", i,
+                       ( ( fp.queueFlags & VK_QUEUE_GRAPHICS_BIT ) ? " [graphics]" : "" ),
+                       ( ( fp.queueFlags & VK_QUEUE_TRANSFER_BIT ) ? " [transfer]" : "" ),
+                       ( ( fp.queueFlags & VK_QUEUE_COMPUTE_BIT ) ? " [compute]" : "" ),
+                       ( ( surface_presentation_supported ) ? " [presentation]" : "" ) );
     }
 }
 
@@ -414,6 +470,13 @@ void create_vk_logical_device( vulkan_data< TAlloc >& vd,
         VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,           nullptr, 0,
         static_cast< uint32_t >( vd.selected_gfx_queue_idx ), 1,       queue_priorities};
 
+    // only what the diagnostics need, and only where it's there
+    const auto& supported_features = vd.device_features[vd.selected_device_idx];
+
+    vd.enabled_features = VkPhysicalDeviceFeatures{};
+    vd.enabled_features.pipelineStatisticsQuery =
+        supported_features.pipelineStatisticsQuery;
+
     VkDeviceCreateInfo device_create_info{
         VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
         nullptr,
@@ -424,17 +487,17 @@ void create_vk_logical_device( vulkan_data< TAlloc >& vd,
         nullptr,
         static_cast< uint32_t >( required_device_extensions.size() ),
         required_device_extensions.raw_ptr(),
-        nullptr};
+        &vd.enabled_features};
 
     const auto res = vkCreateDevice( vd.selected_device, &device_create_info, nullptr,
                                      &vd.logical_device );
     if ( res != VK_SUCCESS )
     {
-        log( "Failed to create Vulkan Device!" );
+        NEO_LOG_ERROR( vulkan, "Failed to create Vulkan Device!" );
         exit( -1 );
     }
 
-    log( "Vulkan Device created!" );
+    NEO_LOG_INFO( vulkan, "Vulkan Device created!" );
 }
 
 template < typename TAlloc > void create_vk_queues( vulkan_data< TAlloc >& vd )
@@ -444,22 +507,24 @@ template < typename TAlloc > void create_vk_queues( vulkan_data< TAlloc >& vd )
 
     if ( vd.graphics_queue == nullptr )
     {
-        log( "Failed to create graphics queue!" );
+        NEO_LOG_ERROR( vulkan, "Failed to create graphics queue!" );
         exit( -1 );
     }
 
-    log( "Graphics queue created" );
+    NEO_LOG_INFO( vulkan, "Graphics queue created" );
 }
 
 template < typename TAlloc > void destroy_vk_logical_device( vulkan_data< TAlloc >& vd )
 {
     vkDestroyDevice( vd.logical_device, nullptr );
     vd.logical_device = nullptr;
-    log( "Vulkan Device destroyed!" );
+    NEO_LOG_INFO( vulkan, "Vulkan Device destroyed!" );
 }
 
 template < typename TAlloc > void choose_physical_device( vulkan_data< TAlloc >& vd )
 {
+    NEO_ASSERT_ALWAYS( vd.physical_devices.size() > 0, "No Vulkan device found!" );
+
     std::vector< std::tuple< uint32_t, uint32_t > > scores;
 
     scores.resize( vd.physical_devices.size() );
@@ -485,9 +550,9 @@ template < typename TAlloc > void choose_physical_device( vulkan_data< TAlloc >&
     vd.selected_device     = vd.physical_devices[std::get< 1 >( scores[0] )];
     vd.selected_device_idx = std::get< 1 >( scores[0] );
 
-    log( "Selected physical device: ",
-         vd.device_properties[vd.selected_device_idx].deviceName,
-         " score: ", std::get< 0 >( scores[0] ) );
+    NEO_LOG_INFO( vulkan, "Selected physical device: ",
+                  vd.device_properties[vd.selected_device_idx].deviceName,
+                  " score: ", std::get< 0 >( scores[0] ) );
 }
 
 namespace detail
@@ -511,7 +576,7 @@ namespace detail
             case VK_FORMAT_D16_UNORM:
                 return "VK_FORMAT_D16_UNORM";
             default:
-                log( "id: ", static_cast< int32_t >( f ) );
+                NEO_LOG_DEBUG( vulkan, "id: ", static_cast< int32_t >( f ) );
                 return "UNKNOWN";
         };
     }
@@ -551,14 +616,35 @@ namespace detail
         detail::enumerate( vkGetPhysicalDeviceSurfaceFormatsKHR, vd.selected_device,
                            vd.surface, vd.surface_formats );
 
-        log( "Supported surface formats:" );
+        NEO_LOG_DEBUG( vulkan, "Supported surface formats:" );
 
         for ( VkSurfaceFormatKHR e : vd.surface_formats )
         {
-            log( "\t", vk_format_to_str( e.format ) );
+            NEO_LOG_DEBUG( vulkan, "\t", vk_format_to_str( e.format ) );
         }
     }
 
+    template < typename TAlloc >
+    VkPresentModeKHR select_present_mode( vulkan_data< TAlloc >& vd )
+    {
+        detail::enumerate( vkGetPhysicalDeviceSurfacePresentModesKHR, vd.selected_device,
+                           vd.surface, vd.present_modes );
+
+        const auto it = std::find( vd.present_modes.begin(), vd.present_modes.end(),
+                                   vd.swap_chain.requested_present_mode );
+
+        if ( it != vd.present_modes.end() )
+        {
+            return *it;
+        }
+
+        NEO_LOG_WARNING( vulkan,
+                         "Requested present mode not supported, falling back to FIFO" );
+
+        // the only one every surface supports
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+
     template < typename TAlloc > void acquire_depth_format( vulkan_data< TAlloc >& vd )
     {
         // Since all depth formats may be optional, we need to find a suitable depth
@@ -577,7 +663,8 @@ namespace detail
                  & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT )
             {
                 vd.depth_format = format;
-                log( "Supported depth format: ", vk_format_to_str( format ) );
+                NEO_LOG_DEBUG( vulkan, "Supported depth format: ",
+                               vk_format_to_str( format ) );
                 break;
             }
         }
@@ -595,7 +682,7 @@ namespace detail
         }
 
         vd.swap_chain.images_count = image_count;
-        log( "Will be using: ", image_count, " swap chain image(s)" );
+        NEO_LOG_INFO( vulkan, "Will be using: ", image_count, " swap chain image(s)" );
     }
 
     template < typename TAlloc >
@@ -708,12 +795,14 @@ void create_vk_swap_chain( vulkan_data< TAlloc >& vd, VkExtent2D expected_resolu
     detail::select_number_of_swap_chain_images( vd );
 
     vd.swap_chain.selected_format = detail::select_swap_chain_images_format( vd );
-    log( "Selected swap chain format: ",
-         detail::vk_format_to_str( vd.swap_chain.selected_format.format ) );
+    NEO_LOG_INFO( vulkan, "Selected swap chain format: ",
+                  detail::vk_format_to_str( vd.swap_chain.selected_format.format ) );
 
     vd.swap_chain.selected_extent =
         detail::select_swap_chain_images_extent( vd, expected_resolution );
 
+    vd.swap_chain.selected_present_mode = detail::select_present_mode( vd );
+
     VkSwapchainCreateInfoKHR create_info = {VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
                                             nullptr,
                                             0,
@@ -730,7 +819,7 @@ void create_vk_swap_chain( vulkan_data< TAlloc >& vd, VkExtent2D expected_resolu
                                             nullptr,
                                             vd.surface_capabilities.currentTransform,
                                             VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-                                            VK_PRESENT_MODE_IMMEDIATE_KHR,
+                                            vd.swap_chain.selected_present_mode,
                                             VK_TRUE,
                                             nullptr};
 
@@ -744,7 +833,7 @@ void create_vk_swap_chain( vulkan_data< TAlloc >& vd, VkExtent2D expected_resolu
     detail::get_swap_chain_images( vd );
     detail::create_swap_chain_image_views( vd );
 
-    log( "Swap chain created sucesfully! " );
+    NEO_LOG_INFO( vulkan, "Swap chain created sucesfully! " );
 }
 
 template < typename TAlloc > void destroy_vk_swap_chain( vulkan_data< TAlloc >& vd )
@@ -9,6 +9,22 @@
 #include "static_array.hpp"
 #include "stack_allocator.hpp"
 
+struct buffer_data
+{
+    VkDeviceMemory memory = nullptr;
+    VkBuffer buffer       = nullptr;
+    VkDeviceSize size     = 0;
+};
+
+struct image_data
+{
+    VkImage image          = nullptr;
+    VkDeviceMemory memory  = nullptr;
+    VkImageView image_view = nullptr;
+    VkFormat format        = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent      = VkExtent2D{};
+};
+
 template < typename TAlloc > struct swap_chain_data
 {
     static auto constexpr data_size = 8;
@@ -26,6 +42,9 @@ template < typename TAlloc > struct swap_chain_data
     uint32_t images_count                                                 = 0u;
     VkSurfaceFormatKHR selected_format = VkSurfaceFormatKHR{};
     VkExtent2D selected_extent         = VkExtent2D{};
+    // set before the swap chain is created, FIFO is used when the surface lacks it
+    VkPresentModeKHR requested_present_mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    VkPresentModeKHR selected_present_mode  = VK_PRESENT_MODE_FIFO_KHR;
 };
 
 template < typename TAlloc > struct vulkan_data
@@ -44,6 +63,7 @@ template < typename TAlloc > struct vulkan_data
         , device_features{al}
         , queue_family_properties{al}
         , surface_formats{al}
+        , present_modes{al}
         , swap_chain{al}
     {
     }
@@ -67,10 +87,13 @@ template < typename TAlloc > struct vulkan_data
     static_array< VkExtensionProperties, data_size_device_extension_properties, TAlloc >
         device_extension_properties;
     static_array< VkPhysicalDeviceFeatures, data_size, TAlloc > device_features;
+    // the optional features of the selected device that were enabled
+    VkPhysicalDeviceFeatures enabled_features = VkPhysicalDeviceFeatures{};
     static_array< VkQueueFamilyProperties, data_size, TAlloc > queue_family_properties;
 
     VkSurfaceCapabilitiesKHR surface_capabilities = VkSurfaceCapabilitiesKHR{};
     static_array< VkSurfaceFormatKHR, data_size, TAlloc > surface_formats;
+    static_array< VkPresentModeKHR, data_size, TAlloc > present_modes;
     swap_chain_data< TAlloc > swap_chain;
 
     VkFormat depth_format;
@@ -124,6 +147,182 @@ template < typename TAlloc > struct vulkan_data
         return module;
     }
 
+    buffer_data create_buffer( VkDeviceSize size, VkBufferUsageFlags usage,
+                               VkMemoryPropertyFlags properties )
+    {
+        buffer_data ret{};
+        ret.size = size;
+
+        VkBufferCreateInfo create_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                          nullptr,
+                                          0,
+                                          size,
+                                          usage,
+                                          VK_SHARING_MODE_EXCLUSIVE,
+                                          0,
+                                          nullptr};
+
+        auto res = vkCreateBuffer( logical_device, &create_info, nullptr, &ret.buffer );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creating buffer failed" );
+
+        VkMemoryRequirements memory_requirements{};
+        vkGetBufferMemoryRequirements( logical_device, ret.buffer, &memory_requirements );
+
+        VkMemoryAllocateInfo mem_alloc = {
+            VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, memory_requirements.size,
+            get_memory_type_idx( memory_requirements.memoryTypeBits, properties )};
+
+        res = vkAllocateMemory( logical_device, &mem_alloc, nullptr, &ret.memory );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Allocating buffer memory failed" );
+
+        res = vkBindBufferMemory( logical_device, ret.buffer, ret.memory, 0 );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Binding buffer memory failed" );
+
+        return ret;
+    }
+
+    void destroy_buffer( buffer_data& b )
+    {
+        vkDestroyBuffer( logical_device, b.buffer, nullptr );
+        vkFreeMemory( logical_device, b.memory, nullptr );
+        b = buffer_data{};
+    }
+
+    image_data create_image_2d( VkExtent2D extent, VkFormat format,
+                                VkImageUsageFlags usage,
+                                VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT )
+    {
+        image_data ret{};
+        ret.format = format;
+        ret.extent = extent;
+
+        VkImageCreateInfo image_create_info = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                                               nullptr,
+                                               0,
+                                               VK_IMAGE_TYPE_2D,
+                                               format,
+                                               {extent.width, extent.height, 1},
+                                               1,
+                                               1,
+                                               VK_SAMPLE_COUNT_1_BIT,
+                                               VK_IMAGE_TILING_OPTIMAL,
+                                               usage,
+                                               VK_SHARING_MODE_EXCLUSIVE,
+                                               0,
+                                               nullptr,
+                                               VK_IMAGE_LAYOUT_UNDEFINED};
+
+        auto res =
+            vkCreateImage( logical_device, &image_create_info, nullptr, &ret.image );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Couldn't create image!" );
+
+        VkMemoryRequirements memory_requirements{};
+        vkGetImageMemoryRequirements( logical_device, ret.image, &memory_requirements );
+
+        VkMemoryAllocateInfo mem_alloc = {
+            VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, memory_requirements.size,
+            get_memory_type_idx( memory_requirements.memoryTypeBits,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )};
+
+        res = vkAllocateMemory( logical_device, &mem_alloc, nullptr, &ret.memory );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Can't allocate memory for an image!" );
+
+        res = vkBindImageMemory( logical_device, ret.image, ret.memory, 0 );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Binding image memory failed" );
+
+        VkImageViewCreateInfo view_create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            nullptr,
+            0,
+            ret.image,
+            VK_IMAGE_VIEW_TYPE_2D,
+            format,
+            {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+             VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY},
+            {aspect, 0, 1, 0, 1}};
+
+        res = vkCreateImageView( logical_device, &view_create_info, nullptr,
+                                 &ret.image_view );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Couldn't create image view!" );
+
+        return ret;
+    }
+
+    void destroy_image( image_data& im )
+    {
+        vkDestroyImageView( logical_device, im.image_view, nullptr );
+        vkDestroyImage( logical_device, im.image, nullptr );
+        vkFreeMemory( logical_device, im.memory, nullptr );
+        im = image_data{};
+    }
+
+    VkPipeline
+    create_compute_pipeline( const char* filename, VkPipelineLayout layout,
+                             const VkSpecializationInfo* specialization = nullptr )
+    {
+        VkComputePipelineCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            nullptr,
+            0,
+            {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0,
+             VK_SHADER_STAGE_COMPUTE_BIT, load_shader( filename ), "main",
+             specialization},
+            layout,
+            nullptr,
+            -1};
+
+        VkPipeline pipeline = nullptr;
+        const auto res      = vkCreateComputePipelines( logical_device, nullptr, 1,
+                                                   &create_info, nullptr, &pipeline );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of compute pipeline failed: ",
+                           filename );
+
+        vkDestroyShaderModule( logical_device, create_info.stage.module, nullptr );
+
+        return pipeline;
+    }
+
+    // Records into a throw away command buffer, submit_one_time_commands blocks until
+    // the queue is idle. Meant for initialization and readbacks only.
+    VkCommandBuffer begin_one_time_commands()
+    {
+        VkCommandBufferAllocateInfo allocate_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, nullptr, pool_command_buffers,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1};
+
+        VkCommandBuffer command_buffer = nullptr;
+
+        auto res =
+            vkAllocateCommandBuffers( logical_device, &allocate_info, &command_buffer );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Can't alocate command buffer!" );
+
+        VkCommandBufferBeginInfo begin_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr};
+
+        res = vkBeginCommandBuffer( command_buffer, &begin_info );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Can't begin command buffer!" );
+
+        return command_buffer;
+    }
+
+    void submit_one_time_commands( VkCommandBuffer command_buffer )
+    {
+        vkEndCommandBuffer( command_buffer );
+
+        const VkSubmitInfo submit_info = {
+            VK_STRUCTURE_TYPE_SUBMIT_INFO, nullptr, 0, nullptr, nullptr, 1,
+            &command_buffer,               0,       nullptr};
+
+        auto res = vkQueueSubmit( graphics_queue, 1, &submit_info, nullptr );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Submission of buffer failed!" );
+
+        res = vkQueueWaitIdle( graphics_queue );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Waiting for the queue failed!" );
+
+        vkFreeCommandBuffers( logical_device, pool_command_buffers, 1, &command_buffer );
+    }
+
     void get_memory_budget()
     {
         VkPhysicalDeviceMemoryBudgetPropertiesEXT memory_budget{
@@ -144,11 +343,13 @@ template < typename TAlloc > struct vulkan_data
                     & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT )
                   == VK_MEMORY_HEAP_DEVICE_LOCAL_BIT );
 
-            log( "memory heap ", ( is_device ? "device" : "host" ) );
-            log( "\t budget: ",
-                 memory_budget.heapBudget[i] * ( 1.0f / ( 1024.0f * 1024.0f ) ), " MB" );
-            log( "\t used: ",
-                 memory_budget.heapUsage[i] * ( 1.0f / ( 1024.0f * 1024.0f ) ), " MB" );
+            NEO_LOG_DEBUG( vulkan, "memory heap ", ( is_device ? "device" : "host" ) );
+            NEO_LOG_DEBUG( vulkan, "\t budget: ",
+                           memory_budget.heapBudget[i] * ( 1.0f / ( 1024.0f * 1024.0f ) ),
+                           " MB" );
+            NEO_LOG_DEBUG( vulkan, "\t used: ",
+                           memory_budget.heapUsage[i] * ( 1.0f / ( 1024.0f * 1024.0f ) ),
+                           " MB" );
         }
     }
 };
@@ -3,6 +3,7 @@
 layout( location = 0 ) in vec3 inPos;
 layout( location = 1 ) in vec3 inNormal;
 layout( location = 2 ) in vec2 inTexCoord;
+layout( location = 3 ) in mat4 inInstance; // per instance, locations 3 - 6
 
 layout( location = 0 ) out vec3 outColor;
 layout( location = 1 ) out vec3 outPos;
@@ -19,9 +20,13 @@ ubo;
 
 void main()
 {
+    // spin every instance around its own origin before placing it
+    mat4 model = inInstance * ubo.model;
+
     outColor    = vec3( 1 );
-    outPos      = ( ( ubo.view * ubo.model ) * vec4( inPos.xyz, 1.0 ) ).xyz;
+    outPos      = ( ( ubo.view * model ) * vec4( inPos.xyz, 1.0 ) ).xyz;
     texCoord    = vec2( inTexCoord.x, 1.0 - inTexCoord.y );
-    outNormal   = ( ubo.view * ubo.model * vec4( inNormal, 0.0 ) ).xyz;
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4( inPos.xyz, 1.0 );
+    // instances may be scaled
+    outNormal   = normalize( ( ubo.view * model * vec4( inNormal, 0.0 ) ).xyz );
+    gl_Position = ubo.proj * ubo.view * model * vec4( inPos.xyz, 1.0 );
 }
@@ -0,0 +1,9 @@
+#version 450
+
+// every fragment adds one, the render pass blends additively into an R32 float target
+layout( location = 0 ) out float outCount;
+
+void main()
+{
+    outCount = 1.0;
+}
@@ -0,0 +1,33 @@
+#version 450
+
+layout( location = 0 ) in vec2 inTexCoord;
+
+layout( location = 0 ) out vec4 outFragColor;
+
+layout( binding = 0 ) uniform sampler2D hdrSampler;
+
+layout( std430, binding = 1 ) readonly buffer exposure_buffer
+{
+    float exposure;
+    float average_luminance;
+}
+state;
+
+vec4 tone_map( vec3 c, float exposure )
+{
+    const float gamma = 2.2;
+    vec3 hdrColor     = c.rgb;
+
+    // Exposure tone mapping
+    vec3 mapped = vec3( 1.0 ) - exp( -hdrColor * exposure );
+    // Gamma correction
+    mapped = pow( mapped, vec3( 1.0 / gamma ) );
+
+    return vec4( mapped, 1.0 );
+}
+
+void main()
+{
+    const vec3 hdr = texelFetch( hdrSampler, ivec2( gl_FragCoord.xy ), 0 ).rgb;
+    outFragColor   = tone_map( hdr, state.exposure );
+}
@@ -15,9 +15,63 @@ workspace "VulkanWorkspace"
         flags { "MultiProcessorCompile" }
     filter{}
 
+newoption {
+    trigger     = "avx2",
+    description = "Compile the CPU fallback paths ( software rasterizer ) with AVX2"
+}
+
+newoption {
+    trigger     = "profiler",
+    description = "Record PROFILE_SCOPE zones for Chrome trace export ( --trace <file> )"
+}
+
+newoption {
+    trigger     = "log-level",
+    value       = "LEVEL",
+    description = "Compile out log sites below LEVEL, default debug in Debug and info in Release",
+    allowed     = {
+        { "debug",   "Everything" },
+        { "info",    "No NEO_LOG_DEBUG" },
+        { "warning", "Warnings and errors" },
+        { "error",   "Errors only" }
+    }
+}
+
+local log_levels = { debug = 0, info = 1, warning = 2, error = 3 }
+
+function log_level_defines()
+    for name, value in pairs( log_levels ) do
+        filter( "options:log-level=" .. name )
+            defines { "NEO_LOG_MIN_LEVEL=" .. value }
+    end
+    filter {}
+end
+
 local cwd = os.getcwd()
 shader_out_path = cwd .. "/generated"
 
+function shader_build_rules()
+    filter { "system:linux or system:macosx", "files:media/shaders/**.vert or files:media/shaders/**.frag or files:media/shaders/**.comp" }
+        buildmessage "Compiling shader %{file.name}"
+        buildcommands {
+            "glslangValidator -e main -o %{shader_out_path}/%{file.name}.spirv -DVK=1 -V %{file.relpath}"
+        }
+        buildoutputs {
+            "%{shader_out_path}/%{file.name}.spirv"
+        }
+
+    filter { "system:windows", "files:media/shaders/**.vert or files:media/shaders/**.frag or files:media/shaders/**.comp" }
+        buildmessage "Compiling shader %{file.name}"
+        buildcommands {
+            "glslangValidator.exe -e main -o %{shader_out_path}/%{file.name}.spirv -DVK=1 -V %{file.relpath}"
+        }
+        buildoutputs {
+            "%{shader_out_path}/%{file.name}.spirv"
+        }
+
+    filter{}
+end
+
 project "ComputeTest"
     kind "ConsoleApp"
     language "C++"
@@ -25,7 +79,7 @@ project "ComputeTest"
     flags { "NoPCH", "StaticRuntime" }    
     targetdir "bin/%{cfg.buildcfg}"
 
-    files { "inc/**.h", "inc/**.hpp", "src/**.cpp", "media/shaders/**.vert", "media/shaders/**.frag" }
+    files { "inc/**.h", "inc/**.hpp", "src/**.cpp", "media/shaders/**.vert", "media/shaders/**.frag", "media/shaders/**.comp" }
 
     filter { "system:linux or system:macosx" }
         includedirs { "inc", "${VULKAN_SDK}/include", "lib/tinyobjloader", "lib/stb", "lib/glm" }
@@ -38,23 +92,7 @@ project "ComputeTest"
     filter { "system:linux or system:macosx" }
         toolset "clang"
 
-    filter { "system:linux or system:macosx", "files:media/shaders/**.vert or files:media/shaders/**.frag" }
-        buildmessage "Compiling shader %{file.name}"
-        buildcommands {
-            "glslangValidator -e main -o %{shader_out_path}/%{file.name}.spirv -DVK=1 -V %{file.relpath}"
-        }
-        buildoutputs {
-            "%{shader_out_path}/%{file.name}.spirv"
-        }
-
-    filter { "system:windows", "files:media/shaders/**.vert or files:media/shaders/**.frag" }
-        buildmessage "Compiling shader %{file.name}"
-        buildcommands {
-            "glslangValidator.exe -e main -o %{shader_out_path}/%{file.name}.spirv -DVK=1 -V %{file.relpath}"
-        }
-        buildoutputs {
-            "%{shader_out_path}/%{file.name}.spirv"
-        }
+    shader_build_rules()
 
     filter "configurations:Debug"
         defines { "DEBUG" }
@@ -65,7 +103,7 @@ project "ComputeTest"
         optimize "On"
 
     filter { "system:linux" }
-        links { "vulkan", "SDL2" }
+        links { "vulkan", "SDL2", "pthread" }
 
     filter { "system:windows" }
         links { "vulkan-1", "SDL2" }
@@ -85,3 +123,110 @@ project "ComputeTest"
 
     filter { "system:macosx or system:linux" }
         buildoptions{ "-Wall", "-Wextra" }
+
+    filter { "options:avx2", "system:macosx or system:linux" }
+        buildoptions{ "-mavx2" }
+
+    filter { "options:avx2", "system:windows" }
+        buildoptions{ "/arch:AVX2" }
+
+    filter "options:profiler"
+        defines { "NEO_PROFILER_ENABLED=1" }
+
+    log_level_defines()
+
+-- headless compute benchmarks, no SDL and no window
+project "ComputeBench"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    flags { "NoPCH", "StaticRuntime" }
+    targetdir "bin/%{cfg.buildcfg}"
+
+    files { "inc/**.h", "inc/**.hpp", "src/**.cpp", "bench/**.hpp", "bench/**.cpp", "media/shaders/**.comp", "media/shaders/simple.vert", "media/shaders/simple.frag" }
+    removefiles { "src/main.cpp", "src/sdl.cpp", "src/examples/**", "inc/examples/**", "inc/sdl.hpp", "inc/application.hpp" }
+
+    filter { "system:linux or system:macosx" }
+        includedirs { "inc", "bench", "${VULKAN_SDK}/include", "lib/tinyobjloader", "lib/stb", "lib/glm" }
+        libdirs { "${VULKAN_SDK}/lib" }
+
+    filter { "system:windows" }
+        includedirs { "inc", "bench", "lib/tinyobjloader", "lib/stb", "lib/glm", "%VULKAN_SDK%/Include" }
+        libdirs { "%VULKAN_SDK%/lib" }
+
+    filter { "system:linux or system:macosx" }
+        toolset "clang"
+
+    shader_build_rules()
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        symbols "On"
+
+    filter "configurations:Release"
+        defines { "NDEBUG" }
+        optimize "On"
+
+    filter { "system:linux" }
+        links { "vulkan", "pthread" }
+
+    filter { "system:windows" }
+        links { "vulkan-1" }
+
+    filter { "system:macosx" }
+        links { "MoltenVK", "vulkan.1" }
+        libdirs { "ext/macos/Frameworks" }
+        linkoptions { "-rpath @executable_path/Frameworks", "-rpath @executable_path/../Frameworks", "-rpath @executable_path/../../ext/macos/Frameworks" }
+
+    filter { "system:macosx or system:linux" }
+        buildoptions{ "-Wall", "-Wextra" }
+
+    filter { "options:avx2", "system:macosx or system:linux" }
+        buildoptions{ "-mavx2" }
+
+    filter { "options:avx2", "system:windows" }
+        buildoptions{ "/arch:AVX2" }
+
+    filter "options:profiler"
+        defines { "NEO_PROFILER_ENABLED=1" }
+
+    log_level_defines()
+
+-- CPU side of the asset pipeline on synthetic inputs, no GPU needed
+project "AssetBench"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    flags { "NoPCH", "StaticRuntime" }
+    targetdir "bin/%{cfg.buildcfg}"
+
+    files { "asset_bench/**.hpp", "asset_bench/**.cpp", "src/model.cpp", "src/image.cpp", "src/thread_pool.cpp", "src/cpu_profiler.cpp", "src/logger.cpp", "src/json.cpp", "src/soft_rasterizer.cpp", "bench/result_table.hpp", "bench/result_table.cpp" }
+    includedirs { "inc", "asset_bench", "bench", "lib/tinyobjloader", "lib/stb", "lib/glm" }
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        symbols "On"
+
+    filter "configurations:Release"
+        defines { "NDEBUG" }
+        optimize "On"
+
+    filter { "system:linux" }
+        links { "pthread" }
+
+    filter { "system:linux or system:macosx" }
+        toolset "clang"
+
+    filter { "system:macosx or system:linux" }
+        buildoptions{ "-Wall", "-Wextra" }
+
+    filter { "options:avx2", "system:macosx or system:linux" }
+        buildoptions{ "-mavx2" }
+
+    filter { "options:avx2", "system:windows" }
+        buildoptions{ "/arch:AVX2" }
+
+    filter "options:profiler"
+        defines { "NEO_PROFILER_ENABLED=1" }
+
+    log_level_defines()
@@ -0,0 +1,467 @@
+#include "auto_exposure.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void auto_exposure::initialize( VkImageView hdr_image_view, VkImageLayout hdr_layout,
+                                VkExtent2D extent, uint32_t frame_count,
+                                const settings& s )
+{
+    m_settings = s;
+    m_extent   = extent;
+
+    create_buffers( frame_count );
+    init_descriptor_set_layouts();
+    create_descriptor_sets( hdr_image_view, hdr_layout, frame_count );
+    init_pipelines();
+}
+
+void auto_exposure::deinitialize()
+{
+    destroy_pipelines();
+    destroy_descriptor_sets();
+    destroy_descriptor_set_layouts();
+    destroy_buffers();
+}
+
+void auto_exposure::create_buffers( uint32_t frame_count )
+{
+    m_histogram = m_vulkan_data.create_buffer(
+        HISTOGRAM_BINS * sizeof( uint32_t ),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    m_exposure = m_vulkan_data.create_buffer( sizeof( exposure_state ),
+                                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                                                  | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                                                  | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    m_frame_params.resize( frame_count );
+
+    for ( auto& fp : m_frame_params )
+    {
+        fp = m_vulkan_data.create_buffer( sizeof( frame_params ),
+                                          VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                                              | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+    }
+
+    // the average pass clears the histogram after itself, so we only need to start
+    // from a clean state once
+    const exposure_state initial_state{m_settings.key_value, 1.0f};
+
+    VkCommandBuffer cmd = m_vulkan_data.begin_one_time_commands();
+    vkCmdFillBuffer( cmd, m_histogram.buffer, 0, VK_WHOLE_SIZE, 0 );
+    vkCmdUpdateBuffer( cmd, m_exposure.buffer, 0, sizeof( exposure_state ),
+                       &initial_state );
+    m_vulkan_data.submit_one_time_commands( cmd );
+}
+
+void auto_exposure::destroy_buffers()
+{
+    for ( auto& fp : m_frame_params )
+    {
+        m_vulkan_data.destroy_buffer( fp );
+    }
+
+    m_frame_params.clear();
+
+    m_vulkan_data.destroy_buffer( m_exposure );
+    m_vulkan_data.destroy_buffer( m_histogram );
+}
+
+void auto_exposure::init_descriptor_set_layouts()
+{
+    {
+        std::array< VkDescriptorSetLayoutBinding, 2 > bindings = {
+            VkDescriptorSetLayoutBinding{0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+                                         VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+            VkDescriptorSetLayoutBinding{1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                         VK_SHADER_STAGE_COMPUTE_BIT, nullptr}};
+
+        VkDescriptorSetLayoutCreateInfo create_info{
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+            static_cast< uint32_t >( bindings.size() ), bindings.data()};
+
+        const auto res =
+            vkCreateDescriptorSetLayout( m_vulkan_data.logical_device, &create_info,
+                                         nullptr, &m_histogram_set_layout );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor set layout" );
+    }
+
+    {
+        std::array< VkDescriptorSetLayoutBinding, 3 > bindings = {
+            VkDescriptorSetLayoutBinding{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                         VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+            VkDescriptorSetLayoutBinding{1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                         VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+            VkDescriptorSetLayoutBinding{2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
+                                         VK_SHADER_STAGE_COMPUTE_BIT, nullptr}};
+
+        VkDescriptorSetLayoutCreateInfo create_info{
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+            static_cast< uint32_t >( bindings.size() ), bindings.data()};
+
+        const auto res = vkCreateDescriptorSetLayout(
+            m_vulkan_data.logical_device, &create_info, nullptr, &m_average_set_layout );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor set layout" );
+    }
+}
+
+void auto_exposure::destroy_descriptor_set_layouts()
+{
+    vkDestroyDescriptorSetLayout( m_vulkan_data.logical_device, m_histogram_set_layout,
+                                  nullptr );
+    vkDestroyDescriptorSetLayout( m_vulkan_data.logical_device, m_average_set_layout,
+                                  nullptr );
+}
+
+void auto_exposure::create_descriptor_sets( VkImageView hdr_image_view,
+                                            VkImageLayout hdr_layout,
+                                            uint32_t frame_count )
+{
+    {
+        VkSamplerCreateInfo create_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                                        nullptr,
+                                        0,
+                                        VK_FILTER_NEAREST,
+                                        VK_FILTER_NEAREST,
+                                        VK_SAMPLER_MIPMAP_MODE_NEAREST,
+                                        VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                        VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                        VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                        0,
+                                        VK_FALSE,
+                                        0.0f,
+                                        VK_FALSE,
+                                        VK_COMPARE_OP_NEVER,
+                                        0.0,
+                                        0.0,
+                                        VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+                                        VK_FALSE};
+
+        const auto res = vkCreateSampler( m_vulkan_data.logical_device, &create_info,
+                                          nullptr, &m_sampler );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create image sampler!" );
+    }
+
+    std::array< VkDescriptorPoolSize, 3 > pool_size;
+    pool_size[0] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1};
+    pool_size[1] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 + 2 * frame_count};
+    pool_size[2] = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frame_count};
+
+    {
+        VkDescriptorPoolCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            nullptr,
+            0,
+            1 + frame_count,
+            static_cast< uint32_t >( pool_size.size() ),
+            pool_size.data()};
+
+        const auto res = vkCreateDescriptorPool(
+            m_vulkan_data.logical_device, &create_info, nullptr, &m_descriptor_pool );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor pool!" );
+    }
+
+    {
+        VkDescriptorSetAllocateInfo alloc_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, m_descriptor_pool, 1,
+            &m_histogram_set_layout};
+
+        const auto res = vkAllocateDescriptorSets( m_vulkan_data.logical_device,
+                                                   &alloc_info, &m_histogram_set );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't allocate descriptor sets!" );
+    }
+
+    {
+        std::vector< VkDescriptorSetLayout > layouts( frame_count, m_average_set_layout );
+        VkDescriptorSetAllocateInfo alloc_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, m_descriptor_pool,
+            frame_count, layouts.data()};
+
+        m_average_sets.resize( frame_count );
+
+        const auto res = vkAllocateDescriptorSets( m_vulkan_data.logical_device,
+                                                   &alloc_info, m_average_sets.data() );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't allocate descriptor sets!" );
+    }
+
+    VkDescriptorImageInfo hdr_info{m_sampler, hdr_image_view, hdr_layout};
+    VkDescriptorBufferInfo histogram_info{m_histogram.buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo exposure_info{m_exposure.buffer, 0, VK_WHOLE_SIZE};
+
+    {
+        std::array< VkWriteDescriptorSet, 2 > writes = {
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_histogram_set, 0, 0, 1,
+                                 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &hdr_info,
+                                 nullptr, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_histogram_set, 1, 0, 1,
+                                 VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr,
+                                 &histogram_info, nullptr}};
+
+        vkUpdateDescriptorSets( m_vulkan_data.logical_device,
+                                static_cast< uint32_t >( writes.size() ), writes.data(),
+                                0, nullptr );
+    }
+
+    for ( auto i = 0u; i < frame_count; ++i )
+    {
+        VkDescriptorBufferInfo frame_info{m_frame_params[i].buffer, 0,
+                                          sizeof( frame_params )};
+
+        std::array< VkWriteDescriptorSet, 3 > writes = {
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_average_sets[i], 0, 0, 1,
+                                 VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr,
+                                 &histogram_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_average_sets[i], 1, 0, 1,
+                                 VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr,
+                                 &exposure_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_average_sets[i], 2, 0, 1,
+                                 VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, nullptr, &frame_info,
+                                 nullptr}};
+
+        vkUpdateDescriptorSets( m_vulkan_data.logical_device,
+                                static_cast< uint32_t >( writes.size() ), writes.data(),
+                                0, nullptr );
+    }
+}
+
+void auto_exposure::destroy_descriptor_sets()
+{
+    // sets are released together with the pool
+    vkDestroyDescriptorPool( m_vulkan_data.logical_device, m_descriptor_pool, nullptr );
+    vkDestroySampler( m_vulkan_data.logical_device, m_sampler, nullptr );
+    m_average_sets.clear();
+}
+
+void auto_exposure::init_pipelines()
+{
+    const VkPushConstantRange push_range{VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                         sizeof( push_constants )};
+
+    {
+        VkPipelineLayoutCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &m_histogram_set_layout,
+            1,
+            &push_range};
+
+        const auto res =
+            vkCreatePipelineLayout( m_vulkan_data.logical_device, &create_info, nullptr,
+                                    &m_histogram_pipeline_layout );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline layout failed" );
+    }
+
+    {
+        VkPipelineLayoutCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &m_average_set_layout,
+            1,
+            &push_range};
+
+        const auto res =
+            vkCreatePipelineLayout( m_vulkan_data.logical_device, &create_info, nullptr,
+                                    &m_average_pipeline_layout );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline layout failed" );
+    }
+
+    m_histogram_pipeline = m_vulkan_data.create_compute_pipeline(
+        "generated/luminance_histogram.comp.spirv", m_histogram_pipeline_layout );
+    m_average_pipeline = m_vulkan_data.create_compute_pipeline(
+        "generated/luminance_average.comp.spirv", m_average_pipeline_layout );
+}
+
+void auto_exposure::destroy_pipelines()
+{
+    vkDestroyPipeline( m_vulkan_data.logical_device, m_histogram_pipeline, nullptr );
+    vkDestroyPipeline( m_vulkan_data.logical_device, m_average_pipeline, nullptr );
+    vkDestroyPipelineLayout( m_vulkan_data.logical_device, m_histogram_pipeline_layout,
+                             nullptr );
+    vkDestroyPipelineLayout( m_vulkan_data.logical_device, m_average_pipeline_layout,
+                             nullptr );
+}
+
+void auto_exposure::update( float dt_s, uint32_t frame_idx )
+{
+    const frame_params params{dt_s};
+
+    void* data     = nullptr;
+    const auto res = vkMapMemory( m_vulkan_data.logical_device,
+                                  m_frame_params[frame_idx].memory, 0,
+                                  sizeof( frame_params ), 0, &data );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map frame params memory!" );
+    memcpy( data, &params, sizeof( frame_params ) );
+    vkUnmapMemory( m_vulkan_data.logical_device, m_frame_params[frame_idx].memory );
+}
+
+void auto_exposure::record( VkCommandBuffer cmd, uint32_t frame_idx )
+{
+    const push_constants pc{m_settings.min_log_luminance, m_settings.log_luminance_range,
+                            m_settings.adaptation_rate, m_settings.key_value,
+                            m_extent.width * m_extent.height};
+
+    // previous frame might still be clearing the histogram / reading the exposure
+    {
+        std::array< VkBufferMemoryBarrier, 2 > barriers = {
+            VkBufferMemoryBarrier{
+                VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+                VK_ACCESS_SHADER_WRITE_BIT,
+                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, m_histogram.buffer, 0,
+                VK_WHOLE_SIZE},
+            VkBufferMemoryBarrier{
+                VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, m_exposure.buffer, 0,
+                VK_WHOLE_SIZE}};
+
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+            static_cast< uint32_t >( barriers.size() ), barriers.data(), 0, nullptr );
+    }
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_histogram_pipeline );
+    vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                             m_histogram_pipeline_layout, 0, 1, &m_histogram_set, 0,
+                             nullptr );
+    vkCmdPushConstants( cmd, m_histogram_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                        sizeof( push_constants ), &pc );
+    vkCmdDispatch( cmd, ( m_extent.width + 15 ) / 16, ( m_extent.height + 15 ) / 16, 1 );
+
+    {
+        VkBufferMemoryBarrier barrier = {
+            VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            nullptr,
+            VK_ACCESS_SHADER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            m_histogram.buffer,
+            0,
+            VK_WHOLE_SIZE};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1,
+                              &barrier, 0, nullptr );
+    }
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_average_pipeline );
+    vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                             m_average_pipeline_layout, 0, 1, &m_average_sets[frame_idx],
+                             0, nullptr );
+    vkCmdPushConstants( cmd, m_average_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                        sizeof( push_constants ), &pc );
+    vkCmdDispatch( cmd, 1, 1, 1 );
+
+    // exposure is consumed by the tone mapping fragment shader
+    {
+        VkBufferMemoryBarrier barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                                         nullptr,
+                                         VK_ACCESS_SHADER_WRITE_BIT,
+                                         VK_ACCESS_SHADER_READ_BIT,
+                                         VK_QUEUE_FAMILY_IGNORED,
+                                         VK_QUEUE_FAMILY_IGNORED,
+                                         m_exposure.buffer,
+                                         0,
+                                         VK_WHOLE_SIZE};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 1,
+                              &barrier, 0, nullptr );
+    }
+}
+
+auto_exposure::exposure_state auto_exposure::read_exposure_state()
+{
+    buffer_data staging = m_vulkan_data.create_buffer(
+        sizeof( exposure_state ), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+    VkCommandBuffer cmd = m_vulkan_data.begin_one_time_commands();
+    const VkBufferCopy region{0, 0, sizeof( exposure_state )};
+    vkCmdCopyBuffer( cmd, m_exposure.buffer, staging.buffer, 1, &region );
+    m_vulkan_data.submit_one_time_commands( cmd );
+
+    exposure_state ret{};
+
+    void* data     = nullptr;
+    const auto res = vkMapMemory( m_vulkan_data.logical_device, staging.memory, 0,
+                                  sizeof( exposure_state ), 0, &data );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map staging memory!" );
+    memcpy( &ret, data, sizeof( exposure_state ) );
+    vkUnmapMemory( m_vulkan_data.logical_device, staging.memory );
+
+    m_vulkan_data.destroy_buffer( staging );
+
+    return ret;
+}
+
+auto_exposure_reference_result
+compute_auto_exposure_reference( const float* rgba, int32_t width, int32_t height,
+                                 const auto_exposure::settings& s,
+                                 float previous_average_luminance, float dt_s )
+{
+    auto_exposure_reference_result ret{};
+
+    const int64_t pixel_count = static_cast< int64_t >( width ) * height;
+
+    for ( int64_t i = 0; i < pixel_count; ++i )
+    {
+        const float* c = rgba + i * 4;
+        const float luminance =
+            c[0] * 0.2126f + c[1] * 0.7152f + c[2] * 0.0722f;
+
+        uint32_t bin = 0;
+
+        if ( luminance >= 0.0001f )
+        {
+            const float t = std::clamp( ( std::log2( luminance ) - s.min_log_luminance )
+                                            / s.log_luminance_range,
+                                        0.0f, 1.0f );
+            bin = static_cast< uint32_t >( t * 254.0f + 1.0f );
+        }
+
+        ret.histogram[bin] += 1;
+    }
+
+    float weighted = 0.0f;
+    for ( uint32_t i = 0; i < auto_exposure::HISTOGRAM_BINS; ++i )
+    {
+        weighted += static_cast< float >( ret.histogram[i] ) * static_cast< float >( i );
+    }
+
+    const float valid_pixels =
+        std::max( static_cast< float >( pixel_count - ret.histogram[0] ), 1.0f );
+    const float log_average = std::max( weighted / valid_pixels - 1.0f, 0.0f );
+
+    const float average_luminance =
+        std::exp2( log_average / 254.0f * s.log_luminance_range + s.min_log_luminance );
+
+    ret.average_luminance =
+        previous_average_luminance
+        + ( average_luminance - previous_average_luminance )
+              * ( 1.0f - std::exp( -dt_s * s.adaptation_rate ) );
+    ret.exposure = s.key_value / std::max( ret.average_luminance, 0.0001f );
+
+    return ret;
+}
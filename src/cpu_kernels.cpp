@@ -0,0 +1,136 @@
+#include "cpu_kernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t GROUP_SIZE = 256;
+
+    uint32_t identity( primitives::reduce_op op )
+    {
+        return ( op == primitives::reduce_op::min ) ? 0xffffffffu : 0u;
+    }
+
+    uint32_t combine( primitives::reduce_op op, uint32_t a, uint32_t b )
+    {
+        switch ( op )
+        {
+            case primitives::reduce_op::min:
+                return std::min( a, b );
+            case primitives::reduce_op::max:
+                return std::max( a, b );
+            default:
+                return a + b;
+        }
+    }
+
+    // reduce.comp, writes one partial result per workgroup to out
+    void reduce_pass( cpu_compute& compute, primitives::reduce_op op,
+                      const uint32_t* in, uint32_t count, uint32_t partitions,
+                      uint32_t* out )
+    {
+        struct shared
+        {
+            std::array< uint32_t, GROUP_SIZE > values;
+        };
+
+        const auto kernel = [=]( const workgroup& wg, shared& s ) {
+            const uint32_t group  = wg.linear_id();
+            const uint32_t stride = partitions * GROUP_SIZE;
+
+            wg.invocations( [&]( uint32_t idx ) {
+                uint32_t acc = identity( op );
+
+                for ( uint32_t i = group * GROUP_SIZE + idx; i < count; i += stride )
+                {
+                    acc = combine( op, acc, in[i] );
+                }
+
+                s.values[idx] = acc;
+            } );
+
+            for ( uint32_t offset = GROUP_SIZE / 2; offset > 0; offset >>= 1 )
+            {
+                wg.invocations( [&]( uint32_t idx ) {
+                    if ( idx < offset )
+                    {
+                        s.values[idx] =
+                            combine( op, s.values[idx], s.values[idx + offset] );
+                    }
+                } );
+            }
+
+            out[group] = s.values[0];
+        };
+
+        compute.dispatch< shared >( {partitions, 1, 1}, {GROUP_SIZE, 1, 1}, kernel );
+    }
+} // namespace
+
+uint32_t cpu_reduce( cpu_compute& compute, primitives::reduce_op op,
+                     const uint32_t* in, uint32_t count )
+{
+    const uint32_t groups =
+        std::clamp( ( count + GROUP_SIZE * 4 - 1 ) / ( GROUP_SIZE * 4 ), 1u,
+                    primitives::REDUCE_MAX_GROUPS );
+
+    std::vector< uint32_t > partials( groups );
+    reduce_pass( compute, op, in, count, groups, partials.data() );
+
+    uint32_t ret = 0;
+    reduce_pass( compute, op, partials.data(), groups, 1, &ret );
+
+    return ret;
+}
+
+void cpu_radix_histogram( cpu_compute& compute, const uint32_t* keys, uint32_t count,
+                          uint32_t shift, uint32_t* table )
+{
+    constexpr uint32_t ITEMS  = primitives::SORT_PARTITION_SIZE / GROUP_SIZE;
+    const uint32_t partitions = primitives::sort_partitions( count );
+
+    struct shared
+    {
+        std::array< uint32_t, primitives::RADIX_DIGITS > counts;
+    };
+
+    const auto kernel = [=]( const workgroup& wg, shared& s ) {
+        const uint32_t group = wg.linear_id();
+
+        // the shared atomicAdd turns into a plain increment, invocations of a workgroup
+        // never run concurrently
+        wg.invocations( [&]( uint32_t idx ) {
+            for ( uint32_t i = 0; i < ITEMS; ++i )
+            {
+                const uint32_t k =
+                    group * primitives::SORT_PARTITION_SIZE + i * GROUP_SIZE + idx;
+
+                if ( k < count )
+                {
+                    ++s.counts[( keys[k] >> shift ) & 0xff];
+                }
+            }
+        } );
+
+        wg.invocations(
+            [&]( uint32_t idx ) { table[idx * partitions + group] = s.counts[idx]; } );
+    };
+
+    compute.dispatch< shared >( {partitions, 1, 1}, {GROUP_SIZE, 1, 1}, kernel );
+}
+
+void radix_histogram_reference( const uint32_t* keys, uint32_t count, uint32_t shift,
+                                uint32_t* table )
+{
+    const uint32_t partitions = primitives::sort_partitions( count );
+
+    std::fill( table, table + primitives::RADIX_DIGITS * partitions, 0 );
+
+    for ( uint32_t k = 0; k < count; ++k )
+    {
+        const uint32_t digit = ( keys[k] >> shift ) & 0xff;
+        ++table[digit * partitions + k / primitives::SORT_PARTITION_SIZE];
+    }
+}
@@ -0,0 +1,183 @@
+#include "cpu_profiler.hpp"
+
+#if NEO_PROFILER_ENABLED
+
+#include "json.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct zone
+    {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // Single producer, the owning thread, and a single consumer, profiler_collect()
+    // under the registry lock. head and tail only grow, they index modulo CAPACITY.
+    // Only the latest MAX_COLLECTED zones of a thread are kept for the trace, a session
+    // running for hours would grow without bounds otherwise.
+    struct zone_ring
+    {
+        static constexpr uint32_t CAPACITY      = 1u << 15;
+        static constexpr uint32_t MAX_COLLECTED = 1u << 18;
+
+        std::array< zone, CAPACITY > zones;
+        std::atomic< uint32_t > head{0};
+        std::atomic< uint32_t > tail{0};
+
+        uint32_t thread_idx;
+        std::deque< zone > collected; //!< consumer only
+    };
+
+    struct registry
+    {
+        std::mutex mutex;
+        std::vector< std::unique_ptr< zone_ring > > rings;
+        std::atomic< uint64_t > dropped{0};
+        uint64_t discarded = 0; //!< collected, then pushed out by later zones
+
+        // the clock rate is measured from here to the trace
+        const uint64_t start_ticks = profiler_timestamp();
+        const std::chrono::steady_clock::time_point start_time =
+            std::chrono::steady_clock::now();
+    };
+
+    registry& get_registry()
+    {
+        static registry r;
+        return r;
+    }
+
+    // rings outlive their threads, what a finished thread recorded is still collected
+    zone_ring& thread_ring()
+    {
+        thread_local zone_ring* ring = nullptr;
+
+        if ( ring == nullptr )
+        {
+            auto& r = get_registry();
+            std::lock_guard< std::mutex > lock( r.mutex );
+
+            r.rings.push_back( std::make_unique< zone_ring >() );
+            ring             = r.rings.back().get();
+            ring->thread_idx = static_cast< uint32_t >( r.rings.size() );
+        }
+
+        return *ring;
+    }
+} // namespace
+
+void profiler_record( const char* name, uint64_t begin, uint64_t end )
+{
+    zone_ring& ring = thread_ring();
+
+    const uint32_t head = ring.head.load( std::memory_order_relaxed );
+    if ( head - ring.tail.load( std::memory_order_acquire ) == zone_ring::CAPACITY )
+    {
+        get_registry().dropped.fetch_add( 1, std::memory_order_relaxed );
+        return;
+    }
+
+    ring.zones[head % zone_ring::CAPACITY] = {name, begin, end};
+    ring.head.store( head + 1, std::memory_order_release );
+}
+
+void profiler_collect()
+{
+    auto& r = get_registry();
+    std::lock_guard< std::mutex > lock( r.mutex );
+
+    for ( auto& ring : r.rings )
+    {
+        const uint32_t tail = ring->tail.load( std::memory_order_relaxed );
+        const uint32_t head = ring->head.load( std::memory_order_acquire );
+
+        for ( uint32_t i = tail; i != head; ++i )
+        {
+            ring->collected.push_back( ring->zones[i % zone_ring::CAPACITY] );
+        }
+
+        while ( ring->collected.size() > zone_ring::MAX_COLLECTED )
+        {
+            ring->collected.pop_front();
+            ++r.discarded;
+        }
+
+        ring->tail.store( head, std::memory_order_release );
+    }
+}
+
+bool profiler_write_chrome_trace( const std::string& path )
+{
+    profiler_collect();
+
+    auto& r = get_registry();
+    std::lock_guard< std::mutex > lock( r.mutex );
+
+    std::ofstream os( path );
+    if ( !os.is_open() )
+    {
+        NEO_LOG_ERROR( frame, "Couldn't open ", path, " for the trace" );
+        return false;
+    }
+
+    const uint64_t ticks = profiler_timestamp() - r.start_ticks;
+    const double us      = std::chrono::duration< double, std::micro >(
+                          std::chrono::steady_clock::now() - r.start_time )
+                          .count();
+    const double us_per_tick = us / std::max( 1.0, static_cast< double >( ticks ) );
+
+    // the first zone may have begun before the registry existed
+    uint64_t origin = r.start_ticks;
+    for ( const auto& ring : r.rings )
+    {
+        for ( const auto& z : ring->collected )
+        {
+            origin = std::min( origin, z.begin );
+        }
+    }
+
+    os << std::fixed << std::setprecision( 3 );
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    for ( const auto& ring : r.rings )
+    {
+        for ( const auto& z : ring->collected )
+        {
+            os << ( first ? "" : ",\n" ) << "{\"name\":";
+            write_json_string( os, z.name );
+            os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->thread_idx
+               << ",\"ts\":" << ( z.begin - origin ) * us_per_tick
+               << ",\"dur\":" << ( z.end - z.begin ) * us_per_tick << "}";
+            first = false;
+        }
+    }
+
+    os << "\n]}\n";
+
+    NEO_LOG_INFO( frame, "Trace written to ", path, ", ", r.dropped.load(),
+                  " zones dropped, ", r.discarded, " older ones discarded" );
+
+    return true;
+}
+
+uint64_t profiler_dropped_zones()
+{
+    return get_registry().dropped.load();
+}
+
+#endif
@@ -1,43 +1,92 @@
 #include "examples/example4.hpp"
 
+#include "cpu_profiler.hpp"
 #include "debug.hpp"
 #include "logger.hpp"
+#include "mesh_lod.hpp"
+#include "thread_pool.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <fstream>
 #include <array>
 
 void example4::initialize()
 {
+    PROFILE_SCOPE( "example4::initialize" );
+
     m_vulkan_data.get_memory_budget();
 
     m_cmd_draw.resize( m_vulkan_data.swap_chain.images_count );
-    m_framebuffers.resize( m_vulkan_data.swap_chain.images_count );
 
-    init_render_pass();
-    init_framebuffers_and_images();
+    // the pipelines are created for the render passes of the graph
+    init_render_graph();
+
+    m_auto_exposure.initialize( m_graph.image_view( m_hdr_color ),
+                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, {WIDTH, HEIGHT},
+                                m_vulkan_data.swap_chain.images_count );
 
     init_descriptor_set_layout();
     create_uniform_buffers();
     create_descriptor_pool();
 
-    const auto the_model = load_model( "media/cat.obj" );
+    auto the_model = load_model( "media/cat.obj" );
+
+    // the levels go after the full resolution in the same index buffer
+    build_lod_chain( the_model, m_workers );
 
-    create_vertex_buffer( the_model.vertex_data );
-    create_index_buffer( the_model.index_data );
+    m_geometry.initialize( MAX_POOL_VERTICES, MAX_POOL_INDICES );
+    m_cat = m_geometry.add( the_model );
+    NEO_ASSERT_ALWAYS( m_cat != geometry_pool::INVALID_HANDLE,
+                       "The cat doesn't fit into the geometry pool" );
 
     const auto the_image = load_image( "media/cat.png" );
 
     create_texture( the_image );
 
     create_descriptor_sets();
+    create_tone_map_descriptor_set();
+
+    // the overdraw pipeline needs the heatmap's render pass
+    if ( m_diagnostics_enabled )
+    {
+        m_diagnostics.initialize( {WIDTH, HEIGHT},
+                                  m_vulkan_data.swap_chain.images_count );
+    }
+
     init_pipeline();
+    init_tone_map_pipeline();
+
+    float bounding_radius = 0.0f;
+    for ( const auto& v : the_model.vertex_data )
+    {
+        bounding_radius = std::max( bounding_radius, glm::length( v.position ) );
+    }
 
-    m_indices_to_draw = the_model.index_data.size();
+    m_instances.initialize( MAX_INSTANCES, m_vulkan_data.swap_chain.images_count,
+                            bounding_radius );
+    m_instances.add( glm::mat4( 1.0f ) );
 
+    m_hiz.initialize( m_graph.image( m_depth ), m_vulkan_data.depth_format,
+                      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, {WIDTH, HEIGHT} );
+    const auto& cat = m_geometry.range( m_cat );
+    m_culling.initialize( m_instances, m_hiz, cat.lods, cat.vertex_offset,
+                          m_vulkan_data.swap_chain.images_count );
+    m_culling_version = m_geometry.version();
+
+    m_early_recorder.initialize( m_workers.thread_count(),
+                                 m_vulkan_data.swap_chain.images_count );
+    m_late_recorder.initialize( m_workers.thread_count(),
+                                m_vulkan_data.swap_chain.images_count );
+
+    create_fences();
     init_command_buffer();
+    m_profiler.initialize( m_vulkan_data.swap_chain.images_count, MAX_PROFILED_SCOPES );
 
     m_vulkan_data.get_memory_budget();
+
+    m_last_step = std::chrono::steady_clock::now();
 }
 
 void example4::deinitialize()
@@ -45,29 +94,70 @@ void example4::deinitialize()
     vkDeviceWaitIdle( m_vulkan_data.logical_device );
 
     destroy_texture();
-    destroy_vertex_buffer();
-    destroy_index_buffer();
+    m_profiler.deinitialize();
+    if ( m_diagnostics_enabled )
+    {
+        m_diagnostics.deinitialize();
+    }
+    m_geometry.deinitialize();
+    m_late_recorder.deinitialize();
+    m_early_recorder.deinitialize();
+    m_culling.deinitialize();
+    m_hiz.deinitialize();
+    m_instances.deinitialize();
     destroy_command_buffer();
+    destroy_fences();
+    destroy_tone_map_pipeline();
     destroy_pipeline();
+    m_auto_exposure.deinitialize();
     destroy_descriptor_set_layout();
     destroy_uniform_buffers();
     destroy_descriptor_sets();
     destroy_descriptor_pool();
-    destroy_framebuffers_and_images();
-    destroy_render_pass();
+    destroy_render_graph();
 }
 
 void example4::step( float delta_time_ms )
 {
+    PROFILE_SCOPE( "example4::step" );
+
+    using clock_h = std::chrono::steady_clock;
+
+    const auto to_ms = []( clock_h::time_point from, clock_h::time_point to ) {
+        return std::chrono::duration< double, std::milli >( to - from ).count();
+    };
+
+    const auto step_begin = clock_h::now();
+
     uint32_t image_idx = 0u;
 
     vkAcquireNextImageKHR(
         m_vulkan_data.logical_device, m_vulkan_data.swap_chain.swap_chain, UINT64_MAX,
         m_vulkan_data.swap_chain.image_available_semaphore, nullptr, &image_idx );
 
+    // the per image buffers are rewritten below, and the culling stats of the last use
+    // of the image are complete
+    vkWaitForFences( m_vulkan_data.logical_device, 1, &m_fences[image_idx], VK_TRUE,
+                     UINT64_MAX );
+    vkResetFences( m_vulkan_data.logical_device, 1, &m_fences[image_idx] );
+
+    m_frame_arena.begin_frame( image_idx );
+
+    sync_geometry();
+
+    const auto acquired = clock_h::now();
+
+    m_cull_stats = m_culling.read_stats( image_idx );
+
     update_unform_buffer( delta_time_ms, image_idx );
+    m_auto_exposure.update( delta_time_ms, image_idx );
+
+    m_instances.upload( image_idx );
 
-    const VkPipelineStageFlags stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    record_command_buffer( image_idx );
+
+    // the swapchain image is first touched by the tone mapping pass
+    const VkPipelineStageFlags stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     const VkSubmitInfo submit_info        = {
         VK_STRUCTURE_TYPE_SUBMIT_INFO,
         nullptr,
@@ -79,7 +169,9 @@ void example4::step( float delta_time_ms )
         1,
         &m_vulkan_data.swap_chain.rendering_finished_semaphore};
 
-    vkQueueSubmit( m_vulkan_data.graphics_queue, 1, &submit_info, nullptr );
+    const auto submit_begin = clock_h::now();
+    vkQueueSubmit( m_vulkan_data.graphics_queue, 1, &submit_info, m_fences[image_idx] );
+    const auto submitted = clock_h::now();
 
     const VkPresentInfoKHR present_info = {
         VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
@@ -93,94 +185,186 @@ void example4::step( float delta_time_ms )
 
     const VkResult res = vkQueuePresentKHR( m_vulkan_data.graphics_queue, &present_info );
     NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Queue presentation failed" );
+
+    const auto presented = clock_h::now();
+
+    m_frame_stats.record( {to_ms( m_last_step, step_begin ),
+                           to_ms( step_begin, acquired ),
+                           to_ms( acquired, submit_begin ),
+                           to_ms( submit_begin, submitted ),
+                           to_ms( submitted, presented )} );
+    m_last_step = step_begin;
 }
 
-void example4::init_render_pass()
+void example4::sync_geometry()
 {
-    // Color attachment
-    VkAttachmentDescription attachment_color = {
-        0,
-        m_vulkan_data.swap_chain.selected_format.format,
-        VK_SAMPLE_COUNT_1_BIT,
-        VK_ATTACHMENT_LOAD_OP_CLEAR,
-        VK_ATTACHMENT_STORE_OP_STORE,
-        VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-        VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
-
-    VkAttachmentDescription attachment_depth_stencil = {
-        0,
-        m_vulkan_data.depth_format,
-        VK_SAMPLE_COUNT_1_BIT,
-        VK_ATTACHMENT_LOAD_OP_CLEAR,
-        VK_ATTACHMENT_STORE_OP_STORE,
-        VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-        VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+    if ( m_culling_version == m_geometry.version() )
+    {
+        return;
+    }
 
-    std::array< VkAttachmentDescription, 2 > attachments = {attachment_color,
-                                                            attachment_depth_stencil};
+    // compaction moves every mesh, no frame in flight may still draw from the pool
+    if ( m_geometry.fragments() > 1 )
+    {
+        vkDeviceWaitIdle( m_vulkan_data.logical_device );
+        m_geometry.compact();
+    }
 
-    VkAttachmentReference color_reference = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    // the draw commands written by record_early() follow the ranges, the secondaries
+    // are recorded again for the new version in record_command_buffer()
+    const auto& cat = m_geometry.range( m_cat );
+    m_culling.set_mesh( cat.lods, cat.vertex_offset );
 
-    VkAttachmentReference depth_stencil_reference = {
-        1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+    m_culling_version = m_geometry.version();
+}
 
-    VkSubpassDescription subpass_description = {
-        0,       VK_PIPELINE_BIND_POINT_GRAPHICS, 0, nullptr, 1, &color_reference,
-        nullptr, &depth_stencil_reference,        0, nullptr};
+void example4::init_render_graph()
+{
+    const VkExtent2D extent = {WIDTH, HEIGHT};
 
-    VkSubpassDependency subpass_final_to_initial = {
-        VK_SUBPASS_EXTERNAL,
-        0,
-        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_ACCESS_MEMORY_READ_BIT,
-        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-        VK_DEPENDENCY_BY_REGION_BIT};
-
-    VkSubpassDependency subpass_initial_to_final = {
-        VK_SUBPASS_EXTERNAL,
-        0,
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-        VK_ACCESS_MEMORY_READ_BIT,
-        VK_DEPENDENCY_BY_REGION_BIT};
-
-    std::array< VkSubpassDependency, 2 > dependencies = {subpass_final_to_initial,
-                                                         subpass_initial_to_final};
-
-    // Create the actual renderpass
-    VkRenderPassCreateInfo renderpass_info = {
-        VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-        nullptr,
-        0,
-        static_cast< uint32_t >( attachments.size() ),
-        attachments.data(),
-        1,
-        &subpass_description,
-        static_cast< uint32_t >( dependencies.size() ),
-        dependencies.data()};
+    std::vector< image_data > swapchain_images( m_vulkan_data.swap_chain.images_count );
+    const auto& swap_chain = m_vulkan_data.swap_chain;
+    for ( uint32_t i = 0; i < swapchain_images.size(); ++i )
+    {
+        swapchain_images[i].image      = swap_chain.swap_chain_images[i];
+        swapchain_images[i].image_view = swap_chain.swap_chain_image_views[i];
+        swapchain_images[i].format     = swap_chain.selected_format.format;
+        swapchain_images[i].extent     = extent;
+    }
 
-    const auto res = vkCreateRenderPass( m_vulkan_data.logical_device, &renderpass_info,
-                                         nullptr, &m_render_pass );
+    m_hdr_color = m_graph.create_image( "hdr color", extent, HDR_FORMAT );
+    m_depth     = m_graph.create_image( "depth", extent, m_vulkan_data.depth_format,
+                                        VK_IMAGE_ASPECT_DEPTH_BIT
+                                            | VK_IMAGE_ASPECT_STENCIL_BIT );
+
+    // only the tone mapping pass writes there, it presents afterwards
+    const auto swapchain =
+        m_graph.import_images( "swapchain", swapchain_images, VK_IMAGE_LAYOUT_UNDEFINED,
+                               VK_IMAGE_LAYOUT_PRESENT_SRC_KHR );
+
+    using pass_type = render_graph::pass_type;
+
+    // instances visible in the previous frame's depth, the statistics cover both scene
+    // passes
+    const auto early_culling = m_graph.add_pass(
+        "early culling", pass_type::compute, [this]( VkCommandBuffer cmd ) {
+            m_culling.record_early( cmd, m_frame_idx );
+            if ( m_diagnostics_enabled )
+            {
+                m_diagnostics.begin_statistics( cmd );
+            }
+        } );
+    m_graph.set_side_effects( early_culling );
+
+    VkClearValue color_clear{};
+    color_clear.color = {{0.0f, 0.1f, 0.0f, 1.0f}};
+
+    VkClearValue depth_clear{};
+    depth_clear.depthStencil = {1.0f, 0};
+
+    m_early_scene_pass = m_graph.add_pass(
+        "early scene", pass_type::graphics,
+        [this]( VkCommandBuffer cmd ) { m_early_recorder.execute( cmd, m_frame_idx ); } );
+    m_graph.write( m_early_scene_pass, m_hdr_color, graph_access::color_attachment );
+    m_graph.write( m_early_scene_pass, m_depth, graph_access::depth_attachment );
+    m_graph.clear( m_early_scene_pass, m_hdr_color, color_clear );
+    m_graph.clear( m_early_scene_pass, m_depth, depth_clear );
+    m_graph.set_secondary_buffers( m_early_scene_pass );
+
+    // instances hidden there but visible in this frame's depth
+    const auto hiz = m_graph.add_pass( "hi-z", pass_type::compute,
+                                       [this]( VkCommandBuffer cmd ) {
+                                           m_hiz.record( cmd );
+                                       } );
+    m_graph.read( hiz, m_depth, graph_access::sampled );
+    m_graph.set_side_effects( hiz );
+
+    const auto late_culling = m_graph.add_pass(
+        "late culling", pass_type::compute,
+        [this]( VkCommandBuffer cmd ) { m_culling.record_late( cmd, m_frame_idx ); } );
+    m_graph.set_side_effects( late_culling );
+
+    // the depth isn't stored after this one
+    m_late_scene_pass = m_graph.add_pass(
+        "late scene", pass_type::graphics,
+        [this]( VkCommandBuffer cmd ) { m_late_recorder.execute( cmd, m_frame_idx ); } );
+    m_graph.write( m_late_scene_pass, m_hdr_color, graph_access::color_attachment );
+    m_graph.write( m_late_scene_pass, m_depth, graph_access::depth_attachment );
+    m_graph.set_secondary_buffers( m_late_scene_pass );
+
+    // the heatmap has a render pass of its own, to the graph it's outside work
+    if ( m_diagnostics_enabled )
+    {
+        const auto overdraw = m_graph.add_pass(
+            "overdraw", pass_type::compute, [this]( VkCommandBuffer cmd ) {
+                m_diagnostics.end_statistics( cmd );
+                if ( m_overdraw_pipeline != nullptr )
+                {
+                    record_overdraw( m_frame_idx );
+                }
+            } );
+        m_graph.set_side_effects( overdraw );
+    }
 
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Command buffer allocation failed" );
+    const auto exposure = m_graph.add_pass(
+        "auto exposure", pass_type::compute,
+        [this]( VkCommandBuffer cmd ) { m_auto_exposure.record( cmd, m_frame_idx ); } );
+    m_graph.read( exposure, m_hdr_color, graph_access::sampled );
+    m_graph.set_side_effects( exposure );
+
+    m_tone_map_pass = m_graph.add_pass(
+        "tone map", pass_type::graphics, [this]( VkCommandBuffer cmd ) {
+            vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                               m_tone_map_pipeline );
+            vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                     m_tone_map_pipeline_layout, 0, 1, &m_tone_map_set,
+                                     0, nullptr );
+            vkCmdDraw( cmd, 3, 1, 0, 0 );
+        } );
+    m_graph.read( m_tone_map_pass, m_hdr_color, graph_access::sampled );
+    m_graph.write( m_tone_map_pass, swapchain, graph_access::color_attachment );
+
+    m_graph.compile();
+
+    VkSamplerCreateInfo create_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                                    nullptr,
+                                    0,
+                                    VK_FILTER_NEAREST,
+                                    VK_FILTER_NEAREST,
+                                    VK_SAMPLER_MIPMAP_MODE_NEAREST,
+                                    VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                    VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                    VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                    0,
+                                    VK_FALSE,
+                                    0.0f,
+                                    VK_FALSE,
+                                    VK_COMPARE_OP_NEVER,
+                                    0.0,
+                                    0.0,
+                                    VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+                                    VK_FALSE};
+
+    const auto res = vkCreateSampler( m_vulkan_data.logical_device, &create_info,
+                                      nullptr, &m_hdr_sampler );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create image sampler!" );
 }
 
 void example4::destroy_command_buffer()
 {
-    vkFreeCommandBuffers( m_vulkan_data.logical_device,
-                          m_vulkan_data.pool_command_buffers, m_cmd_draw.size(),
-                          m_cmd_draw.data() );
+    // destroying a pool frees its buffers
+    for ( auto pool : m_cmd_pools )
+    {
+        vkDestroyCommandPool( m_vulkan_data.logical_device, pool, nullptr );
+    }
+
+    m_cmd_pools.clear();
     m_cmd_draw.clear();
 }
 
 void example4::destroy_pipeline()
 {
+    vkDestroyPipeline( m_vulkan_data.logical_device, m_overdraw_pipeline, nullptr );
     vkDestroyPipeline( m_vulkan_data.logical_device, m_pipeline, nullptr );
     vkDestroyPipelineLayout( m_vulkan_data.logical_device, m_pipeline_layout, nullptr );
 }
@@ -205,298 +389,219 @@ void example4::init_descriptor_set_layout()
         m_vulkan_data.logical_device, &create_info, nullptr, &m_descriptor_set_layout );
 
     NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor set layout" );
+
+    // tone mapping: hdr color + exposure written by the auto exposure pass
+    std::array< VkDescriptorSetLayoutBinding, 2 > tone_map_bindings = {
+        VkDescriptorSetLayoutBinding{0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+                                     VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     VK_SHADER_STAGE_FRAGMENT_BIT, nullptr}};
+
+    VkDescriptorSetLayoutCreateInfo tone_map_create_info{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+        static_cast< uint32_t >( tone_map_bindings.size() ), tone_map_bindings.data()};
+
+    const auto tone_map_res =
+        vkCreateDescriptorSetLayout( m_vulkan_data.logical_device, &tone_map_create_info,
+                                     nullptr, &m_tone_map_set_layout );
+
+    NEO_ASSERT_ALWAYS( tone_map_res == VK_SUCCESS,
+                       "Couldn't create descriptor set layout" );
 }
 
 void example4::destroy_descriptor_set_layout()
 {
     vkDestroyDescriptorSetLayout( m_vulkan_data.logical_device, m_descriptor_set_layout,
                                   nullptr );
+    vkDestroyDescriptorSetLayout( m_vulkan_data.logical_device, m_tone_map_set_layout,
+                                  nullptr );
 }
 
-void example4::destroy_framebuffers_and_images()
-{
-    for ( auto& fb : m_framebuffers )
-    {
-        vkDestroyFramebuffer( m_vulkan_data.logical_device, fb, nullptr );
-    }
-
-    m_framebuffers.clear();
-
-    vkDestroyImageView( m_vulkan_data.logical_device, m_depth_stencil_image_view,
-                        nullptr );
-
-    vkDestroyImage( m_vulkan_data.logical_device, m_depth_stencil_image, nullptr );
-    vkFreeMemory( m_vulkan_data.logical_device, m_depth_stencil_memory, nullptr );
-}
-
-void example4::destroy_render_pass()
+void example4::destroy_render_graph()
 {
-    vkDestroyRenderPass( m_vulkan_data.logical_device, m_render_pass, nullptr );
+    vkDestroySampler( m_vulkan_data.logical_device, m_hdr_sampler, nullptr );
+    m_graph.deinitialize();
 }
 
-void example4::record_command_buffers()
+void example4::create_fences()
 {
-    const VkCommandBufferBeginInfo begin_info = {
-        VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr,
-        VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT, nullptr};
+    // signaled, the first wait on every image returns right away
+    const VkFenceCreateInfo create_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr,
+                                           VK_FENCE_CREATE_SIGNALED_BIT};
 
-    const VkClearColorValue color                = {{0.0f, 0.1f, 0.0f, 1.0f}};
-    const VkClearDepthStencilValue depth_stencil = {1.0f, 0};
-    VkClearValue clear_values[2]                 = {};
-    clear_values[0].color                        = color;
-    clear_values[1].depthStencil                 = depth_stencil;
+    m_fences.resize( m_vulkan_data.swap_chain.images_count );
 
-    VkRenderPassBeginInfo render_pass_begin_info = {
-        VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-        nullptr,
-        m_render_pass,
-        {},
-        {{0, 0}, {WIDTH, HEIGHT}},
-        2,
-        clear_values};
-
-    const auto cmd_count = m_cmd_draw.size();
-    for ( uint32_t idx = 0; idx < cmd_count; ++idx )
+    for ( auto& fence : m_fences )
     {
-        render_pass_begin_info.framebuffer = m_framebuffers[idx];
-
-        vkBeginCommandBuffer( m_cmd_draw[idx], &begin_info );
-
-        vkCmdBeginRenderPass( m_cmd_draw[idx], &render_pass_begin_info,
-                              VK_SUBPASS_CONTENTS_INLINE );
-
-        vkCmdBindPipeline( m_cmd_draw[idx], VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline );
-
-        // Bind triangle vertex buffer (contains position and colors)
-        VkDeviceSize offsets = 0;
-        vkCmdBindVertexBuffers( m_cmd_draw[idx], 0, 1, &m_vertices.buffer, &offsets );
-        vkCmdBindIndexBuffer( m_cmd_draw[idx], m_indices.buffer, 0,
-                              VK_INDEX_TYPE_UINT32 );
-
-        vkCmdBindDescriptorSets( m_cmd_draw[idx], VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                 m_pipeline_layout, 0, 1, &m_descriptor_sets[idx], 0,
-                                 nullptr );
-
-        vkCmdDrawIndexed( m_cmd_draw[idx], m_indices_to_draw, 1, 0, 0, 0 );
-
-        vkCmdEndRenderPass( m_cmd_draw[idx] );
-
-        vkEndCommandBuffer( m_cmd_draw[idx] );
+        const auto res =
+            vkCreateFence( m_vulkan_data.logical_device, &create_info, nullptr, &fence );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Fence creation failed" );
     }
+
+    // the temporaries of a frame are reused once its fence signaled
+    m_frame_arena.initialize( m_vulkan_data.swap_chain.images_count );
 }
 
-void example4::init_framebuffers_and_images()
+void example4::destroy_fences()
 {
-    const auto swapchain_image_count = m_vulkan_data.swap_chain.images_count;
-
-    // Depth stencil image and depth stencil image view
-    VkImageCreateInfo depth_stencil_image_create_info = {
-        VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-        nullptr,
-        0,
-        VK_IMAGE_TYPE_2D,
-        m_vulkan_data.depth_format,
-        {WIDTH, HEIGHT, 1},
-        1,
-        1,
-        VK_SAMPLE_COUNT_1_BIT,
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-        VK_SHARING_MODE_EXCLUSIVE,
-        0,
-        nullptr,
-        VK_IMAGE_LAYOUT_UNDEFINED};
-
-    auto res =
-        vkCreateImage( m_vulkan_data.logical_device, &depth_stencil_image_create_info,
-                       nullptr, &m_depth_stencil_image );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Failed to create stencil image" );
+    for ( auto fence : m_fences )
+    {
+        vkDestroyFence( m_vulkan_data.logical_device, fence, nullptr );
+    }
 
-    VkMemoryRequirements memory_requirements;
-    vkGetImageMemoryRequirements( m_vulkan_data.logical_device, m_depth_stencil_image,
-                                  &memory_requirements );
+    m_fences.clear();
+}
 
-    const auto memory_type_index = m_vulkan_data.get_memory_type_idx(
-        memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+void example4::set_instance_grid( uint32_t count )
+{
+    NEO_ASSERT_ALWAYS( count <= MAX_INSTANCES, "Too many instances requested" );
 
-    VkMemoryAllocateInfo mem_alloc = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr,
-                                      memory_requirements.size, memory_type_index};
+    m_instances.clear();
 
-    res = vkAllocateMemory( m_vulkan_data.logical_device, &mem_alloc, nullptr,
-                            &m_depth_stencil_memory );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res,
-                       "Allocate memory for depth stencil image failed" );
+    if ( count == 0 )
+    {
+        return;
+    }
 
-    res = vkBindImageMemory( m_vulkan_data.logical_device, m_depth_stencil_image,
-                             m_depth_stencil_memory, 0 );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Bind memory for depth stencil image failed" );
+    // the cat is ~55 units tall and the camera sees ~84 units vertically at z = 0
+    const auto side   = static_cast< uint32_t >( std::ceil( std::sqrt( 1.0f * count ) ) );
+    const float cell  = 80.0f / side;
+    const float scale = std::min( 1.0f, cell / 60.0f );
+    const float start = -0.5f * cell * ( side - 1 );
 
-    VkImageViewCreateInfo depth_stencil_image_view_create_info = {
-        VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-        nullptr,
-        0,
-        m_depth_stencil_image,
-        VK_IMAGE_VIEW_TYPE_2D,
-        m_vulkan_data.depth_format,
-        {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
-         VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY},
-        {VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, 0, 1, 0, 1}};
-
-    res = vkCreateImageView( m_vulkan_data.logical_device,
-                             &depth_stencil_image_view_create_info, nullptr,
-                             &m_depth_stencil_image_view );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res,
-                       "Creating image view for depth stencil image failed" );
-
-    // Framebuffers for swapchain color images
-    for ( size_t idx = 0; idx < swapchain_image_count; ++idx )
+    for ( uint32_t i = 0; i < count; ++i )
     {
-        std::array< VkImageView, 2 > attachments = {
-            m_vulkan_data.swap_chain.swap_chain_image_views[idx],
-            m_depth_stencil_image_view};
+        const glm::vec3 position( start + cell * ( i % side ),
+                                  start + cell * ( i / side ), 0.0f );
 
-        VkFramebufferCreateInfo framebuffer_create_info = {
-            VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-            nullptr,
-            0,
-            m_render_pass,
-            static_cast< uint32_t >( attachments.size() ),
-            attachments.data(),
-            WIDTH,
-            HEIGHT,
-            1};
-
-        // Create the framebuffer
-        const auto res =
-            vkCreateFramebuffer( m_vulkan_data.logical_device, &framebuffer_create_info,
-                                 nullptr, &m_framebuffers[idx] );
-        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Framebuffer creation failed" );
+        m_instances.add( glm::translate( glm::mat4( 1.0f ), position )
+                         * glm::scale( glm::mat4( 1.0f ), glm::vec3( scale ) ) );
     }
 }
 
-void example4::init_command_buffer()
+void example4::record_command_buffer( uint32_t idx )
 {
-    const VkCommandBufferAllocateInfo cmd_alloc_info = {
-        VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, nullptr,
-        m_vulkan_data.pool_command_buffers, VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        m_vulkan_data.swap_chain.images_count};
-
-    const auto res = vkAllocateCommandBuffers( m_vulkan_data.logical_device,
-                                               &cmd_alloc_info, m_cmd_draw.data() );
+    PROFILE_SCOPE( "example4::record_command_buffer" );
 
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Command buffer allocation failed" );
+    // the memory of the previous recording goes back to the pool at once
+    vkResetCommandPool( m_vulkan_data.logical_device, m_cmd_pools[idx], 0 );
 
-    record_command_buffers();
-}
+    const VkCommandBufferBeginInfo begin_info = {
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr,
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr};
 
-void example4::create_vertex_buffer( const std::vector< vtx_t::vertex >& vertices )
-{
-    uint32_t vertex_buffer_size =
-        static_cast< uint32_t >( vertices.size() ) * sizeof( vtx_t::vertex );
+    // binding 0 is the geometry pool, the culling adds the transforms of the visible
+    // instances as binding 1 and the indirect draw of each LOD. There's one pipeline and
+    // one set, the LOD is the material. The scene passes are recorded in parallel into
+    // secondary buffers, which have to be complete before the primary executes them.
+    auto record_scene = [this, idx]( parallel_recorder& recorder, bool early,
+                                     uint32_t pass ) {
+        m_scene_queue.clear();
 
-    VkMemoryRequirements mem_requirements;
+        for ( uint32_t l = 0; l < m_culling.lod_count(); ++l )
+        {
+            draw_item item = early ? m_culling.early_draw( l ) : m_culling.late_draw( l );
+            item.pipeline  = m_pipeline;
+            item.layout    = m_pipeline_layout;
+            item.set       = m_descriptor_sets[idx];
+            item.vertices  = m_geometry.vertex_buffer();
+            item.indices   = m_geometry.index_buffer();
+
+            m_scene_queue.push( make_sort_key( 0, 0, l, 0.0f ), item );
+        }
 
-    // Vertex buffer
-    VkBufferCreateInfo vertex_buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                                             nullptr,
-                                             0,
-                                             vertex_buffer_size,
-                                             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                                             VK_SHARING_MODE_EXCLUSIVE,
-                                             0,
-                                             nullptr};
+        m_scene_queue.sort();
+        m_render_stats +=
+            recorder.record( m_scene_queue, idx, m_graph.render_pass( pass ), 0,
+                             m_graph.framebuffer( pass ), 0, m_frame_arena );
+    };
 
-    // Copy vertex data to a buffer visible to the host
-    auto res = vkCreateBuffer( m_vulkan_data.logical_device, &vertex_buffer_info, nullptr,
-                               &m_vertices.buffer );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creating buffer memory failed" );
+    // The draws only change with the geometry, what the culling finds visible reaches
+    // them through the indirect buffers. The secondary buffers are kept until then.
+    if ( m_scene_versions[idx] != m_geometry.version() )
+    {
+        m_render_stats = {};
 
-    vkGetBufferMemoryRequirements( m_vulkan_data.logical_device, m_vertices.buffer,
-                                   &mem_requirements );
+        record_scene( m_early_recorder, true, m_early_scene_pass );
+        record_scene( m_late_recorder, false, m_late_scene_pass );
 
-    const auto memory_type_idx = m_vulkan_data.get_memory_type_idx(
-        mem_requirements.memoryTypeBits,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+        m_scene_versions[idx] = m_geometry.version();
+        ++m_scene_recordings;
+    }
 
-    VkMemoryAllocateInfo mem_alloc = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr,
-                                      mem_requirements.size, memory_type_idx};
+    vkBeginCommandBuffer( m_cmd_draw[idx], &begin_info );
 
-    res = vkAllocateMemory( m_vulkan_data.logical_device, &mem_alloc, nullptr,
-                            &m_vertices.memory );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Allocating buffer memory failed" );
+    // the timings of the image's previous frame are read here
+    m_profiler.begin_frame( m_cmd_draw[idx], idx );
+    if ( m_diagnostics_enabled )
+    {
+        m_diagnostics.begin_frame( m_cmd_draw[idx], idx );
+    }
 
-    void* data;
-    res = vkMapMemory( m_vulkan_data.logical_device, m_vertices.memory, 0,
-                       mem_alloc.allocationSize, 0, &data );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Mapping buffer memory failed" );
+    const uint32_t frame_scope = m_profiler.begin( m_cmd_draw[idx], "frame" );
 
-    memcpy( data, vertices.data(), vertex_buffer_size );
-    vkUnmapMemory( m_vulkan_data.logical_device, m_vertices.memory );
+    // every pass is a scope of its own
+    m_frame_idx = idx;
+    m_graph.execute( m_cmd_draw[idx], idx, &m_profiler );
 
-    res = vkBindBufferMemory( m_vulkan_data.logical_device, m_vertices.buffer,
-                              m_vertices.memory, 0 );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Binding buffer memory failed" );
-}
+    m_profiler.end( m_cmd_draw[idx], frame_scope );
 
-void example4::destroy_vertex_buffer()
-{
-    vkFreeMemory( m_vulkan_data.logical_device, m_vertices.memory, nullptr );
-    vkDestroyBuffer( m_vulkan_data.logical_device, m_vertices.buffer, nullptr );
+    vkEndCommandBuffer( m_cmd_draw[idx] );
 }
 
-void example4::create_index_buffer( const std::vector< vtx_t::index >& indices )
+void example4::record_overdraw( uint32_t idx )
 {
-    uint32_t index_buffer_size =
-        static_cast< uint32_t >( indices.size() ) * sizeof( vtx_t::index );
-
-    VkMemoryRequirements mem_requirements;
+    // whatever either phase found visible, drawn inline by the primary buffer
+    m_scene_queue.clear();
 
-    // Vertex buffer
-    VkBufferCreateInfo vertex_buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                                             nullptr,
-                                             0,
-                                             index_buffer_size,
-                                             VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                                             VK_SHARING_MODE_EXCLUSIVE,
-                                             0,
-                                             nullptr};
+    for ( uint32_t l = 0; l < m_culling.lod_count(); ++l )
+    {
+        for ( draw_item item : {m_culling.early_draw( l ), m_culling.late_draw( l )} )
+        {
+            item.pipeline = m_overdraw_pipeline;
+            item.layout   = m_pipeline_layout;
+            item.set      = m_descriptor_sets[idx];
+            item.vertices = m_geometry.vertex_buffer();
+            item.indices  = m_geometry.index_buffer();
 
-    // Copy vertex data to a buffer visible to the host
-    auto res = vkCreateBuffer( m_vulkan_data.logical_device, &vertex_buffer_info, nullptr,
-                               &m_indices.buffer );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creating buffer memory failed" );
+            m_scene_queue.push( make_sort_key( 0, 0, l, 0.0f ), item );
+        }
+    }
 
-    vkGetBufferMemoryRequirements( m_vulkan_data.logical_device, m_indices.buffer,
-                                   &mem_requirements );
+    m_scene_queue.sort();
 
-    const auto memory_type_idx = m_vulkan_data.get_memory_type_idx(
-        mem_requirements.memoryTypeBits,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+    m_diagnostics.begin_overdraw( m_cmd_draw[idx] );
+    m_scene_queue.record( m_cmd_draw[idx] );
+    m_diagnostics.end_overdraw( m_cmd_draw[idx] );
+}
 
-    VkMemoryAllocateInfo mem_alloc = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr,
-                                      mem_requirements.size, memory_type_idx};
+void example4::init_command_buffer()
+{
+    // a transient pool per image, reset before the image's buffer is recorded again
+    const VkCommandPoolCreateInfo pool_create_info = {
+        VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, nullptr,
+        VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        static_cast< uint32_t >( m_vulkan_data.selected_gfx_queue_idx )};
 
-    res = vkAllocateMemory( m_vulkan_data.logical_device, &mem_alloc, nullptr,
-                            &m_indices.memory );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Allocating buffer memory failed" );
+    m_cmd_pools.resize( m_cmd_draw.size() );
 
-    void* data;
-    res = vkMapMemory( m_vulkan_data.logical_device, m_indices.memory, 0,
-                       mem_alloc.allocationSize, 0, &data );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Mapping buffer memory failed" );
+    for ( size_t i = 0; i < m_cmd_draw.size(); ++i )
+    {
+        auto res = vkCreateCommandPool( m_vulkan_data.logical_device, &pool_create_info,
+                                        nullptr, &m_cmd_pools[i] );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Command pool creation failed" );
 
-    memcpy( data, indices.data(), index_buffer_size );
-    vkUnmapMemory( m_vulkan_data.logical_device, m_indices.memory );
+        const VkCommandBufferAllocateInfo cmd_alloc_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, nullptr, m_cmd_pools[i],
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1};
 
-    res = vkBindBufferMemory( m_vulkan_data.logical_device, m_indices.buffer,
-                              m_indices.memory, 0 );
-    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Binding buffer memory failed" );
-}
+        res = vkAllocateCommandBuffers( m_vulkan_data.logical_device, &cmd_alloc_info,
+                                        &m_cmd_draw[i] );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Command buffer allocation failed" );
+    }
 
-void example4::destroy_index_buffer()
-{
-    vkFreeMemory( m_vulkan_data.logical_device, m_indices.memory, nullptr );
-    vkDestroyBuffer( m_vulkan_data.logical_device, m_indices.buffer, nullptr );
+    // nothing is recorded yet, every image records its scene passes first
+    m_scene_versions.assign( m_cmd_draw.size(), ~m_geometry.version() );
 }
 
 void example4::init_pipeline()
@@ -595,23 +700,34 @@ void example4::init_pipeline()
         VK_FALSE,
         VK_FALSE};
 
-    VkVertexInputBindingDescription vertex_input_binding = {0, sizeof( vtx_t::vertex ),
-                                                            VK_VERTEX_INPUT_RATE_VERTEX};
+    std::array< VkVertexInputBindingDescription, 2 > vertex_input_bindings = {
+        VkVertexInputBindingDescription{0, sizeof( vtx_t::vertex ),
+                                        VK_VERTEX_INPUT_RATE_VERTEX},
+        VkVertexInputBindingDescription{1, sizeof( glm::mat4 ),
+                                        VK_VERTEX_INPUT_RATE_INSTANCE}};
 
-    std::array< VkVertexInputAttributeDescription, 3 > attributes = {
+    // the instance transform takes one location per column
+    std::array< VkVertexInputAttributeDescription, 7 > attributes = {
         VkVertexInputAttributeDescription{0, 0, VK_FORMAT_R32G32B32_SFLOAT,
                                           offsetof( vtx_t::vertex, position )},
         VkVertexInputAttributeDescription{1, 0, VK_FORMAT_R32G32B32_SFLOAT,
                                           offsetof( vtx_t::vertex, normal )},
         VkVertexInputAttributeDescription{2, 0, VK_FORMAT_R32G32_SFLOAT,
-                                          offsetof( vtx_t::vertex, texcoord )}};
+                                          offsetof( vtx_t::vertex, texcoord )},
+        VkVertexInputAttributeDescription{3, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 0},
+        VkVertexInputAttributeDescription{4, 1, VK_FORMAT_R32G32B32A32_SFLOAT,
+                                          sizeof( glm::vec4 )},
+        VkVertexInputAttributeDescription{5, 1, VK_FORMAT_R32G32B32A32_SFLOAT,
+                                          2 * sizeof( glm::vec4 )},
+        VkVertexInputAttributeDescription{6, 1, VK_FORMAT_R32G32B32A32_SFLOAT,
+                                          3 * sizeof( glm::vec4 )}};
 
     VkPipelineVertexInputStateCreateInfo vertex_input_state = {
         VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
         nullptr,
         0,
-        1,
-        &vertex_input_binding,
+        vertex_input_bindings.size(),
+        vertex_input_bindings.data(),
         attributes.size(),
         attributes.data()};
 
@@ -666,7 +782,7 @@ void example4::init_pipeline()
         &color_blend_state,
         nullptr,
         m_pipeline_layout,
-        m_render_pass,
+        m_graph.render_pass( m_early_scene_pass ),
         0,
         m_pipeline,
         0};
@@ -675,12 +791,190 @@ void example4::init_pipeline()
                                      &pipeline_create_info, nullptr, &m_pipeline );
     NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline failed. Go home." );
 
+    // The same geometry counted into the heatmap. Without a depth test every fragment
+    // the rasterizer produces adds one.
+    if ( m_diagnostics_enabled && m_diagnostics.overdraw_supported() )
+    {
+        VkPipelineShaderStageCreateInfo shader_stage_overdraw = shader_stage_fragment;
+        shader_stage_overdraw.module =
+            m_vulkan_data.load_shader( "generated/overdraw.frag.spirv" );
+
+        const std::array< VkPipelineShaderStageCreateInfo, 2 > overdraw_stages{
+            shader_stage_vertex, shader_stage_overdraw};
+
+        blend_attachment_state = render_diagnostics::overdraw_blend_attachment();
+
+        pipeline_create_info.pStages            = overdraw_stages.data();
+        pipeline_create_info.pDepthStencilState = nullptr;
+        pipeline_create_info.renderPass         = m_diagnostics.overdraw_render_pass();
+
+        res = vkCreateGraphicsPipelines( m_vulkan_data.logical_device, nullptr, 1,
+                                         &pipeline_create_info, nullptr,
+                                         &m_overdraw_pipeline );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of overdraw pipeline failed" );
+
+        vkDestroyShaderModule( m_vulkan_data.logical_device, shader_stage_overdraw.module,
+                               nullptr );
+    }
+
+    vkDestroyShaderModule( m_vulkan_data.logical_device, shader_stages[0].module,
+                           nullptr );
+    vkDestroyShaderModule( m_vulkan_data.logical_device, shader_stages[1].module,
+                           nullptr );
+}
+
+void example4::init_tone_map_pipeline()
+{
+    VkPipelineVertexInputStateCreateInfo vertex_input_state = {
+        VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO, nullptr, 0, 0, nullptr,
+        0, nullptr};
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly_state = {
+        VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO, nullptr, 0,
+        VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_FALSE};
+
+    VkPipelineRasterizationStateCreateInfo rasterization_state = {
+        VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        nullptr,
+        0,
+        VK_FALSE,
+        VK_FALSE,
+        VK_POLYGON_MODE_FILL,
+        VK_CULL_MODE_NONE,
+        VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        VK_FALSE,
+        0.0f,
+        0.0f,
+        0.0f,
+        1.0f};
+
+    VkPipelineColorBlendAttachmentState blend_attachment_state = {
+        VK_FALSE,
+        VK_BLEND_FACTOR_ZERO,
+        VK_BLEND_FACTOR_ZERO,
+        VK_BLEND_OP_ADD,
+        VK_BLEND_FACTOR_ZERO,
+        VK_BLEND_FACTOR_ZERO,
+        VK_BLEND_OP_ADD,
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT
+            | VK_COLOR_COMPONENT_A_BIT};
+
+    VkPipelineColorBlendStateCreateInfo color_blend_state = {
+        VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        nullptr,
+        0,
+        VK_FALSE,
+        VK_LOGIC_OP_CLEAR,
+        1,
+        &blend_attachment_state,
+        {0.0f, 0.0f, 0.0f, 0.0f}};
+
+    VkViewport viewport = {};
+    viewport.height     = ( float )HEIGHT;
+    viewport.width      = ( float )WIDTH;
+    viewport.minDepth   = ( float )0.0f;
+    viewport.maxDepth   = ( float )1.0f;
+
+    VkRect2D scissor      = {};
+    scissor.extent.width  = WIDTH;
+    scissor.extent.height = HEIGHT;
+    scissor.offset.x      = 0;
+    scissor.offset.y      = 0;
+
+    VkPipelineViewportStateCreateInfo viewport_state = {
+        VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        nullptr,
+        0,
+        1,
+        &viewport,
+        1,
+        &scissor};
+
+    VkPipelineMultisampleStateCreateInfo multisample_state = {
+        VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        nullptr,
+        0,
+        VK_SAMPLE_COUNT_1_BIT,
+        VK_FALSE,
+        0.0f,
+        nullptr,
+        VK_FALSE,
+        VK_FALSE};
+
+    VkPipelineShaderStageCreateInfo shader_stage_vertex = {
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        nullptr,
+        0,
+        VK_SHADER_STAGE_VERTEX_BIT,
+        m_vulkan_data.load_shader( "generated/tone_map.vert.spirv" ),
+        "main",
+        nullptr};
+
+    VkPipelineShaderStageCreateInfo shader_stage_fragment = {
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        nullptr,
+        0,
+        VK_SHADER_STAGE_FRAGMENT_BIT,
+        m_vulkan_data.load_shader( "generated/tone_map.frag.spirv" ),
+        "main",
+        nullptr};
+
+    std::array< VkPipelineShaderStageCreateInfo, 2 > shader_stages{shader_stage_vertex,
+                                                                   shader_stage_fragment};
+
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {
+        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        nullptr,
+        0,
+        1,
+        &m_tone_map_set_layout,
+        0,
+        nullptr};
+
+    auto res = vkCreatePipelineLayout( m_vulkan_data.logical_device,
+                                       &pipeline_layout_create_info, nullptr,
+                                       &m_tone_map_pipeline_layout );
+    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline layout failed" );
+
+    VkGraphicsPipelineCreateInfo pipeline_create_info = {
+        VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        nullptr,
+        0,
+        shader_stages.size(),
+        shader_stages.data(),
+        &vertex_input_state,
+        &input_assembly_state,
+        nullptr,
+        &viewport_state,
+        &rasterization_state,
+        &multisample_state,
+        nullptr,
+        &color_blend_state,
+        nullptr,
+        m_tone_map_pipeline_layout,
+        m_graph.render_pass( m_tone_map_pass ),
+        0,
+        nullptr,
+        0};
+
+    res = vkCreateGraphicsPipelines( m_vulkan_data.logical_device, nullptr, 1,
+                                     &pipeline_create_info, nullptr,
+                                     &m_tone_map_pipeline );
+    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of tone map pipeline failed." );
+
     vkDestroyShaderModule( m_vulkan_data.logical_device, shader_stages[0].module,
                            nullptr );
     vkDestroyShaderModule( m_vulkan_data.logical_device, shader_stages[1].module,
                            nullptr );
 }
 
+void example4::destroy_tone_map_pipeline()
+{
+    vkDestroyPipeline( m_vulkan_data.logical_device, m_tone_map_pipeline, nullptr );
+    vkDestroyPipelineLayout( m_vulkan_data.logical_device, m_tone_map_pipeline_layout,
+                             nullptr );
+}
+
 void example4::create_uniform_buffers()
 {
     VkDeviceSize ubo_size = sizeof( uniform_buffer );
@@ -738,15 +1032,21 @@ void example4::destroy_uniform_buffers()
 
 void example4::create_descriptor_pool()
 {
-    std::array< VkDescriptorPoolSize, 2 > pool_size;
+    // one set per swapchain image + the tone mapping set
+    std::array< VkDescriptorPoolSize, 3 > pool_size;
     pool_size[0] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                    m_vulkan_data.swap_chain.images_count};
+                    m_vulkan_data.swap_chain.images_count + 1};
     pool_size[1] = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
                     m_vulkan_data.swap_chain.images_count};
+    pool_size[2] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1};
 
     VkDescriptorPoolCreateInfo create_info = {
-        VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, nullptr, 0,
-        m_vulkan_data.swap_chain.images_count,         2,       pool_size.data()};
+        VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        nullptr,
+        0,
+        m_vulkan_data.swap_chain.images_count + 1,
+        static_cast< uint32_t >( pool_size.size() ),
+        pool_size.data()};
 
     const auto res = vkCreateDescriptorPool( m_vulkan_data.logical_device, &create_info,
                                              nullptr, &m_descriptor_pool );
@@ -815,6 +1115,35 @@ void example4::create_descriptor_sets()
     }
 }
 
+void example4::create_tone_map_descriptor_set()
+{
+    VkDescriptorSetAllocateInfo alloc_info = {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, m_descriptor_pool, 1,
+        &m_tone_map_set_layout};
+
+    const auto res = vkAllocateDescriptorSets( m_vulkan_data.logical_device, &alloc_info,
+                                               &m_tone_map_set );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't allocate descriptor sets!" );
+
+    VkDescriptorImageInfo image_info{m_hdr_sampler, m_graph.image_view( m_hdr_color ),
+                                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkDescriptorBufferInfo buffer_info{m_auto_exposure.exposure_buffer(), 0,
+                                       VK_WHOLE_SIZE};
+
+    std::array< VkWriteDescriptorSet, 2 > descriptor_writes = {
+        VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                             m_tone_map_set, 0, 0, 1,
+                             VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &image_info,
+                             nullptr, nullptr},
+        VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                             m_tone_map_set, 1, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                             nullptr, &buffer_info, nullptr}};
+
+    vkUpdateDescriptorSets( m_vulkan_data.logical_device,
+                            static_cast< uint32_t >( descriptor_writes.size() ),
+                            descriptor_writes.data(), 0, nullptr );
+}
+
 void example4::destroy_descriptor_sets()
 {
     // We don't need to destroy descriptor sets as it will dissapear after the release of
@@ -823,26 +1152,13 @@ void example4::destroy_descriptor_sets()
 
 void example4::update_unform_buffer( float dt_s, uint32_t current_image )
 {
-    uniform_buffer ubo{};
-
     m_rotation_y += dt_s * 0.75;
     // m_rotation_x += dt_s * 1.25;
     // m_rotation_z += dt_s * 0.25;
 
-    ubo.model = glm::rotate( glm::mat4( 1.0f ), m_rotation_x * glm::radians( 90.0f ),
-                             glm::vec3( 1.0f, 0.0f, 0.0f ) );
-
-    ubo.model *= glm::rotate( glm::mat4( 1.0f ), m_rotation_y * glm::radians( 90.0f ),
-                              glm::vec3( 0.0f, 1.0f, 0.0f ) );
-
-    ubo.model *= glm::rotate( glm::mat4( 1.0f ), m_rotation_z * glm::radians( 90.0f ),
-                              glm::vec3( 0.0f, 0.0f, 1.0f ) );
-
-    ubo.view = glm::lookAt( glm::vec3( 0.0f, 0.0f, 50.0f ), glm::vec3( 0.0f, 0.0f, 0.0f ),
-                            glm::vec3( 0.0f, 1.0f, 0.0f ) );
-
-    ubo.proj = glm::perspective( glm::radians( 80.0f ),
-                                 WIDTH / static_cast< float >( HEIGHT ), 0.1f, 100.0f );
+    const uniform_buffer ubo =
+        make_example4_transforms( m_rotation_x, m_rotation_y, m_rotation_z,
+                                  WIDTH / static_cast< float >( HEIGHT ) );
 
     void* data     = nullptr;
     const auto res = vkMapMemory( m_vulkan_data.logical_device,
@@ -852,6 +1168,10 @@ void example4::update_unform_buffer( float dt_s, uint32_t current_image )
     memcpy( data, &ubo, sizeof( uniform_buffer ) );
     vkUnmapMemory( m_vulkan_data.logical_device,
                    m_uniform_buffers[current_image].memory );
+
+    // the instance bounds contain the cat in any rotation, the model matrix doesn't
+    // matter for culling
+    m_culling.update( current_image, ubo.view, ubo.proj, m_instances.count() );
 }
 
 void example4::create_texture( const image& img )
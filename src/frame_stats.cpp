@@ -0,0 +1,195 @@
+#include "frame_stats.hpp"
+
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <fstream>
+#include <iomanip>
+
+namespace
+{
+    // all a signal handler may touch
+    volatile std::sig_atomic_t g_dump_requested = 0;
+
+    void request_dump( int )
+    {
+        g_dump_requested = 1;
+    }
+
+    uint64_t to_us( double ms )
+    {
+        return static_cast< uint64_t >( std::max( 0.0, ms ) * 1000.0 + 0.5 );
+    }
+
+    double to_ms( uint64_t us )
+    {
+        return us * 0.001;
+    }
+
+    constexpr const char* METRIC_NAMES[] = {"frame", "acquire", "cpu", "submit",
+                                            "present"};
+} // namespace
+
+hdr_histogram::hdr_histogram()
+    : m_buckets( ( MAGNITUDES + 2 ) * SUB_BUCKETS )
+{
+}
+
+void hdr_histogram::record( uint64_t value )
+{
+    value = std::min( value, MAX_VALUE );
+
+    m_buckets[bucket_index( value )] += 1;
+    m_count += 1;
+    m_max = std::max( m_max, value );
+}
+
+void hdr_histogram::reset()
+{
+    std::fill( m_buckets.begin(), m_buckets.end(), 0 );
+    m_count = 0;
+    m_max   = 0;
+}
+
+uint64_t hdr_histogram::value_at_percentile( double p ) const
+{
+    if ( m_count == 0 )
+    {
+        return 0;
+    }
+
+    const auto rank = std::max(
+        uint64_t{1}, static_cast< uint64_t >( std::ceil( p * m_count ) ) );
+
+    uint64_t seen = 0;
+    for ( uint32_t i = 0; i < m_buckets.size(); ++i )
+    {
+        seen += m_buckets[i];
+        if ( seen >= rank )
+        {
+            return std::min( bucket_highest_value( i ), m_max );
+        }
+    }
+
+    return m_max;
+}
+
+uint32_t hdr_histogram::bucket_index( uint64_t value )
+{
+    if ( value < 2 * SUB_BUCKETS )
+    {
+        return static_cast< uint32_t >( value );
+    }
+
+    // the shift leaving SUB_BUCKET_BITS + 1 significant bits
+    uint32_t shift = 1;
+    while ( ( value >> ( shift + SUB_BUCKET_BITS + 1 ) ) != 0 )
+    {
+        ++shift;
+    }
+
+    return shift * SUB_BUCKETS + static_cast< uint32_t >( value >> shift );
+}
+
+uint64_t hdr_histogram::bucket_highest_value( uint32_t idx )
+{
+    if ( idx < 2 * SUB_BUCKETS )
+    {
+        return idx;
+    }
+
+    const uint32_t shift = idx / SUB_BUCKETS - 1;
+    const uint64_t top   = idx - shift * SUB_BUCKETS;
+
+    return ( ( top + 1 ) << shift ) - 1;
+}
+
+frame_stats::frame_stats()
+    : m_history( HISTORY )
+{
+}
+
+void frame_stats::record( const frame_timing& timing )
+{
+    m_histograms[0].record( to_us( timing.frame_ms ) );
+    m_histograms[1].record( to_us( timing.acquire_ms ) );
+    m_histograms[2].record( to_us( timing.cpu_ms ) );
+    m_histograms[3].record( to_us( timing.submit_ms ) );
+    m_histograms[4].record( to_us( timing.present_ms ) );
+
+    m_history[m_frames % HISTORY] = timing;
+    m_frames += 1;
+
+    if ( g_dump_requested != 0 && !m_signal_path.empty() )
+    {
+        g_dump_requested = 0;
+        write_csv( m_signal_path );
+    }
+}
+
+void frame_stats::reset()
+{
+    for ( auto& h : m_histograms )
+    {
+        h.reset();
+    }
+
+    m_frames = 0;
+}
+
+std::vector< frame_time_summary > frame_stats::summary() const
+{
+    std::vector< frame_time_summary > ret;
+    ret.reserve( METRICS );
+
+    for ( uint32_t m = 0; m < METRICS; ++m )
+    {
+        const auto& h = m_histograms[m];
+
+        ret.push_back( {METRIC_NAMES[m], h.count(), to_ms( h.value_at_percentile( 0.5 ) ),
+                        to_ms( h.value_at_percentile( 0.9 ) ),
+                        to_ms( h.value_at_percentile( 0.99 ) ),
+                        to_ms( h.value_at_percentile( 0.999 ) ), to_ms( h.max() )} );
+    }
+
+    return ret;
+}
+
+bool frame_stats::write_csv( const std::string& path ) const
+{
+    std::ofstream os( path );
+    if ( !os.is_open() )
+    {
+        NEO_LOG_ERROR( frame, "Couldn't open ", path, " for the frame times" );
+        return false;
+    }
+
+    os << std::fixed << std::setprecision( 3 );
+    os << "frame,frame_ms,acquire_ms,cpu_ms,submit_ms,present_ms\n";
+
+    const uint64_t first = m_frames > HISTORY ? m_frames - HISTORY : 0;
+    for ( uint64_t f = first; f < m_frames; ++f )
+    {
+        const auto& t = m_history[f % HISTORY];
+        os << f << ',' << t.frame_ms << ',' << t.acquire_ms << ',' << t.cpu_ms << ','
+           << t.submit_ms << ',' << t.present_ms << '\n';
+    }
+
+    NEO_LOG_INFO( frame, "Frame times of ", m_frames - first, " frames written to ",
+                  path );
+
+    return true;
+}
+
+void frame_stats::dump_on_signal( const std::string& path )
+{
+    m_signal_path = path;
+
+#ifdef SIGUSR1
+    std::signal( SIGUSR1, request_dump );
+#else
+    NEO_LOG_WARNING( frame, "No SIGUSR1 here, the frame times are only written on exit" );
+#endif
+}
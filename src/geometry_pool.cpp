@@ -0,0 +1,286 @@
+#include "geometry_pool.hpp"
+
+#include "debug.hpp"
+
+#include <cstring>
+#include <iterator>
+
+void geometry_pool::free_list::reset( uint32_t capacity )
+{
+    ranges.assign( 1, {0, capacity} );
+}
+
+bool geometry_pool::free_list::allocate( uint32_t count, uint32_t& offset )
+{
+    for ( auto it = ranges.begin(); it != ranges.end(); ++it )
+    {
+        if ( it->count >= count )
+        {
+            offset = it->offset;
+            it->offset += count;
+            it->count -= count;
+
+            if ( it->count == 0 )
+            {
+                ranges.erase( it );
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void geometry_pool::free_list::release( uint32_t offset, uint32_t count )
+{
+    if ( count == 0 )
+    {
+        return;
+    }
+
+    auto next = std::lower_bound(
+        ranges.begin(), ranges.end(), offset,
+        []( const range& r, uint32_t o ) { return r.offset < o; } );
+
+    // grow the neighbours instead of adding a range where possible
+    const bool joins_previous =
+        next != ranges.begin() && std::prev( next )->offset + std::prev( next )->count
+                                      == offset;
+    const bool joins_next = next != ranges.end() && offset + count == next->offset;
+
+    if ( joins_previous && joins_next )
+    {
+        std::prev( next )->count += count + next->count;
+        ranges.erase( next );
+    }
+    else if ( joins_previous )
+    {
+        std::prev( next )->count += count;
+    }
+    else if ( joins_next )
+    {
+        next->offset = offset;
+        next->count += count;
+    }
+    else
+    {
+        ranges.insert( next, {offset, count} );
+    }
+}
+
+void geometry_pool::initialize( uint32_t max_vertices, uint32_t max_indices )
+{
+    m_max_vertices  = max_vertices;
+    m_max_indices   = max_indices;
+    m_mesh_count    = 0;
+    m_used_vertices = 0;
+    m_used_indices  = 0;
+
+    create_buffers( m_vertices, m_indices );
+
+    m_free_vertices.reset( max_vertices );
+    m_free_indices.reset( max_indices );
+}
+
+void geometry_pool::deinitialize()
+{
+    m_vulkan_data.destroy_buffer( m_indices );
+    m_vulkan_data.destroy_buffer( m_vertices );
+
+    m_meshes.clear();
+    m_free_handles.clear();
+}
+
+void geometry_pool::create_buffers( buffer_data& vertices, buffer_data& indices ) const
+{
+    // transfers in for add(), out of the old buffers for compact()
+    vertices = m_vulkan_data.create_buffer(
+        static_cast< VkDeviceSize >( m_max_vertices ) * sizeof( vtx_t::vertex ),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    indices = m_vulkan_data.create_buffer(
+        static_cast< VkDeviceSize >( m_max_indices ) * sizeof( vtx_t::index ),
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+}
+
+geometry_pool::handle geometry_pool::add( const model_data& model )
+{
+    NEO_ASSERT_ALWAYS( !model.vertex_data.empty() && !model.index_data.empty(),
+                       "Can't pool an empty mesh" );
+
+    const auto vertex_count = static_cast< uint32_t >( model.vertex_data.size() );
+    const auto index_count  = static_cast< uint32_t >( model.index_data.size() );
+
+    uint32_t first_vertex = 0;
+    uint32_t first_index  = 0;
+
+    if ( !m_free_vertices.allocate( vertex_count, first_vertex ) )
+    {
+        return INVALID_HANDLE;
+    }
+
+    if ( !m_free_indices.allocate( index_count, first_index ) )
+    {
+        m_free_vertices.release( first_vertex, vertex_count );
+        return INVALID_HANDLE;
+    }
+
+    const VkDeviceSize vertex_size = vertex_count * sizeof( vtx_t::vertex );
+    const VkDeviceSize index_size  = index_count * sizeof( vtx_t::index );
+
+    buffer_data staging = m_vulkan_data.create_buffer(
+        vertex_size + index_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+    void* data     = nullptr;
+    const auto res = vkMapMemory( m_vulkan_data.logical_device, staging.memory, 0,
+                                  staging.size, 0, &data );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map staging memory!" );
+    memcpy( data, model.vertex_data.data(), vertex_size );
+    memcpy( static_cast< char* >( data ) + vertex_size, model.index_data.data(),
+            index_size );
+    vkUnmapMemory( m_vulkan_data.logical_device, staging.memory );
+
+    VkCommandBuffer cmd = m_vulkan_data.begin_one_time_commands();
+
+    const VkBufferCopy vertex_region{0, first_vertex * sizeof( vtx_t::vertex ),
+                                     vertex_size};
+    const VkBufferCopy index_region{vertex_size, first_index * sizeof( vtx_t::index ),
+                                    index_size};
+    vkCmdCopyBuffer( cmd, staging.buffer, m_vertices.buffer, 1, &vertex_region );
+    vkCmdCopyBuffer( cmd, staging.buffer, m_indices.buffer, 1, &index_region );
+
+    m_vulkan_data.submit_one_time_commands( cmd );
+    m_vulkan_data.destroy_buffer( staging );
+
+    mesh_range range{static_cast< int32_t >( first_vertex ), vertex_count, first_index,
+                     index_count, model.lods};
+
+    if ( range.lods.empty() )
+    {
+        range.lods.push_back( {0, index_count, 0.0f} );
+    }
+
+    for ( auto& l : range.lods )
+    {
+        l.first_index += first_index;
+    }
+
+    handle h = static_cast< handle >( m_meshes.size() );
+    if ( !m_free_handles.empty() )
+    {
+        h = m_free_handles.back();
+        m_free_handles.pop_back();
+        m_meshes[h] = std::move( range );
+    }
+    else
+    {
+        m_meshes.push_back( std::move( range ) );
+    }
+
+    ++m_mesh_count;
+    ++m_version;
+    m_used_vertices += vertex_count;
+    m_used_indices += index_count;
+
+    return h;
+}
+
+void geometry_pool::remove( handle h )
+{
+    NEO_ASSERT_ALWAYS( h < m_meshes.size() && m_meshes[h].index_count > 0,
+                       "Invalid mesh handle ", h );
+
+    mesh_range& range = m_meshes[h];
+
+    m_free_vertices.release( static_cast< uint32_t >( range.vertex_offset ),
+                             range.vertex_count );
+    m_free_indices.release( range.first_index, range.index_count );
+
+    --m_mesh_count;
+    ++m_version;
+    m_used_vertices -= range.vertex_count;
+    m_used_indices -= range.index_count;
+
+    range = mesh_range{};
+    m_free_handles.push_back( h );
+}
+
+void geometry_pool::compact()
+{
+    buffer_data vertices;
+    buffer_data indices;
+    create_buffers( vertices, indices );
+
+    std::vector< VkBufferCopy > vertex_regions;
+    std::vector< VkBufferCopy > index_regions;
+
+    uint32_t vertex_offset = 0;
+    uint32_t index_offset  = 0;
+
+    // handle order, the meshes end up packed without holes
+    for ( auto& range : m_meshes )
+    {
+        if ( range.index_count == 0 )
+        {
+            continue;
+        }
+
+        vertex_regions.push_back(
+            {static_cast< uint32_t >( range.vertex_offset ) * sizeof( vtx_t::vertex ),
+             vertex_offset * sizeof( vtx_t::vertex ),
+             range.vertex_count * sizeof( vtx_t::vertex )} );
+        index_regions.push_back( {range.first_index * sizeof( vtx_t::index ),
+                                  index_offset * sizeof( vtx_t::index ),
+                                  range.index_count * sizeof( vtx_t::index )} );
+
+        for ( auto& l : range.lods )
+        {
+            l.first_index = l.first_index - range.first_index + index_offset;
+        }
+
+        range.vertex_offset = static_cast< int32_t >( vertex_offset );
+        range.first_index   = index_offset;
+
+        vertex_offset += range.vertex_count;
+        index_offset += range.index_count;
+    }
+
+    if ( !vertex_regions.empty() )
+    {
+        VkCommandBuffer cmd = m_vulkan_data.begin_one_time_commands();
+
+        vkCmdCopyBuffer( cmd, m_vertices.buffer, vertices.buffer,
+                         static_cast< uint32_t >( vertex_regions.size() ),
+                         vertex_regions.data() );
+        vkCmdCopyBuffer( cmd, m_indices.buffer, indices.buffer,
+                         static_cast< uint32_t >( index_regions.size() ),
+                         index_regions.data() );
+
+        m_vulkan_data.submit_one_time_commands( cmd );
+    }
+
+    m_vulkan_data.destroy_buffer( m_indices );
+    m_vulkan_data.destroy_buffer( m_vertices );
+
+    m_vertices = vertices;
+    m_indices  = indices;
+    ++m_version;
+
+    m_free_vertices.ranges.clear();
+    m_free_indices.ranges.clear();
+    m_free_vertices.release( vertex_offset, m_max_vertices - vertex_offset );
+    m_free_indices.release( index_offset, m_max_indices - index_offset );
+}
+
+void geometry_pool::bind( VkCommandBuffer cmd ) const
+{
+    const VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers( cmd, 0, 1, &m_vertices.buffer, &offset );
+    vkCmdBindIndexBuffer( cmd, m_indices.buffer, 0, VK_INDEX_TYPE_UINT32 );
+}
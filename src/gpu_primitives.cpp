@@ -0,0 +1,475 @@
+#include "gpu_primitives.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+    uint32_t scan_partitions( uint32_t count )
+    {
+        return ( count + gpu_primitives::SCAN_PARTITION_SIZE - 1 )
+               / gpu_primitives::SCAN_PARTITION_SIZE;
+    }
+} // namespace
+
+void gpu_primitives::initialize( uint32_t max_elements )
+{
+    const auto& limits =
+        m_vulkan_data.device_properties[m_vulkan_data.selected_device_idx].limits;
+
+    const uint64_t table_size = uint64_t{RADIX_DIGITS} * sort_partitions( max_elements );
+
+    NEO_ASSERT_ALWAYS( uint64_t{max_elements} * sizeof( uint32_t )
+                           <= limits.maxStorageBufferRange,
+                       "Element count exceeds maxStorageBufferRange: ", max_elements );
+    NEO_ASSERT_ALWAYS( table_size * sizeof( uint32_t ) <= limits.maxStorageBufferRange,
+                       "Radix sort table exceeds maxStorageBufferRange" );
+
+    m_max_elements = max_elements;
+
+    create_buffers();
+    init_descriptor_set_layouts();
+    create_descriptor_pool();
+    init_pipelines();
+}
+
+void gpu_primitives::deinitialize()
+{
+    destroy_pipelines();
+    destroy_descriptor_pool();
+    destroy_descriptor_set_layouts();
+    destroy_buffers();
+}
+
+void gpu_primitives::reset()
+{
+    vkResetDescriptorPool( m_vulkan_data.logical_device, m_descriptor_pool, 0 );
+}
+
+void gpu_primitives::create_buffers()
+{
+    const VkBufferUsageFlags usage =
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    const uint32_t table_size  = RADIX_DIGITS * sort_partitions( m_max_elements );
+    const uint32_t scan_blocks =
+        scan_partitions( std::max( m_max_elements, table_size ) );
+
+    // counter plus flag, aggregate and inclusive prefix per partition
+    m_scan_status = m_vulkan_data.create_buffer(
+        ( 1 + 3 * VkDeviceSize{scan_blocks} ) * sizeof( uint32_t ), usage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    m_reduce_partials =
+        m_vulkan_data.create_buffer( REDUCE_MAX_GROUPS * sizeof( uint32_t ), usage,
+                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    const VkDeviceSize elements_size =
+        std::max( VkDeviceSize{m_max_elements}, VkDeviceSize{1} ) * sizeof( uint32_t );
+
+    m_sort_keys = m_vulkan_data.create_buffer( elements_size, usage,
+                                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+    m_sort_values = m_vulkan_data.create_buffer( elements_size, usage,
+                                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+    m_sort_table =
+        m_vulkan_data.create_buffer( VkDeviceSize{table_size} * sizeof( uint32_t ), usage,
+                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+}
+
+void gpu_primitives::destroy_buffers()
+{
+    m_vulkan_data.destroy_buffer( m_sort_table );
+    m_vulkan_data.destroy_buffer( m_sort_values );
+    m_vulkan_data.destroy_buffer( m_sort_keys );
+    m_vulkan_data.destroy_buffer( m_reduce_partials );
+    m_vulkan_data.destroy_buffer( m_scan_status );
+}
+
+void gpu_primitives::init_descriptor_set_layouts()
+{
+    auto create_layout = [this]( uint32_t binding_count, VkDescriptorSetLayout* layout ) {
+        std::vector< VkDescriptorSetLayoutBinding > bindings( binding_count );
+
+        for ( uint32_t i = 0; i < binding_count; ++i )
+        {
+            bindings[i] = {i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                           VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+        }
+
+        VkDescriptorSetLayoutCreateInfo create_info{
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+            binding_count, bindings.data()};
+
+        const auto res = vkCreateDescriptorSetLayout( m_vulkan_data.logical_device,
+                                                      &create_info, nullptr, layout );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor set layout" );
+    };
+
+    create_layout( 2, &m_set_layout_2 );
+    create_layout( 3, &m_set_layout_3 );
+    create_layout( 5, &m_set_layout_5 );
+}
+
+void gpu_primitives::destroy_descriptor_set_layouts()
+{
+    vkDestroyDescriptorSetLayout( m_vulkan_data.logical_device, m_set_layout_2, nullptr );
+    vkDestroyDescriptorSetLayout( m_vulkan_data.logical_device, m_set_layout_3, nullptr );
+    vkDestroyDescriptorSetLayout( m_vulkan_data.logical_device, m_set_layout_5, nullptr );
+}
+
+void gpu_primitives::create_descriptor_pool()
+{
+    const VkDescriptorPoolSize pool_size{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MAX_SETS * 5};
+
+    VkDescriptorPoolCreateInfo create_info = {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, nullptr, 0, MAX_SETS, 1,
+        &pool_size};
+
+    const auto res = vkCreateDescriptorPool( m_vulkan_data.logical_device, &create_info,
+                                             nullptr, &m_descriptor_pool );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor pool!" );
+}
+
+void gpu_primitives::destroy_descriptor_pool()
+{
+    vkDestroyDescriptorPool( m_vulkan_data.logical_device, m_descriptor_pool, nullptr );
+}
+
+void gpu_primitives::init_pipelines()
+{
+    const VkPushConstantRange push_range{VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                         sizeof( push_constants )};
+
+    auto create_layout = [this, &push_range]( VkDescriptorSetLayout* set_layout,
+                                              VkPipelineLayout* layout ) {
+        VkPipelineLayoutCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            set_layout,
+            1,
+            &push_range};
+
+        const auto res = vkCreatePipelineLayout( m_vulkan_data.logical_device,
+                                                 &create_info, nullptr, layout );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline layout failed" );
+    };
+
+    create_layout( &m_set_layout_2, &m_pipeline_layout_2 );
+    create_layout( &m_set_layout_3, &m_pipeline_layout_3 );
+    create_layout( &m_set_layout_5, &m_pipeline_layout_5 );
+
+    // both spec constants are 32 bit, bool included
+    const VkSpecializationMapEntry entry{0, 0, sizeof( uint32_t )};
+
+    for ( uint32_t device_wide = 0; device_wide < 2; ++device_wide )
+    {
+        const VkSpecializationInfo specialization{1, &entry, sizeof( uint32_t ),
+                                                  &device_wide};
+        ( device_wide ? m_scan_pipeline : m_workgroup_scan_pipeline ) =
+            m_vulkan_data.create_compute_pipeline( "generated/scan.comp.spirv",
+                                                   m_pipeline_layout_3, &specialization );
+    }
+
+    for ( uint32_t op = 0; op < m_reduce_pipelines.size(); ++op )
+    {
+        const VkSpecializationInfo specialization{1, &entry, sizeof( uint32_t ), &op};
+        m_reduce_pipelines[op] = m_vulkan_data.create_compute_pipeline(
+            "generated/reduce.comp.spirv", m_pipeline_layout_2, &specialization );
+    }
+
+    m_radix_histogram_pipeline = m_vulkan_data.create_compute_pipeline(
+        "generated/radix_histogram.comp.spirv", m_pipeline_layout_2 );
+    m_radix_scatter_pipeline = m_vulkan_data.create_compute_pipeline(
+        "generated/radix_scatter.comp.spirv", m_pipeline_layout_5 );
+}
+
+void gpu_primitives::destroy_pipelines()
+{
+    const auto device = m_vulkan_data.logical_device;
+
+    vkDestroyPipeline( device, m_scan_pipeline, nullptr );
+    vkDestroyPipeline( device, m_workgroup_scan_pipeline, nullptr );
+
+    for ( auto p : m_reduce_pipelines )
+    {
+        vkDestroyPipeline( device, p, nullptr );
+    }
+
+    vkDestroyPipeline( device, m_radix_histogram_pipeline, nullptr );
+    vkDestroyPipeline( device, m_radix_scatter_pipeline, nullptr );
+
+    vkDestroyPipelineLayout( device, m_pipeline_layout_2, nullptr );
+    vkDestroyPipelineLayout( device, m_pipeline_layout_3, nullptr );
+    vkDestroyPipelineLayout( device, m_pipeline_layout_5, nullptr );
+}
+
+VkDescriptorSet gpu_primitives::allocate_set( VkDescriptorSetLayout layout,
+                                              std::initializer_list< VkBuffer > buffers )
+{
+    VkDescriptorSet set = nullptr;
+
+    VkDescriptorSetAllocateInfo alloc_info = {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, m_descriptor_pool, 1,
+        &layout};
+
+    const auto res =
+        vkAllocateDescriptorSets( m_vulkan_data.logical_device, &alloc_info, &set );
+    NEO_ASSERT_ALWAYS(
+        res == VK_SUCCESS,
+        "Couldn't allocate descriptor set, missing gpu_primitives::reset()?" );
+
+    std::array< VkDescriptorBufferInfo, 5 > infos;
+    std::array< VkWriteDescriptorSet, 5 > writes;
+
+    uint32_t binding = 0;
+    for ( const auto b : buffers )
+    {
+        infos[binding]  = {b, 0, VK_WHOLE_SIZE};
+        writes[binding] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                           nullptr,
+                           set,
+                           binding,
+                           0,
+                           1,
+                           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                           nullptr,
+                           &infos[binding],
+                           nullptr};
+        ++binding;
+    }
+
+    vkUpdateDescriptorSets( m_vulkan_data.logical_device, binding, writes.data(), 0,
+                            nullptr );
+
+    return set;
+}
+
+void gpu_primitives::dispatch( VkCommandBuffer cmd, VkPipelineLayout layout,
+                               uint32_t groups, uint32_t count, uint32_t shift )
+{
+    const auto& limits =
+        m_vulkan_data.device_properties[m_vulkan_data.selected_device_idx].limits;
+
+    // large inputs don't fit the guaranteed 65535 groups in x, the shaders linearize
+    // the 2D group id and drop the overhang
+    const uint32_t groups_x = std::min( groups, limits.maxComputeWorkGroupCount[0] );
+    const uint32_t groups_y = ( groups + groups_x - 1 ) / groups_x;
+
+    const push_constants pc{count, groups, shift};
+    vkCmdPushConstants( cmd, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                        sizeof( push_constants ), &pc );
+    vkCmdDispatch( cmd, groups_x, groups_y, 1 );
+}
+
+void gpu_primitives::compute_barrier( VkCommandBuffer cmd )
+{
+    const VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+                                  VK_ACCESS_SHADER_WRITE_BIT,
+                                  VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+
+    vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                          nullptr, 0, nullptr );
+}
+
+void gpu_primitives::record_scan_impl( VkCommandBuffer cmd, VkPipeline pipeline,
+                                       VkBuffer in, VkBuffer out, uint32_t count )
+{
+    if ( count == 0 )
+    {
+        return;
+    }
+
+    // the look-back state in m_scan_status is sized for max_elements
+    NEO_ASSERT_ALWAYS( count <= m_max_elements, "Scanning more than max_elements!" );
+
+    const uint32_t partitions = scan_partitions( count );
+
+    // the look-back state has to start out zeroed, a previous scan might still use it
+    {
+        const VkMemoryBarrier barrier{
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            VK_ACCESS_TRANSFER_WRITE_BIT};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr,
+                              0, nullptr );
+    }
+
+    vkCmdFillBuffer( cmd, m_scan_status.buffer, 0,
+                     ( 1 + 3 * VkDeviceSize{partitions} ) * sizeof( uint32_t ), 0 );
+
+    {
+        const VkMemoryBarrier barrier{
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                              nullptr, 0, nullptr );
+    }
+
+    const VkDescriptorSet set =
+        allocate_set( m_set_layout_3, {in, out, m_scan_status.buffer} );
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+    vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout_3, 0,
+                             1, &set, 0, nullptr );
+    dispatch( cmd, m_pipeline_layout_3, partitions, count, 0 );
+}
+
+void gpu_primitives::record_scan( VkCommandBuffer cmd, VkBuffer in, VkBuffer out,
+                                  uint32_t count )
+{
+    record_scan_impl( cmd, m_scan_pipeline, in, out, count );
+}
+
+void gpu_primitives::record_workgroup_scan( VkCommandBuffer cmd, VkBuffer in,
+                                            VkBuffer out, uint32_t count )
+{
+    record_scan_impl( cmd, m_workgroup_scan_pipeline, in, out, count );
+}
+
+void gpu_primitives::record_reduce( VkCommandBuffer cmd, reduce_op op, VkBuffer in,
+                                    VkBuffer out, uint32_t count )
+{
+    const VkPipeline pipeline = m_reduce_pipelines[static_cast< uint32_t >( op )];
+
+    // a few items per thread before the shared memory tree pays off
+    const uint32_t groups =
+        std::clamp( ( count + 256 * 4 - 1 ) / ( 256 * 4 ), 1u, REDUCE_MAX_GROUPS );
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+
+    {
+        const VkDescriptorSet set =
+            allocate_set( m_set_layout_2, {in, m_reduce_partials.buffer} );
+        vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout_2,
+                                 0, 1, &set, 0, nullptr );
+        dispatch( cmd, m_pipeline_layout_2, groups, count, 0 );
+    }
+
+    compute_barrier( cmd );
+
+    {
+        const VkDescriptorSet set =
+            allocate_set( m_set_layout_2, {m_reduce_partials.buffer, out} );
+        vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout_2,
+                                 0, 1, &set, 0, nullptr );
+        dispatch( cmd, m_pipeline_layout_2, 1, groups, 0 );
+    }
+}
+
+void gpu_primitives::record_radix_sort( VkCommandBuffer cmd, VkBuffer keys,
+                                        VkBuffer values, uint32_t count )
+{
+    if ( count == 0 )
+    {
+        return;
+    }
+
+    NEO_ASSERT_ALWAYS( count <= m_max_elements, "Sorting more than max_elements!" );
+
+    const uint32_t partitions = sort_partitions( count );
+
+    // even number of passes, the result ends up back in keys / values
+    std::array< VkBuffer, 2 > key_buffers   = {keys, m_sort_keys.buffer};
+    std::array< VkBuffer, 2 > value_buffers = {values, m_sort_values.buffer};
+
+    for ( uint32_t pass = 0; pass < 4; ++pass )
+    {
+        const uint32_t shift = pass * 8;
+        const uint32_t src   = pass & 1;
+        const uint32_t dst   = src ^ 1;
+
+        {
+            const VkDescriptorSet set =
+                allocate_set( m_set_layout_2, {key_buffers[src], m_sort_table.buffer} );
+
+            vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                               m_radix_histogram_pipeline );
+            vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                     m_pipeline_layout_2, 0, 1, &set, 0, nullptr );
+            dispatch( cmd, m_pipeline_layout_2, partitions, count, shift );
+        }
+
+        compute_barrier( cmd );
+
+        record_scan( cmd, m_sort_table.buffer, m_sort_table.buffer,
+                     RADIX_DIGITS * partitions );
+
+        compute_barrier( cmd );
+
+        {
+            const VkDescriptorSet set =
+                allocate_set( m_set_layout_5,
+                              {key_buffers[src], value_buffers[src], m_sort_table.buffer,
+                               key_buffers[dst], value_buffers[dst]} );
+
+            vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                               m_radix_scatter_pipeline );
+            vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                     m_pipeline_layout_5, 0, 1, &set, 0, nullptr );
+            dispatch( cmd, m_pipeline_layout_5, partitions, count, shift );
+        }
+
+        compute_barrier( cmd );
+    }
+}
+
+void scan_reference( const uint32_t* in, uint32_t count, uint32_t* out )
+{
+    uint32_t sum = 0;
+
+    for ( uint32_t i = 0; i < count; ++i )
+    {
+        const uint32_t v = in[i];
+        out[i]           = sum;
+        sum += v;
+    }
+}
+
+uint32_t reduce_reference( gpu_primitives::reduce_op op, const uint32_t* in,
+                           uint32_t count )
+{
+    switch ( op )
+    {
+        case gpu_primitives::reduce_op::min:
+            return std::accumulate(
+                in, in + count, 0xffffffffu,
+                []( uint32_t a, uint32_t b ) { return std::min( a, b ); } );
+        case gpu_primitives::reduce_op::max:
+            return std::accumulate(
+                in, in + count, 0u,
+                []( uint32_t a, uint32_t b ) { return std::max( a, b ); } );
+        default:
+            return std::accumulate( in, in + count, 0u );
+    };
+}
+
+void radix_sort_reference( uint32_t* keys, uint32_t* values, uint32_t count )
+{
+    std::vector< uint32_t > order( count );
+    std::iota( order.begin(), order.end(), 0u );
+
+    std::stable_sort( order.begin(), order.end(),
+                      [keys]( uint32_t a, uint32_t b ) { return keys[a] < keys[b]; } );
+
+    std::vector< uint32_t > sorted_keys( count );
+    std::vector< uint32_t > sorted_values( count );
+
+    for ( uint32_t i = 0; i < count; ++i )
+    {
+        sorted_keys[i]   = keys[order[i]];
+        sorted_values[i] = values[order[i]];
+    }
+
+    std::copy( sorted_keys.begin(), sorted_keys.end(), keys );
+    std::copy( sorted_values.begin(), sorted_values.end(), values );
+}
@@ -0,0 +1,200 @@
+#include "gpu_profiler.hpp"
+
+#include "debug.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+void gpu_profiler::initialize( uint32_t frame_count, uint32_t max_scopes )
+{
+    m_max_scopes = max_scopes;
+    m_frame_idx  = 0;
+    m_frame_slots.assign( frame_count, {} );
+
+    const auto& queue_props =
+        m_vulkan_data.queue_family_properties[m_vulkan_data.selected_gfx_queue_idx];
+
+    if ( queue_props.timestampValidBits == 0 )
+    {
+        return;
+    }
+
+    // the counters wrap at timestampValidBits, the difference of two stays valid
+    m_valid_mask = queue_props.timestampValidBits >= 64
+                       ? ~0ull
+                       : ( 1ull << queue_props.timestampValidBits ) - 1;
+    m_ms_per_tick =
+        m_vulkan_data.device_properties[m_vulkan_data.selected_device_idx]
+            .limits.timestampPeriod
+        * 1.0e-6;
+
+    const VkQueryPoolCreateInfo create_info = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                               nullptr,
+                                               0,
+                                               VK_QUERY_TYPE_TIMESTAMP,
+                                               frame_count * max_scopes * 2,
+                                               0};
+
+    const auto res = vkCreateQueryPool( m_vulkan_data.logical_device, &create_info,
+                                        nullptr, &m_query_pool );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create the profiler query pool!" );
+}
+
+void gpu_profiler::deinitialize()
+{
+    vkDestroyQueryPool( m_vulkan_data.logical_device, m_query_pool, nullptr );
+
+    m_query_pool = nullptr;
+    m_frame_slots.clear();
+    m_scopes.clear();
+}
+
+void gpu_profiler::begin_frame( VkCommandBuffer cmd, uint32_t frame_idx )
+{
+    NEO_ASSERT_ALWAYS( frame_idx < m_frame_slots.size(), "Frame ", frame_idx,
+                       " out of range" );
+
+    m_frame_idx = frame_idx;
+
+    if ( !enabled() )
+    {
+        return;
+    }
+
+    resolve( frame_idx );
+
+    vkCmdResetQueryPool( cmd, m_query_pool, frame_idx * m_max_scopes * 2,
+                         m_max_scopes * 2 );
+}
+
+uint32_t gpu_profiler::begin( VkCommandBuffer cmd, const char* name )
+{
+    if ( !enabled() )
+    {
+        return 0;
+    }
+
+    auto& slots = m_frame_slots[m_frame_idx];
+    NEO_ASSERT_ALWAYS( slots.size() < m_max_scopes, "More than ", m_max_scopes,
+                       " profiled scopes in a frame" );
+
+    const auto slot = static_cast< uint32_t >( slots.size() );
+    slots.push_back( find_scope( name ) );
+
+    vkCmdWriteTimestamp( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_query_pool,
+                         ( m_frame_idx * m_max_scopes + slot ) * 2 );
+
+    return slot;
+}
+
+void gpu_profiler::end( VkCommandBuffer cmd, uint32_t slot )
+{
+    if ( !enabled() )
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp( cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_query_pool,
+                         ( m_frame_idx * m_max_scopes + slot ) * 2 + 1 );
+}
+
+void gpu_profiler::resolve( uint32_t frame_idx )
+{
+    auto& slots = m_frame_slots[frame_idx];
+    if ( slots.empty() )
+    {
+        return;
+    }
+
+    // value and availability of every query
+    std::vector< uint64_t > results( slots.size() * 4 );
+
+    // no WAIT_BIT, VK_NOT_READY only says some of them are missing
+    const auto res = vkGetQueryPoolResults(
+        m_vulkan_data.logical_device, m_query_pool, frame_idx * m_max_scopes * 2,
+        static_cast< uint32_t >( slots.size() * 2 ), results.size() * sizeof( uint64_t ),
+        results.data(), 2 * sizeof( uint64_t ),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS || res == VK_NOT_READY,
+                       "Couldn't read the profiler queries!" );
+
+    for ( size_t s = 0; s < slots.size(); ++s )
+    {
+        const uint64_t* begin = &results[s * 4];
+        const uint64_t* end   = &results[s * 4 + 2];
+
+        if ( begin[1] == 0 || end[1] == 0 )
+        {
+            continue;
+        }
+
+        auto& scope = m_scopes[slots[s]];
+
+        const uint64_t ticks = ( end[0] - begin[0] ) & m_valid_mask;
+        scope.history_ms[scope.next] = static_cast< float >( ticks * m_ms_per_tick );
+        scope.next                   = ( scope.next + 1 ) % HISTORY;
+        scope.samples                = std::min( scope.samples + 1, HISTORY );
+    }
+
+    slots.clear();
+}
+
+uint32_t gpu_profiler::find_scope( const char* name )
+{
+    // a handful of scopes, a linear search is fine
+    for ( size_t i = 0; i < m_scopes.size(); ++i )
+    {
+        if ( std::strcmp( m_scopes[i].name.c_str(), name ) == 0 )
+        {
+            return static_cast< uint32_t >( i );
+        }
+    }
+
+    m_scopes.push_back( {name, std::vector< float >( HISTORY ), 0, 0} );
+    return static_cast< uint32_t >( m_scopes.size() - 1 );
+}
+
+std::vector< gpu_scope_timing > gpu_profiler::timings() const
+{
+    std::vector< gpu_scope_timing > ret;
+    ret.reserve( m_scopes.size() );
+
+    std::vector< float > sorted;
+
+    for ( const auto& scope : m_scopes )
+    {
+        gpu_scope_timing t{};
+        t.name    = scope.name;
+        t.samples = scope.samples;
+
+        if ( scope.samples > 0 )
+        {
+            // the ring is filled from the front until it wraps
+            sorted.assign( scope.history_ms.begin(),
+                           scope.history_ms.begin() + scope.samples );
+            std::sort( sorted.begin(), sorted.end() );
+
+            double sum = 0.0;
+            for ( const float ms : sorted )
+            {
+                sum += ms;
+            }
+
+            // nearest rank
+            const auto percentile = [&sorted]( double p ) {
+                const double rank = p * ( sorted.size() - 1 ) + 0.5;
+                return static_cast< double >( sorted[static_cast< size_t >( rank )] );
+            };
+
+            t.average_ms = sum / sorted.size();
+            t.p50_ms     = percentile( 0.50 );
+            t.p95_ms     = percentile( 0.95 );
+            t.p99_ms     = percentile( 0.99 );
+            t.max_ms     = sorted.back();
+        }
+
+        ret.push_back( t );
+    }
+
+    return ret;
+}
@@ -0,0 +1,374 @@
+#include "hiz_pyramid.hpp"
+
+#include "debug.hpp"
+
+#include <algorithm>
+#include <array>
+
+void hiz_pyramid::initialize( VkImage depth_image, VkFormat depth_format,
+                              VkImageLayout depth_layout, VkExtent2D depth_extent )
+{
+    VkFormatProperties props{};
+    vkGetPhysicalDeviceFormatProperties( m_vulkan_data.selected_device, depth_format,
+                                         &props );
+    NEO_ASSERT_ALWAYS( props.optimalTilingFeatures
+                           & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT,
+                       "The depth format can't be sampled, no occlusion culling" );
+
+    m_depth_extent = depth_extent;
+
+    // level 0 is half of the depth buffer
+    m_levels = 1;
+    for ( auto e = level_extent( 0 ); e.width > 1 || e.height > 1;
+          e      = level_extent( m_levels ) )
+    {
+        ++m_levels;
+    }
+
+    create_image();
+    init_descriptor_set_layout();
+    create_descriptor_sets( depth_image, depth_format, depth_layout );
+    init_pipeline();
+}
+
+void hiz_pyramid::deinitialize()
+{
+    destroy_pipeline();
+    destroy_descriptor_sets();
+    destroy_descriptor_set_layout();
+    destroy_image();
+}
+
+VkExtent2D hiz_pyramid::level_extent( uint32_t level ) const
+{
+    VkExtent2D ret = m_depth_extent;
+
+    for ( uint32_t i = 0; i <= level; ++i )
+    {
+        ret = {std::max( ( ret.width + 1 ) / 2, 1u ),
+               std::max( ( ret.height + 1 ) / 2, 1u )};
+    }
+
+    return ret;
+}
+
+void hiz_pyramid::create_image()
+{
+    const VkExtent2D extent = level_extent( 0 );
+
+    VkImageCreateInfo image_create_info = {
+        VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        nullptr,
+        0,
+        VK_IMAGE_TYPE_2D,
+        FORMAT,
+        {extent.width, extent.height, 1},
+        m_levels,
+        1,
+        VK_SAMPLE_COUNT_1_BIT,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+            | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        VK_SHARING_MODE_EXCLUSIVE,
+        0,
+        nullptr,
+        VK_IMAGE_LAYOUT_UNDEFINED};
+
+    auto res = vkCreateImage( m_vulkan_data.logical_device, &image_create_info, nullptr,
+                              &m_image );
+    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Couldn't create image!" );
+
+    VkMemoryRequirements memory_requirements{};
+    vkGetImageMemoryRequirements( m_vulkan_data.logical_device, m_image,
+                                  &memory_requirements );
+
+    VkMemoryAllocateInfo mem_alloc = {
+        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, memory_requirements.size,
+        m_vulkan_data.get_memory_type_idx( memory_requirements.memoryTypeBits,
+                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )};
+
+    res = vkAllocateMemory( m_vulkan_data.logical_device, &mem_alloc, nullptr,
+                            &m_memory );
+    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Can't allocate memory for an image!" );
+
+    res = vkBindImageMemory( m_vulkan_data.logical_device, m_image, m_memory, 0 );
+    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Binding image memory failed" );
+
+    auto create_view = [this]( uint32_t base_level, uint32_t level_count ) {
+        VkImageViewCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            nullptr,
+            0,
+            m_image,
+            VK_IMAGE_VIEW_TYPE_2D,
+            FORMAT,
+            {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+             VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY},
+            {VK_IMAGE_ASPECT_COLOR_BIT, base_level, level_count, 0, 1}};
+
+        VkImageView view = nullptr;
+        const auto res   = vkCreateImageView( m_vulkan_data.logical_device, &create_info,
+                                            nullptr, &view );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Couldn't create image view!" );
+
+        return view;
+    };
+
+    m_image_view = create_view( 0, m_levels );
+
+    m_level_views.resize( m_levels );
+    for ( uint32_t i = 0; i < m_levels; ++i )
+    {
+        m_level_views[i] = create_view( i, 1 );
+    }
+
+    // everything lives in GENERAL from here on, far plane until the first build
+    const VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, m_levels, 0, 1};
+    const VkClearColorValue far_plane = {{1.0f, 1.0f, 1.0f, 1.0f}};
+
+    VkImageMemoryBarrier to_general = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                                       nullptr,
+                                       0,
+                                       VK_ACCESS_TRANSFER_WRITE_BIT,
+                                       VK_IMAGE_LAYOUT_UNDEFINED,
+                                       VK_IMAGE_LAYOUT_GENERAL,
+                                       VK_QUEUE_FAMILY_IGNORED,
+                                       VK_QUEUE_FAMILY_IGNORED,
+                                       m_image,
+                                       range};
+
+    VkImageMemoryBarrier to_compute = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                                       nullptr,
+                                       VK_ACCESS_TRANSFER_WRITE_BIT,
+                                       VK_ACCESS_SHADER_READ_BIT,
+                                       VK_IMAGE_LAYOUT_GENERAL,
+                                       VK_IMAGE_LAYOUT_GENERAL,
+                                       VK_QUEUE_FAMILY_IGNORED,
+                                       VK_QUEUE_FAMILY_IGNORED,
+                                       m_image,
+                                       range};
+
+    VkCommandBuffer cmd = m_vulkan_data.begin_one_time_commands();
+    vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                          &to_general );
+    vkCmdClearColorImage( cmd, m_image, VK_IMAGE_LAYOUT_GENERAL, &far_plane, 1, &range );
+    vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                          1, &to_compute );
+    m_vulkan_data.submit_one_time_commands( cmd );
+}
+
+void hiz_pyramid::destroy_image()
+{
+    for ( auto view : m_level_views )
+    {
+        vkDestroyImageView( m_vulkan_data.logical_device, view, nullptr );
+    }
+
+    m_level_views.clear();
+
+    vkDestroyImageView( m_vulkan_data.logical_device, m_image_view, nullptr );
+    vkDestroyImage( m_vulkan_data.logical_device, m_image, nullptr );
+    vkFreeMemory( m_vulkan_data.logical_device, m_memory, nullptr );
+}
+
+void hiz_pyramid::init_descriptor_set_layout()
+{
+    std::array< VkDescriptorSetLayoutBinding, 2 > bindings = {
+        VkDescriptorSetLayoutBinding{0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr}};
+
+    VkDescriptorSetLayoutCreateInfo create_info{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+        static_cast< uint32_t >( bindings.size() ), bindings.data()};
+
+    const auto res = vkCreateDescriptorSetLayout( m_vulkan_data.logical_device,
+                                                  &create_info, nullptr, &m_set_layout );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor set layout" );
+}
+
+void hiz_pyramid::destroy_descriptor_set_layout()
+{
+    vkDestroyDescriptorSetLayout( m_vulkan_data.logical_device, m_set_layout, nullptr );
+}
+
+void hiz_pyramid::create_descriptor_sets( VkImage depth_image, VkFormat depth_format,
+                                          VkImageLayout depth_layout )
+{
+    {
+        VkImageViewCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            nullptr,
+            0,
+            depth_image,
+            VK_IMAGE_VIEW_TYPE_2D,
+            depth_format,
+            {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+             VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY},
+            {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1}};
+
+        const auto res = vkCreateImageView( m_vulkan_data.logical_device, &create_info,
+                                            nullptr, &m_depth_view );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Couldn't create depth image view!" );
+    }
+
+    {
+        VkSamplerCreateInfo create_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                                        nullptr,
+                                        0,
+                                        VK_FILTER_NEAREST,
+                                        VK_FILTER_NEAREST,
+                                        VK_SAMPLER_MIPMAP_MODE_NEAREST,
+                                        VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                        VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                        VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                        0,
+                                        VK_FALSE,
+                                        0.0f,
+                                        VK_FALSE,
+                                        VK_COMPARE_OP_NEVER,
+                                        0.0,
+                                        static_cast< float >( m_levels ),
+                                        VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+                                        VK_FALSE};
+
+        const auto res = vkCreateSampler( m_vulkan_data.logical_device, &create_info,
+                                          nullptr, &m_sampler );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create image sampler!" );
+    }
+
+    std::array< VkDescriptorPoolSize, 2 > pool_size;
+    pool_size[0] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_levels};
+    pool_size[1] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_levels};
+
+    {
+        VkDescriptorPoolCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            nullptr,
+            0,
+            m_levels,
+            static_cast< uint32_t >( pool_size.size() ),
+            pool_size.data()};
+
+        const auto res = vkCreateDescriptorPool(
+            m_vulkan_data.logical_device, &create_info, nullptr, &m_descriptor_pool );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor pool!" );
+    }
+
+    {
+        std::vector< VkDescriptorSetLayout > layouts( m_levels, m_set_layout );
+        VkDescriptorSetAllocateInfo alloc_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, m_descriptor_pool,
+            m_levels, layouts.data()};
+
+        m_sets.resize( m_levels );
+
+        const auto res = vkAllocateDescriptorSets( m_vulkan_data.logical_device,
+                                                   &alloc_info, m_sets.data() );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't allocate descriptor sets!" );
+    }
+
+    // level i reads the depth buffer or level i - 1
+    for ( uint32_t i = 0; i < m_levels; ++i )
+    {
+        VkDescriptorImageInfo src_info{m_sampler, m_depth_view, depth_layout};
+        if ( i > 0 )
+        {
+            src_info = {m_sampler, m_level_views[i - 1], VK_IMAGE_LAYOUT_GENERAL};
+        }
+
+        VkDescriptorImageInfo dst_info{nullptr, m_level_views[i],
+                                       VK_IMAGE_LAYOUT_GENERAL};
+
+        std::array< VkWriteDescriptorSet, 2 > writes = {
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 0, 0, 1,
+                                 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &src_info,
+                                 nullptr, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 1, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                                 &dst_info, nullptr, nullptr}};
+
+        vkUpdateDescriptorSets( m_vulkan_data.logical_device,
+                                static_cast< uint32_t >( writes.size() ), writes.data(),
+                                0, nullptr );
+    }
+}
+
+void hiz_pyramid::destroy_descriptor_sets()
+{
+    // sets are released together with the pool
+    vkDestroyDescriptorPool( m_vulkan_data.logical_device, m_descriptor_pool, nullptr );
+    vkDestroySampler( m_vulkan_data.logical_device, m_sampler, nullptr );
+    vkDestroyImageView( m_vulkan_data.logical_device, m_depth_view, nullptr );
+    m_sets.clear();
+}
+
+void hiz_pyramid::init_pipeline()
+{
+    const VkPushConstantRange push_range{VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                         sizeof( push_constants )};
+
+    VkPipelineLayoutCreateInfo create_info = {
+        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, nullptr, 0, 1, &m_set_layout, 1,
+        &push_range};
+
+    const auto res = vkCreatePipelineLayout( m_vulkan_data.logical_device, &create_info,
+                                             nullptr, &m_pipeline_layout );
+    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline layout failed" );
+
+    m_pipeline = m_vulkan_data.create_compute_pipeline( "generated/hiz_reduce.comp.spirv",
+                                                        m_pipeline_layout );
+}
+
+void hiz_pyramid::destroy_pipeline()
+{
+    vkDestroyPipeline( m_vulkan_data.logical_device, m_pipeline, nullptr );
+    vkDestroyPipelineLayout( m_vulkan_data.logical_device, m_pipeline_layout, nullptr );
+}
+
+void hiz_pyramid::record( VkCommandBuffer cmd )
+{
+    auto level_barrier = [this, cmd]( uint32_t base_level, uint32_t level_count,
+                                      VkAccessFlags src_access ) {
+        VkImageMemoryBarrier barrier = {
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            nullptr,
+            src_access,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            m_image,
+            {VK_IMAGE_ASPECT_COLOR_BIT, base_level, level_count, 0, 1}};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                              nullptr, 1, &barrier );
+    };
+
+    // culling might still be reading the previous pyramid
+    level_barrier( 0, m_levels, VK_ACCESS_SHADER_READ_BIT );
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline );
+
+    for ( uint32_t i = 0; i < m_levels; ++i )
+    {
+        const VkExtent2D e = level_extent( i );
+        const push_constants pc{
+            {static_cast< int32_t >( e.width ), static_cast< int32_t >( e.height )}};
+
+        vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout,
+                                 0, 1, &m_sets[i], 0, nullptr );
+        vkCmdPushConstants( cmd, m_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                            sizeof( push_constants ), &pc );
+        vkCmdDispatch( cmd, ( e.width + GROUP_SIZE - 1 ) / GROUP_SIZE,
+                       ( e.height + GROUP_SIZE - 1 ) / GROUP_SIZE, 1 );
+
+        level_barrier( i, 1, VK_ACCESS_SHADER_WRITE_BIT );
+    }
+}
@@ -2,6 +2,7 @@
 
 #include <cstring>
 
+#include "cpu_profiler.hpp"
 #include "debug.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -9,6 +10,8 @@
 
 image load_image( const char* file_name )
 {
+    PROFILE_SCOPE( "load_image" );
+
     image ret{};
 
     stbi_uc* pixels =
@@ -0,0 +1,545 @@
+#include "image_filter.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined( __SSE__ ) || defined( _M_X64 )
+#include <xmmintrin.h>
+#define NEO_IMAGE_FILTER_SSE 1
+#endif
+
+void image_filter::initialize( VkImageView input_view, VkImageLayout input_layout,
+                               VkExtent2D extent, const settings& s )
+{
+    NEO_ASSERT_ALWAYS( s.blur_radius > 0 && s.blur_radius <= MAX_BLUR_RADIUS,
+                       "Blur radius out of range: ", s.blur_radius );
+    NEO_ASSERT_ALWAYS( s.bloom_levels > 0 && s.bloom_levels <= MAX_BLOOM_LEVELS,
+                       "Bloom level count out of range: ", s.bloom_levels );
+
+    m_settings = s;
+    m_extent   = extent;
+
+    create_images();
+    init_descriptor_set_layout();
+    create_descriptor_sets( input_view, input_layout );
+    init_pipelines();
+}
+
+void image_filter::deinitialize()
+{
+    destroy_pipelines();
+    destroy_descriptor_sets();
+    destroy_descriptor_set_layout();
+    destroy_images();
+}
+
+void image_filter::create_images()
+{
+    const VkImageUsageFlags usage =
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+        | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    m_blur_temp   = m_vulkan_data.create_image_2d( m_extent, FORMAT, usage );
+    m_blur_output = m_vulkan_data.create_image_2d( m_extent, FORMAT, usage );
+
+    m_bloom_levels.resize( m_settings.bloom_levels );
+
+    VkExtent2D level_extent = m_extent;
+    for ( auto& level : m_bloom_levels )
+    {
+        level_extent = {std::max( ( level_extent.width + 1 ) / 2, 1u ),
+                        std::max( ( level_extent.height + 1 ) / 2, 1u )};
+        level        = m_vulkan_data.create_image_2d( level_extent, FORMAT, usage );
+    }
+
+    // everything lives in GENERAL from here on
+    std::vector< VkImageMemoryBarrier > barriers;
+
+    auto add_barrier = [&barriers]( VkImage image ) {
+        barriers.push_back( {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                             nullptr,
+                             0,
+                             VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                             VK_IMAGE_LAYOUT_UNDEFINED,
+                             VK_IMAGE_LAYOUT_GENERAL,
+                             VK_QUEUE_FAMILY_IGNORED,
+                             VK_QUEUE_FAMILY_IGNORED,
+                             image,
+                             {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}} );
+    };
+
+    add_barrier( m_blur_temp.image );
+    add_barrier( m_blur_output.image );
+
+    for ( const auto& level : m_bloom_levels )
+    {
+        add_barrier( level.image );
+    }
+
+    VkCommandBuffer cmd = m_vulkan_data.begin_one_time_commands();
+    vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                          static_cast< uint32_t >( barriers.size() ), barriers.data() );
+    m_vulkan_data.submit_one_time_commands( cmd );
+}
+
+void image_filter::destroy_images()
+{
+    for ( auto& level : m_bloom_levels )
+    {
+        m_vulkan_data.destroy_image( level );
+    }
+
+    m_bloom_levels.clear();
+
+    m_vulkan_data.destroy_image( m_blur_output );
+    m_vulkan_data.destroy_image( m_blur_temp );
+}
+
+void image_filter::init_descriptor_set_layout()
+{
+    // every pass reads one image through a sampler and writes one storage image
+    std::array< VkDescriptorSetLayoutBinding, 2 > bindings = {
+        VkDescriptorSetLayoutBinding{0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr}};
+
+    VkDescriptorSetLayoutCreateInfo create_info{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+        static_cast< uint32_t >( bindings.size() ), bindings.data()};
+
+    const auto res = vkCreateDescriptorSetLayout( m_vulkan_data.logical_device,
+                                                  &create_info, nullptr, &m_set_layout );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor set layout" );
+}
+
+void image_filter::destroy_descriptor_set_layout()
+{
+    vkDestroyDescriptorSetLayout( m_vulkan_data.logical_device, m_set_layout, nullptr );
+}
+
+void image_filter::create_descriptor_sets( VkImageView input_view,
+                                           VkImageLayout input_layout )
+{
+    auto create_sampler = [this]( VkFilter filter, VkSampler* sampler ) {
+        VkSamplerCreateInfo create_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                                        nullptr,
+                                        0,
+                                        filter,
+                                        filter,
+                                        VK_SAMPLER_MIPMAP_MODE_NEAREST,
+                                        VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                        VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                        VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                        0,
+                                        VK_FALSE,
+                                        0.0f,
+                                        VK_FALSE,
+                                        VK_COMPARE_OP_NEVER,
+                                        0.0,
+                                        0.0,
+                                        VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+                                        VK_FALSE};
+
+        const auto res = vkCreateSampler( m_vulkan_data.logical_device, &create_info,
+                                          nullptr, sampler );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create image sampler!" );
+    };
+
+    create_sampler( VK_FILTER_NEAREST, &m_point_sampler );
+    create_sampler( VK_FILTER_LINEAR, &m_linear_sampler );
+
+    const uint32_t levels = m_settings.bloom_levels;
+
+    // 2 blur passes, one downsample per level and one upsample per level but the last
+    const uint32_t set_count = 2 + levels + ( levels - 1 );
+
+    std::array< VkDescriptorPoolSize, 2 > pool_size;
+    pool_size[0] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, set_count};
+    pool_size[1] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, set_count};
+
+    {
+        VkDescriptorPoolCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            nullptr,
+            0,
+            set_count,
+            static_cast< uint32_t >( pool_size.size() ),
+            pool_size.data()};
+
+        const auto res = vkCreateDescriptorPool(
+            m_vulkan_data.logical_device, &create_info, nullptr, &m_descriptor_pool );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor pool!" );
+    }
+
+    std::vector< VkDescriptorSet > sets( set_count );
+
+    {
+        std::vector< VkDescriptorSetLayout > layouts( set_count, m_set_layout );
+        VkDescriptorSetAllocateInfo alloc_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, m_descriptor_pool,
+            set_count, layouts.data()};
+
+        const auto res = vkAllocateDescriptorSets( m_vulkan_data.logical_device,
+                                                   &alloc_info, sets.data() );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't allocate descriptor sets!" );
+    }
+
+    m_blur_h_set = sets[0];
+    m_blur_v_set = sets[1];
+    m_downsample_sets.assign( sets.begin() + 2, sets.begin() + 2 + levels );
+    m_upsample_sets.assign( sets.begin() + 2 + levels, sets.end() );
+
+    auto write_set = [this]( VkDescriptorSet set, VkSampler sampler, VkImageView src,
+                             VkImageLayout src_layout, VkImageView dst ) {
+        VkDescriptorImageInfo src_info{sampler, src, src_layout};
+        VkDescriptorImageInfo dst_info{nullptr, dst, VK_IMAGE_LAYOUT_GENERAL};
+
+        std::array< VkWriteDescriptorSet, 2 > writes = {
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, 0,
+                                 0, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                 &src_info, nullptr, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, 1,
+                                 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &dst_info,
+                                 nullptr, nullptr}};
+
+        vkUpdateDescriptorSets( m_vulkan_data.logical_device,
+                                static_cast< uint32_t >( writes.size() ), writes.data(),
+                                0, nullptr );
+    };
+
+    write_set( m_blur_h_set, m_point_sampler, input_view, input_layout,
+               m_blur_temp.image_view );
+    write_set( m_blur_v_set, m_point_sampler, m_blur_temp.image_view,
+               VK_IMAGE_LAYOUT_GENERAL, m_blur_output.image_view );
+
+    for ( uint32_t i = 0; i < levels; ++i )
+    {
+        const bool first = i == 0;
+        write_set( m_downsample_sets[i], m_point_sampler,
+                   first ? input_view : m_bloom_levels[i - 1].image_view,
+                   first ? input_layout : VK_IMAGE_LAYOUT_GENERAL,
+                   m_bloom_levels[i].image_view );
+    }
+
+    for ( uint32_t i = 0; i + 1 < levels; ++i )
+    {
+        write_set( m_upsample_sets[i], m_linear_sampler, m_bloom_levels[i + 1].image_view,
+                   VK_IMAGE_LAYOUT_GENERAL, m_bloom_levels[i].image_view );
+    }
+}
+
+void image_filter::destroy_descriptor_sets()
+{
+    // sets are released together with the pool
+    vkDestroyDescriptorPool( m_vulkan_data.logical_device, m_descriptor_pool, nullptr );
+    vkDestroySampler( m_vulkan_data.logical_device, m_linear_sampler, nullptr );
+    vkDestroySampler( m_vulkan_data.logical_device, m_point_sampler, nullptr );
+    m_downsample_sets.clear();
+    m_upsample_sets.clear();
+}
+
+void image_filter::init_pipelines()
+{
+    auto create_layout = [this]( uint32_t push_constants_size,
+                                 VkPipelineLayout* layout ) {
+        const VkPushConstantRange push_range{VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                             push_constants_size};
+
+        VkPipelineLayoutCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &m_set_layout,
+            1,
+            &push_range};
+
+        const auto res = vkCreatePipelineLayout( m_vulkan_data.logical_device,
+                                                 &create_info, nullptr, layout );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline layout failed" );
+    };
+
+    create_layout( sizeof( blur_push_constants ), &m_blur_pipeline_layout );
+    create_layout( sizeof( bloom_push_constants ), &m_bloom_pipeline_layout );
+
+    const int32_t radius = static_cast< int32_t >( m_settings.blur_radius );
+    const VkSpecializationMapEntry radius_entry{0, 0, sizeof( int32_t )};
+    const VkSpecializationInfo specialization{1, &radius_entry, sizeof( int32_t ),
+                                              &radius};
+
+    m_blur_pipeline = m_vulkan_data.create_compute_pipeline(
+        "generated/blur_separable.comp.spirv", m_blur_pipeline_layout, &specialization );
+    m_downsample_pipeline = m_vulkan_data.create_compute_pipeline(
+        "generated/bloom_downsample.comp.spirv", m_bloom_pipeline_layout );
+    m_upsample_pipeline = m_vulkan_data.create_compute_pipeline(
+        "generated/bloom_upsample.comp.spirv", m_bloom_pipeline_layout );
+}
+
+void image_filter::destroy_pipelines()
+{
+    vkDestroyPipeline( m_vulkan_data.logical_device, m_blur_pipeline, nullptr );
+    vkDestroyPipeline( m_vulkan_data.logical_device, m_downsample_pipeline, nullptr );
+    vkDestroyPipeline( m_vulkan_data.logical_device, m_upsample_pipeline, nullptr );
+    vkDestroyPipelineLayout( m_vulkan_data.logical_device, m_blur_pipeline_layout,
+                             nullptr );
+    vkDestroyPipelineLayout( m_vulkan_data.logical_device, m_bloom_pipeline_layout,
+                             nullptr );
+}
+
+void image_filter::general_image_barrier( VkCommandBuffer cmd, VkImage image )
+{
+    VkImageMemoryBarrier barrier = {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        nullptr,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        image,
+        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+
+    vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                          1, &barrier );
+}
+
+void image_filter::record_blur( VkCommandBuffer cmd )
+{
+    record_blur_horizontal( cmd );
+    record_blur_vertical( cmd );
+}
+
+void image_filter::record_blur_horizontal( VkCommandBuffer cmd )
+{
+    const blur_push_constants pc{{1, 0},
+                                 {static_cast< int32_t >( m_extent.width ),
+                                  static_cast< int32_t >( m_extent.height )},
+                                 m_settings.blur_sigma};
+
+    // a previous vertical pass might still be reading the temporary image
+    general_image_barrier( cmd, m_blur_temp.image );
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_blur_pipeline );
+    vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_blur_pipeline_layout,
+                             0, 1, &m_blur_h_set, 0, nullptr );
+    vkCmdPushConstants( cmd, m_blur_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                        sizeof( blur_push_constants ), &pc );
+    vkCmdDispatch( cmd, ( m_extent.width + BLUR_TILE_SIZE - 1 ) / BLUR_TILE_SIZE,
+                   m_extent.height, 1 );
+}
+
+void image_filter::record_blur_vertical( VkCommandBuffer cmd )
+{
+    const blur_push_constants pc{{0, 1},
+                                 {static_cast< int32_t >( m_extent.width ),
+                                  static_cast< int32_t >( m_extent.height )},
+                                 m_settings.blur_sigma};
+
+    general_image_barrier( cmd, m_blur_temp.image );
+    general_image_barrier( cmd, m_blur_output.image );
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_blur_pipeline );
+    vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_blur_pipeline_layout,
+                             0, 1, &m_blur_v_set, 0, nullptr );
+    vkCmdPushConstants( cmd, m_blur_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                        sizeof( blur_push_constants ), &pc );
+    vkCmdDispatch( cmd, ( m_extent.height + BLUR_TILE_SIZE - 1 ) / BLUR_TILE_SIZE,
+                   m_extent.width, 1 );
+}
+
+void image_filter::record_bloom( VkCommandBuffer cmd )
+{
+    const uint32_t levels = m_settings.bloom_levels;
+
+    auto dispatch = [this, cmd]( VkExtent2D e, float threshold ) {
+        const bloom_push_constants pc{
+            {static_cast< int32_t >( e.width ), static_cast< int32_t >( e.height )},
+            threshold};
+
+        vkCmdPushConstants( cmd, m_bloom_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                            sizeof( bloom_push_constants ), &pc );
+        vkCmdDispatch( cmd, ( e.width + BLOOM_GROUP_SIZE - 1 ) / BLOOM_GROUP_SIZE,
+                       ( e.height + BLOOM_GROUP_SIZE - 1 ) / BLOOM_GROUP_SIZE, 1 );
+    };
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_downsample_pipeline );
+
+    for ( uint32_t i = 0; i < levels; ++i )
+    {
+        if ( i > 0 )
+        {
+            general_image_barrier( cmd, m_bloom_levels[i - 1].image );
+        }
+
+        general_image_barrier( cmd, m_bloom_levels[i].image );
+
+        vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                 m_bloom_pipeline_layout, 0, 1, &m_downsample_sets[i], 0,
+                                 nullptr );
+        dispatch( m_bloom_levels[i].extent, i == 0 ? m_settings.bloom_threshold : -1.0f );
+    }
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_upsample_pipeline );
+
+    // walk back up, each level accumulates the already upsampled level below it
+    for ( uint32_t i = levels - 1; i-- > 0; )
+    {
+        general_image_barrier( cmd, m_bloom_levels[i + 1].image );
+
+        vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                 m_bloom_pipeline_layout, 0, 1, &m_upsample_sets[i], 0,
+                                 nullptr );
+        dispatch( m_bloom_levels[i].extent, -1.0f );
+    }
+}
+
+std::vector< float > gaussian_weights( uint32_t radius, float sigma )
+{
+    // same order of operations as blur_separable.comp
+    std::vector< float > weights( radius + 1 );
+
+    float sum = 0.0f;
+
+    for ( uint32_t i = 0; i <= radius; ++i )
+    {
+        weights[i] =
+            std::exp( -static_cast< float >( i * i ) / ( 2.0f * sigma * sigma ) );
+        sum += ( i == 0 ) ? weights[i] : 2.0f * weights[i];
+    }
+
+    for ( auto& w : weights )
+    {
+        w /= sum;
+    }
+
+    return weights;
+}
+
+namespace
+{
+    // out = sum of weights[|i|] * src[clamp( x + i )] along one axis, stride is in
+    // pixels between two neighbours on that axis
+    void blur_line( const float* src, float* dst, int32_t count, int32_t stride,
+                    const std::vector< float >& weights )
+    {
+        const int32_t radius = static_cast< int32_t >( weights.size() ) - 1;
+
+        for ( int32_t x = 0; x < count; ++x )
+        {
+            auto tap = [&]( int32_t i ) {
+                return src + std::clamp( x + i, 0, count - 1 ) * stride * 4;
+            };
+
+#ifdef NEO_IMAGE_FILTER_SSE
+            __m128 acc =
+                _mm_mul_ps( _mm_loadu_ps( tap( 0 ) ), _mm_set1_ps( weights[0] ) );
+
+            for ( int32_t i = 1; i <= radius; ++i )
+            {
+                const __m128 pair =
+                    _mm_add_ps( _mm_loadu_ps( tap( -i ) ), _mm_loadu_ps( tap( i ) ) );
+                acc = _mm_add_ps( acc, _mm_mul_ps( pair, _mm_set1_ps( weights[i] ) ) );
+            }
+
+            _mm_storeu_ps( dst + x * stride * 4, acc );
+#else
+            for ( int32_t c = 0; c < 4; ++c )
+            {
+                float acc = tap( 0 )[c] * weights[0];
+
+                for ( int32_t i = 1; i <= radius; ++i )
+                {
+                    acc += ( tap( -i )[c] + tap( i )[c] ) * weights[i];
+                }
+
+                dst[x * stride * 4 + c] = acc;
+            }
+#endif
+        }
+    }
+} // namespace
+
+void blur_reference( const float* rgba, int32_t width, int32_t height, uint32_t radius,
+                     float sigma, float* out )
+{
+    const auto weights = gaussian_weights( radius, sigma );
+
+    std::vector< float > temp( static_cast< size_t >( width ) * height * 4 );
+
+    for ( int32_t y = 0; y < height; ++y )
+    {
+        const size_t row = static_cast< size_t >( y ) * width * 4;
+        blur_line( rgba + row, temp.data() + row, width, 1, weights );
+    }
+
+    for ( int32_t x = 0; x < width; ++x )
+    {
+        blur_line( temp.data() + x * 4, out + x * 4, height, width, weights );
+    }
+}
+
+void bloom_downsample_reference( const float* rgba, int32_t width, int32_t height,
+                                 float threshold, float* out )
+{
+    const int32_t dst_width  = std::max( ( width + 1 ) / 2, 1 );
+    const int32_t dst_height = std::max( ( height + 1 ) / 2, 1 );
+
+    const float weights[4] = {1.0f, 3.0f, 3.0f, 1.0f};
+
+    auto fetch = [&]( int32_t x, int32_t y, float* c ) {
+        const float* p = rgba
+                         + ( std::clamp( y, 0, height - 1 ) * width
+                             + std::clamp( x, 0, width - 1 ) )
+                               * 4;
+        std::memcpy( c, p, 4 * sizeof( float ) );
+
+        if ( threshold >= 0.0f )
+        {
+            const float brightness = std::max( c[0], std::max( c[1], c[2] ) );
+            const float scale = std::max( brightness - threshold, 0.0f )
+                                / std::max( brightness, 0.0001f );
+
+            for ( int32_t i = 0; i < 4; ++i )
+            {
+                c[i] *= scale;
+            }
+        }
+    };
+
+    for ( int32_t y = 0; y < dst_height; ++y )
+    {
+        for ( int32_t x = 0; x < dst_width; ++x )
+        {
+            float acc[4] = {};
+
+            for ( int32_t ty = 0; ty < 4; ++ty )
+            {
+                for ( int32_t tx = 0; tx < 4; ++tx )
+                {
+                    float c[4];
+                    fetch( x * 2 - 1 + tx, y * 2 - 1 + ty, c );
+
+                    const float w = weights[tx] * weights[ty];
+
+                    for ( int32_t i = 0; i < 4; ++i )
+                    {
+                        acc[i] += c[i] * w;
+                    }
+                }
+            }
+
+            for ( int32_t i = 0; i < 4; ++i )
+            {
+                out[( y * dst_width + x ) * 4 + i] = acc[i] * ( 1.0f / 64.0f );
+            }
+        }
+    }
+}
@@ -0,0 +1,553 @@
+#include "instance_culling.hpp"
+
+#include "debug.hpp"
+#include "mesh_lod.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+void instance_culling::initialize( const instance_scene& scene,
+                                   const hiz_pyramid& pyramid,
+                                   const std::vector< lod_level >& lods,
+                                   int32_t vertex_offset, uint32_t frame_count )
+{
+    NEO_ASSERT_ALWAYS( !lods.empty() && lods.size() <= MAX_LODS,
+                       "Unsupported number of LODs: ", lods.size() );
+
+    m_max_instances  = scene.capacity();
+    m_lods           = lods;
+    m_vertex_offset  = vertex_offset;
+    m_depth_extent   = pyramid.depth_extent();
+    m_pyramid_levels = pyramid.levels();
+
+    m_has_previous_view = false;
+
+    create_buffers( frame_count );
+    init_descriptor_set_layout();
+    create_descriptor_sets( scene, pyramid, frame_count );
+    init_pipelines();
+}
+
+void instance_culling::set_mesh( const std::vector< lod_level >& lods,
+                                 int32_t vertex_offset )
+{
+    // the transforms have a region per LOD, their number is fixed
+    NEO_ASSERT_ALWAYS( lods.size() == m_lods.size(), "Expected ", m_lods.size(),
+                       " LODs, got ", lods.size() );
+
+    m_lods          = lods;
+    m_vertex_offset = vertex_offset;
+}
+
+void instance_culling::deinitialize()
+{
+    destroy_pipelines();
+    destroy_descriptor_sets();
+    destroy_descriptor_set_layout();
+    destroy_buffers();
+}
+
+void instance_culling::create_buffers( uint32_t frame_count )
+{
+    // a region per LOD, any instance may end up in any of them
+    const auto transforms_size = static_cast< VkDeviceSize >( m_max_instances )
+                                 * m_lods.size() * sizeof( glm::mat4 );
+
+    m_early_transforms = m_vulkan_data.create_buffer(
+        transforms_size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    m_late_transforms = m_vulkan_data.create_buffer(
+        transforms_size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    m_candidates = m_vulkan_data.create_buffer(
+        static_cast< VkDeviceSize >( m_max_instances ) * sizeof( uint32_t ),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    m_state = m_vulkan_data.create_buffer(
+        sizeof( cull_state ),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+            | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    m_frame_params.resize( frame_count );
+    m_readback.resize( frame_count );
+    m_frame_instances.assign( frame_count, 0 );
+
+    auto fill = [this]( const buffer_data& b, const void* src, size_t size ) {
+        void* data     = nullptr;
+        const auto res = vkMapMemory( m_vulkan_data.logical_device, b.memory, 0, size, 0,
+                                      &data );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map culling memory!" );
+        memcpy( data, src, size );
+        vkUnmapMemory( m_vulkan_data.logical_device, b.memory );
+    };
+
+    for ( uint32_t i = 0; i < frame_count; ++i )
+    {
+        m_frame_params[i] = m_vulkan_data.create_buffer(
+            sizeof( frame_params ), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+        m_readback[i] = m_vulkan_data.create_buffer(
+            sizeof( cull_state ), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+        // nothing is drawn until the first update(), and nothing was culled
+        const frame_params params{};
+        const cull_state state{};
+
+        fill( m_frame_params[i], &params, sizeof( frame_params ) );
+        fill( m_readback[i], &state, sizeof( cull_state ) );
+    }
+}
+
+void instance_culling::destroy_buffers()
+{
+    for ( auto& b : m_readback )
+    {
+        m_vulkan_data.destroy_buffer( b );
+    }
+
+    for ( auto& fp : m_frame_params )
+    {
+        m_vulkan_data.destroy_buffer( fp );
+    }
+
+    m_readback.clear();
+    m_frame_params.clear();
+    m_frame_instances.clear();
+
+    m_vulkan_data.destroy_buffer( m_state );
+    m_vulkan_data.destroy_buffer( m_candidates );
+    m_vulkan_data.destroy_buffer( m_late_transforms );
+    m_vulkan_data.destroy_buffer( m_early_transforms );
+}
+
+void instance_culling::init_descriptor_set_layout()
+{
+    std::array< VkDescriptorSetLayoutBinding, 8 > bindings = {
+        VkDescriptorSetLayoutBinding{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{7, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr}};
+
+    VkDescriptorSetLayoutCreateInfo create_info{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+        static_cast< uint32_t >( bindings.size() ), bindings.data()};
+
+    const auto res = vkCreateDescriptorSetLayout( m_vulkan_data.logical_device,
+                                                  &create_info, nullptr, &m_set_layout );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor set layout" );
+}
+
+void instance_culling::destroy_descriptor_set_layout()
+{
+    vkDestroyDescriptorSetLayout( m_vulkan_data.logical_device, m_set_layout, nullptr );
+}
+
+void instance_culling::create_descriptor_sets( const instance_scene& scene,
+                                               const hiz_pyramid& pyramid,
+                                               uint32_t frame_count )
+{
+    std::array< VkDescriptorPoolSize, 3 > pool_size;
+    pool_size[0] = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frame_count};
+    pool_size[1] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6 * frame_count};
+    pool_size[2] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frame_count};
+
+    {
+        VkDescriptorPoolCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            nullptr,
+            0,
+            frame_count,
+            static_cast< uint32_t >( pool_size.size() ),
+            pool_size.data()};
+
+        const auto res = vkCreateDescriptorPool(
+            m_vulkan_data.logical_device, &create_info, nullptr, &m_descriptor_pool );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor pool!" );
+    }
+
+    {
+        std::vector< VkDescriptorSetLayout > layouts( frame_count, m_set_layout );
+        VkDescriptorSetAllocateInfo alloc_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, m_descriptor_pool,
+            frame_count, layouts.data()};
+
+        m_sets.resize( frame_count );
+
+        const auto res = vkAllocateDescriptorSets( m_vulkan_data.logical_device,
+                                                   &alloc_info, m_sets.data() );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't allocate descriptor sets!" );
+    }
+
+    VkDescriptorBufferInfo early_info{m_early_transforms.buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo late_info{m_late_transforms.buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo state_info{m_state.buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo candidates_info{m_candidates.buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorImageInfo pyramid_info{pyramid.sampler(), pyramid.image_view(),
+                                       VK_IMAGE_LAYOUT_GENERAL};
+
+    for ( auto i = 0u; i < frame_count; ++i )
+    {
+        VkDescriptorBufferInfo frame_info{m_frame_params[i].buffer, 0,
+                                          sizeof( frame_params )};
+        VkDescriptorBufferInfo transforms_info{scene.transform_buffer( i ), 0,
+                                               VK_WHOLE_SIZE};
+        VkDescriptorBufferInfo bounds_info{scene.bounds_buffer( i ), 0, VK_WHOLE_SIZE};
+
+        std::array< VkWriteDescriptorSet, 8 > writes = {
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 0, 0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                 nullptr, &frame_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 1, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                 nullptr, &transforms_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 2, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                 nullptr, &bounds_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 3, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                 nullptr, &early_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 4, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                 nullptr, &late_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 5, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                 nullptr, &state_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 6, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                 nullptr, &candidates_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 7, 0, 1,
+                                 VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &pyramid_info,
+                                 nullptr, nullptr}};
+
+        vkUpdateDescriptorSets( m_vulkan_data.logical_device,
+                                static_cast< uint32_t >( writes.size() ), writes.data(),
+                                0, nullptr );
+    }
+}
+
+void instance_culling::destroy_descriptor_sets()
+{
+    // sets are released together with the pool
+    vkDestroyDescriptorPool( m_vulkan_data.logical_device, m_descriptor_pool, nullptr );
+    m_sets.clear();
+}
+
+void instance_culling::init_pipelines()
+{
+    VkPipelineLayoutCreateInfo create_info = {
+        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, nullptr, 0, 1, &m_set_layout, 0,
+        nullptr};
+
+    const auto res = vkCreatePipelineLayout( m_vulkan_data.logical_device, &create_info,
+                                             nullptr, &m_pipeline_layout );
+    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline layout failed" );
+
+    const VkSpecializationMapEntry entry{0, 0, sizeof( uint32_t )};
+
+    for ( uint32_t phase = 0; phase < m_pipelines.size(); ++phase )
+    {
+        const VkSpecializationInfo specialization{1, &entry, sizeof( uint32_t ), &phase};
+        m_pipelines[phase] = m_vulkan_data.create_compute_pipeline(
+            "generated/instance_cull.comp.spirv", m_pipeline_layout, &specialization );
+    }
+}
+
+void instance_culling::destroy_pipelines()
+{
+    for ( auto pipeline : m_pipelines )
+    {
+        vkDestroyPipeline( m_vulkan_data.logical_device, pipeline, nullptr );
+    }
+
+    vkDestroyPipelineLayout( m_vulkan_data.logical_device, m_pipeline_layout, nullptr );
+}
+
+void instance_culling::update( uint32_t frame_idx, const glm::mat4& view,
+                               const glm::mat4& proj, uint32_t instance_count )
+{
+    static_assert( offsetof( frame_params, projection ) == 224
+                       && offsetof( frame_params, pyramid_levels ) == 256
+                       && offsetof( frame_params, lod_errors ) == 272,
+                   "frame_params has to match the std140 block of instance_cull.comp" );
+
+    NEO_ASSERT_ALWAYS( instance_count <= m_max_instances, "Too many instances to cull" );
+
+    if ( !m_has_previous_view )
+    {
+        m_previous_view     = view;
+        m_has_previous_view = true;
+    }
+
+    std::array< float, MAX_LODS > lod_errors = {};
+    for ( size_t l = 0; l < m_lods.size(); ++l )
+    {
+        lod_errors[l] = m_lods[l].error;
+    }
+
+    // depth = P22 + P32 / z for a left handed, zero to one projection
+    const frame_params params{
+        extract_frustum_planes( proj * view ),
+        view,
+        m_previous_view,
+        glm::vec4( proj[0][0], proj[1][1], proj[2][2], proj[3][2] ),
+        glm::vec2( m_depth_extent.width, m_depth_extent.height ),
+        -proj[3][2] / proj[2][2],
+        instance_count,
+        m_pyramid_levels,
+        static_cast< uint32_t >( m_lods.size() ),
+        lod_error_scale( proj, static_cast< float >( m_depth_extent.height ),
+                         m_lod_threshold ),
+        m_max_instances,
+        lod_errors};
+
+    m_previous_view              = view;
+    m_frame_instances[frame_idx] = instance_count;
+
+    void* data     = nullptr;
+    const auto res = vkMapMemory( m_vulkan_data.logical_device,
+                                  m_frame_params[frame_idx].memory, 0,
+                                  sizeof( frame_params ), 0, &data );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map frame params memory!" );
+    memcpy( data, &params, sizeof( frame_params ) );
+    vkUnmapMemory( m_vulkan_data.logical_device, m_frame_params[frame_idx].memory );
+}
+
+void instance_culling::dispatch( VkCommandBuffer cmd, uint32_t frame_idx, uint32_t phase )
+{
+    // the instance and candidate counts live on the GPU, covering the capacity keeps the
+    // dispatch static
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelines[phase] );
+    vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1,
+                             &m_sets[frame_idx], 0, nullptr );
+    vkCmdDispatch( cmd, ( m_max_instances + WORKGROUP_SIZE - 1 ) / WORKGROUP_SIZE, 1, 1 );
+}
+
+void instance_culling::record_early( VkCommandBuffer cmd, uint32_t frame_idx )
+{
+    // the previous frame might still be drawing from the outputs or copying the state
+    {
+        const VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+                                      VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+                                          | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+                                          | VK_ACCESS_TRANSFER_READ_BIT
+                                          | VK_ACCESS_SHADER_READ_BIT,
+                                      VK_ACCESS_TRANSFER_WRITE_BIT
+                                          | VK_ACCESS_SHADER_WRITE_BIT};
+
+        vkCmdPipelineBarrier( cmd,
+                              VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+                                  | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                                  | VK_PIPELINE_STAGE_TRANSFER_BIT
+                                  | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT
+                                  | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              0, 1, &barrier, 0, nullptr, 0, nullptr );
+    }
+
+    // no instances yet, draws of LODs the mesh doesn't have stay empty
+    cull_state initial_state{};
+    for ( uint32_t phase = 0; phase < 2; ++phase )
+    {
+        for ( size_t l = 0; l < m_lods.size(); ++l )
+        {
+            initial_state.draws[phase * MAX_LODS + l] = {
+                m_lods[l].index_count, 0, m_lods[l].first_index, m_vertex_offset, 0};
+        }
+    }
+
+    vkCmdUpdateBuffer( cmd, m_state.buffer, 0, sizeof( initial_state ), &initial_state );
+
+    {
+        const VkBufferMemoryBarrier barrier = {
+            VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            nullptr,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            m_state.buffer,
+            0,
+            VK_WHOLE_SIZE};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1,
+                              &barrier, 0, nullptr );
+    }
+
+    dispatch( cmd, frame_idx, 0 );
+
+    // the late phase reads the candidates, the draw the early list
+    {
+        const VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+                                      VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+                                          | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+                                          | VK_ACCESS_SHADER_READ_BIT
+                                          | VK_ACCESS_SHADER_WRITE_BIT};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+                                  | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                                  | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              0, 1, &barrier, 0, nullptr, 0, nullptr );
+    }
+}
+
+void instance_culling::record_late( VkCommandBuffer cmd, uint32_t frame_idx )
+{
+    dispatch( cmd, frame_idx, 1 );
+
+    {
+        const VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+                                      VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+                                          | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+                                          | VK_ACCESS_TRANSFER_READ_BIT};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+                                  | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                                  | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              0, 1, &barrier, 0, nullptr, 0, nullptr );
+    }
+
+    // the counts of both phases for read_stats()
+    const VkBufferCopy region{0, 0, sizeof( cull_state )};
+    vkCmdCopyBuffer( cmd, m_state.buffer, m_readback[frame_idx].buffer, 1, &region );
+
+    {
+        const VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+                                      VK_ACCESS_TRANSFER_WRITE_BIT,
+                                      VK_ACCESS_HOST_READ_BIT};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0,
+                              nullptr );
+    }
+}
+
+draw_item instance_culling::draw( VkBuffer transforms, uint32_t phase,
+                                  uint32_t lod ) const
+{
+    NEO_ASSERT_ALWAYS( lod < m_lods.size(), "LOD ", lod, " out of range" );
+
+    // without multiDrawIndirect every LOD is its own draw, the transforms of each one
+    // start at their own offset
+    draw_item item{};
+    item.instances       = transforms;
+    item.instance_offset = static_cast< VkDeviceSize >( lod ) * m_max_instances
+                           * sizeof( glm::mat4 );
+    item.indirect        = m_state.buffer;
+    item.indirect_offset = offsetof( cull_state, draws )
+                           + ( phase * MAX_LODS + lod )
+                                 * sizeof( VkDrawIndexedIndirectCommand );
+
+    return item;
+}
+
+draw_item instance_culling::early_draw( uint32_t lod ) const
+{
+    return draw( m_early_transforms.buffer, 0, lod );
+}
+
+draw_item instance_culling::late_draw( uint32_t lod ) const
+{
+    return draw( m_late_transforms.buffer, 1, lod );
+}
+
+instance_cull_stats instance_culling::read_stats( uint32_t frame_idx ) const
+{
+    cull_state state{};
+
+    void* data     = nullptr;
+    const auto res = vkMapMemory( m_vulkan_data.logical_device,
+                                  m_readback[frame_idx].memory, 0, sizeof( cull_state ),
+                                  0, &data );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map culling stats memory!" );
+    memcpy( &state, data, sizeof( cull_state ) );
+    vkUnmapMemory( m_vulkan_data.logical_device, m_readback[frame_idx].memory );
+
+    instance_cull_stats ret{};
+    ret.instances = m_frame_instances[frame_idx];
+
+    for ( size_t l = 0; l < m_lods.size(); ++l )
+    {
+        const auto& early = state.draws[l];
+        const auto& late  = state.draws[MAX_LODS + l];
+
+        ret.visible_early += early.instanceCount;
+        ret.visible_late += late.instanceCount;
+        ret.triangles += uint64_t{early.instanceCount + late.instanceCount}
+                         * m_lods[l].index_count / 3;
+    }
+
+    ret.occluded       = state.occlusion_candidates - ret.visible_late;
+    ret.frustum_culled = ret.instances - ret.visible_early - state.occlusion_candidates;
+
+    return ret;
+}
+
+frustum_planes extract_frustum_planes( const glm::mat4& view_proj )
+{
+    // rows of the matrix, glm is column major
+    const auto row = [&view_proj]( int r ) {
+        return glm::vec4( view_proj[0][r], view_proj[1][r], view_proj[2][r],
+                          view_proj[3][r] );
+    };
+
+    frustum_planes ret = {row( 3 ) + row( 0 ), row( 3 ) - row( 0 ), row( 3 ) + row( 1 ),
+                          row( 3 ) - row( 1 ), row( 2 ),            row( 3 ) - row( 2 )};
+
+    for ( auto& p : ret )
+    {
+        p /= glm::length( glm::vec3( p ) );
+    }
+
+    return ret;
+}
+
+std::vector< uint32_t >
+cull_instances_reference( const frustum_planes& planes,
+                          const std::vector< glm::vec4 >& bounds )
+{
+    std::vector< uint32_t > ret;
+
+    for ( uint32_t i = 0; i < bounds.size(); ++i )
+    {
+        bool is_visible = true;
+
+        for ( const auto& p : planes )
+        {
+            is_visible = is_visible
+                         && glm::dot( glm::vec3( p ), glm::vec3( bounds[i] ) ) + p.w
+                                >= -bounds[i].w;
+        }
+
+        if ( is_visible )
+        {
+            ret.push_back( i );
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,162 @@
+#include "instance_scene.hpp"
+
+#include "debug.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+void instance_scene::initialize( uint32_t max_instances, uint32_t frame_count,
+                                 float bounding_radius )
+{
+    m_capacity        = max_instances;
+    m_bounding_radius = bounding_radius;
+
+    m_transforms.reserve( max_instances );
+    m_bounds.reserve( max_instances );
+    m_owners.reserve( max_instances );
+    m_slots.reserve( max_instances );
+
+    m_transform_buffers.resize( frame_count );
+    m_bounds_buffers.resize( frame_count );
+    m_uploaded_versions.assign( frame_count, ~0ull );
+
+    for ( auto i = 0u; i < frame_count; ++i )
+    {
+        m_transform_buffers[i] = m_vulkan_data.create_buffer(
+            static_cast< VkDeviceSize >( max_instances ) * sizeof( glm::mat4 ),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+        m_bounds_buffers[i] = m_vulkan_data.create_buffer(
+            static_cast< VkDeviceSize >( max_instances ) * sizeof( glm::vec4 ),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+    }
+}
+
+void instance_scene::deinitialize()
+{
+    for ( auto& b : m_transform_buffers )
+    {
+        m_vulkan_data.destroy_buffer( b );
+    }
+
+    for ( auto& b : m_bounds_buffers )
+    {
+        m_vulkan_data.destroy_buffer( b );
+    }
+
+    m_transform_buffers.clear();
+    m_bounds_buffers.clear();
+    m_uploaded_versions.clear();
+    clear();
+}
+
+instance_scene::handle instance_scene::add( const glm::mat4& transform )
+{
+    NEO_ASSERT_ALWAYS( count() < m_capacity, "Instance scene is full" );
+
+    handle h = INVALID_HANDLE;
+    if ( !m_free.empty() )
+    {
+        h = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        h = static_cast< handle >( m_slots.size() );
+        m_slots.push_back( 0 );
+    }
+
+    m_slots[h] = count();
+    m_owners.push_back( h );
+    m_transforms.push_back( transform );
+    m_bounds.push_back( world_bounds( transform ) );
+
+    ++m_version;
+
+    return h;
+}
+
+void instance_scene::remove( handle h )
+{
+    NEO_ASSERT_ALWAYS( h < m_slots.size() && m_slots[h] != INVALID_HANDLE,
+                       "Removing an instance which doesn't exist" );
+
+    const uint32_t slot = m_slots[h];
+    const handle last   = m_owners.back();
+
+    m_transforms[slot] = m_transforms.back();
+    m_bounds[slot]     = m_bounds.back();
+    m_owners[slot]     = last;
+    m_slots[last]      = slot;
+
+    m_transforms.pop_back();
+    m_bounds.pop_back();
+    m_owners.pop_back();
+
+    m_slots[h] = INVALID_HANDLE;
+    m_free.push_back( h );
+
+    ++m_version;
+}
+
+void instance_scene::set_transform( handle h, const glm::mat4& transform )
+{
+    NEO_ASSERT_ALWAYS( h < m_slots.size() && m_slots[h] != INVALID_HANDLE,
+                       "Updating an instance which doesn't exist" );
+
+    m_transforms[m_slots[h]] = transform;
+    m_bounds[m_slots[h]]     = world_bounds( transform );
+
+    ++m_version;
+}
+
+void instance_scene::clear()
+{
+    m_transforms.clear();
+    m_bounds.clear();
+    m_owners.clear();
+    m_slots.clear();
+    m_free.clear();
+
+    ++m_version;
+}
+
+void instance_scene::upload( uint32_t frame_idx )
+{
+    if ( m_uploaded_versions[frame_idx] == m_version )
+    {
+        return;
+    }
+
+    m_uploaded_versions[frame_idx] = m_version;
+
+    if ( m_transforms.empty() )
+    {
+        return;
+    }
+
+    const auto copy = [this]( const buffer_data& b, const void* src, VkDeviceSize size ) {
+        void* data     = nullptr;
+        const auto res = vkMapMemory( m_vulkan_data.logical_device, b.memory, 0, size, 0,
+                                      &data );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map instance buffer memory!" );
+        memcpy( data, src, size );
+        vkUnmapMemory( m_vulkan_data.logical_device, b.memory );
+    };
+
+    copy( m_transform_buffers[frame_idx], m_transforms.data(),
+          m_transforms.size() * sizeof( glm::mat4 ) );
+    copy( m_bounds_buffers[frame_idx], m_bounds.data(),
+          m_bounds.size() * sizeof( glm::vec4 ) );
+}
+
+glm::vec4 instance_scene::world_bounds( const glm::mat4& transform ) const
+{
+    const float scale = std::max( { glm::length( glm::vec3( transform[0] ) ),
+                                    glm::length( glm::vec3( transform[1] ) ),
+                                    glm::length( glm::vec3( transform[2] ) ) } );
+
+    return glm::vec4( glm::vec3( transform[3] ), m_bounding_radius * scale );
+}
@@ -0,0 +1,45 @@
+#include "json.hpp"
+
+void write_json_string( std::ostream& os, std::string_view s )
+{
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    os << '"';
+    for ( const char c : s )
+    {
+        switch ( c )
+        {
+        case '"':
+            os << "\\\"";
+            break;
+        case '\\':
+            os << "\\\\";
+            break;
+        case '\b':
+            os << "\\b";
+            break;
+        case '\f':
+            os << "\\f";
+            break;
+        case '\n':
+            os << "\\n";
+            break;
+        case '\r':
+            os << "\\r";
+            break;
+        case '\t':
+            os << "\\t";
+            break;
+        default:
+            if ( static_cast< unsigned char >( c ) < 0x20 )
+            {
+                os << "\\u00" << HEX[c >> 4] << HEX[c & 0xf];
+            }
+            else
+            {
+                os << c;
+            }
+        }
+    }
+    os << '"';
+}
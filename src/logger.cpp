@@ -0,0 +1,309 @@
+#include "logger.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    using clock_h = std::chrono::high_resolution_clock;
+
+    // Bounded MPSC queue after Dmitry Vyukov. The sequence of a slot says whose turn it
+    // is: pos for the producer claiming position pos, pos + 1 for the consumer once the
+    // record is committed, pos + CAPACITY when the slot is free for the next round.
+    struct log_slot
+    {
+        std::atomic< uint64_t > sequence;
+        detail::log_record record;
+    };
+
+    struct logger_state
+    {
+        static constexpr uint64_t CAPACITY = 4096; //!< 2 MB of records
+
+        logger_state()
+            : slots( new log_slot[CAPACITY] )
+        {
+            for ( uint64_t i = 0; i < CAPACITY; ++i )
+            {
+                slots[i].sequence.store( i, std::memory_order_relaxed );
+            }
+
+            consumer = std::thread( [this] { run(); } );
+
+            // whatever is logged until the end is written before the process exits
+            std::atexit( [] { stop(); } );
+        }
+
+        static void stop();
+
+        void run();
+        // writes out committed records in order, returns how many
+        uint64_t drain();
+        void write( const detail::log_record& record );
+
+        const clock_h::time_point start = clock_h::now();
+
+        std::unique_ptr< log_slot[] > slots;
+        alignas( 64 ) std::atomic< uint64_t > enqueue_pos{0};
+        alignas( 64 ) std::atomic< uint64_t > written_pos{0};
+        std::atomic< uint64_t > dropped{0};
+        std::atomic< uint64_t > truncated{0};
+        std::atomic< bool > stopped{false};
+
+        // consumer only, taken by the background thread or, after stop(), by the
+        // logging thread itself
+        std::mutex drain_mutex;
+        uint64_t dequeue_pos      = 0;
+        uint64_t reported_dropped = 0;
+
+        std::thread consumer;
+    };
+
+    // never destroyed, logging from static destructors keeps working
+    logger_state& state()
+    {
+        static logger_state* s = new logger_state();
+        return *s;
+    }
+
+    void write_prefix( uint64_t timestamp_us )
+    {
+        std::cout << "[" << std::setfill( '0' ) << std::setw( 9 ) << std::fixed
+                  << std::setprecision( 4 ) << timestamp_us / 1000000.0f << "]:\t";
+    }
+
+    constexpr const char* LEVEL_LABELS[]    = {"debug: ", "", "warning: ", "error: "};
+    constexpr const char* CATEGORY_LABELS[] = {"", "vulkan: ", "assets: ", "frame: "};
+
+    template < typename T > T read_value( const unsigned char* p )
+    {
+        T v;
+        std::memcpy( &v, p, sizeof( T ) );
+        return v;
+    }
+} // namespace
+
+void logger_state::stop()
+{
+    auto& s = state();
+
+    if ( s.stopped.exchange( true ) )
+    {
+        return;
+    }
+
+    s.consumer.join();
+
+    std::lock_guard< std::mutex > lock( s.drain_mutex );
+    s.drain();
+    std::cout.flush();
+}
+
+void logger_state::run()
+{
+    while ( !stopped.load( std::memory_order_acquire ) )
+    {
+        uint64_t count = 0;
+        {
+            std::lock_guard< std::mutex > lock( drain_mutex );
+            count = drain();
+
+            if ( count == 0 )
+            {
+                std::cout.flush();
+                written_pos.store( dequeue_pos, std::memory_order_release );
+            }
+        }
+
+        if ( count == 0 )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+    }
+}
+
+uint64_t logger_state::drain()
+{
+    uint64_t count = 0;
+
+    for ( ;; )
+    {
+        log_slot& slot = slots[dequeue_pos % CAPACITY];
+
+        if ( slot.sequence.load( std::memory_order_acquire ) != dequeue_pos + 1 )
+        {
+            break;
+        }
+
+        write( slot.record );
+
+        slot.sequence.store( dequeue_pos + CAPACITY, std::memory_order_release );
+        dequeue_pos += 1;
+        count += 1;
+    }
+
+    const uint64_t lost = dropped.load( std::memory_order_relaxed );
+    if ( lost != reported_dropped )
+    {
+        const uint64_t now_us = std::chrono::duration_cast< std::chrono::microseconds >(
+                                    clock_h::now() - start )
+                                    .count();
+        write_prefix( now_us );
+        std::cout << lost - reported_dropped << " log records dropped\n";
+        reported_dropped = lost;
+    }
+
+    return count;
+}
+
+void logger_state::write( const detail::log_record& record )
+{
+    write_prefix( record.timestamp_us );
+    std::cout << LEVEL_LABELS[static_cast< size_t >( record.level )]
+              << CATEGORY_LABELS[static_cast< size_t >( record.category )];
+
+    const unsigned char* p   = record.payload;
+    const unsigned char* end = record.payload + record.size;
+
+    while ( p < end )
+    {
+        const auto tag = static_cast< detail::log_arg >( *p++ );
+
+        switch ( tag )
+        {
+            case detail::log_arg::int64:
+                std::cout << read_value< int64_t >( p );
+                p += sizeof( int64_t );
+                break;
+            case detail::log_arg::uint64:
+                std::cout << read_value< uint64_t >( p );
+                p += sizeof( uint64_t );
+                break;
+            case detail::log_arg::float64:
+                std::cout << read_value< double >( p );
+                p += sizeof( double );
+                break;
+            case detail::log_arg::character:
+                std::cout << static_cast< char >( *p );
+                p += 1;
+                break;
+            case detail::log_arg::string:
+            {
+                const auto length = read_value< uint16_t >( p );
+                p += sizeof( uint16_t );
+                std::cout.write( reinterpret_cast< const char* >( p ), length );
+                p += length;
+                break;
+            }
+            case detail::log_arg::heap_string:
+            {
+                const auto* str   = read_value< const char* >( p );
+                const auto length = read_value< size_t >( p + sizeof( str ) );
+                p += sizeof( str ) + sizeof( length );
+                std::cout.write( str, static_cast< std::streamsize >( length ) );
+                delete[] str;
+                break;
+            }
+        }
+    }
+
+    if ( record.truncated != 0 )
+    {
+        std::cout << "...";
+    }
+
+    std::cout << '\n';
+}
+
+detail::log_record* detail::log_begin( log_level level, log_category category )
+{
+    auto& s = state();
+
+    uint64_t pos = s.enqueue_pos.load( std::memory_order_relaxed );
+
+    for ( ;; )
+    {
+        log_slot& slot     = s.slots[pos % logger_state::CAPACITY];
+        const uint64_t seq = slot.sequence.load( std::memory_order_acquire );
+
+        if ( seq == pos )
+        {
+            if ( s.enqueue_pos.compare_exchange_weak( pos, pos + 1,
+                                                      std::memory_order_relaxed ) )
+            {
+                auto& record = slot.record;
+                record.timestamp_us =
+                    std::chrono::duration_cast< std::chrono::microseconds >(
+                        clock_h::now() - s.start )
+                        .count();
+                record.size      = 0;
+                record.level     = level;
+                record.category  = category;
+                record.truncated = 0;
+                return &record;
+            }
+        }
+        else if ( seq < pos )
+        {
+            // the consumer is a whole ring behind
+            s.dropped.fetch_add( 1, std::memory_order_relaxed );
+            return nullptr;
+        }
+        else
+        {
+            pos = s.enqueue_pos.load( std::memory_order_relaxed );
+        }
+    }
+}
+
+void detail::log_commit( log_record* record )
+{
+    auto& s = state();
+    if ( record->truncated != 0 )
+    {
+        s.truncated.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    auto* slot = reinterpret_cast< log_slot* >( reinterpret_cast< char* >( record )
+                                                - offsetof( log_slot, record ) );
+
+    // the producer still owns the slot, its sequence is the position it claimed
+    slot->sequence.store( slot->sequence.load( std::memory_order_relaxed ) + 1,
+                          std::memory_order_release );
+
+    if ( s.stopped.load( std::memory_order_acquire ) )
+    {
+        std::lock_guard< std::mutex > lock( s.drain_mutex );
+        s.drain();
+        std::cout.flush();
+    }
+}
+
+void log_flush()
+{
+    auto& s = state();
+
+    const uint64_t target = s.enqueue_pos.load( std::memory_order_acquire );
+
+    while ( !s.stopped.load( std::memory_order_acquire )
+            && s.written_pos.load( std::memory_order_acquire ) < target )
+    {
+        std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+    }
+}
+
+uint64_t log_dropped_records()
+{
+    return state().dropped.load( std::memory_order_relaxed );
+}
+
+uint64_t log_truncated_records()
+{
+    return state().truncated.load( std::memory_order_relaxed );
+}
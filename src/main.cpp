@@ -5,26 +5,533 @@
 #include <iostream>
 #include <cassert>
 #include <random>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
 
 #include "debug.hpp"
+#include "json.hpp"
 #include "logger.hpp"
 #include "stack_allocator.hpp"
 #include "static_array.hpp"
 #include "application.hpp"
+#include "cpu_profiler.hpp"
 
+#include "examples/example1.hpp"
+#include "examples/example2.hpp"
+#include "examples/example3.hpp"
 #include "examples/example4.hpp"
 
 #undef main
 
-int main()
+namespace
 {
+    void log_gpu_timings( const gpu_profiler& profiler )
+    {
+        for ( const auto& t : profiler.timings() )
+        {
+            log_result( "\tgpu ", t.name, ": ", t.average_ms, " ms average, p50 ",
+                        t.p50_ms, ", p95 ", t.p95_ms, ", p99 ", t.p99_ms, ", max ",
+                        t.max_ms, " over ", t.samples, " frames" );
+        }
+    }
+
+    void log_frame_stats( const frame_stats& stats )
+    {
+        for ( const auto& t : stats.summary() )
+        {
+            log_result( "\tcpu ", t.name, ": p50 ", t.p50_ms, " ms, p90 ", t.p90_ms,
+                        ", p99 ", t.p99_ms, ", p99.9 ", t.p999_ms, ", max ", t.max_ms,
+                        " over ", t.frames, " frames" );
+        }
+    }
+
+    void log_frame_arena( const frame_arena_stats& s )
+    {
+        log_result( "\tframe arena: ", s.high_water_mark, " of ", s.capacity,
+                    " bytes at most, ", s.overflows, " overflows, ", s.overflow_bytes,
+                    " bytes from the heap" );
+    }
+
+    void log_diagnostics( const frame_diagnostics& d )
+    {
+        log_result( "\tvertices: ", d.input_vertices, " fetched, ", d.vertex_invocations,
+                    " shaded, ", d.vertices_per_triangle,
+                    " per triangle, cache miss rate ", d.vertex_cache_miss_rate );
+        log_result( "\tprimitives: ", d.input_primitives, " assembled, ",
+                    d.clipping_invocations, " reached the clipper, ",
+                    d.clipping_primitives, " left it" );
+        log_result( "\tfragments: ", d.fragment_invocations, " shaded, ",
+                    d.shaded_per_pixel, " per pixel" );
+        log_result( "\toverdraw: ", d.overdraw, " average, ", d.max_overdraw, " max, ",
+                    d.covered_pixels, " pixels covered by ", d.rasterized_fragments,
+                    " fragments" );
+    }
+
+    // frame time of example4 against the number of instanced cats
+    void run_instance_sweep( application< example4 >& app )
+    {
+        constexpr uint32_t WARMUP_FRAMES   = 16;
+        constexpr uint32_t MEASURED_FRAMES = 128;
+
+        for ( uint32_t count = 1; count <= 100000; count *= 10 )
+        {
+            app.get_renderer().set_instance_grid( count );
+            app.run_frames( WARMUP_FRAMES );
+            app.get_renderer().frame_statistics().reset();
+
+            const double frame_ms = app.run_frames( MEASURED_FRAMES );
+            log_result( "instances ", count, ": ", frame_ms, " ms/frame, ",
+                        count / frame_ms * 1000.0, " instances/s" );
+
+            const auto& stats = app.get_renderer().last_cull_stats();
+            log_result( "\tfrustum culled ", stats.frustum_culled, ", occluded ",
+                        stats.occluded, ", visible ", stats.visible_early, " early + ",
+                        stats.visible_late, " late, ", stats.triangles, " triangles" );
+
+            const auto& binds = app.get_renderer().last_render_stats();
+            log_result( "\t", binds.draws, " draws, binds: ", binds.pipeline_binds,
+                        " pipeline, ", binds.set_binds, " descriptor set, ",
+                        binds.vertex_binds, " vertex, ", binds.index_binds,
+                        " index, scene recorded ", app.get_renderer().scene_recordings(),
+                        " times" );
+
+            log_gpu_timings( app.get_renderer().profiler() );
+            log_frame_stats( app.get_renderer().frame_statistics() );
+
+            if ( app.get_renderer().diagnostics_enabled() )
+            {
+                log_diagnostics( app.get_renderer().last_diagnostics() );
+            }
+        }
+    }
+
+    struct benchmark_options
+    {
+        uint32_t example              = 4;
+        uint32_t frames               = 1000;
+        uint32_t warmup_frames        = 100;
+        float timestep_ms             = 1000.0f / 60.0f;
+        VkPresentModeKHR present_mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+        const char* json              = "benchmark.json";
+        const char* trace             = nullptr;
+        bool diagnostics              = false; //!< example4 only
+    };
+
+    constexpr std::pair< const char*, VkPresentModeKHR > PRESENT_MODES[] = {
+        {"immediate", VK_PRESENT_MODE_IMMEDIATE_KHR},
+        {"mailbox", VK_PRESENT_MODE_MAILBOX_KHR},
+        {"fifo", VK_PRESENT_MODE_FIFO_KHR},
+        {"fifo_relaxed", VK_PRESENT_MODE_FIFO_RELAXED_KHR}};
+
+    const char* present_mode_name( VkPresentModeKHR mode )
+    {
+        for ( const auto& m : PRESENT_MODES )
+        {
+            if ( m.second == mode )
+            {
+                return m.first;
+            }
+        }
+
+        return "unknown";
+    }
+
+    bool parse_present_mode( const char* name, VkPresentModeKHR& mode )
+    {
+        for ( const auto& m : PRESENT_MODES )
+        {
+            if ( std::strcmp( m.first, name ) == 0 )
+            {
+                mode = m.second;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    constexpr std::pair< const char*, log_level > LOG_LEVELS[] = {
+        {"debug", log_level::debug},
+        {"info", log_level::info},
+        {"warning", log_level::warning},
+        {"error", log_level::error}};
+
+    constexpr std::pair< const char*, log_category > LOG_CATEGORIES[] = {
+        {"general", log_category::general},
+        {"vulkan", log_category::vulkan},
+        {"assets", log_category::assets},
+        {"frame", log_category::frame}};
+
+    // "warning" sets every category, "vulkan=debug" only the one
+    bool parse_log_level( const char* value )
+    {
+        const char* separator = std::strchr( value, '=' );
+        const char* name      = separator != nullptr ? separator + 1 : value;
+
+        const auto level = std::find_if(
+            std::begin( LOG_LEVELS ), std::end( LOG_LEVELS ),
+            [name]( const auto& l ) { return std::strcmp( l.first, name ) == 0; } );
+
+        if ( level == std::end( LOG_LEVELS ) )
+        {
+            return false;
+        }
+
+        if ( separator == nullptr )
+        {
+            log_set_level( level->second );
+            return true;
+        }
+
+        const std::string_view category_name( value, separator - value );
+        for ( const auto& c : LOG_CATEGORIES )
+        {
+            if ( category_name == c.first )
+            {
+                log_set_level( c.second, level->second );
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // what only example4 measures, the other examples add nothing
+    template < class TRenderer > void reset_renderer_stats( TRenderer& )
+    {
+    }
+
+    void reset_renderer_stats( example4& renderer )
+    {
+        renderer.frame_statistics().reset();
+    }
+
+    template < class TRenderer > void enable_renderer_diagnostics( TRenderer& ) {}
+
+    void enable_renderer_diagnostics( example4& renderer )
+    {
+        renderer.enable_diagnostics();
+    }
+
+    template < class TRenderer > void log_renderer_diagnostics( TRenderer& ) {}
+
+    void log_renderer_diagnostics( example4& renderer )
+    {
+        if ( renderer.diagnostics_enabled() )
+        {
+            log_diagnostics( renderer.last_diagnostics() );
+        }
+    }
+
+    template < class TRenderer > void write_renderer_json( std::ofstream&, TRenderer& )
+    {
+    }
+
+    void write_renderer_json( std::ofstream& os, example4& renderer )
+    {
+        os << ",\n  \"frame_phases_ms\": [";
+        bool first = true;
+        for ( const auto& t : renderer.frame_statistics().summary() )
+        {
+            os << ( first ? "\n" : ",\n" ) << "    {\"name\": ";
+            write_json_string( os, t.name );
+            os << ", \"p50\": " << t.p50_ms << ", \"p90\": " << t.p90_ms
+               << ", \"p99\": " << t.p99_ms << ", \"p99.9\": " << t.p999_ms
+               << ", \"max\": " << t.max_ms << "}";
+            first = false;
+        }
+
+        os << "\n  ],\n  \"gpu_ms\": [";
+        first = true;
+        for ( const auto& t : renderer.profiler().timings() )
+        {
+            os << ( first ? "\n" : ",\n" ) << "    {\"name\": ";
+            write_json_string( os, t.name );
+            os << ", \"average\": " << t.average_ms << ", \"p50\": " << t.p50_ms
+               << ", \"p95\": " << t.p95_ms << ", \"p99\": " << t.p99_ms
+               << ", \"max\": " << t.max_ms << "}";
+            first = false;
+        }
+        os << "\n  ]";
+
+        const frame_arena_stats arena = renderer.frame_arena_statistics();
+        os << ",\n  \"frame_arena\": {\"capacity\": " << arena.capacity
+           << ", \"high_water_mark\": " << arena.high_water_mark
+           << ", \"overflows\": " << arena.overflows
+           << ", \"overflow_bytes\": " << arena.overflow_bytes << "}";
+
+        if ( renderer.diagnostics_enabled() )
+        {
+            const frame_diagnostics& d = renderer.last_diagnostics();
+            os << ",\n  \"diagnostics\": {\"input_vertices\": " << d.input_vertices
+               << ", \"vertex_invocations\": " << d.vertex_invocations
+               << ", \"vertices_per_triangle\": " << d.vertices_per_triangle
+               << ", \"vertex_cache_miss_rate\": " << d.vertex_cache_miss_rate
+               << ", \"input_primitives\": " << d.input_primitives
+               << ", \"clipping_invocations\": " << d.clipping_invocations
+               << ", \"clipping_primitives\": " << d.clipping_primitives
+               << ", \"fragment_invocations\": " << d.fragment_invocations
+               << ", \"shaded_per_pixel\": " << d.shaded_per_pixel
+               << ", \"overdraw\": " << d.overdraw
+               << ", \"max_overdraw\": " << d.max_overdraw << "}";
+        }
+    }
+
+    // the zones collected so far, if the build records any
+    void write_trace( const char* path )
+    {
+        if ( !NEO_PROFILER_ENABLED )
+        {
+            log( "--trace needs a build with the profiler, premake5 --profiler" );
+            return;
+        }
+
+        profiler_write_chrome_trace( path );
+    }
+
+    // Unattended run of one example with a fixed timestep, so the animation and the
+    // camera are the same in every run. Writes frame times, startup phases and the
+    // device to options.json, the diagnostics of the last frame when they are enabled.
+    template < class TRenderer > bool run_benchmark( const benchmark_options& options )
+    {
+        application< TRenderer > app;
+
+        if ( options.diagnostics )
+        {
+            enable_renderer_diagnostics( app.get_renderer() );
+        }
+
+        app.get_vulkan_data().swap_chain.requested_present_mode = options.present_mode;
+        app.initialize();
+
+        const float dt_s = options.timestep_ms * 0.001f;
+
+        app.run_frames( options.warmup_frames, dt_s );
+
+        hdr_histogram frame_times;
+        reset_renderer_stats( app.get_renderer() );
+        const double average_ms = app.run_frames( options.frames, dt_s, &frame_times );
+
+        std::ofstream os( options.json );
+        if ( !os.is_open() )
+        {
+            log( "Couldn't open ", options.json, " for the results" );
+            app.deinitialize();
+            return false;
+        }
+
+        auto& vd                 = app.get_vulkan_data();
+        const auto& device       = vd.device_properties[vd.selected_device_idx];
+        const auto& startup      = app.get_startup_timings();
+        const auto percentile_ms = [&frame_times]( double p ) {
+            return frame_times.value_at_percentile( p ) * 0.001;
+        };
+
+        os << std::fixed << std::setprecision( 3 );
+        os << "{\n  \"example\": ";
+        write_json_string( os, TRenderer::NAME );
+        os << ",\n  \"frames\": " << options.frames
+           << ",\n  \"warmup_frames\": " << options.warmup_frames
+           << ",\n  \"timestep_ms\": " << options.timestep_ms
+           << ",\n  \"present_mode\": {\"requested\": \""
+           << present_mode_name( options.present_mode ) << "\", \"selected\": \""
+           << present_mode_name( vd.swap_chain.selected_present_mode ) << "\"}";
+
+        os << ",\n  \"device\": {\"name\": ";
+        write_json_string( os, device.deviceName );
+        os << ", \"vendor_id\": " << device.vendorID
+           << ", \"device_id\": " << device.deviceID
+           << ", \"driver_version\": " << device.driverVersion << ", \"api_version\": \""
+           << VK_VERSION_MAJOR( device.apiVersion ) << '.'
+           << VK_VERSION_MINOR( device.apiVersion ) << '.'
+           << VK_VERSION_PATCH( device.apiVersion ) << "\"}";
+
+        os << ",\n  \"swap_chain\": {\"images\": " << vd.swap_chain.images_count
+           << ", \"width\": " << vd.swap_chain.selected_extent.width
+           << ", \"height\": " << vd.swap_chain.selected_extent.height << "}";
+
+        os << ",\n  \"startup_ms\": {\"window\": " << startup.window_ms
+           << ", \"vulkan\": " << startup.vulkan_ms
+           << ", \"renderer\": " << startup.renderer_ms << "}";
+
+        os << ",\n  \"frame_time_ms\": {\"average\": " << average_ms
+           << ", \"p50\": " << percentile_ms( 0.5 )
+           << ", \"p90\": " << percentile_ms( 0.9 )
+           << ", \"p99\": " << percentile_ms( 0.99 )
+           << ", \"p99.9\": " << percentile_ms( 0.999 )
+           << ", \"max\": " << frame_times.max() * 0.001 << "}";
+
+        write_renderer_json( os, app.get_renderer() );
+
+        os << "\n}\n";
+
+        log_result( "Benchmark of ", TRenderer::NAME, ": ", average_ms,
+                    " ms/frame, written to ", options.json );
+        log_renderer_diagnostics( app.get_renderer() );
+
+        app.deinitialize();
+
+        if ( options.trace != nullptr )
+        {
+            write_trace( options.trace );
+        }
+
+        return true;
+    }
+} // namespace
+
+int main( int argc, char** argv )
+{
+    bool instance_sweep = false;
+    bool diagnostics    = false;
+    bool benchmark      = false;
+    const char* trace   = nullptr;
+    const char* csv     = nullptr;
+
+    benchmark_options options;
+
+    for ( int i = 1; i < argc; ++i )
+    {
+        const char* arg   = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        instance_sweep = instance_sweep || std::strcmp( arg, "--instance-sweep" ) == 0;
+        diagnostics    = diagnostics || std::strcmp( arg, "--diagnostics" ) == 0;
+        benchmark      = benchmark || std::strcmp( arg, "--benchmark" ) == 0;
+
+        if ( value == nullptr )
+        {
+            continue;
+        }
+
+        // the options with a value
+        if ( std::strcmp( arg, "--trace" ) == 0 )
+        {
+            trace = value;
+        }
+        else if ( std::strcmp( arg, "--frame-csv" ) == 0 )
+        {
+            csv = value;
+        }
+        else if ( std::strcmp( arg, "--example" ) == 0 )
+        {
+            options.example = std::strtoul( value, nullptr, 10 );
+        }
+        else if ( std::strcmp( arg, "--frames" ) == 0 )
+        {
+            options.frames = std::strtoul( value, nullptr, 10 );
+        }
+        else if ( std::strcmp( arg, "--warmup" ) == 0 )
+        {
+            options.warmup_frames = std::strtoul( value, nullptr, 10 );
+        }
+        else if ( std::strcmp( arg, "--timestep" ) == 0 )
+        {
+            options.timestep_ms = std::strtof( value, nullptr );
+        }
+        else if ( std::strcmp( arg, "--present-mode" ) == 0 )
+        {
+            NEO_ASSERT_ALWAYS( parse_present_mode( value, options.present_mode ),
+                               "Unknown present mode ", value,
+                               ", one of immediate, mailbox, fifo, fifo_relaxed" );
+        }
+        else if ( std::strcmp( arg, "--json" ) == 0 )
+        {
+            options.json = value;
+        }
+        else if ( std::strcmp( arg, "--log-level" ) == 0 )
+        {
+            // sites below NEO_LOG_MIN_LEVEL are compiled out and stay silent
+            NEO_ASSERT_ALWAYS( parse_log_level( value ), "Unknown log level ", value,
+                               ", [category=]level with one of debug, info, warning,"
+                               " error" );
+        }
+        else
+        {
+            continue;
+        }
+
+        ++i;
+    }
+
+    if ( benchmark )
+    {
+        NEO_ASSERT_ALWAYS( options.frames > 0, "--frames has to be at least 1" );
+        NEO_ASSERT_ALWAYS( !diagnostics || options.example == 4,
+                           "--diagnostics needs --example 4" );
+
+        options.trace       = trace;
+        options.diagnostics = diagnostics;
+
+        bool ok = false;
+        switch ( options.example )
+        {
+            case 1:
+                ok = run_benchmark< example1 >( options );
+                break;
+            case 2:
+                ok = run_benchmark< example2 >( options );
+                break;
+            case 3:
+                ok = run_benchmark< example3 >( options );
+                break;
+            case 4:
+                ok = run_benchmark< example4 >( options );
+                break;
+            default:
+                NEO_ASSERT_ALWAYS( false, "No example ", options.example );
+        }
+
+        return ok ? 0 : 1;
+    }
+
     {
         application< example4 > app;
+
+        if ( diagnostics )
+        {
+            app.get_renderer().enable_diagnostics();
+        }
+
         app.initialize();
-        app.run();
+
+        // SIGUSR1 writes the frame times of a running session
+        if ( csv != nullptr )
+        {
+            app.get_renderer().frame_statistics().dump_on_signal( csv );
+        }
+
+        if ( instance_sweep )
+        {
+            run_instance_sweep( app );
+        }
+        else
+        {
+            app.run();
+            log_gpu_timings( app.get_renderer().profiler() );
+            log_frame_stats( app.get_renderer().frame_statistics() );
+            log_frame_arena( app.get_renderer().frame_arena_statistics() );
+
+            if ( diagnostics )
+            {
+                log_diagnostics( app.get_renderer().last_diagnostics() );
+            }
+        }
+
+        if ( csv != nullptr )
+        {
+            app.get_renderer().frame_statistics().write_csv( csv );
+        }
+
         app.deinitialize();
     }
 
+    if ( trace != nullptr )
+    {
+        write_trace( trace );
+    }
+
     log( "End" );
 
     return 0;
@@ -0,0 +1,614 @@
+#include "mesh_lod.hpp"
+
+#include "debug.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace
+{
+    // position, normal and texcoord, the attribute weights trade their error against
+    // the position error in a unit sized model
+    constexpr uint32_t ATTRIBUTES   = 8;
+    constexpr float NORMAL_WEIGHT   = 0.5f;
+    constexpr float TEXCOORD_WEIGHT = 0.5f;
+
+    template < size_t N > using vector_n = std::array< double, N >;
+
+    using attribute_vector = vector_n< ATTRIBUTES >;
+    using position_vector  = vector_n< 3 >;
+
+    template < size_t N > double dot( const vector_n< N >& a, const vector_n< N >& b )
+    {
+        double ret = 0.0;
+        for ( uint32_t i = 0; i < N; ++i )
+        {
+            ret += a[i] * b[i];
+        }
+
+        return ret;
+    }
+
+    // Area weighted sum of squared distances to triangle planes in N dimensions,
+    //     x^T A x + 2 b^T x + c
+    // A is symmetric and only its upper triangle is kept. The residuals of a fine mesh
+    // are far below the precision of a float.
+    template < size_t N > struct quadric
+    {
+        std::array< double, N*( N + 1 ) / 2 > a{};
+        vector_n< N > b{};
+        double c      = 0.0;
+        double weight = 0.0;
+
+        quadric& operator+=( const quadric& q )
+        {
+            for ( uint32_t i = 0; i < a.size(); ++i )
+            {
+                a[i] += q.a[i];
+            }
+
+            for ( uint32_t i = 0; i < N; ++i )
+            {
+                b[i] += q.b[i];
+            }
+
+            c += q.c;
+            weight += q.weight;
+
+            return *this;
+        }
+
+        // not divided by the weight yet
+        double residual( const vector_n< N >& x ) const
+        {
+            double ret = c;
+            uint32_t k = 0;
+
+            for ( uint32_t i = 0; i < N; ++i )
+            {
+                double row = a[k++] * x[i];
+                for ( uint32_t j = i + 1; j < N; ++j )
+                {
+                    row += 2.0 * a[k++] * x[j];
+                }
+
+                ret += x[i] * row + 2.0 * b[i] * x[i];
+            }
+
+            return ret;
+        }
+    };
+
+    // mean squared distance of x to the planes of both quadrics
+    template < size_t N >
+    float mean_error( const quadric< N >& q0, const quadric< N >& q1,
+                      const vector_n< N >& x )
+    {
+        const double weight = q0.weight + q1.weight;
+        const double r      = q0.residual( x ) + q1.residual( x );
+
+        return weight > 0.0 ? static_cast< float >( std::max( r, 0.0 ) / weight ) : 0.0f;
+    }
+
+    // The plane through p, q and r is spanned by the orthonormal e1 and e2, the distance
+    // of x to it is what's left of x - p after removing both components.
+    template < size_t N >
+    quadric< N > triangle_quadric( const vector_n< N >& p, const vector_n< N >& q,
+                                   const vector_n< N >& r, double area )
+    {
+        quadric< N > ret{};
+
+        vector_n< N > e1, e2;
+        for ( uint32_t i = 0; i < N; ++i )
+        {
+            e1[i] = q[i] - p[i];
+            e2[i] = r[i] - p[i];
+        }
+
+        const double len1 = std::sqrt( dot( e1, e1 ) );
+        if ( len1 < 1e-12 || area <= 0.0 )
+        {
+            return ret;
+        }
+
+        for ( auto& e : e1 )
+        {
+            e /= len1;
+        }
+
+        const double d = dot( e1, e2 );
+        for ( uint32_t i = 0; i < N; ++i )
+        {
+            e2[i] -= d * e1[i];
+        }
+
+        const double len2 = std::sqrt( dot( e2, e2 ) );
+        if ( len2 < 1e-12 )
+        {
+            return ret;
+        }
+
+        for ( auto& e : e2 )
+        {
+            e /= len2;
+        }
+
+        const double pe1 = dot( p, e1 );
+        const double pe2 = dot( p, e2 );
+
+        uint32_t k = 0;
+        for ( uint32_t i = 0; i < N; ++i )
+        {
+            for ( uint32_t j = i; j < N; ++j )
+            {
+                const double identity = i == j ? 1.0 : 0.0;
+                ret.a[k++] = area * ( identity - e1[i] * e1[j] - e2[i] * e2[j] );
+            }
+
+            ret.b[i] = area * ( pe1 * e1[i] + pe2 * e2[i] - p[i] );
+        }
+
+        ret.c      = area * ( dot( p, p ) - pe1 * pe1 - pe2 * pe2 );
+        ret.weight = area;
+
+        return ret;
+    }
+
+    constexpr float NEVER = std::numeric_limits< float >::infinity();
+
+    struct collapse
+    {
+        vtx_t::index from;
+        vtx_t::index to;
+        float cost;
+    };
+
+    // Everything about the input which doesn't depend on the target, shared by the
+    // levels of a chain. Positions are scaled into a unit box.
+    struct simplifier
+    {
+        const std::vector< vtx_t::index >& indices;
+
+        float scale;
+        std::vector< glm::vec3 > positions;
+        std::vector< attribute_vector > attributes;
+        std::vector< uint8_t > locked;
+
+        // the attribute quadrics order the collapses, the position ones measure the
+        // geometric error
+        std::vector< quadric< ATTRIBUTES > > quadrics;
+        std::vector< quadric< 3 > > position_quadrics;
+
+        simplifier( const std::vector< vtx_t::vertex >& vertices,
+                    const std::vector< vtx_t::index >& in_indices )
+            : indices{in_indices}
+        {
+            glm::vec3 lo( std::numeric_limits< float >::max() );
+            glm::vec3 hi( -std::numeric_limits< float >::max() );
+            for ( const auto& v : vertices )
+            {
+                lo = glm::min( lo, v.position );
+                hi = glm::max( hi, v.position );
+            }
+
+            const glm::vec3 extent = hi - lo;
+            scale = std::max( std::max( extent.x, extent.y ), extent.z );
+            scale = scale > 0.0f ? scale : 1.0f;
+
+            positions.resize( vertices.size() );
+            attributes.resize( vertices.size() );
+            for ( size_t i = 0; i < vertices.size(); ++i )
+            {
+                const auto& v = vertices[i];
+                positions[i]  = ( v.position - lo ) / scale;
+
+                attributes[i] = {positions[i].x,
+                                 positions[i].y,
+                                 positions[i].z,
+                                 v.normal.x * NORMAL_WEIGHT,
+                                 v.normal.y * NORMAL_WEIGHT,
+                                 v.normal.z * NORMAL_WEIGHT,
+                                 v.texcoord.x * TEXCOORD_WEIGHT,
+                                 v.texcoord.y * TEXCOORD_WEIGHT};
+            }
+
+            lock_borders_and_seams( vertices );
+            build_quadrics();
+        }
+
+        void lock_borders_and_seams( const std::vector< vtx_t::vertex >& vertices )
+        {
+            // vertices sharing a position are one corner of the surface, several of them
+            // in use make a seam
+            std::unordered_map< glm::vec3, uint32_t > corner_of_position;
+            std::vector< uint32_t > corners( vertices.size() );
+            std::vector< uint32_t > users;
+
+            std::vector< uint8_t > is_used( vertices.size(), 0 );
+            for ( const auto i : indices )
+            {
+                is_used[i] = 1;
+            }
+
+            for ( size_t i = 0; i < vertices.size(); ++i )
+            {
+                const auto it = corner_of_position
+                                    .emplace( vertices[i].position,
+                                              static_cast< uint32_t >( users.size() ) )
+                                    .first;
+
+                if ( it->second == users.size() )
+                {
+                    users.push_back( 0 );
+                }
+
+                corners[i] = it->second;
+                users[it->second] += is_used[i];
+            }
+
+            std::vector< uint8_t > locked_corners( users.size(), 0 );
+            for ( size_t c = 0; c < users.size(); ++c )
+            {
+                locked_corners[c] = users[c] > 1;
+            }
+
+            // edges between corners used by one triangle are open borders, by more than
+            // two non manifold, both stay where they are
+            std::unordered_map< uint64_t, uint32_t > edge_users;
+            edge_users.reserve( indices.size() );
+
+            const auto edge_key = []( uint32_t a, uint32_t b ) {
+                return uint64_t{std::min( a, b )} << 32 | std::max( a, b );
+            };
+
+            for ( size_t t = 0; t < indices.size(); t += 3 )
+            {
+                for ( uint32_t e = 0; e < 3; ++e )
+                {
+                    const uint32_t a = corners[indices[t + e]];
+                    const uint32_t b = corners[indices[t + ( e + 1 ) % 3]];
+                    if ( a != b )
+                    {
+                        ++edge_users[edge_key( a, b )];
+                    }
+                }
+            }
+
+            for ( const auto& e : edge_users )
+            {
+                if ( e.second != 2 )
+                {
+                    locked_corners[e.first >> 32]         = 1;
+                    locked_corners[e.first & 0xffffffffu] = 1;
+                }
+            }
+
+            locked.resize( vertices.size() );
+            for ( size_t i = 0; i < vertices.size(); ++i )
+            {
+                locked[i] = locked_corners[corners[i]];
+            }
+        }
+
+        void build_quadrics()
+        {
+            quadrics.assign( positions.size(), quadric< ATTRIBUTES >{} );
+            position_quadrics.assign( positions.size(), quadric< 3 >{} );
+
+            for ( size_t t = 0; t < indices.size(); t += 3 )
+            {
+                const auto i0 = indices[t];
+                const auto i1 = indices[t + 1];
+                const auto i2 = indices[t + 2];
+
+                const float area = 0.5f * glm::length( glm::cross(
+                                              positions[i1] - positions[i0],
+                                              positions[i2] - positions[i0] ) );
+
+                const auto q = triangle_quadric( attributes[i0], attributes[i1],
+                                                 attributes[i2], area );
+                const auto pq = triangle_quadric( position( i0 ), position( i1 ),
+                                                  position( i2 ), area );
+
+                quadrics[i0] += q;
+                quadrics[i1] += q;
+                quadrics[i2] += q;
+
+                position_quadrics[i0] += pq;
+                position_quadrics[i1] += pq;
+                position_quadrics[i2] += pq;
+            }
+        }
+
+        position_vector position( vtx_t::index v ) const
+        {
+            return {positions[v].x, positions[v].y, positions[v].z};
+        }
+
+        // true when moving from onto to turns a triangle around
+        bool flips( const vtx_t::index* tris, const uint32_t* around, uint32_t count,
+                    vtx_t::index from, vtx_t::index to ) const
+        {
+            for ( uint32_t i = 0; i < count; ++i )
+            {
+                const vtx_t::index* t = tris + around[i] * 3;
+                if ( t[0] == to || t[1] == to || t[2] == to )
+                {
+                    continue;
+                }
+
+                std::array< glm::vec3, 3 > before, after;
+                for ( uint32_t k = 0; k < 3; ++k )
+                {
+                    before[k] = positions[t[k]];
+                    after[k]  = positions[t[k] == from ? to : t[k]];
+                }
+
+                const glm::vec3 n0 =
+                    glm::cross( before[1] - before[0], before[2] - before[0] );
+                const glm::vec3 n1 =
+                    glm::cross( after[1] - after[0], after[2] - after[0] );
+
+                if ( glm::dot( n0, n1 ) <= 0.0f )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // Passes of independent collapses, cheapest first. Within a pass no vertex
+        // around a collapse changes again, so the adjacency of the pass stays valid.
+        std::vector< vtx_t::index > simplify( size_t target_index_count,
+                                              float& error ) const
+        {
+            std::vector< vtx_t::index > ret        = indices;
+            std::vector< quadric< ATTRIBUTES > > q = quadrics;
+            std::vector< quadric< 3 > > pq         = position_quadrics;
+
+            const auto vertex_count = static_cast< uint32_t >( positions.size() );
+
+            std::vector< uint32_t > offsets( vertex_count + 1 );
+            std::vector< uint32_t > around;
+            std::vector< collapse > collapses;
+            std::vector< vtx_t::index > remap( vertex_count );
+            std::vector< uint8_t > touched( vertex_count );
+
+            float max_error = 0.0f;
+
+            while ( ret.size() > target_index_count )
+            {
+                const auto triangle_count = static_cast< uint32_t >( ret.size() / 3 );
+
+                std::fill( offsets.begin(), offsets.end(), 0 );
+                for ( const auto i : ret )
+                {
+                    ++offsets[i + 1];
+                }
+
+                for ( uint32_t v = 0; v < vertex_count; ++v )
+                {
+                    offsets[v + 1] += offsets[v];
+                }
+
+                around.resize( ret.size() );
+                {
+                    std::vector< uint32_t > fill( offsets.begin(), offsets.end() - 1 );
+                    for ( uint32_t t = 0; t < triangle_count; ++t )
+                    {
+                        for ( uint32_t k = 0; k < 3; ++k )
+                        {
+                            around[fill[ret[t * 3 + k]]++] = t;
+                        }
+                    }
+                }
+
+                // one candidate per edge, in its cheaper direction
+                collapses.clear();
+                for ( uint32_t t = 0; t < triangle_count; ++t )
+                {
+                    for ( uint32_t k = 0; k < 3; ++k )
+                    {
+                        const vtx_t::index a = ret[t * 3 + k];
+                        const vtx_t::index b = ret[t * 3 + ( k + 1 ) % 3];
+
+                        // the other triangle of the edge sees it the other way around
+                        if ( a > b || ( locked[a] && locked[b] ) )
+                        {
+                            continue;
+                        }
+
+                        const float ab =
+                            locked[a] ? NEVER : mean_error( q[a], q[b], attributes[b] );
+                        const float ba =
+                            locked[b] ? NEVER : mean_error( q[b], q[a], attributes[a] );
+
+                        collapses.push_back( ab <= ba ? collapse{a, b, ab}
+                                                      : collapse{b, a, ba} );
+                    }
+                }
+
+                if ( collapses.empty() )
+                {
+                    break;
+                }
+
+                // Collapses remove two triangles each and some are skipped, the twice as
+                // many cheapest ones as needed get a chance. The rest wait for a later
+                // pass with fresh costs.
+                const size_t to_remove = ( ret.size() - target_index_count + 2 ) / 3;
+                const auto considered =
+                    collapses.begin() + std::min( to_remove, collapses.size() );
+
+                std::nth_element( collapses.begin(), considered - 1, collapses.end(),
+                                  []( const collapse& l, const collapse& r ) {
+                                      return l.cost < r.cost;
+                                  } );
+                std::sort( collapses.begin(), considered,
+                           []( const collapse& l, const collapse& r ) {
+                               return l.cost < r.cost;
+                           } );
+                collapses.erase( considered, collapses.end() );
+
+                for ( uint32_t v = 0; v < vertex_count; ++v )
+                {
+                    remap[v] = v;
+                }
+                std::fill( touched.begin(), touched.end(), 0 );
+
+                size_t removed = 0;
+                for ( const auto& c : collapses )
+                {
+                    if ( removed >= to_remove )
+                    {
+                        break;
+                    }
+
+                    if ( touched[c.from] || touched[c.to] )
+                    {
+                        continue;
+                    }
+
+                    const uint32_t* tris = around.data() + offsets[c.from];
+                    const uint32_t count = offsets[c.from + 1] - offsets[c.from];
+
+                    if ( flips( ret.data(), tris, count, c.from, c.to ) )
+                    {
+                        continue;
+                    }
+
+                    for ( uint32_t i = 0; i < count; ++i )
+                    {
+                        const vtx_t::index* t = ret.data() + tris[i] * 3;
+
+                        removed += t[0] == c.to || t[1] == c.to || t[2] == c.to;
+
+                        touched[t[0]] = 1;
+                        touched[t[1]] = 1;
+                        touched[t[2]] = 1;
+                    }
+
+                    remap[c.from] = c.to;
+                    max_error = std::max(
+                        max_error, mean_error( pq[c.from], pq[c.to], position( c.to ) ) );
+
+                    q[c.to] += q[c.from];
+                    pq[c.to] += pq[c.from];
+                }
+
+                if ( removed == 0 )
+                {
+                    break;
+                }
+
+                // drop the triangles which lost an edge
+                size_t kept = 0;
+                for ( size_t t = 0; t < ret.size(); t += 3 )
+                {
+                    const vtx_t::index a = remap[ret[t]];
+                    const vtx_t::index b = remap[ret[t + 1]];
+                    const vtx_t::index c = remap[ret[t + 2]];
+
+                    if ( a != b && b != c && a != c )
+                    {
+                        ret[kept++] = a;
+                        ret[kept++] = b;
+                        ret[kept++] = c;
+                    }
+                }
+
+                ret.resize( kept );
+            }
+
+            error = std::sqrt( max_error ) * scale;
+
+            return ret;
+        }
+    };
+} // namespace
+
+std::vector< vtx_t::index > simplify_mesh( const std::vector< vtx_t::vertex >& vertices,
+                                           const std::vector< vtx_t::index >& indices,
+                                           size_t target_index_count, float& error )
+{
+    return simplifier{vertices, indices}.simplify( target_index_count, error );
+}
+
+void build_lod_chain( model_data& model, thread_pool& pool, uint32_t max_levels,
+                      float ratio )
+{
+    NEO_ASSERT_ALWAYS( model.lods.empty(), "The LOD chain was built already" );
+    NEO_ASSERT_ALWAYS( max_levels > 0 && ratio > 0.0f && ratio < 1.0f,
+                       "Invalid LOD chain parameters" );
+
+    const auto index_count = static_cast< uint32_t >( model.index_data.size() );
+
+    std::vector< std::vector< vtx_t::index > > levels( max_levels - 1 );
+    std::vector< float > errors( max_levels - 1 );
+
+    {
+        const simplifier s{model.vertex_data, model.index_data};
+
+        pool.parallel_for( max_levels - 1, 1, [&]( uint32_t begin, uint32_t end ) {
+            for ( uint32_t l = begin; l < end; ++l )
+            {
+                const auto target = static_cast< size_t >(
+                    index_count / 3 * std::pow( ratio, float( l + 1 ) ) );
+
+                levels[l] = s.simplify( target * 3, errors[l] );
+            }
+        } );
+    }
+
+    model.lods.push_back( {0, index_count, 0.0f} );
+
+    for ( uint32_t l = 0; l < levels.size(); ++l )
+    {
+        const lod_level& previous = model.lods.back();
+
+        // locked borders and seams keep a floor on the triangle count
+        if ( levels[l].empty() || levels[l].size() > previous.index_count * 9 / 10 )
+        {
+            break;
+        }
+
+        // levels were simplified independently, the error only ever grows along the chain
+        model.lods.push_back( {static_cast< uint32_t >( model.index_data.size() ),
+                               static_cast< uint32_t >( levels[l].size() ),
+                               std::max( errors[l], previous.error )} );
+
+        model.index_data.insert( model.index_data.end(), levels[l].begin(),
+                                 levels[l].end() );
+    }
+}
+
+float lod_error_scale( const glm::mat4& proj, float viewport_height,
+                       float threshold_pixels )
+{
+    // P11 maps a view space height at depth 1 to half the viewport
+    return proj[1][1] * 0.5f * viewport_height / threshold_pixels;
+}
+
+uint32_t select_lod( const std::vector< lod_level >& lods, float error_scale, float scale,
+                     float depth )
+{
+    const float pixels_per_unit = error_scale * scale / depth;
+
+    uint32_t ret = 0;
+    for ( uint32_t l = 1; l < lods.size(); ++l )
+    {
+        if ( lods[l].error * pixels_per_unit > 1.0f )
+        {
+            break;
+        }
+
+        ret = l;
+    }
+
+    return ret;
+}
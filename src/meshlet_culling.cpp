@@ -0,0 +1,363 @@
+#include "meshlet_culling.hpp"
+
+#include "debug.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // device local, filled through a staging buffer
+    buffer_data create_static_buffer( vulkan_data< application_data::stack_alloc_t >& vd,
+                                      const void* src, VkDeviceSize size,
+                                      VkBufferUsageFlags usage )
+    {
+        buffer_data ret =
+            vd.create_buffer( size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+        buffer_data staging = vd.create_buffer(
+            size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+        void* data     = nullptr;
+        const auto res =
+            vkMapMemory( vd.logical_device, staging.memory, 0, size, 0, &data );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map staging memory!" );
+        memcpy( data, src, size );
+        vkUnmapMemory( vd.logical_device, staging.memory );
+
+        VkCommandBuffer cmd = vd.begin_one_time_commands();
+
+        const VkBufferCopy region{0, 0, size};
+        vkCmdCopyBuffer( cmd, staging.buffer, ret.buffer, 1, &region );
+
+        vd.submit_one_time_commands( cmd );
+        vd.destroy_buffer( staging );
+
+        return ret;
+    }
+} // namespace
+
+void meshlet_culling::initialize( const model_data& model, uint32_t frame_count )
+{
+    NEO_ASSERT_ALWAYS( !model.meshlets.empty(), "The model has no meshlets to cull" );
+
+    m_meshlet_count = static_cast< uint32_t >( model.meshlets.size() );
+
+    create_buffers( model, frame_count );
+    init_descriptor_set_layout();
+    create_descriptor_sets( frame_count );
+    init_pipeline();
+}
+
+void meshlet_culling::deinitialize()
+{
+    destroy_pipeline();
+    destroy_descriptor_sets();
+    destroy_descriptor_set_layout();
+    destroy_buffers();
+}
+
+void meshlet_culling::create_buffers( const model_data& model, uint32_t frame_count )
+{
+    m_meshlets = create_static_buffer( m_vulkan_data, model.meshlets.data(),
+                                       model.meshlets.size() * sizeof( meshlet ),
+                                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT );
+
+    const VkDeviceSize indices_size = model.index_data.size() * sizeof( vtx_t::index );
+
+    m_source_indices = create_static_buffer( m_vulkan_data, model.index_data.data(),
+                                             indices_size,
+                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT );
+
+    // every meshlet visible at worst
+    m_indices = m_vulkan_data.create_buffer(
+        indices_size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    m_state = m_vulkan_data.create_buffer(
+        sizeof( cull_state ),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+            | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    m_cull_params.resize( frame_count );
+
+    for ( auto& cp : m_cull_params )
+    {
+        cp = m_vulkan_data.create_buffer( sizeof( cull_params ),
+                                          VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                                              | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+
+        // nothing is drawn until the first update()
+        const cull_params params{};
+
+        void* data     = nullptr;
+        const auto res = vkMapMemory( m_vulkan_data.logical_device, cp.memory, 0,
+                                      sizeof( cull_params ), 0, &data );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map cull params memory!" );
+        memcpy( data, &params, sizeof( cull_params ) );
+        vkUnmapMemory( m_vulkan_data.logical_device, cp.memory );
+    }
+}
+
+void meshlet_culling::destroy_buffers()
+{
+    for ( auto& cp : m_cull_params )
+    {
+        m_vulkan_data.destroy_buffer( cp );
+    }
+
+    m_cull_params.clear();
+
+    m_vulkan_data.destroy_buffer( m_state );
+    m_vulkan_data.destroy_buffer( m_indices );
+    m_vulkan_data.destroy_buffer( m_source_indices );
+    m_vulkan_data.destroy_buffer( m_meshlets );
+}
+
+void meshlet_culling::init_descriptor_set_layout()
+{
+    std::array< VkDescriptorSetLayoutBinding, 5 > bindings = {
+        VkDescriptorSetLayoutBinding{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        VkDescriptorSetLayoutBinding{4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     VK_SHADER_STAGE_COMPUTE_BIT, nullptr}};
+
+    VkDescriptorSetLayoutCreateInfo create_info{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+        static_cast< uint32_t >( bindings.size() ), bindings.data()};
+
+    const auto res = vkCreateDescriptorSetLayout( m_vulkan_data.logical_device,
+                                                  &create_info, nullptr, &m_set_layout );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor set layout" );
+}
+
+void meshlet_culling::destroy_descriptor_set_layout()
+{
+    vkDestroyDescriptorSetLayout( m_vulkan_data.logical_device, m_set_layout, nullptr );
+}
+
+void meshlet_culling::create_descriptor_sets( uint32_t frame_count )
+{
+    std::array< VkDescriptorPoolSize, 2 > pool_size;
+    pool_size[0] = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frame_count};
+    pool_size[1] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * frame_count};
+
+    {
+        VkDescriptorPoolCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            nullptr,
+            0,
+            frame_count,
+            static_cast< uint32_t >( pool_size.size() ),
+            pool_size.data()};
+
+        const auto res = vkCreateDescriptorPool(
+            m_vulkan_data.logical_device, &create_info, nullptr, &m_descriptor_pool );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create descriptor pool!" );
+    }
+
+    {
+        std::vector< VkDescriptorSetLayout > layouts( frame_count, m_set_layout );
+        VkDescriptorSetAllocateInfo alloc_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, m_descriptor_pool,
+            frame_count, layouts.data()};
+
+        m_sets.resize( frame_count );
+
+        const auto res = vkAllocateDescriptorSets( m_vulkan_data.logical_device,
+                                                   &alloc_info, m_sets.data() );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't allocate descriptor sets!" );
+    }
+
+    VkDescriptorBufferInfo meshlets_info{m_meshlets.buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo source_info{m_source_indices.buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo indices_info{m_indices.buffer, 0, VK_WHOLE_SIZE};
+    VkDescriptorBufferInfo state_info{m_state.buffer, 0, VK_WHOLE_SIZE};
+
+    for ( auto i = 0u; i < frame_count; ++i )
+    {
+        VkDescriptorBufferInfo params_info{m_cull_params[i].buffer, 0,
+                                           sizeof( cull_params )};
+
+        std::array< VkWriteDescriptorSet, 5 > writes = {
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 0, 0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                 nullptr, &params_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 1, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                 nullptr, &meshlets_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 2, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                 nullptr, &source_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 3, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                 nullptr, &indices_info, nullptr},
+            VkWriteDescriptorSet{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr,
+                                 m_sets[i], 4, 0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                 nullptr, &state_info, nullptr}};
+
+        vkUpdateDescriptorSets( m_vulkan_data.logical_device,
+                                static_cast< uint32_t >( writes.size() ), writes.data(),
+                                0, nullptr );
+    }
+}
+
+void meshlet_culling::destroy_descriptor_sets()
+{
+    // sets are released together with the pool
+    vkDestroyDescriptorPool( m_vulkan_data.logical_device, m_descriptor_pool, nullptr );
+    m_sets.clear();
+}
+
+void meshlet_culling::init_pipeline()
+{
+    VkPipelineLayoutCreateInfo create_info = {
+        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, nullptr, 0, 1, &m_set_layout, 0,
+        nullptr};
+
+    const auto res = vkCreatePipelineLayout( m_vulkan_data.logical_device, &create_info,
+                                             nullptr, &m_pipeline_layout );
+    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of pipeline layout failed" );
+
+    m_pipeline = m_vulkan_data.create_compute_pipeline(
+        "generated/meshlet_cull.comp.spirv", m_pipeline_layout );
+}
+
+void meshlet_culling::destroy_pipeline()
+{
+    vkDestroyPipeline( m_vulkan_data.logical_device, m_pipeline, nullptr );
+    vkDestroyPipelineLayout( m_vulkan_data.logical_device, m_pipeline_layout, nullptr );
+}
+
+void meshlet_culling::update( uint32_t frame_idx, const glm::mat4& model,
+                              const glm::mat4& view, const glm::mat4& proj )
+{
+    // the planes of proj * view * model are the world planes in model space
+    const glm::vec4 camera = glm::inverse( view * model ) * glm::vec4( 0, 0, 0, 1 );
+    const cull_params params{extract_frustum_planes( proj * view * model ), camera,
+                             m_meshlet_count};
+
+    void* data     = nullptr;
+    const auto res = vkMapMemory( m_vulkan_data.logical_device,
+                                  m_cull_params[frame_idx].memory, 0,
+                                  sizeof( cull_params ), 0, &data );
+    NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map cull params memory!" );
+    memcpy( data, &params, sizeof( cull_params ) );
+    vkUnmapMemory( m_vulkan_data.logical_device, m_cull_params[frame_idx].memory );
+}
+
+void meshlet_culling::record( VkCommandBuffer cmd, uint32_t frame_idx )
+{
+    // the previous frame might still be drawing from the outputs
+    {
+        const VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+                                      VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+                                          | VK_ACCESS_INDEX_READ_BIT
+                                          | VK_ACCESS_TRANSFER_READ_BIT,
+                                      VK_ACCESS_TRANSFER_WRITE_BIT
+                                          | VK_ACCESS_SHADER_WRITE_BIT};
+
+        vkCmdPipelineBarrier( cmd,
+                              VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+                                  | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                                  | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT
+                                  | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              0, 1, &barrier, 0, nullptr, 0, nullptr );
+    }
+
+    const cull_state initial_state{{0, 1, 0, 0, 0}, 0};
+    vkCmdUpdateBuffer( cmd, m_state.buffer, 0, sizeof( initial_state ), &initial_state );
+
+    {
+        const VkBufferMemoryBarrier barrier = {
+            VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            nullptr,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            m_state.buffer,
+            0,
+            VK_WHOLE_SIZE};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1,
+                              &barrier, 0, nullptr );
+    }
+
+    // one workgroup per meshlet, spread over y to stay below the group count limits
+    const uint32_t groups_x = std::min( m_meshlet_count, 32768u );
+    const uint32_t groups_y = ( m_meshlet_count + groups_x - 1 ) / groups_x;
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline );
+    vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1,
+                             &m_sets[frame_idx], 0, nullptr );
+    vkCmdDispatch( cmd, groups_x, groups_y, 1 );
+
+    {
+        const VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+                                      VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+                                          | VK_ACCESS_INDEX_READ_BIT
+                                          | VK_ACCESS_TRANSFER_READ_BIT};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+                                  | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                                  | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              0, 1, &barrier, 0, nullptr, 0, nullptr );
+    }
+}
+
+void meshlet_culling::record_draw( VkCommandBuffer cmd )
+{
+    vkCmdDrawIndexedIndirect( cmd, m_state.buffer, 0, 1,
+                              sizeof( VkDrawIndexedIndirectCommand ) );
+}
+
+std::vector< uint32_t > cull_meshlets_reference( const std::vector< meshlet >& meshlets,
+                                                 const frustum_planes& planes,
+                                                 const glm::vec3& camera, float margin )
+{
+    std::vector< uint32_t > ret;
+
+    for ( uint32_t i = 0; i < meshlets.size(); ++i )
+    {
+        const glm::vec3 center = meshlets[i].sphere;
+        const float radius     = meshlets[i].sphere.w + margin;
+
+        bool is_visible = true;
+
+        for ( const auto& p : planes )
+        {
+            is_visible =
+                is_visible && glm::dot( glm::vec3( p ), center ) + p.w >= -radius;
+        }
+
+        // all triangles facing away from the camera
+        const glm::vec3 d    = center - camera;
+        const glm::vec4 cone = meshlets[i].cone;
+        is_visible           = is_visible
+                     && glm::dot( d, glm::vec3( cone ) )
+                            < cone.w * glm::length( d ) + radius;
+
+        if ( is_visible )
+        {
+            ret.push_back( i );
+        }
+    }
+
+    return ret;
+}
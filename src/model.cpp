@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <numeric>
 
 #include "model.hpp"
+#include "cpu_profiler.hpp"
+#include "thread_pool.hpp"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tiny_obj_loader.h"
@@ -9,33 +12,278 @@
 
 namespace detail
 {
-    model_data calculate_normals( model_data&& m )
+    // triangles per parallel task, meshlets never cross a chunk
+    constexpr uint32_t MESHLET_CHUNK_TRIANGLES = 8192;
+
+    struct meshlet_builder
     {
-        for ( uint32_t i = 0; i < m.index_data.size(); i += 3 )
+        const vtx_t::index* indices;
+        uint32_t triangle_count;
+
+        std::vector< vtx_t::index > out_indices;
+        std::vector< meshlet > out_meshlets;
+
+        // chunk local vertex ids of every triangle, and the triangles around every
+        // vertex in compressed rows
+        std::vector< uint32_t > local_indices;
+        std::vector< uint32_t > adjacency_offsets;
+        std::vector< uint32_t > adjacency;
+
+        std::vector< bool > used;
+        std::vector< uint32_t > stamps; //!< per vertex, current meshlet when it's in it
+        uint32_t stamp = 0;
+
+        uint32_t vertex_count   = 0; //!< of the current meshlet
+        uint32_t meshlet_first  = 0; //!< first triangle of the current meshlet in out
+        uint32_t meshlet_length = 0;
+
+        uint32_t new_vertices( uint32_t tri ) const
         {
-            auto& v0 = m.vertex_data[m.index_data[i]];
-            auto& v1 = m.vertex_data[m.index_data[i + 1]];
-            auto& v2 = m.vertex_data[m.index_data[i + 2]];
+            uint32_t ret = 0;
+            for ( uint32_t k = 0; k < 3; ++k )
+            {
+                ret += stamps[local_indices[tri * 3 + k]] != stamp;
+            }
 
-            const auto n = glm::normalize(
-                glm::cross( v1.position - v0.position, v2.position - v0.position ) );
+            return ret;
+        }
 
-            v0.normal += n;
-            v1.normal += n;
-            v2.normal += n;
+        bool fits( uint32_t tri ) const
+        {
+            return meshlet_length < meshlet::MAX_TRIANGLES
+                   && vertex_count + new_vertices( tri ) <= meshlet::MAX_VERTICES;
         }
 
-        for ( auto& v : m.vertex_data )
+        void add( uint32_t tri )
         {
-            v.normal = glm::normalize( v.normal );
+            for ( uint32_t k = 0; k < 3; ++k )
+            {
+                auto& s = stamps[local_indices[tri * 3 + k]];
+                vertex_count += s != stamp;
+                s = stamp;
+            }
+
+            out_indices.insert( out_indices.end(), indices + tri * 3,
+                                indices + tri * 3 + 3 );
+            used[tri] = true;
+            ++meshlet_length;
+        }
+
+        // the unused triangle around the given triangles' vertices adding the fewest
+        // vertices, triangle_count if none fits
+        uint32_t best_neighbour( const uint32_t* tris, uint32_t count ) const
+        {
+            uint32_t best       = triangle_count;
+            uint32_t best_score = ~0u;
+
+            for ( uint32_t i = 0; i < count * 3; ++i )
+            {
+                const uint32_t v = local_indices[tris[i / 3] * 3 + i % 3];
+
+                const uint32_t first = adjacency_offsets[v];
+                const uint32_t last  = adjacency_offsets[v + 1];
+
+                for ( uint32_t a = first; a < last; ++a )
+                {
+                    const uint32_t tri = adjacency[a];
+                    if ( used[tri] || !fits( tri ) )
+                    {
+                        continue;
+                    }
+
+                    const uint32_t score = new_vertices( tri );
+                    if ( score < best_score )
+                    {
+                        best       = tri;
+                        best_score = score;
+                    }
+                }
+            }
+
+            return best;
+        }
+
+        void flush()
+        {
+            meshlet m{};
+            m.first_index    = meshlet_first * 3;
+            m.triangle_count = meshlet_length;
+            m.vertex_count   = vertex_count;
+            out_meshlets.push_back( m );
+
+            meshlet_first += meshlet_length;
+            meshlet_length = 0;
+            vertex_count   = 0;
+            ++stamp;
+        }
+
+        void build()
+        {
+            // chunk local vertex ids
+            std::vector< std::pair< vtx_t::index, uint32_t > > sorted( triangle_count
+                                                                       * 3 );
+            for ( uint32_t i = 0; i < sorted.size(); ++i )
+            {
+                sorted[i] = {indices[i], i};
+            }
+
+            std::sort( sorted.begin(), sorted.end() );
+
+            local_indices.resize( sorted.size() );
+            uint32_t local_count = 0;
+            for ( uint32_t i = 0; i < sorted.size(); ++i )
+            {
+                local_count += i > 0 && sorted[i].first != sorted[i - 1].first;
+                local_indices[sorted[i].second] = local_count;
+            }
+
+            local_count += sorted.empty() ? 0 : 1;
+
+            adjacency_offsets.assign( local_count + 1, 0 );
+            for ( const auto v : local_indices )
+            {
+                ++adjacency_offsets[v + 1];
+            }
+
+            std::partial_sum( adjacency_offsets.begin(), adjacency_offsets.end(),
+                              adjacency_offsets.begin() );
+
+            adjacency.resize( local_indices.size() );
+            std::vector< uint32_t > fill( adjacency_offsets.begin(),
+                                          adjacency_offsets.end() - 1 );
+            for ( uint32_t i = 0; i < local_indices.size(); ++i )
+            {
+                adjacency[fill[local_indices[i]]++] = i / 3;
+            }
+
+            used.assign( triangle_count, false );
+            stamps.assign( local_count, ~0u );
+            out_indices.reserve( triangle_count * 3 );
+
+            // Grow every meshlet from the first unused triangle, preferring neighbours
+            // of the last triangle and then of the whole meshlet.
+            std::vector< uint32_t > meshlet_triangles;
+            meshlet_triangles.reserve( meshlet::MAX_TRIANGLES );
+
+            for ( uint32_t seed = 0; seed < triangle_count; ++seed )
+            {
+                if ( used[seed] )
+                {
+                    continue;
+                }
+
+                meshlet_triangles.clear();
+
+                for ( uint32_t tri = seed; tri != triangle_count; )
+                {
+                    add( tri );
+                    meshlet_triangles.push_back( tri );
+
+                    tri = best_neighbour( &tri, 1 );
+                    if ( tri == triangle_count )
+                    {
+                        tri = best_neighbour( meshlet_triangles.data(),
+                                              meshlet_triangles.size() );
+                    }
+                }
+
+                flush();
+            }
         }
+    };
 
-        return std::move( m );
+    void compute_meshlet_bounds( const model_data& m, meshlet& out )
+    {
+        const auto* first = m.index_data.data() + out.first_index;
+        const auto* last  = first + out.triangle_count * 3;
+
+        glm::vec3 lo( std::numeric_limits< float >::max() );
+        glm::vec3 hi( -std::numeric_limits< float >::max() );
+        for ( auto it = first; it != last; ++it )
+        {
+            lo = glm::min( lo, m.vertex_data[*it].position );
+            hi = glm::max( hi, m.vertex_data[*it].position );
+        }
+
+        const glm::vec3 center = ( lo + hi ) * 0.5f;
+        float radius           = 0.0f;
+        for ( auto it = first; it != last; ++it )
+        {
+            radius =
+                std::max( radius, glm::length( m.vertex_data[*it].position - center ) );
+        }
+
+        // degenerate triangles don't contribute to the cone
+        std::vector< glm::vec3 > normals;
+        normals.reserve( out.triangle_count );
+
+        glm::vec3 axis( 0.0f );
+        for ( auto it = first; it != last; it += 3 )
+        {
+            const auto& p0 = m.vertex_data[it[0]].position;
+            const auto& p1 = m.vertex_data[it[1]].position;
+            const auto& p2 = m.vertex_data[it[2]].position;
+
+            const glm::vec3 n = glm::cross( p1 - p0, p2 - p0 );
+            const float len   = glm::length( n );
+
+            if ( len > 0.0f )
+            {
+                normals.push_back( n / len );
+                axis += normals.back();
+            }
+        }
+
+        float cutoff    = 1.0f;
+        const float len = glm::length( axis );
+
+        if ( len > 0.0f )
+        {
+            axis /= len;
+
+            float min_dot = 1.0f;
+            for ( const auto& n : normals )
+            {
+                min_dot = std::min( min_dot, glm::dot( n, axis ) );
+            }
+
+            // a cone wider than a half space can't face away from anything
+            cutoff = min_dot > 0.0f ? std::sqrt( 1.0f - min_dot * min_dot ) : 1.0f;
+        }
+
+        out.sphere = glm::vec4( center, radius );
+        out.cone   = glm::vec4( axis, cutoff );
     }
 } // namespace detail
 
+model_data calculate_normals( model_data&& m )
+{
+    for ( uint32_t i = 0; i < m.index_data.size(); i += 3 )
+    {
+        auto& v0 = m.vertex_data[m.index_data[i]];
+        auto& v1 = m.vertex_data[m.index_data[i + 1]];
+        auto& v2 = m.vertex_data[m.index_data[i + 2]];
+
+        const auto n = glm::normalize(
+            glm::cross( v1.position - v0.position, v2.position - v0.position ) );
+
+        v0.normal += n;
+        v1.normal += n;
+        v2.normal += n;
+    }
+
+    for ( auto& v : m.vertex_data )
+    {
+        v.normal = glm::normalize( v.normal );
+    }
+
+    return std::move( m );
+}
+
 model_data load_model( const char* file_name )
 {
+    PROFILE_SCOPE( "load_model" );
+
     model_data ret{};
     tinyobj::attrib_t attrib;
 
@@ -82,5 +330,54 @@ model_data load_model( const char* file_name )
         }
     }
 
-    return detail::calculate_normals( std::move( ret ) );
-}
\ No newline at end of file
+    return calculate_normals( std::move( ret ) );
+}
+
+void build_meshlets( model_data& model, thread_pool& pool )
+{
+    NEO_ASSERT_ALWAYS( model.lods.empty(), "Meshlets have to be built before the LODs" );
+
+    const auto triangle_count = static_cast< uint32_t >( model.index_data.size() / 3 );
+    const uint32_t chunk_count =
+        ( triangle_count + detail::MESHLET_CHUNK_TRIANGLES - 1 )
+        / detail::MESHLET_CHUNK_TRIANGLES;
+
+    std::vector< detail::meshlet_builder > builders( chunk_count );
+
+    pool.parallel_for( chunk_count, 1, [&]( uint32_t begin, uint32_t end ) {
+        for ( uint32_t c = begin; c < end; ++c )
+        {
+            const uint32_t first = c * detail::MESHLET_CHUNK_TRIANGLES;
+
+            builders[c].indices = model.index_data.data() + first * 3;
+            builders[c].triangle_count =
+                std::min( detail::MESHLET_CHUNK_TRIANGLES, triangle_count - first );
+            builders[c].build();
+        }
+    } );
+
+    // chunks keep their place in the index data, only their triangles are reordered
+    model.meshlets.clear();
+
+    for ( uint32_t c = 0; c < chunk_count; ++c )
+    {
+        const uint32_t first_index = c * detail::MESHLET_CHUNK_TRIANGLES * 3;
+
+        std::copy( builders[c].out_indices.begin(), builders[c].out_indices.end(),
+                   model.index_data.begin() + first_index );
+
+        for ( auto m : builders[c].out_meshlets )
+        {
+            m.first_index += first_index;
+            model.meshlets.push_back( m );
+        }
+    }
+
+    pool.parallel_for( static_cast< uint32_t >( model.meshlets.size() ), 64,
+                       [&model]( uint32_t begin, uint32_t end ) {
+                           for ( uint32_t i = begin; i < end; ++i )
+                           {
+                               detail::compute_meshlet_bounds( model, model.meshlets[i] );
+                           }
+                       } );
+}
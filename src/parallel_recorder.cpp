@@ -0,0 +1,111 @@
+#include "parallel_recorder.hpp"
+
+#include "cpu_profiler.hpp"
+#include "debug.hpp"
+
+#include <algorithm>
+
+void parallel_recorder::initialize( uint32_t partitions, uint32_t frame_count )
+{
+    NEO_ASSERT_ALWAYS( partitions > 0, "At least one partition is needed" );
+
+    m_partitions = partitions;
+
+    m_pools.resize( partitions * frame_count );
+    m_buffers.resize( partitions * frame_count );
+
+    // buffers are never reset one by one, only their pool
+    const VkCommandPoolCreateInfo pool_create_info = {
+        VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, nullptr,
+        VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        static_cast< uint32_t >( m_vulkan_data.selected_gfx_queue_idx )};
+
+    for ( size_t i = 0; i < m_pools.size(); ++i )
+    {
+        auto res = vkCreateCommandPool( m_vulkan_data.logical_device, &pool_create_info,
+                                        nullptr, &m_pools[i] );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Command pool creation failed" );
+
+        const VkCommandBufferAllocateInfo allocate_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, nullptr, m_pools[i],
+            VK_COMMAND_BUFFER_LEVEL_SECONDARY, 1};
+
+        res = vkAllocateCommandBuffers( m_vulkan_data.logical_device, &allocate_info,
+                                        &m_buffers[i] );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Allocation of command buffers failed" );
+    }
+}
+
+void parallel_recorder::deinitialize()
+{
+    // destroying a pool frees its buffers
+    for ( auto pool : m_pools )
+    {
+        vkDestroyCommandPool( m_vulkan_data.logical_device, pool, nullptr );
+    }
+
+    m_pools.clear();
+    m_buffers.clear();
+}
+
+render_queue_stats parallel_recorder::record( const render_queue& queue,
+                                              uint32_t frame_idx,
+                                              VkRenderPass render_pass, uint32_t subpass,
+                                              VkFramebuffer framebuffer,
+                                              VkCommandBufferUsageFlags usage,
+                                              application_data::frame_arena_t& arena )
+{
+    const uint32_t first = frame_idx * m_partitions;
+    NEO_ASSERT_ALWAYS( first < m_buffers.size(), "Frame ", frame_idx, " out of range" );
+
+    const VkCommandBufferInheritanceInfo inheritance_info = {
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        nullptr,
+        render_pass,
+        subpass,
+        framebuffer,
+        VK_FALSE,
+        0,
+        0};
+
+    const VkCommandBufferBeginInfo begin_info = {
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr,
+        usage | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &inheritance_info};
+
+    const uint32_t draws = queue.size();
+    const uint32_t grain = ( draws + m_partitions - 1 ) / m_partitions;
+
+    render_queue_stats* stats =
+        arena.allocate_array< render_queue_stats >( m_partitions );
+
+    // one partition per task, a partition past the end records an empty buffer
+    m_workers.parallel_for( m_partitions, 1, [&]( uint32_t begin, uint32_t end ) {
+        for ( uint32_t p = begin; p < end; ++p )
+        {
+            PROFILE_SCOPE( "record partition" );
+
+            const uint32_t draw_begin = std::min( p * grain, draws );
+            const uint32_t draw_end   = std::min( draw_begin + grain, draws );
+
+            vkResetCommandPool( m_vulkan_data.logical_device, m_pools[first + p], 0 );
+
+            VkCommandBuffer cmd = m_buffers[first + p];
+            vkBeginCommandBuffer( cmd, &begin_info );
+            stats[p] = queue.record( cmd, draw_begin, draw_end );
+            vkEndCommandBuffer( cmd );
+        }
+    } );
+
+    render_queue_stats total{};
+    for ( uint32_t p = 0; p < m_partitions; ++p )
+    {
+        total += stats[p];
+    }
+
+    return total;
+}
+
+void parallel_recorder::execute( VkCommandBuffer primary, uint32_t frame_idx ) const
+{
+    vkCmdExecuteCommands( primary, m_partitions, &m_buffers[frame_idx * m_partitions] );
+}
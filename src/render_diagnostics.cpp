@@ -0,0 +1,339 @@
+#include "render_diagnostics.hpp"
+
+#include "debug.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    // in the order vkGetQueryPoolResults returns them, the order of the bits
+    constexpr VkQueryPipelineStatisticFlags STATISTICS =
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+        | VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+        | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+        | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
+        | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+        | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+    constexpr uint32_t STATISTICS_COUNT = 6;
+} // namespace
+
+void render_diagnostics::initialize( VkExtent2D extent, uint32_t frame_count )
+{
+    m_extent    = extent;
+    m_frame_idx = 0;
+    m_has_statistics.assign( frame_count, false );
+    m_has_overdraw.assign( frame_count, false );
+    m_last_frame = {};
+
+    if ( m_vulkan_data.enabled_features.pipelineStatisticsQuery )
+    {
+        const VkQueryPoolCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, nullptr, 0,
+            VK_QUERY_TYPE_PIPELINE_STATISTICS,        frame_count, STATISTICS};
+
+        const auto res = vkCreateQueryPool( m_vulkan_data.logical_device, &create_info,
+                                            nullptr, &m_query_pool );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't create statistics query pool!" );
+    }
+    else
+    {
+        NEO_LOG_WARNING( vulkan, "Pipeline statistics queries are not supported" );
+    }
+
+    // blending R32 float isn't required by the spec
+    VkFormatProperties format_properties{};
+    vkGetPhysicalDeviceFormatProperties( m_vulkan_data.selected_device, OVERDRAW_FORMAT,
+                                         &format_properties );
+
+    if ( format_properties.optimalTilingFeatures
+         & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT )
+    {
+        create_overdraw_target( frame_count );
+    }
+    else
+    {
+        NEO_LOG_WARNING( vulkan,
+                         "Blending R32 float is not supported, no overdraw heatmap" );
+    }
+}
+
+void render_diagnostics::deinitialize()
+{
+    vkDestroyQueryPool( m_vulkan_data.logical_device, m_query_pool, nullptr );
+    m_query_pool = nullptr;
+
+    if ( overdraw_supported() )
+    {
+        destroy_overdraw_target();
+    }
+}
+
+void render_diagnostics::create_overdraw_target( uint32_t frame_count )
+{
+    m_overdraw = m_vulkan_data.create_image_2d(
+        m_extent, OVERDRAW_FORMAT,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT );
+
+    // cleared to no fragments, left for the copy into the readback buffer
+    const VkAttachmentDescription attachment = {0,
+                                                OVERDRAW_FORMAT,
+                                                VK_SAMPLE_COUNT_1_BIT,
+                                                VK_ATTACHMENT_LOAD_OP_CLEAR,
+                                                VK_ATTACHMENT_STORE_OP_STORE,
+                                                VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+                                                VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                                                VK_IMAGE_LAYOUT_UNDEFINED,
+                                                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL};
+
+    const VkAttachmentReference color_reference = {
+        0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+    const VkSubpassDescription subpass = {0,       VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                          0,       nullptr,
+                                          1,       &color_reference,
+                                          nullptr, nullptr,
+                                          0,       nullptr};
+
+    // the previous frame's copy reads the image before it is cleared again
+    const VkSubpassDependency dependency = {VK_SUBPASS_EXTERNAL,
+                                            0,
+                                            VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                            VK_ACCESS_TRANSFER_READ_BIT,
+                                            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                            0};
+
+    const VkRenderPassCreateInfo create_info = {VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+                                                nullptr,
+                                                0,
+                                                1,
+                                                &attachment,
+                                                1,
+                                                &subpass,
+                                                1,
+                                                &dependency};
+
+    auto res = vkCreateRenderPass( m_vulkan_data.logical_device, &create_info, nullptr,
+                                   &m_overdraw_render_pass );
+    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of overdraw render pass failed" );
+
+    const VkFramebufferCreateInfo framebuffer_info = {
+        VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+        nullptr,
+        0,
+        m_overdraw_render_pass,
+        1,
+        &m_overdraw.image_view,
+        m_extent.width,
+        m_extent.height,
+        1};
+
+    res = vkCreateFramebuffer( m_vulkan_data.logical_device, &framebuffer_info, nullptr,
+                               &m_overdraw_framebuffer );
+    NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of overdraw framebuffer failed" );
+
+    m_readback.resize( frame_count );
+    for ( auto& b : m_readback )
+    {
+        b = m_vulkan_data.create_buffer(
+            sizeof( float ) * m_extent.width * m_extent.height,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+    }
+}
+
+void render_diagnostics::destroy_overdraw_target()
+{
+    for ( auto& b : m_readback )
+    {
+        m_vulkan_data.destroy_buffer( b );
+    }
+    m_readback.clear();
+
+    vkDestroyFramebuffer( m_vulkan_data.logical_device, m_overdraw_framebuffer, nullptr );
+    vkDestroyRenderPass( m_vulkan_data.logical_device, m_overdraw_render_pass, nullptr );
+    m_overdraw_render_pass = nullptr;
+
+    m_vulkan_data.destroy_image( m_overdraw );
+}
+
+VkPipelineColorBlendAttachmentState render_diagnostics::overdraw_blend_attachment()
+{
+    return {VK_TRUE,
+            VK_BLEND_FACTOR_ONE,
+            VK_BLEND_FACTOR_ONE,
+            VK_BLEND_OP_ADD,
+            VK_BLEND_FACTOR_ONE,
+            VK_BLEND_FACTOR_ONE,
+            VK_BLEND_OP_ADD,
+            VK_COLOR_COMPONENT_R_BIT};
+}
+
+void render_diagnostics::begin_frame( VkCommandBuffer cmd, uint32_t frame_idx )
+{
+    NEO_ASSERT_ALWAYS( frame_idx < m_has_statistics.size(), "Frame ", frame_idx,
+                       " out of range" );
+
+    resolve( frame_idx );
+
+    m_frame_idx                 = frame_idx;
+    m_has_statistics[frame_idx] = false;
+    m_has_overdraw[frame_idx]   = false;
+
+    if ( statistics_supported() )
+    {
+        vkCmdResetQueryPool( cmd, m_query_pool, frame_idx, 1 );
+    }
+}
+
+void render_diagnostics::begin_statistics( VkCommandBuffer cmd )
+{
+    if ( statistics_supported() )
+    {
+        vkCmdBeginQuery( cmd, m_query_pool, m_frame_idx, 0 );
+    }
+}
+
+void render_diagnostics::end_statistics( VkCommandBuffer cmd )
+{
+    if ( statistics_supported() )
+    {
+        vkCmdEndQuery( cmd, m_query_pool, m_frame_idx );
+        m_has_statistics[m_frame_idx] = true;
+    }
+}
+
+void render_diagnostics::begin_overdraw( VkCommandBuffer cmd )
+{
+    NEO_ASSERT_ALWAYS( overdraw_supported(), "No overdraw heatmap on this device" );
+
+    const VkClearValue clear_value = {};
+
+    const VkRenderPassBeginInfo begin_info = {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                                              nullptr,
+                                              m_overdraw_render_pass,
+                                              m_overdraw_framebuffer,
+                                              {{0, 0}, m_extent},
+                                              1,
+                                              &clear_value};
+
+    vkCmdBeginRenderPass( cmd, &begin_info, VK_SUBPASS_CONTENTS_INLINE );
+}
+
+void render_diagnostics::end_overdraw( VkCommandBuffer cmd )
+{
+    vkCmdEndRenderPass( cmd );
+
+    // the render pass left the image in TRANSFER_SRC_OPTIMAL
+    {
+        const VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                                              nullptr,
+                                              VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                              VK_ACCESS_TRANSFER_READ_BIT,
+                                              VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                              VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                              VK_QUEUE_FAMILY_IGNORED,
+                                              VK_QUEUE_FAMILY_IGNORED,
+                                              m_overdraw.image,
+                                              {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                              1, &barrier );
+    }
+
+    const VkBufferImageCopy region = {0,
+                                      0,
+                                      0,
+                                      {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+                                      {0, 0, 0},
+                                      {m_extent.width, m_extent.height, 1}};
+
+    vkCmdCopyImageToBuffer( cmd, m_overdraw.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                            m_readback[m_frame_idx].buffer, 1, &region );
+
+    {
+        const VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+                                      VK_ACCESS_TRANSFER_WRITE_BIT,
+                                      VK_ACCESS_HOST_READ_BIT};
+
+        vkCmdPipelineBarrier( cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0,
+                              nullptr );
+    }
+
+    m_has_overdraw[m_frame_idx] = true;
+}
+
+void render_diagnostics::resolve( uint32_t frame_idx )
+{
+    if ( !m_has_statistics[frame_idx] && !m_has_overdraw[frame_idx] )
+    {
+        return;
+    }
+
+    frame_diagnostics ret{};
+
+    if ( m_has_statistics[frame_idx] )
+    {
+        // the counters, then the availability
+        std::array< uint64_t, STATISTICS_COUNT + 1 > results{};
+
+        const auto res = vkGetQueryPoolResults(
+            m_vulkan_data.logical_device, m_query_pool, frame_idx, 1,
+            sizeof( results ), results.data(), sizeof( results ),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS || res == VK_NOT_READY,
+                           "Couldn't read the statistics query!" );
+
+        if ( results[STATISTICS_COUNT] != 0 )
+        {
+            ret.input_vertices       = results[0];
+            ret.input_primitives     = results[1];
+            ret.vertex_invocations   = results[2];
+            ret.clipping_invocations = results[3];
+            ret.clipping_primitives  = results[4];
+            ret.fragment_invocations = results[5];
+
+            const double pixels = 1.0 * m_extent.width * m_extent.height;
+
+            ret.vertices_per_triangle =
+                ret.vertex_invocations / std::max( 1.0, 1.0 * ret.input_primitives );
+            ret.vertex_cache_miss_rate =
+                ret.vertex_invocations / std::max( 1.0, 1.0 * ret.input_vertices );
+            ret.shaded_per_pixel = ret.fragment_invocations / pixels;
+        }
+    }
+
+    if ( m_has_overdraw[frame_idx] )
+    {
+        const size_t pixels = size_t{m_extent.width} * m_extent.height;
+
+        void* data     = nullptr;
+        const auto res = vkMapMemory( m_vulkan_data.logical_device,
+                                      m_readback[frame_idx].memory, 0,
+                                      pixels * sizeof( float ), 0, &data );
+        NEO_ASSERT_ALWAYS( res == VK_SUCCESS, "Couldn't map overdraw memory!" );
+
+        // exact, a pixel would need 2^24 fragments to lose one
+        const float* counts = static_cast< const float* >( data );
+        for ( size_t i = 0; i < pixels; ++i )
+        {
+            const auto count = static_cast< uint32_t >( counts[i] );
+
+            ret.covered_pixels += count > 0 ? 1 : 0;
+            ret.rasterized_fragments += count;
+            ret.max_overdraw = std::max( ret.max_overdraw, count );
+        }
+
+        vkUnmapMemory( m_vulkan_data.logical_device, m_readback[frame_idx].memory );
+
+        ret.overdraw = ret.rasterized_fragments
+                       / std::max( 1.0, 1.0 * ret.covered_pixels );
+    }
+
+    m_last_frame = ret;
+}
@@ -0,0 +1,1130 @@
+#include "render_graph.hpp"
+
+#include "debug.hpp"
+#include "gpu_profiler.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // what an access implies for synchronization and for creating the resource
+    struct access_info
+    {
+        VkPipelineStageFlags stages;
+        VkAccessFlags read_access;
+        VkAccessFlags write_access; //!< 0 for read only accesses
+        VkImageLayout layout;
+        VkImageUsageFlags image_usage;
+        VkBufferUsageFlags buffer_usage;
+    };
+
+    access_info get_access_info( graph_access access )
+    {
+        switch ( access )
+        {
+        case graph_access::color_attachment:
+            return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
+                    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT
+                        | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                    0};
+        case graph_access::depth_attachment:
+            return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+                        | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
+                        | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                    0};
+        case graph_access::sampled:
+            return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+                        | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_SHADER_READ_BIT,
+                    0,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    VK_IMAGE_USAGE_SAMPLED_BIT,
+                    VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT};
+        case graph_access::storage_read:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_SHADER_READ_BIT,
+                    0,
+                    VK_IMAGE_LAYOUT_GENERAL,
+                    VK_IMAGE_USAGE_STORAGE_BIT,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
+        case graph_access::storage_write:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_SHADER_READ_BIT,
+                    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                    VK_IMAGE_LAYOUT_GENERAL,
+                    VK_IMAGE_USAGE_STORAGE_BIT,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
+        case graph_access::transfer_src:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_TRANSFER_READ_BIT,
+                    0,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT};
+        case graph_access::transfer_dst:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0,
+                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT};
+        case graph_access::indirect:
+            return {VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                    VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                    0,
+                    VK_IMAGE_LAYOUT_UNDEFINED,
+                    0,
+                    VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT};
+        case graph_access::vertex:
+            return {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                    VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT,
+                    0,
+                    VK_IMAGE_LAYOUT_UNDEFINED,
+                    0,
+                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT};
+        }
+
+        NEO_ASSERT_ALWAYS( false, "Unknown graph access" );
+        return {};
+    }
+
+    bool is_attachment( graph_access access )
+    {
+        return access == graph_access::color_attachment
+               || access == graph_access::depth_attachment;
+    }
+
+    // what the passes so far did to a resource, reads are only those synchronized with
+    // the last write
+    struct resource_state
+    {
+        VkPipelineStageFlags write_stages;
+        VkAccessFlags write_access;
+        VkPipelineStageFlags read_stages;
+        VkAccessFlags read_access;
+        VkImageLayout layout;
+    };
+
+    constexpr uint32_t NO_PASS = ~0u;
+} // namespace
+
+render_graph::resource render_graph::add_resource( resource_data data )
+{
+    NEO_ASSERT_ALWAYS( !m_compiled, "The graph is compiled already" );
+
+    data.first_pass = NO_PASS;
+    data.last_pass  = NO_PASS;
+
+    m_resources.push_back( std::move( data ) );
+    return static_cast< resource >( m_resources.size() - 1 );
+}
+
+render_graph::resource render_graph::create_image( const std::string& name,
+                                                   VkExtent2D extent, VkFormat format,
+                                                   VkImageAspectFlags aspect )
+{
+    resource_data data{};
+    data.name           = name;
+    data.is_image       = true;
+    data.extent         = extent;
+    data.format         = format;
+    data.aspect         = aspect;
+    data.initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    data.final_layout   = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    return add_resource( std::move( data ) );
+}
+
+render_graph::resource render_graph::create_buffer( const std::string& name,
+                                                    VkDeviceSize size )
+{
+    resource_data data{};
+    data.name = name;
+    data.size = size;
+
+    return add_resource( std::move( data ) );
+}
+
+render_graph::resource render_graph::import_image( const std::string& name,
+                                                   const image_data& image,
+                                                   VkImageLayout layout,
+                                                   VkImageLayout final_layout,
+                                                   VkImageAspectFlags aspect )
+{
+    resource_data data{};
+    data.name           = name;
+    data.is_image       = true;
+    data.imported       = true;
+    data.extent         = image.extent;
+    data.format         = image.format;
+    data.aspect         = aspect;
+    data.initial_layout = layout;
+    data.final_layout   = final_layout;
+    data.image          = image.image;
+    data.image_view     = image.image_view;
+
+    return add_resource( std::move( data ) );
+}
+
+render_graph::resource render_graph::import_buffer( const std::string& name,
+                                                    VkBuffer buffer, VkDeviceSize size )
+{
+    resource_data data{};
+    data.name     = name;
+    data.imported = true;
+    data.size     = size;
+    data.buffer   = buffer;
+
+    return add_resource( std::move( data ) );
+}
+
+render_graph::resource
+render_graph::import_images( const std::string& name,
+                             const std::vector< image_data >& images,
+                             VkImageLayout layout, VkImageLayout final_layout,
+                             VkImageAspectFlags aspect )
+{
+    NEO_ASSERT_ALWAYS( !images.empty(), name, " has no images" );
+    NEO_ASSERT_ALWAYS( m_image_count == 1 || m_image_count == images.size(), name,
+                       " has ", images.size(), " images, others have ", m_image_count );
+
+    for ( const auto& img : images )
+    {
+        NEO_ASSERT_ALWAYS( img.format == images[0].format
+                               && img.extent.width == images[0].extent.width
+                               && img.extent.height == images[0].extent.height,
+                           "The images of ", name, " differ" );
+    }
+
+    const resource r = import_image( name, images[0], layout, final_layout, aspect );
+    m_resources[r].images = images;
+    m_image_count         = static_cast< uint32_t >( images.size() );
+
+    return r;
+}
+
+void render_graph::mark_output( resource r )
+{
+    m_resources[r].output = true;
+}
+
+uint32_t render_graph::add_pass( const std::string& name, pass_type type,
+                                 std::function< void( VkCommandBuffer ) > execute )
+{
+    NEO_ASSERT_ALWAYS( !m_compiled, "The graph is compiled already" );
+
+    pass_data data{};
+    data.name    = name;
+    data.type    = type;
+    data.execute = std::move( execute );
+
+    m_passes.push_back( std::move( data ) );
+    return static_cast< uint32_t >( m_passes.size() - 1 );
+}
+
+void render_graph::read( uint32_t pass, resource r, graph_access access )
+{
+    NEO_ASSERT_ALWAYS( get_access_info( access ).read_access != 0,
+                       m_passes[pass].name, " can't read ", m_resources[r].name,
+                       " with a write only access" );
+
+    m_passes[pass].accesses.push_back( {r, access, false} );
+}
+
+void render_graph::write( uint32_t pass, resource r, graph_access access )
+{
+    NEO_ASSERT_ALWAYS( get_access_info( access ).write_access != 0,
+                       m_passes[pass].name, " can't write ", m_resources[r].name,
+                       " with a read only access" );
+
+    m_passes[pass].accesses.push_back( {r, access, true} );
+}
+
+void render_graph::clear( uint32_t pass, resource r, VkClearValue value )
+{
+    NEO_ASSERT_ALWAYS( m_passes[pass].type == pass_type::graphics,
+                       "Only graphics passes clear attachments, not ",
+                       m_passes[pass].name );
+
+    m_passes[pass].clears.push_back( {r, value} );
+}
+
+void render_graph::set_side_effects( uint32_t pass )
+{
+    m_passes[pass].side_effects = true;
+}
+
+void render_graph::set_secondary_buffers( uint32_t pass )
+{
+    NEO_ASSERT_ALWAYS( m_passes[pass].type == pass_type::graphics,
+                       "Only graphics passes execute secondary buffers, not ",
+                       m_passes[pass].name );
+
+    m_passes[pass].secondary_buffers = true;
+}
+
+void render_graph::compile()
+{
+    NEO_ASSERT_ALWAYS( !m_compiled, "The graph is compiled already" );
+
+    m_stats = {};
+
+    cull_passes();
+    find_lifetimes();
+    create_resources();
+    alias_memory();
+    create_render_passes();
+    build_barriers();
+
+    m_compiled = true;
+}
+
+void render_graph::cull_passes()
+{
+    std::vector< bool > needed( m_resources.size() );
+    for ( size_t r = 0; r < m_resources.size(); ++r )
+    {
+        needed[r] = m_resources[r].imported || m_resources[r].output;
+    }
+
+    // backwards, a pass lives when something needed comes out of it, then whatever it
+    // reads is needed as well. A cleared attachment doesn't depend on earlier writes.
+    for ( auto pass = m_passes.rbegin(); pass != m_passes.rend(); ++pass )
+    {
+        pass->live = pass->side_effects;
+
+        for ( const auto& a : pass->accesses )
+        {
+            pass->live = pass->live || ( a.writes && needed[a.r] );
+        }
+
+        if ( !pass->live )
+        {
+            ++m_stats.culled_passes;
+            continue;
+        }
+
+        ++m_stats.passes;
+
+        for ( const auto& a : pass->accesses )
+        {
+            const bool cleared =
+                std::any_of( pass->clears.begin(), pass->clears.end(),
+                             [&a]( const auto& c ) { return c.first == a.r; } );
+
+            needed[a.r] = needed[a.r] || !cleared;
+        }
+    }
+}
+
+void render_graph::find_lifetimes()
+{
+    for ( uint32_t p = 0; p < m_passes.size(); ++p )
+    {
+        if ( !m_passes[p].live )
+        {
+            continue;
+        }
+
+        for ( const auto& a : m_passes[p].accesses )
+        {
+            auto& res = m_resources[a.r];
+            const access_info info = get_access_info( a.access );
+
+            NEO_ASSERT_ALWAYS( res.is_image || info.buffer_usage != 0, res.name,
+                               " is a buffer, ", m_passes[p].name,
+                               " uses it like an image" );
+            NEO_ASSERT_ALWAYS( !res.is_image || info.image_usage != 0, res.name,
+                               " is an image, ", m_passes[p].name,
+                               " uses it like a buffer" );
+
+            // passes are visited in order
+            res.first_pass = res.first_pass == NO_PASS ? p : res.first_pass;
+            res.last_pass  = p;
+            res.image_usage |= info.image_usage;
+            res.buffer_usage |= info.buffer_usage;
+        }
+    }
+
+    // Touched by one graphics pass only and never seen outside, its contents don't
+    // have to exist in memory. Such attachments can live in tile memory.
+    for ( auto& res : m_resources )
+    {
+        res.lazy = false;
+
+        if ( res.imported || res.output || !res.is_image || res.first_pass == NO_PASS
+             || res.first_pass != res.last_pass
+             || m_passes[res.first_pass].type != pass_type::graphics )
+        {
+            continue;
+        }
+
+        const auto& accesses = m_passes[res.first_pass].accesses;
+        res.lazy             = std::all_of(
+            accesses.begin(), accesses.end(), [&res, this]( const pass_access& a ) {
+                return &m_resources[a.r] != &res || is_attachment( a.access );
+            } );
+    }
+}
+
+void render_graph::create_resources()
+{
+    for ( auto& res : m_resources )
+    {
+        if ( res.imported || res.first_pass == NO_PASS )
+        {
+            continue;
+        }
+
+        if ( res.is_image )
+        {
+            const VkImageUsageFlags transient_usage =
+                VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+            const VkImageCreateInfo create_info = {
+                VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                nullptr,
+                0,
+                VK_IMAGE_TYPE_2D,
+                res.format,
+                {res.extent.width, res.extent.height, 1},
+                1,
+                1,
+                VK_SAMPLE_COUNT_1_BIT,
+                VK_IMAGE_TILING_OPTIMAL,
+                res.image_usage | ( res.lazy ? transient_usage : 0 ),
+                VK_SHARING_MODE_EXCLUSIVE,
+                0,
+                nullptr,
+                VK_IMAGE_LAYOUT_UNDEFINED};
+
+            const auto res_create = vkCreateImage( m_vulkan_data.logical_device,
+                                                   &create_info, nullptr, &res.image );
+            NEO_ASSERT_ALWAYS( VK_SUCCESS == res_create, "Couldn't create ", res.name );
+        }
+        else
+        {
+            const VkBufferCreateInfo create_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                                                    nullptr,
+                                                    0,
+                                                    res.size,
+                                                    res.buffer_usage,
+                                                    VK_SHARING_MODE_EXCLUSIVE,
+                                                    0,
+                                                    nullptr};
+
+            const auto res_create = vkCreateBuffer( m_vulkan_data.logical_device,
+                                                    &create_info, nullptr, &res.buffer );
+            NEO_ASSERT_ALWAYS( VK_SUCCESS == res_create, "Couldn't create ", res.name );
+        }
+    }
+}
+
+void render_graph::alias_memory()
+{
+    VkPhysicalDeviceMemoryProperties memory_properties{};
+    vkGetPhysicalDeviceMemoryProperties( m_vulkan_data.selected_device,
+                                         &memory_properties );
+
+    struct placement
+    {
+        resource r;
+        uint32_t heap;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        VkDeviceSize alignment;
+    };
+
+    // Images and buffers get heaps of their own, so bufferImageGranularity never
+    // matters. Heaps are identified by memory type and kind.
+    std::vector< std::pair< uint32_t, bool > > heap_keys;
+    std::vector< VkDeviceSize > heap_sizes;
+    std::vector< placement > placements;
+
+    for ( resource r = 0; r < m_resources.size(); ++r )
+    {
+        auto& res = m_resources[r];
+        if ( res.imported || res.first_pass == NO_PASS )
+        {
+            continue;
+        }
+
+        VkMemoryRequirements requirements{};
+        if ( res.is_image )
+        {
+            vkGetImageMemoryRequirements( m_vulkan_data.logical_device, res.image,
+                                          &requirements );
+        }
+        else
+        {
+            vkGetBufferMemoryRequirements( m_vulkan_data.logical_device, res.buffer,
+                                           &requirements );
+        }
+
+        m_stats.transient_bytes += requirements.size;
+
+        if ( res.lazy )
+        {
+            uint32_t lazy_type = memory_properties.memoryTypeCount;
+            for ( uint32_t t = 0; t < memory_properties.memoryTypeCount; ++t )
+            {
+                if ( ( requirements.memoryTypeBits & ( 1u << t ) )
+                     && ( memory_properties.memoryTypes[t].propertyFlags
+                          & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT ) )
+                {
+                    lazy_type = t;
+                    break;
+                }
+            }
+
+            // most desktop GPUs have no lazily allocated memory, the image is aliased
+            // like any other
+            if ( lazy_type < memory_properties.memoryTypeCount )
+            {
+                const VkMemoryAllocateInfo allocate_info = {
+                    VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, requirements.size,
+                    lazy_type};
+
+                auto res_alloc = vkAllocateMemory( m_vulkan_data.logical_device,
+                                                   &allocate_info, nullptr,
+                                                   &res.own_memory );
+                NEO_ASSERT_ALWAYS( VK_SUCCESS == res_alloc,
+                                   "Allocating lazy memory failed for ", res.name );
+
+                res_alloc = vkBindImageMemory( m_vulkan_data.logical_device, res.image,
+                                               res.own_memory, 0 );
+                NEO_ASSERT_ALWAYS( VK_SUCCESS == res_alloc, "Binding ", res.name,
+                                   " failed" );
+
+                ++m_stats.lazy_images;
+                continue;
+            }
+
+            res.lazy = false;
+        }
+
+        const uint32_t type = m_vulkan_data.get_memory_type_idx(
+            requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+        const std::pair< uint32_t, bool > key{type, res.is_image};
+
+        auto it = std::find( heap_keys.begin(), heap_keys.end(), key );
+        if ( it == heap_keys.end() )
+        {
+            heap_keys.push_back( key );
+            heap_sizes.push_back( 0 );
+            it = heap_keys.end() - 1;
+        }
+
+        placements.push_back( {r, static_cast< uint32_t >( it - heap_keys.begin() ), 0,
+                               requirements.size, requirements.alignment} );
+    }
+
+    const auto lifetimes_overlap = [this]( resource a, resource b ) {
+        return m_resources[a].first_pass <= m_resources[b].last_pass
+               && m_resources[b].first_pass <= m_resources[a].last_pass;
+    };
+
+    // Largest first, each goes to the lowest offset that doesn't overlap the memory of
+    // an already placed resource alive at the same time.
+    std::vector< size_t > order( placements.size() );
+    for ( size_t i = 0; i < order.size(); ++i )
+    {
+        order[i] = i;
+    }
+    std::stable_sort( order.begin(), order.end(), [&placements]( size_t a, size_t b ) {
+        return placements[a].size > placements[b].size;
+    } );
+
+    std::vector< size_t > placed;
+
+    for ( const size_t i : order )
+    {
+        auto& p = placements[i];
+
+        std::vector< const placement* > conflicts;
+        for ( const size_t j : placed )
+        {
+            if ( placements[j].heap == p.heap
+                 && lifetimes_overlap( placements[j].r, p.r ) )
+            {
+                conflicts.push_back( &placements[j] );
+            }
+        }
+
+        std::sort( conflicts.begin(), conflicts.end(),
+                   []( const placement* a, const placement* b ) {
+                       return a->offset < b->offset;
+                   } );
+
+        VkDeviceSize offset = 0;
+        for ( const auto* c : conflicts )
+        {
+            if ( offset + p.size <= c->offset )
+            {
+                break;
+            }
+
+            offset = std::max( offset, c->offset + c->size );
+            offset = ( offset + p.alignment - 1 ) / p.alignment * p.alignment;
+        }
+
+        p.offset           = offset;
+        heap_sizes[p.heap] = std::max( heap_sizes[p.heap], offset + p.size );
+        placed.push_back( i );
+    }
+
+    m_heaps.resize( heap_keys.size() );
+    for ( size_t h = 0; h < m_heaps.size(); ++h )
+    {
+        const VkMemoryAllocateInfo allocate_info = {
+            VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, heap_sizes[h],
+            heap_keys[h].first};
+
+        const auto res_alloc = vkAllocateMemory( m_vulkan_data.logical_device,
+                                                 &allocate_info, nullptr, &m_heaps[h] );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res_alloc, "Allocating a graph heap of ",
+                           heap_sizes[h], " bytes failed" );
+
+        m_stats.allocated_bytes += heap_sizes[h];
+    }
+
+    for ( const auto& p : placements )
+    {
+        auto& res = m_resources[p.r];
+
+        const auto res_bind =
+            res.is_image ? vkBindImageMemory( m_vulkan_data.logical_device, res.image,
+                                              m_heaps[p.heap], p.offset )
+                         : vkBindBufferMemory( m_vulkan_data.logical_device, res.buffer,
+                                               m_heaps[p.heap], p.offset );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res_bind, "Binding ", res.name, " failed" );
+    }
+
+    // views need the memory bound
+    for ( auto& res : m_resources )
+    {
+        if ( res.imported || !res.is_image || res.first_pass == NO_PASS )
+        {
+            continue;
+        }
+
+        const VkImageViewCreateInfo view_create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            nullptr,
+            0,
+            res.image,
+            VK_IMAGE_VIEW_TYPE_2D,
+            res.format,
+            {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+             VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY},
+            {res.aspect, 0, 1, 0, 1}};
+
+        const auto res_view = vkCreateImageView( m_vulkan_data.logical_device,
+                                                 &view_create_info, nullptr,
+                                                 &res.image_view );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res_view, "Couldn't create a view of ",
+                           res.name );
+    }
+}
+
+void render_graph::create_render_passes()
+{
+    for ( uint32_t p = 0; p < m_passes.size(); ++p )
+    {
+        auto& pass = m_passes[p];
+        if ( !pass.live || pass.type != pass_type::graphics )
+        {
+            continue;
+        }
+
+        std::vector< resource > attachments;
+        std::vector< VkAttachmentDescription > descriptions;
+        std::vector< VkAttachmentReference > color_references;
+        VkAttachmentReference depth_reference{VK_ATTACHMENT_UNUSED,
+                                              VK_IMAGE_LAYOUT_UNDEFINED};
+
+        for ( const auto& a : pass.accesses )
+        {
+            if ( !is_attachment( a.access )
+                 || std::find( attachments.begin(), attachments.end(), a.r )
+                        != attachments.end() )
+            {
+                continue;
+            }
+
+            const auto& res = m_resources[a.r];
+            const auto index = static_cast< uint32_t >( attachments.size() );
+            const VkImageLayout layout = get_access_info( a.access ).layout;
+
+            const auto clear =
+                std::find_if( pass.clears.begin(), pass.clears.end(),
+                              [&a]( const auto& c ) { return c.first == a.r; } );
+
+            // what an imported image held before is only kept when its layout is known
+            const bool has_contents =
+                ( res.imported && res.initial_layout != VK_IMAGE_LAYOUT_UNDEFINED )
+                || res.first_pass < p;
+            const bool is_read_later = res.imported || res.output || res.last_pass > p;
+
+            const VkAttachmentLoadOp load_op =
+                clear != pass.clears.end()
+                    ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                    : ( has_contents ? VK_ATTACHMENT_LOAD_OP_LOAD
+                                     : VK_ATTACHMENT_LOAD_OP_DONT_CARE );
+            const VkAttachmentStoreOp store_op = is_read_later
+                                                     ? VK_ATTACHMENT_STORE_OP_STORE
+                                                     : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+            const bool stencil = ( res.aspect & VK_IMAGE_ASPECT_STENCIL_BIT ) != 0;
+
+            // the barriers before the pass do the layout transitions
+            descriptions.push_back(
+                {0, res.format, VK_SAMPLE_COUNT_1_BIT, load_op, store_op,
+                 stencil ? load_op : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+                 stencil ? store_op : VK_ATTACHMENT_STORE_OP_DONT_CARE, layout, layout} );
+
+            if ( a.access == graph_access::depth_attachment )
+            {
+                depth_reference = {index, layout};
+            }
+            else
+            {
+                color_references.push_back( {index, layout} );
+            }
+
+            attachments.push_back( a.r );
+            pass.clear_values.push_back( clear != pass.clears.end() ? clear->second
+                                                                    : VkClearValue{} );
+        }
+
+        NEO_ASSERT_ALWAYS( !attachments.empty(), "Graphics pass ", pass.name,
+                           " has no attachments" );
+
+        pass.extent = m_resources[attachments[0]].extent;
+
+        // a framebuffer per image index when one of the attachments has several images
+        uint32_t framebuffer_count = 1;
+        for ( const auto r : attachments )
+        {
+            NEO_ASSERT_ALWAYS( m_resources[r].extent.width == pass.extent.width
+                                   && m_resources[r].extent.height == pass.extent.height,
+                               "Attachments of ", pass.name, " differ in size" );
+
+            if ( !m_resources[r].images.empty() )
+            {
+                framebuffer_count = m_image_count;
+            }
+        }
+
+        const VkSubpassDescription subpass = {
+            0,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            0,
+            nullptr,
+            static_cast< uint32_t >( color_references.size() ),
+            color_references.data(),
+            nullptr,
+            depth_reference.attachment != VK_ATTACHMENT_UNUSED ? &depth_reference
+                                                               : nullptr,
+            0,
+            nullptr};
+
+        const VkRenderPassCreateInfo create_info = {
+            VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+            nullptr,
+            0,
+            static_cast< uint32_t >( descriptions.size() ),
+            descriptions.data(),
+            1,
+            &subpass,
+            0,
+            nullptr};
+
+        auto res = vkCreateRenderPass( m_vulkan_data.logical_device, &create_info,
+                                       nullptr, &pass.render_pass );
+        NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of render pass ", pass.name,
+                           " failed" );
+
+        pass.framebuffers.resize( framebuffer_count );
+
+        for ( uint32_t i = 0; i < framebuffer_count; ++i )
+        {
+            std::vector< VkImageView > views;
+            for ( const auto r : attachments )
+            {
+                const auto& images = m_resources[r].images;
+                views.push_back( images.empty() ? m_resources[r].image_view
+                                                : images[i].image_view );
+            }
+
+            const VkFramebufferCreateInfo framebuffer_info = {
+                VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+                nullptr,
+                0,
+                pass.render_pass,
+                static_cast< uint32_t >( views.size() ),
+                views.data(),
+                pass.extent.width,
+                pass.extent.height,
+                1};
+
+            res = vkCreateFramebuffer( m_vulkan_data.logical_device, &framebuffer_info,
+                                       nullptr, &pass.framebuffers[i] );
+            NEO_ASSERT_ALWAYS( VK_SUCCESS == res, "Creation of framebuffer for ",
+                               pass.name, " failed" );
+        }
+    }
+}
+
+void render_graph::build_barriers()
+{
+    std::vector< resource_state > states( m_resources.size() );
+
+    for ( size_t r = 0; r < m_resources.size(); ++r )
+    {
+        const auto& res = m_resources[r];
+
+        // Nothing is known about what happened outside. The memory of a transient
+        // resource was last used by an earlier pass aliasing it or by the previous
+        // execute(), which may still run when frames overlap, so the first access
+        // waits for everything before.
+        states[r].write_stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        states[r].write_access = VK_ACCESS_MEMORY_WRITE_BIT;
+
+        states[r].layout = res.imported ? res.initial_layout : VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+
+    const auto add_barrier = [this]( VkPipelineStageFlags& src_stages,
+                                     VkPipelineStageFlags& dst_stages,
+                                     std::vector< VkImageMemoryBarrier >& images,
+                                     std::vector< VkBufferMemoryBarrier >& buffers,
+                                     resource r, VkPipelineStageFlags src,
+                                     VkAccessFlags src_access, VkPipelineStageFlags dst,
+                                     VkAccessFlags dst_access, VkImageLayout old_layout,
+                                     VkImageLayout new_layout ) {
+        const auto& res = m_resources[r];
+
+        src_stages |= src != 0 ? src
+                              : VkPipelineStageFlags{VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT};
+        dst_stages |= dst;
+
+        if ( res.is_image )
+        {
+            images.push_back( {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                               nullptr,
+                               src_access,
+                               dst_access,
+                               old_layout,
+                               new_layout,
+                               VK_QUEUE_FAMILY_IGNORED,
+                               VK_QUEUE_FAMILY_IGNORED,
+                               res.image,
+                               {res.aspect, 0, VK_REMAINING_MIP_LEVELS, 0,
+                                VK_REMAINING_ARRAY_LAYERS}} );
+        }
+        else
+        {
+            buffers.push_back( {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+                                src_access, dst_access, VK_QUEUE_FAMILY_IGNORED,
+                                VK_QUEUE_FAMILY_IGNORED, res.buffer, 0, VK_WHOLE_SIZE} );
+        }
+    };
+
+    for ( auto& pass : m_passes )
+    {
+        if ( !pass.live )
+        {
+            continue;
+        }
+
+        pass.src_stages = 0;
+        pass.dst_stages = 0;
+
+        // all accesses of a resource within the pass are one
+        std::vector< resource > touched;
+        for ( const auto& a : pass.accesses )
+        {
+            if ( std::find( touched.begin(), touched.end(), a.r ) == touched.end() )
+            {
+                touched.push_back( a.r );
+            }
+        }
+
+        for ( const resource r : touched )
+        {
+            VkPipelineStageFlags stages = 0;
+            VkAccessFlags access        = 0;
+            VkImageLayout layout        = VK_IMAGE_LAYOUT_UNDEFINED;
+            bool writes                 = false;
+
+            for ( const auto& a : pass.accesses )
+            {
+                if ( a.r != r )
+                {
+                    continue;
+                }
+
+                const access_info info = get_access_info( a.access );
+                NEO_ASSERT_ALWAYS( layout == VK_IMAGE_LAYOUT_UNDEFINED
+                                       || layout == info.layout,
+                                   pass.name, " needs ", m_resources[r].name,
+                                   " in two layouts" );
+
+                stages |= info.stages;
+                access |= a.writes ? info.write_access : info.read_access;
+                layout = info.layout;
+                writes = writes || a.writes;
+            }
+
+            auto& state = states[r];
+            const bool transition = m_resources[r].is_image && state.layout != layout;
+
+            if ( writes || transition )
+            {
+                // after everything before, a layout transition writes as well
+                const VkPipelineStageFlags src = state.write_stages | state.read_stages;
+
+                if ( src != 0 || transition )
+                {
+                    add_barrier( pass.src_stages, pass.dst_stages,
+                                 pass.image_barriers, pass.buffer_barriers, r, src,
+                                 state.write_access, stages, access, state.layout,
+                                 m_resources[r].is_image ? layout : state.layout );
+                }
+
+                state.write_stages = stages;
+                state.write_access = writes ? access : 0;
+                state.read_stages  = writes ? 0 : stages;
+                state.read_access  = writes ? 0 : access;
+                state.layout       = m_resources[r].is_image ? layout : state.layout;
+            }
+            else
+            {
+                // read after read needs nothing, a new kind of read waits for the write
+                if ( state.write_stages != 0
+                     && ( ( stages & ~state.read_stages ) != 0
+                          || ( access & ~state.read_access ) != 0 ) )
+                {
+                    add_barrier( pass.src_stages, pass.dst_stages,
+                                 pass.image_barriers, pass.buffer_barriers, r,
+                                 state.write_stages, state.write_access, stages, access,
+                                 state.layout, state.layout );
+                }
+
+                state.read_stages |= stages;
+                state.read_access |= access;
+            }
+        }
+
+        if ( !pass.image_barriers.empty() || !pass.buffer_barriers.empty() )
+        {
+            ++m_stats.barriers;
+            m_stats.image_barriers +=
+                static_cast< uint32_t >( pass.image_barriers.size() );
+            m_stats.buffer_barriers +=
+                static_cast< uint32_t >( pass.buffer_barriers.size() );
+        }
+    }
+
+    // imported images go back to what their owner expects
+    VkPipelineStageFlags final_dst = 0;
+    std::vector< VkBufferMemoryBarrier > no_buffers;
+
+    for ( resource r = 0; r < m_resources.size(); ++r )
+    {
+        const auto& res = m_resources[r];
+        const auto& state = states[r];
+
+        if ( res.imported && res.is_image && state.layout != res.final_layout
+             && res.final_layout != VK_IMAGE_LAYOUT_UNDEFINED )
+        {
+            add_barrier( m_final_src_stages, final_dst, m_final_barriers,
+                         no_buffers, r, state.write_stages | state.read_stages,
+                         state.write_access, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                         state.layout, res.final_layout );
+        }
+    }
+
+    if ( !m_final_barriers.empty() )
+    {
+        ++m_stats.barriers;
+        m_stats.image_barriers += static_cast< uint32_t >( m_final_barriers.size() );
+    }
+
+    for ( auto& pass : m_passes )
+    {
+        expand_image_barriers( pass.image_barriers );
+    }
+    expand_image_barriers( m_final_barriers );
+}
+
+void render_graph::expand_image_barriers(
+    std::vector< VkImageMemoryBarrier >& barriers ) const
+{
+    const size_t count = barriers.size();
+    barriers.reserve( count * m_image_count );
+
+    // the barriers were built for the first image of every import_images() resource
+    for ( uint32_t i = 1; i < m_image_count; ++i )
+    {
+        for ( size_t b = 0; b < count; ++b )
+        {
+            VkImageMemoryBarrier barrier = barriers[b];
+
+            for ( const auto& res : m_resources )
+            {
+                if ( !res.images.empty() && barrier.image == res.image )
+                {
+                    barrier.image = res.images[i].image;
+                }
+            }
+
+            barriers.push_back( barrier );
+        }
+    }
+}
+
+void render_graph::execute( VkCommandBuffer cmd, uint32_t image_idx,
+                            gpu_profiler* profiler ) const
+{
+    NEO_ASSERT_ALWAYS( m_compiled, "The graph has to be compiled first" );
+    NEO_ASSERT_ALWAYS( image_idx < m_image_count, "Image ", image_idx, " of ",
+                       m_image_count );
+
+    for ( uint32_t p = 0; p < m_passes.size(); ++p )
+    {
+        const auto& pass = m_passes[p];
+        if ( !pass.live )
+        {
+            continue;
+        }
+
+        const uint32_t slot =
+            profiler != nullptr ? profiler->begin( cmd, pass.name.c_str() ) : 0;
+
+        const size_t image_barrier_count = pass.image_barriers.size() / m_image_count;
+
+        if ( image_barrier_count != 0 || !pass.buffer_barriers.empty() )
+        {
+            vkCmdPipelineBarrier(
+                cmd, pass.src_stages, pass.dst_stages, 0, 0, nullptr,
+                static_cast< uint32_t >( pass.buffer_barriers.size() ),
+                pass.buffer_barriers.data(),
+                static_cast< uint32_t >( image_barrier_count ),
+                pass.image_barriers.data() + image_idx * image_barrier_count );
+        }
+
+        if ( pass.type == pass_type::graphics )
+        {
+            const VkRenderPassBeginInfo begin_info = {
+                VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                nullptr,
+                pass.render_pass,
+                framebuffer( p, image_idx ),
+                {{0, 0}, pass.extent},
+                static_cast< uint32_t >( pass.clear_values.size() ),
+                pass.clear_values.data()};
+
+            vkCmdBeginRenderPass( cmd, &begin_info,
+                                  pass.secondary_buffers
+                                      ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                      : VK_SUBPASS_CONTENTS_INLINE );
+            pass.execute( cmd );
+            vkCmdEndRenderPass( cmd );
+        }
+        else
+        {
+            pass.execute( cmd );
+        }
+
+        if ( profiler != nullptr )
+        {
+            profiler->end( cmd, slot );
+        }
+    }
+
+    const size_t final_barrier_count = m_final_barriers.size() / m_image_count;
+
+    if ( final_barrier_count != 0 )
+    {
+        vkCmdPipelineBarrier( cmd, m_final_src_stages,
+                              VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0,
+                              nullptr, static_cast< uint32_t >( final_barrier_count ),
+                              m_final_barriers.data() + image_idx * final_barrier_count );
+    }
+}
+
+void render_graph::deinitialize()
+{
+    for ( auto& pass : m_passes )
+    {
+        for ( auto framebuffer : pass.framebuffers )
+        {
+            vkDestroyFramebuffer( m_vulkan_data.logical_device, framebuffer, nullptr );
+        }
+        vkDestroyRenderPass( m_vulkan_data.logical_device, pass.render_pass, nullptr );
+    }
+
+    for ( auto& res : m_resources )
+    {
+        if ( res.imported )
+        {
+            continue;
+        }
+
+        vkDestroyImageView( m_vulkan_data.logical_device, res.image_view, nullptr );
+        vkDestroyImage( m_vulkan_data.logical_device, res.image, nullptr );
+        vkDestroyBuffer( m_vulkan_data.logical_device, res.buffer, nullptr );
+        vkFreeMemory( m_vulkan_data.logical_device, res.own_memory, nullptr );
+    }
+
+    for ( auto heap : m_heaps )
+    {
+        vkFreeMemory( m_vulkan_data.logical_device, heap, nullptr );
+    }
+
+    m_passes.clear();
+    m_resources.clear();
+    m_heaps.clear();
+    m_final_barriers.clear();
+    m_final_src_stages = 0;
+    m_image_count      = 1;
+    m_compiled         = false;
+}
+
+VkFramebuffer render_graph::framebuffer( uint32_t pass, uint32_t image_idx ) const
+{
+    const auto& framebuffers = m_passes[pass].framebuffers;
+    NEO_ASSERT_ALWAYS( !framebuffers.empty(), m_passes[pass].name,
+                       " is no graphics pass or was culled" );
+
+    return framebuffers.size() == 1 ? framebuffers[0] : framebuffers[image_idx];
+}
+
+VkImage render_graph::image( resource r ) const
+{
+    NEO_ASSERT_ALWAYS( m_resources[r].image != nullptr, m_resources[r].name,
+                       " is no image or was never created" );
+    return m_resources[r].image;
+}
+
+VkImageView render_graph::image_view( resource r ) const
+{
+    NEO_ASSERT_ALWAYS( m_resources[r].image_view != nullptr, m_resources[r].name,
+                       " is no image or was never created" );
+    return m_resources[r].image_view;
+}
+
+VkBuffer render_graph::buffer( resource r ) const
+{
+    NEO_ASSERT_ALWAYS( m_resources[r].buffer != nullptr, m_resources[r].name,
+                       " is no buffer or was never created" );
+    return m_resources[r].buffer;
+}
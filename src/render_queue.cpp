@@ -0,0 +1,193 @@
+#include "render_queue.hpp"
+
+#include "debug.hpp"
+
+#include <algorithm>
+#include <array>
+
+uint64_t make_sort_key( uint32_t pipeline, uint32_t set, uint32_t material, float depth )
+{
+    NEO_ASSERT_ALWAYS( pipeline < ( 1u << 12 ) && set < ( 1u << 16 )
+                           && material < ( 1u << 16 ),
+                       "Sort key id out of range: ", pipeline, ", ", set, ", ",
+                       material );
+
+    constexpr uint32_t DEPTH_MAX = ( 1u << 20 ) - 1;
+
+    const auto quantized =
+        static_cast< uint32_t >( std::min( std::max( depth, 0.0f ), 1.0f ) * DEPTH_MAX );
+
+    return uint64_t{pipeline} << 52 | uint64_t{set} << 36 | uint64_t{material} << 20
+           | quantized;
+}
+
+void radix_sort( std::vector< sort_entry >& entries, std::vector< sort_entry >& scratch )
+{
+    constexpr uint32_t PASSES = 8;
+
+    // all histograms in one read of the keys
+    std::array< std::array< uint32_t, 256 >, PASSES > counts{};
+
+    for ( const auto& e : entries )
+    {
+        for ( uint32_t p = 0; p < PASSES; ++p )
+        {
+            ++counts[p][( e.key >> ( 8 * p ) ) & 0xff];
+        }
+    }
+
+    scratch.resize( entries.size() );
+
+    for ( uint32_t p = 0; p < PASSES; ++p )
+    {
+        auto& count = counts[p];
+
+        // every key has the same byte here, the pass wouldn't move anything
+        if ( std::find( count.begin(), count.end(), entries.size() ) != count.end() )
+        {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for ( auto& c : count )
+        {
+            const uint32_t n = c;
+            c                = offset;
+            offset += n;
+        }
+
+        for ( const auto& e : entries )
+        {
+            scratch[count[( e.key >> ( 8 * p ) ) & 0xff]++] = e;
+        }
+
+        entries.swap( scratch );
+    }
+}
+
+void render_queue::clear()
+{
+    m_items.clear();
+    m_order.clear();
+}
+
+void render_queue::push( uint64_t key, const draw_item& item )
+{
+    m_order.push_back( {key, static_cast< uint32_t >( m_items.size() )} );
+    m_items.push_back( item );
+}
+
+void render_queue::sort()
+{
+    radix_sort( m_order, m_scratch );
+}
+
+render_queue_stats render_queue::record( VkCommandBuffer cmd ) const
+{
+    return record( cmd, 0, size() );
+}
+
+render_queue_stats render_queue::record( VkCommandBuffer cmd, uint32_t begin,
+                                         uint32_t end ) const
+{
+    NEO_ASSERT_ALWAYS( begin <= end && end <= m_order.size(), "Draws [", begin, ", ", end,
+                       ") out of range" );
+
+    render_queue_stats stats{};
+
+    // nothing is assumed to be bound when the queue starts
+    VkPipeline pipeline          = nullptr;
+    VkPipelineLayout layout      = nullptr;
+    VkDescriptorSet set          = nullptr;
+    VkBuffer vertices            = nullptr;
+    VkBuffer instances           = nullptr;
+    VkDeviceSize instance_offset = 0;
+    VkBuffer indices             = nullptr;
+
+    for ( uint32_t i = begin; i < end; ++i )
+    {
+        const draw_item& item = m_items[m_order[i].index];
+
+        if ( item.pipeline != pipeline )
+        {
+            if ( cmd != nullptr )
+            {
+                vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, item.pipeline );
+            }
+
+            pipeline = item.pipeline;
+            ++stats.pipeline_binds;
+        }
+
+        // a different layout might not be compatible, the set is bound again
+        if ( item.set != nullptr && ( item.set != set || item.layout != layout ) )
+        {
+            if ( cmd != nullptr )
+            {
+                vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                         item.layout, 0, 1, &item.set, 0, nullptr );
+            }
+
+            set    = item.set;
+            layout = item.layout;
+            ++stats.set_binds;
+        }
+
+        const bool bind_vertices = item.vertices != vertices;
+        const bool bind_instances =
+            item.instances != nullptr
+            && ( item.instances != instances || item.instance_offset != instance_offset );
+
+        // both bindings in one call when both change
+        if ( bind_vertices || bind_instances )
+        {
+            const VkBuffer buffers[2]     = {item.vertices, item.instances};
+            const VkDeviceSize offsets[2] = {0, item.instance_offset};
+            const uint32_t first          = bind_vertices ? 0 : 1;
+            const uint32_t count          = bind_instances ? 2 - first : 1;
+
+            if ( cmd != nullptr )
+            {
+                vkCmdBindVertexBuffers( cmd, first, count, buffers + first,
+                                        offsets + first );
+            }
+
+            vertices = item.vertices;
+            if ( bind_instances )
+            {
+                instances       = item.instances;
+                instance_offset = item.instance_offset;
+            }
+            ++stats.vertex_binds;
+        }
+
+        if ( item.indices != indices )
+        {
+            if ( cmd != nullptr )
+            {
+                vkCmdBindIndexBuffer( cmd, item.indices, 0, VK_INDEX_TYPE_UINT32 );
+            }
+
+            indices = item.indices;
+            ++stats.index_binds;
+        }
+
+        if ( cmd != nullptr )
+        {
+            if ( item.indirect != nullptr )
+            {
+                vkCmdDrawIndexedIndirect( cmd, item.indirect, item.indirect_offset, 1,
+                                          sizeof( VkDrawIndexedIndirectCommand ) );
+            }
+            else
+            {
+                vkCmdDrawIndexed( cmd, item.index_count, item.instance_count,
+                                  item.first_index, item.vertex_offset, 0 );
+            }
+        }
+
+        ++stats.draws;
+    }
+
+    return stats;
+}
@@ -0,0 +1,493 @@
+#include "soft_rasterizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    glm::vec4 fetch( const image& img, int32_t x, int32_t y )
+    {
+        x = std::clamp( x, 0, img.width - 1 );
+        y = std::clamp( y, 0, img.height - 1 );
+
+        const unsigned char* p = &img.data[( size_t( y ) * img.width + x ) * 4];
+        return glm::vec4( p[0], p[1], p[2], p[3] ) * ( 1.0f / 255.0f );
+    }
+
+    // VK_FILTER_LINEAR with CLAMP_TO_EDGE on an UNORM texture, like example4's sampler
+    glm::vec4 sample_bilinear( const image& img, glm::vec2 uv )
+    {
+        const float x = uv.x * img.width - 0.5f;
+        const float y = uv.y * img.height - 0.5f;
+
+        const float fx = std::floor( x );
+        const float fy = std::floor( y );
+        const float tx = x - fx;
+        const float ty = y - fy;
+
+        const auto ix = static_cast< int32_t >( fx );
+        const auto iy = static_cast< int32_t >( fy );
+
+        const glm::vec4 top =
+            glm::mix( fetch( img, ix, iy ), fetch( img, ix + 1, iy ), tx );
+        const glm::vec4 bottom =
+            glm::mix( fetch( img, ix, iy + 1 ), fetch( img, ix + 1, iy + 1 ), tx );
+
+        return glm::mix( top, bottom, ty );
+    }
+
+    glm::vec4 linearize( const glm::vec4& c ) { return glm::pow( c, glm::vec4( 2.4f ) ); }
+} // namespace
+
+soft_rasterizer::soft_rasterizer( thread_pool& pool, int32_t width, int32_t height )
+    : m_pool{pool}
+    , m_width{width}
+    , m_height{height}
+    , m_tiles_x{( width + TILE_SIZE - 1 ) / TILE_SIZE}
+    , m_tiles_y{( height + TILE_SIZE - 1 ) / TILE_SIZE}
+    , m_blocks_x{( width + BLOCK_SIZE - 1 ) / BLOCK_SIZE}
+{
+    const int32_t blocks_y = ( height + BLOCK_SIZE - 1 ) / BLOCK_SIZE;
+
+    // depth is padded to whole blocks so spans never read past the end
+    m_color.resize( size_t( width ) * height );
+    m_depth.resize( size_t( m_blocks_x ) * BLOCK_SIZE * blocks_y * BLOCK_SIZE );
+    m_block_max_depth.resize( size_t( m_blocks_x ) * blocks_y );
+
+    m_chunk_count = ( pool.thread_count() + 1 ) * 4;
+    m_chunk_triangles.resize( m_chunk_count );
+    m_bins.resize( size_t( m_chunk_count ) * m_tiles_x * m_tiles_y );
+}
+
+void soft_rasterizer::clear( const glm::vec4& color, float depth )
+{
+    std::fill( m_color.begin(), m_color.end(), color );
+    std::fill( m_depth.begin(), m_depth.end(), depth );
+    std::fill( m_block_max_depth.begin(), m_block_max_depth.end(), depth );
+}
+
+soft_raster_stats soft_rasterizer::draw( const model_data& model, const image& texture,
+                                         const example4_transforms& transforms )
+{
+    const auto vertex_count   = static_cast< uint32_t >( model.vertex_data.size() );
+    const auto triangle_count = static_cast< uint32_t >( model.index_data.size() / 3 );
+    const auto tile_count     = static_cast< uint32_t >( m_tiles_x * m_tiles_y );
+
+    // example4.vert
+    const glm::mat4 model_view = transforms.view * transforms.model;
+    const glm::mat4 mvp        = transforms.proj * model_view;
+
+    m_vertices.resize( vertex_count );
+    m_pool.parallel_for( vertex_count, 4096, [&]( uint32_t begin, uint32_t end ) {
+        for ( uint32_t i = begin; i < end; ++i )
+        {
+            const auto& v = model.vertex_data[i];
+
+            m_vertices[i].position = mvp * glm::vec4( v.position, 1.0f );
+            m_vertices[i].normal = glm::vec3( model_view * glm::vec4( v.normal, 0.0f ) );
+            m_vertices[i].texcoord = glm::vec2( v.texcoord.x, 1.0f - v.texcoord.y );
+        }
+    } );
+
+    for ( auto& t : m_chunk_triangles )
+    {
+        t.clear();
+    }
+
+    for ( auto& b : m_bins )
+    {
+        b.clear();
+    }
+
+    const uint32_t grain =
+        std::max( ( triangle_count + m_chunk_count - 1 ) / m_chunk_count, 1u );
+    m_pool.parallel_for( triangle_count, grain, [&]( uint32_t begin, uint32_t end ) {
+        bin_triangles( model, begin / grain, begin, end );
+    } );
+
+    std::vector< uint64_t > pixels( tile_count );
+    m_pool.parallel_for( tile_count, 1, [&]( uint32_t begin, uint32_t end ) {
+        for ( uint32_t t = begin; t < end; ++t )
+        {
+            pixels[t] = rasterize_tile( static_cast< int32_t >( t ), texture );
+        }
+    } );
+
+    soft_raster_stats ret{triangle_count, 0, 0};
+
+    for ( const auto& t : m_chunk_triangles )
+    {
+        ret.triangles_rasterized += t.size();
+    }
+
+    for ( const auto p : pixels )
+    {
+        ret.pixels_shaded += p;
+    }
+
+    return ret;
+}
+
+void soft_rasterizer::setup_triangle( const clip_vertex& v0, const clip_vertex& v1,
+                                      const clip_vertex& v2,
+                                      std::vector< triangle >& out ) const
+{
+    const std::array< const clip_vertex*, 3 > v = {&v0, &v1, &v2};
+
+    triangle t{};
+    float sx[3];
+    float sy[3];
+
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        t.inv_w[i]    = 1.0f / v[i]->position.w;
+        sx[i]         = ( v[i]->position.x * t.inv_w[i] * 0.5f + 0.5f ) * m_width;
+        sy[i]         = ( v[i]->position.y * t.inv_w[i] * 0.5f + 0.5f ) * m_height;
+        t.z[i]        = v[i]->position.z * t.inv_w[i];
+        t.normal[i]   = v[i]->normal;
+        t.texcoord[i] = v[i]->texcoord;
+    }
+
+    const float area =
+        ( sx[1] - sx[0] ) * ( sy[2] - sy[0] ) - ( sx[2] - sx[0] ) * ( sy[1] - sy[0] );
+
+    if ( !std::isfinite( area ) || area == 0.0f )
+    {
+        return;
+    }
+
+    const float min_sx = std::min( {sx[0], sx[1], sx[2]} );
+    const float max_sx = std::max( {sx[0], sx[1], sx[2]} );
+    const float min_sy = std::min( {sy[0], sy[1], sy[2]} );
+    const float max_sy = std::max( {sy[0], sy[1], sy[2]} );
+
+    t.min_z = std::min( {t.z[0], t.z[1], t.z[2]} );
+
+    if ( max_sx < 0.0f || max_sy < 0.0f || min_sx > m_width || min_sy > m_height
+         || t.min_z > 1.0f )
+    {
+        return;
+    }
+
+    t.min_x = std::max( static_cast< int32_t >( std::floor( min_sx ) ), 0 );
+    t.min_y = std::max( static_cast< int32_t >( std::floor( min_sy ) ), 0 );
+    t.max_x = std::min( static_cast< int32_t >( std::ceil( max_sx ) ), m_width - 1 );
+    t.max_y = std::min( static_cast< int32_t >( std::ceil( max_sy ) ), m_height - 1 );
+
+    // edge i is opposite of vertex i, divided by the area it is 1 at vertex i
+    const float inv_area = 1.0f / area;
+
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        const uint32_t j = ( i + 1 ) % 3;
+        const uint32_t k = ( i + 2 ) % 3;
+
+        t.edge_a[i] = -( sy[k] - sy[j] ) * inv_area;
+        t.edge_b[i] = ( sx[k] - sx[j] ) * inv_area;
+        t.edge_c[i] =
+            ( ( sy[k] - sy[j] ) * sx[j] - ( sx[k] - sx[j] ) * sy[j] ) * inv_area;
+
+        t.top_left[i] =
+            t.edge_a[i] > 0.0f || ( t.edge_a[i] == 0.0f && t.edge_b[i] > 0.0f );
+    }
+
+    out.push_back( t );
+}
+
+void soft_rasterizer::bin_triangles( const model_data& model, uint32_t chunk,
+                                     uint32_t begin, uint32_t end )
+{
+    auto& triangles  = m_chunk_triangles[chunk];
+    const auto tiles = static_cast< size_t >( m_tiles_x * m_tiles_y );
+    auto* const bins = &m_bins[chunk * tiles];
+
+    const auto lerp = []( const clip_vertex& a, const clip_vertex& b, float t ) {
+        return clip_vertex{glm::mix( a.position, b.position, t ),
+                           glm::mix( a.normal, b.normal, t ),
+                           glm::mix( a.texcoord, b.texcoord, t )};
+    };
+
+    for ( uint32_t tri = begin; tri < end; ++tri )
+    {
+        const std::array< const clip_vertex*, 3 > v = {
+            &m_vertices[model.index_data[tri * 3]],
+            &m_vertices[model.index_data[tri * 3 + 1]],
+            &m_vertices[model.index_data[tri * 3 + 2]]};
+
+        const size_t first = triangles.size();
+
+        // only the near plane z >= 0 is clipped, everything else is handled by the
+        // screen bounds and the per pixel depth range check
+        const std::array< float, 3 > d = {v[0]->position.z, v[1]->position.z,
+                                          v[2]->position.z};
+
+        if ( d[0] >= 0.0f && d[1] >= 0.0f && d[2] >= 0.0f )
+        {
+            setup_triangle( *v[0], *v[1], *v[2], triangles );
+        }
+        else if ( d[0] >= 0.0f || d[1] >= 0.0f || d[2] >= 0.0f )
+        {
+            std::array< clip_vertex, 4 > polygon;
+            uint32_t n = 0;
+
+            for ( uint32_t i = 0; i < 3; ++i )
+            {
+                const uint32_t next = ( i + 1 ) % 3;
+
+                if ( d[i] >= 0.0f )
+                {
+                    polygon[n++] = *v[i];
+                }
+
+                if ( ( d[i] >= 0.0f ) != ( d[next] >= 0.0f ) )
+                {
+                    polygon[n++] = lerp( *v[i], *v[next], d[i] / ( d[i] - d[next] ) );
+                }
+            }
+
+            for ( uint32_t i = 1; i + 1 < n; ++i )
+            {
+                setup_triangle( polygon[0], polygon[i], polygon[i + 1], triangles );
+            }
+        }
+
+        for ( size_t i = first; i < triangles.size(); ++i )
+        {
+            const triangle& t = triangles[i];
+
+            for ( int32_t ty = t.min_y / TILE_SIZE; ty <= t.max_y / TILE_SIZE; ++ty )
+            {
+                for ( int32_t tx = t.min_x / TILE_SIZE; tx <= t.max_x / TILE_SIZE; ++tx )
+                {
+                    bins[ty * m_tiles_x + tx].push_back( static_cast< uint32_t >( i ) );
+                }
+            }
+        }
+    }
+}
+
+uint64_t soft_rasterizer::rasterize_tile( int32_t tile, const image& texture )
+{
+    const int32_t tile_x0 = ( tile % m_tiles_x ) * TILE_SIZE;
+    const int32_t tile_y0 = ( tile / m_tiles_x ) * TILE_SIZE;
+    const int32_t tile_x1 = std::min( tile_x0 + TILE_SIZE, m_width ) - 1;
+    const int32_t tile_y1 = std::min( tile_y0 + TILE_SIZE, m_height ) - 1;
+
+    const auto tiles = static_cast< size_t >( m_tiles_x * m_tiles_y );
+
+    uint64_t ret = 0;
+
+    for ( uint32_t chunk = 0; chunk < m_chunk_count; ++chunk )
+    {
+        const auto& triangles = m_chunk_triangles[chunk];
+
+        for ( const uint32_t idx : m_bins[chunk * tiles + tile] )
+        {
+            const triangle& t = triangles[idx];
+
+            const int32_t bx0 = std::max( t.min_x, tile_x0 ) / BLOCK_SIZE;
+            const int32_t by0 = std::max( t.min_y, tile_y0 ) / BLOCK_SIZE;
+            const int32_t bx1 = std::min( t.max_x, tile_x1 ) / BLOCK_SIZE;
+            const int32_t by1 = std::min( t.max_y, tile_y1 ) / BLOCK_SIZE;
+
+            for ( int32_t by = by0; by <= by1; ++by )
+            {
+                for ( int32_t bx = bx0; bx <= bx1; ++bx )
+                {
+                    ret += rasterize_block( t, bx, by, texture );
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+uint64_t soft_rasterizer::rasterize_block( const triangle& t, int32_t block_x,
+                                           int32_t block_y, const image& texture )
+{
+    float& block_max_depth = m_block_max_depth[block_y * m_blocks_x + block_x];
+
+    // hierarchical depth test, nothing can pass if the triangle is behind the block
+    if ( t.min_z > block_max_depth )
+    {
+        return 0;
+    }
+
+    const int32_t x0 = block_x * BLOCK_SIZE;
+    const int32_t y0 = block_y * BLOCK_SIZE;
+
+    // the barycentrics are linear, if all corners are outside an edge so is the block
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        const float left   = t.edge_a[i] * ( x0 + 0.5f );
+        const float right  = t.edge_a[i] * ( x0 + BLOCK_SIZE - 0.5f );
+        const float top    = t.edge_b[i] * ( y0 + 0.5f );
+        const float bottom = t.edge_b[i] * ( y0 + BLOCK_SIZE - 0.5f );
+
+        if ( std::max( left, right ) + std::max( top, bottom ) + t.edge_c[i] < 0.0f )
+        {
+            return 0;
+        }
+    }
+
+    const int32_t stride = m_blocks_x * BLOCK_SIZE;
+
+    uint64_t shaded = 0;
+
+    for ( int32_t sy = 0; sy < BLOCK_SIZE; sy += 2 )
+    {
+        for ( int32_t sx = 0; sx < BLOCK_SIZE; sx += 4 )
+        {
+            const int32_t px = x0 + sx;
+            const int32_t py = y0 + sy;
+
+            float* const depth_row0 = &m_depth[size_t( py ) * stride + px];
+            float* const depth_row1 = depth_row0 + stride;
+
+            // lanes 0-3 are the first row of the span, 4-7 the second
+            alignas( 32 ) float bary[3][8];
+            alignas( 32 ) float z[8];
+            uint32_t mask = 0;
+
+#ifdef __AVX2__
+            const __m256 x = _mm256_add_ps(
+                _mm256_set1_ps( static_cast< float >( px ) ),
+                _mm256_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f, 0.5f, 1.5f, 2.5f, 3.5f ) );
+            const __m256 y = _mm256_add_ps(
+                _mm256_set1_ps( static_cast< float >( py ) ),
+                _mm256_setr_ps( 0.5f, 0.5f, 0.5f, 0.5f, 1.5f, 1.5f, 1.5f, 1.5f ) );
+
+            const __m256 zero = _mm256_setzero_ps();
+            __m256 inside     = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+            __m256 z_acc      = zero;
+
+            for ( uint32_t i = 0; i < 3; ++i )
+            {
+                const __m256 b = _mm256_add_ps(
+                    _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( t.edge_a[i] ), x ),
+                                   _mm256_mul_ps( _mm256_set1_ps( t.edge_b[i] ), y ) ),
+                    _mm256_set1_ps( t.edge_c[i] ) );
+
+                const __m256 edge_inside = t.top_left[i]
+                                               ? _mm256_cmp_ps( b, zero, _CMP_GE_OQ )
+                                               : _mm256_cmp_ps( b, zero, _CMP_GT_OQ );
+
+                inside = _mm256_and_ps( inside, edge_inside );
+                z_acc =
+                    _mm256_add_ps( z_acc, _mm256_mul_ps( b, _mm256_set1_ps( t.z[i] ) ) );
+
+                _mm256_store_ps( bary[i], b );
+            }
+
+            const __m256 depth = _mm256_insertf128_ps(
+                _mm256_castps128_ps256( _mm_loadu_ps( depth_row0 ) ),
+                _mm_loadu_ps( depth_row1 ), 1 );
+
+            inside = _mm256_and_ps( inside, _mm256_cmp_ps( z_acc, depth, _CMP_LE_OQ ) );
+            inside = _mm256_and_ps( inside, _mm256_cmp_ps( z_acc, zero, _CMP_GE_OQ ) );
+            inside = _mm256_and_ps(
+                inside, _mm256_cmp_ps( z_acc, _mm256_set1_ps( 1.0f ), _CMP_LE_OQ ) );
+
+            _mm256_store_ps( z, z_acc );
+            mask = static_cast< uint32_t >( _mm256_movemask_ps( inside ) );
+#else
+            for ( uint32_t lane = 0; lane < 8; ++lane )
+            {
+                const float x = px + ( lane & 3 ) + 0.5f;
+                const float y = py + ( lane >> 2 ) + 0.5f;
+
+                bool inside = true;
+                z[lane]     = 0.0f;
+
+                for ( uint32_t i = 0; i < 3; ++i )
+                {
+                    const float b = t.edge_a[i] * x + t.edge_b[i] * y + t.edge_c[i];
+
+                    inside &= t.top_left[i] ? b >= 0.0f : b > 0.0f;
+                    z[lane] += b * t.z[i];
+                    bary[i][lane] = b;
+                }
+
+                const float depth =
+                    ( lane < 4 ) ? depth_row0[lane] : depth_row1[lane - 4];
+                inside &= z[lane] <= depth && z[lane] >= 0.0f && z[lane] <= 1.0f;
+
+                mask |= inside ? ( 1u << lane ) : 0u;
+            }
+#endif
+
+            for ( uint32_t lane = 0; mask != 0; ++lane, mask >>= 1 )
+            {
+                if ( ( mask & 1 ) == 0 )
+                {
+                    continue;
+                }
+
+                const int32_t x = px + static_cast< int32_t >( lane & 3 );
+                const int32_t y = py + static_cast< int32_t >( lane >> 2 );
+
+                // the padding of the depth buffer is never written
+                if ( x >= m_width || y >= m_height )
+                {
+                    continue;
+                }
+
+                const float b[3] = {bary[0][lane], bary[1][lane], bary[2][lane]};
+
+                ( lane < 4 ? depth_row0 : depth_row1 )[lane & 3] = z[lane];
+                m_color[size_t( y ) * m_width + x] = shade( t, b, texture );
+                ++shaded;
+            }
+        }
+    }
+
+    if ( shaded > 0 )
+    {
+        float max_depth = 0.0f;
+
+        for ( int32_t y = y0; y < std::min( y0 + BLOCK_SIZE, m_height ); ++y )
+        {
+            for ( int32_t x = x0; x < std::min( x0 + BLOCK_SIZE, m_width ); ++x )
+            {
+                max_depth = std::max( max_depth, m_depth[size_t( y ) * stride + x] );
+            }
+        }
+
+        block_max_depth = max_depth;
+    }
+
+    return shaded;
+}
+
+glm::vec4 soft_rasterizer::shade( const triangle& t, const float bary[3],
+                                  const image& texture ) const
+{
+    // perspective correct interpolation of the varyings
+    const float w0    = bary[0] * t.inv_w[0];
+    const float w1    = bary[1] * t.inv_w[1];
+    const float w2    = bary[2] * t.inv_w[2];
+    const float inv_w = 1.0f / ( w0 + w1 + w2 );
+
+    const glm::vec3 normal =
+        ( t.normal[0] * w0 + t.normal[1] * w1 + t.normal[2] * w2 ) * inv_w;
+    const glm::vec2 uv =
+        ( t.texcoord[0] * w0 + t.texcoord[1] * w1 + t.texcoord[2] * w2 ) * inv_w;
+
+    // example4.frag
+    const glm::vec4 color = linearize( sample_bilinear( texture, uv ) );
+    const float NdL       = std::max( normal.z, 0.0f );
+    const float spec      = std::clamp( std::pow( NdL, 50.0f ), 0.0f, 1.0f ) * 0.2f;
+    const float diff      = NdL;
+    const float ambient   = std::pow( 0.4f, 2.4f );
+
+    const glm::vec3 rgb = glm::vec3( color ) * ambient + glm::vec3( spec )
+                          + ( diff * ( 1.0f - spec ) ) * glm::vec3( color );
+
+    return glm::vec4( rgb, 1.0f );
+}
@@ -0,0 +1,145 @@
+#include "thread_pool.hpp"
+
+namespace
+{
+    // index of the queue owned by the current thread, the external queue otherwise
+    thread_local uint32_t t_queue_idx = UINT32_MAX;
+} // namespace
+
+thread_pool::thread_pool( uint32_t thread_count )
+    : m_thread_count{thread_count}
+    , m_queued{0}
+    , m_next_queue{0}
+    , m_stop{false}
+{
+    if ( m_thread_count == 0 )
+    {
+        m_thread_count = std::max( std::thread::hardware_concurrency(), 1u );
+    }
+
+    for ( uint32_t i = 0; i < m_thread_count + 1; ++i )
+    {
+        m_queues.push_back( std::make_unique< worker_queue >() );
+    }
+
+    for ( uint32_t i = 0; i < m_thread_count; ++i )
+    {
+        m_threads.emplace_back( &thread_pool::worker_main, this, i );
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard< std::mutex > lock( m_sleep_mutex );
+        m_stop = true;
+    }
+
+    m_wake.notify_all();
+
+    for ( auto& t : m_threads )
+    {
+        t.join();
+    }
+}
+
+void thread_pool::push( task t )
+{
+    const uint32_t external_idx = thread_count();
+
+    // workers keep their own tasks local, everyone else spreads them out
+    uint32_t idx = t_queue_idx;
+    if ( idx >= external_idx )
+    {
+        idx = m_next_queue.fetch_add( 1, std::memory_order_relaxed )
+              % ( external_idx + 1 );
+    }
+
+    {
+        std::lock_guard< std::mutex > lock( m_queues[idx]->mutex );
+        m_queues[idx]->tasks.push_back( std::move( t ) );
+    }
+
+    {
+        std::lock_guard< std::mutex > lock( m_sleep_mutex );
+        m_queued.fetch_add( 1, std::memory_order_release );
+    }
+
+    m_wake.notify_one();
+}
+
+bool thread_pool::pop( uint32_t queue_idx, task& out )
+{
+    auto& q = *m_queues[queue_idx];
+    std::lock_guard< std::mutex > lock( q.mutex );
+
+    if ( q.tasks.empty() )
+    {
+        return false;
+    }
+
+    out = std::move( q.tasks.back() );
+    q.tasks.pop_back();
+    m_queued.fetch_sub( 1, std::memory_order_relaxed );
+
+    return true;
+}
+
+bool thread_pool::steal( uint32_t thief_idx, task& out )
+{
+    const uint32_t queue_count = static_cast< uint32_t >( m_queues.size() );
+
+    for ( uint32_t i = 1; i <= queue_count; ++i )
+    {
+        auto& q = *m_queues[( thief_idx + i ) % queue_count];
+        std::lock_guard< std::mutex > lock( q.mutex );
+
+        if ( !q.tasks.empty() )
+        {
+            out = std::move( q.tasks.front() );
+            q.tasks.pop_front();
+            m_queued.fetch_sub( 1, std::memory_order_relaxed );
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool thread_pool::run_one()
+{
+    const uint32_t idx = std::min( t_queue_idx, thread_count() );
+
+    task t;
+    if ( pop( idx, t ) || steal( idx, t ) )
+    {
+        t();
+        return true;
+    }
+
+    return false;
+}
+
+void thread_pool::worker_main( uint32_t idx )
+{
+    t_queue_idx = idx;
+
+    for ( ;; )
+    {
+        if ( run_one() )
+        {
+            continue;
+        }
+
+        std::unique_lock< std::mutex > lock( m_sleep_mutex );
+        m_wake.wait( lock, [this]() {
+            return m_stop || m_queued.load( std::memory_order_acquire ) > 0;
+        } );
+
+        if ( m_stop )
+        {
+            return;
+        }
+    }
+}
@@ -2,10 +2,24 @@
 
 #ifdef DEBUG
 VKAPI_ATTR VkBool32 VKAPI_CALL
-debug_callback( VkDebugUtilsMessageSeverityFlagBitsEXT, VkDebugUtilsMessageTypeFlagsEXT,
+debug_callback( VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                VkDebugUtilsMessageTypeFlagsEXT,
                 const VkDebugUtilsMessengerCallbackDataEXT* callback_data, void* )
 {
-    log( "\033[1;31mvalidation layer: ", callback_data->pMessage, "\033[0m" );
+    if ( severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT )
+    {
+        NEO_LOG_ERROR( vulkan, "\033[1;31mvalidation layer: ", callback_data->pMessage,
+                       "\033[0m" );
+    }
+    else if ( severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT )
+    {
+        NEO_LOG_WARNING( vulkan, "\033[1;31mvalidation layer: ", callback_data->pMessage,
+                         "\033[0m" );
+    }
+    else
+    {
+        NEO_LOG_DEBUG( vulkan, "validation layer: ", callback_data->pMessage );
+    }
     return VK_FALSE;
 }
 #endif